@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <optional>
 #include <string>
 #include <vector>
@@ -16,6 +17,10 @@ struct DetectionConfig {
     double quadExpandOffset {12.0};
     int warpMinShort {1400};
     int warpMinDim {400};
+    // Find candidates on a downscaled crop and refine each circle in its own ROI of
+    // the original image instead of warping the whole board; falls back to the
+    // warped path when that fails.
+    bool warpFreeDetection {false};
     double houghGaussianSigma {1.0};
     double houghCannyLowRatio {0.66};
     int houghCannyLowMin {10};
@@ -31,6 +36,7 @@ struct DetectionConfig {
     int houghKmeansMaxIter {200};
     double houghKmeansEps {1e-4};
     int houghKmeansAttempts {4};
+    int houghQuadTopK {8}; // best-scoring quads kept by the line-pair enumeration
     double quadMargin {0.005};
     double quadAreaMinRatio {0.002};
     double quadAreaMaxRatio {0.80};
@@ -68,10 +74,16 @@ struct DetectionConfig {
     double refineWinScale {3.0};
     double refineWinMin {30.0};
     double refineWinMax {220.0};
+    // After back-projection, re-fits every centre on the original image from its
+    // gradient (warped path only; the warp-free path always measures there).
+    bool refineOnImage {true};
     int refineSegmentKsize {3};
     cv::Size refineOpenKernel {3, 3};
     int fallbackCannyLow {30};
     int fallbackCannyHigh {90};
+    // Per-stage debug PNGs under the temp directory; the detection tuner turns
+    // them off.
+    bool writeDebugImages {true};
 };
 
 class BoardDetector {
@@ -80,7 +92,28 @@ public:
 
     DetectionResult detect(const cv::Mat &gray, const BoardSpec &spec, const std::string &name) const;
 
+    // Quad search alone, e.g. on a reduced-resolution decode; corners are in gray's pixels.
+    [[nodiscard]] std::optional<std::array<cv::Point2f, 4>> locateBoard(const cv::Mat &gray) const;
+
+    // Circle detection with the board quad already known (in gray's pixels), so
+    // gray may be just the board region of a larger image.
+    DetectionResult detectWithQuad(const cv::Mat &gray,
+                                   const std::array<cv::Point2f, 4> &quad,
+                                   const BoardSpec &spec,
+                                   const std::string &name) const;
+
 private:
+    DetectionResult detectWithFallback(const cv::Mat &gray,
+                                       const BoardSpec &spec,
+                                       const std::string &name,
+                                       const std::array<cv::Point2f, 4> *quadHint) const;
+    DetectionResult detectImpl(const cv::Mat &gray,
+                               const BoardSpec &spec,
+                               const std::string &name,
+                               bool warpFree,
+                               const std::array<cv::Point2f, 4> *quadHint,
+                               bool *quadFound) const;
+
     DetectionConfig m_cfg;
 };
 
@@ -1,53 +1,204 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 #include <opencv2/core.hpp>
 
 namespace mycalib {
 
+struct BoardCell {
+    int row {0};
+    int col {0};
+};
+
+// Orientation marker centre in lattice units; markers sit between circles.
+struct BoardMarker {
+    double row {0.0};
+    double col {0.0};
+};
+
+// Printed circle lattices. A layout is a type carrying its geometry as constexpr
+// data (kRows, kCols, kMissing, kMarkers, kKey, kName); BoardLayoutTraits derives the
+// tables the detector and object-point paths iterate over. Cell indices are shared
+// by object-point generation and the detector's numbering.
+struct Asymmetric7x6CenterMissing {
+    static constexpr int kRows = 7;
+    static constexpr int kCols = 6;
+    static constexpr std::array<BoardCell, 1> kMissing {{{3, 3}}};
+    // BR, TR, BL, TL; BR carries the right angle axes_from_big4() looks for.
+    static constexpr std::array<BoardMarker, 4> kMarkers {{{1.5, 1.5}, {1.5, 3.5}, {4.5, 1.5}, {5.5, 4.5}}};
+    static constexpr const char *kKey = "7x6";
+    static constexpr const char *kName = "7x6 asymmetric circles (center missing)";
+};
+
+// Larger prints of the same design: the gap stays at (rows/2, cols/2) and the
+// markers keep their offsets from it, so the axis logic is unchanged.
+struct Asymmetric9x8CenterMissing {
+    static constexpr int kRows = 9;
+    static constexpr int kCols = 8;
+    static constexpr std::array<BoardCell, 1> kMissing {{{4, 4}}};
+    static constexpr std::array<BoardMarker, 4> kMarkers {{{2.5, 2.5}, {2.5, 4.5}, {5.5, 2.5}, {6.5, 5.5}}};
+    static constexpr const char *kKey = "9x8";
+    static constexpr const char *kName = "9x8 asymmetric circles (center missing)";
+};
+
+struct Asymmetric11x10CenterMissing {
+    static constexpr int kRows = 11;
+    static constexpr int kCols = 10;
+    static constexpr std::array<BoardCell, 1> kMissing {{{5, 5}}};
+    static constexpr std::array<BoardMarker, 4> kMarkers {{{3.5, 3.5}, {3.5, 5.5}, {6.5, 3.5}, {7.5, 6.5}}};
+    static constexpr const char *kKey = "11x10";
+    static constexpr const char *kName = "11x10 asymmetric circles (center missing)";
+};
+
+enum class BoardLayoutId {
+    Asymmetric7x6CenterMissing,
+    Asymmetric9x8CenterMissing,
+    Asymmetric11x10CenterMissing
+};
+
+inline constexpr std::array<BoardLayoutId, 3> kBoardLayoutIds {BoardLayoutId::Asymmetric7x6CenterMissing,
+                                                               BoardLayoutId::Asymmetric9x8CenterMissing,
+                                                               BoardLayoutId::Asymmetric11x10CenterMissing};
+
+template <typename Layout>
+constexpr bool isMissingCell(int row, int col)
+{
+    for (const auto &cell : Layout::kMissing) {
+        if (cell.row == row && cell.col == col) {
+            return true;
+        }
+    }
+    return false;
+}
+
+template <typename Layout>
+struct BoardLayoutTraits {
+    static constexpr int kRows = Layout::kRows;
+    static constexpr int kCols = Layout::kCols;
+    static constexpr int kCircleCount = kRows * kCols - static_cast<int>(Layout::kMissing.size());
+
+    static constexpr std::array<int, kRows> kRowSizes = [] {
+        std::array<int, kRows> sizes {};
+        for (int row = 0; row < kRows; ++row) {
+            for (int col = 0; col < kCols; ++col) {
+                sizes[static_cast<std::size_t>(row)] += isMissingCell<Layout>(row, col) ? 0 : 1;
+            }
+        }
+        return sizes;
+    }();
+
+    static constexpr int kRowsWithGaps = [] {
+        int count = 0;
+        for (int size : kRowSizes) {
+            count += size < kCols ? 1 : 0;
+        }
+        return count;
+    }();
+
+    // Object-point order: rows and columns descending, missing cells skipped.
+    static constexpr std::array<BoardCell, kCircleCount> kObjectOrder = [] {
+        std::array<BoardCell, kCircleCount> cells {};
+        std::size_t n = 0;
+        for (int row = kRows - 1; row >= 0; --row) {
+            for (int col = kCols - 1; col >= 0; --col) {
+                if (!isMissingCell<Layout>(row, col)) {
+                    cells[n++] = BoardCell {row, col};
+                }
+            }
+        }
+        return cells;
+    }();
+};
+
+// Calls visitor(std::type_identity<Layout>{}) for the compile-time layout behind id.
+template <typename Visitor>
+decltype(auto) visitBoardLayout(BoardLayoutId id, Visitor &&visitor)
+{
+    switch (id) {
+    case BoardLayoutId::Asymmetric9x8CenterMissing:
+        return visitor(std::type_identity<Asymmetric9x8CenterMissing> {});
+    case BoardLayoutId::Asymmetric11x10CenterMissing:
+        return visitor(std::type_identity<Asymmetric11x10CenterMissing> {});
+    case BoardLayoutId::Asymmetric7x6CenterMissing:
+    default:
+        return visitor(std::type_identity<Asymmetric7x6CenterMissing> {});
+    }
+}
+
+// Short name ("7x6") used by the command line and the project file.
+inline const char *boardLayoutKey(BoardLayoutId id)
+{
+    return visitBoardLayout(id, [](auto tag) {
+        return decltype(tag)::type::kKey;
+    });
+}
+
+inline bool boardLayoutFromKey(std::string_view key, BoardLayoutId &id)
+{
+    for (BoardLayoutId candidate : kBoardLayoutIds) {
+        if (key == boardLayoutKey(candidate)) {
+            id = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
 struct BoardSpec {
+    BoardLayoutId layout {BoardLayoutId::Asymmetric7x6CenterMissing};
     double smallDiameterMm {5.0};
     double centerSpacingMm {25.0};
 
     [[nodiscard]] std::string description() const;
     [[nodiscard]] std::size_t expectedCircleCount() const;
     [[nodiscard]] std::vector<cv::Point3f> buildObjectPoints(int count) const;
+    [[nodiscard]] std::array<BoardMarker, 4> markers() const;
 };
 
 inline std::string BoardSpec::description() const
 {
-    return "7x6 asymmetric circles (center missing) -- d=" + std::to_string(smallDiameterMm) +
+    const char *name = visitBoardLayout(layout, [](auto tag) {
+        return decltype(tag)::type::kName;
+    });
+    return std::string(name) + " -- d=" + std::to_string(smallDiameterMm) +
            "mm, spacing=" + std::to_string(centerSpacingMm) + "mm";
 }
 
 inline std::size_t BoardSpec::expectedCircleCount() const
 {
-    return 41U; // 7x6 grid with one missing centre location
+    return visitBoardLayout(layout, [](auto tag) {
+        return static_cast<std::size_t>(BoardLayoutTraits<typename decltype(tag)::type>::kCircleCount);
+    });
 }
 
 inline std::vector<cv::Point3f> BoardSpec::buildObjectPoints(int count) const
 {
-    std::vector<cv::Point3f> coords;
-    coords.reserve(count);
-
-    for (int row = 6; row >= 0; --row) {
-        for (int col = 5; col >= 0; --col) {
-            if (row == 3 && col == 3) {
-                continue; // central circle is missing on the physical board
-            }
-            const float x = static_cast<float>(col * centerSpacingMm);
-            const float y = static_cast<float>(row * centerSpacingMm);
-            coords.emplace_back(x, y, 0.0f);
-            if (static_cast<int>(coords.size()) >= count) {
-                return coords;
-            }
+    return visitBoardLayout(layout, [&](auto tag) {
+        using Traits = BoardLayoutTraits<typename decltype(tag)::type>;
+        const int n = std::clamp(count, 0, Traits::kCircleCount);
+        std::vector<cv::Point3f> coords(static_cast<std::size_t>(n));
+        for (int i = 0; i < n; ++i) {
+            const BoardCell &cell = Traits::kObjectOrder[static_cast<std::size_t>(i)];
+            coords[static_cast<std::size_t>(i)] = cv::Point3f(static_cast<float>(cell.col * centerSpacingMm),
+                                                              static_cast<float>(cell.row * centerSpacingMm),
+                                                              0.0f);
         }
-    }
+        return coords;
+    });
+}
 
-    return coords;
+inline std::array<BoardMarker, 4> BoardSpec::markers() const
+{
+    return visitBoardLayout(layout, [](auto tag) {
+        return decltype(tag)::type::kMarkers;
+    });
 }
 
 } // namespace mycalib
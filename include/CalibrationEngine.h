@@ -21,9 +21,13 @@
 #include "BoardDetector.h"
 #include "BoardSpec.h"
 #include "DetectionResult.h"
+#include "HeatmapGenerator.h"
+#include "RunControl.h"
 
 namespace mycalib {
 
+class ThumbnailCache;
+
 struct CalibrationMetrics {
     double rms {0.0};
     double meanErrorPx {0.0};
@@ -37,29 +41,28 @@ struct CalibrationMetrics {
     cv::Vec3d rmsResidualMm {0.0, 0.0, 0.0};
     cv::Vec3d meanResidualPercent {0.0, 0.0, 0.0};
     cv::Vec3d rmsResidualPercent {0.0, 0.0, 0.0};
+    double validationRmsPx {0.0}; // views held out by view selection, 0 when none
+    int validationViews {0};
+};
+
+// One out-of-sample fold: intrinsics fitted without the test views, then the test
+// views scored by PnP + projectPoints against them.
+struct ValidationFold {
+    int trainViews {0};
+    int testViews {0};
+    int testPoints {0};
+    double trainRmsPx {0.0};
+    double testRmsPx {0.0};
+    cv::Mat cameraMatrix;
+    cv::Mat distCoeffs;
 };
 
-struct HeatmapBundle {
-    cv::Mat boardCoverage;
-    cv::Mat pixelError;
-    cv::Mat boardError;
-    cv::Mat residualScatter;
-    cv::Mat distortionMap;
-    std::vector<std::vector<cv::Point2f>> distortionGrid;
-    cv::Mat boardCoverageScalar;
-    cv::Mat pixelErrorScalar;
-    cv::Mat boardErrorScalar;
-    cv::Mat distortionScalar;
-    cv::Mat distortionVectors;
-    double boardCoverageMin {0.0};
-    double boardCoverageMax {1.0};
-    double pixelErrorMin {0.0};
-    double pixelErrorMax {1.0};
-    double boardErrorMin {0.0};
-    double boardErrorMax {1.0};
-    double residualScatterMax {0.0};
-    double distortionMin {0.0};
-    double distortionMax {0.0};
+struct CrossValidationReport {
+    QString mode; // "holdout" or "kfold"; empty when validation was not run
+    std::vector<ValidationFold> folds;
+    double meanTestRmsPx {0.0};
+    double pooledTestRmsPx {0.0};
+    cv::Vec4d intrinsicsSpread {0.0, 0.0, 0.0, 0.0}; // fold-to-fold std of fx, fy, cx, cy
 };
 
 struct CalibrationOutput {
@@ -71,11 +74,16 @@ struct CalibrationOutput {
     QStringList removalDiagnostics;
     cv::Mat cameraMatrix;
     cv::Mat distCoeffs;
+    // 1-sigma intrinsics uncertainty in calibrateCamera order:
+    // fx, fy, cx, cy, k1, k2, p1, p2, k3, k4, k5, k6, s1, s2, s3, s4, tauX, tauY.
+    cv::Mat intrinsicsStdDev;
     cv::Size imageSize {0, 0};
     std::vector<DetectionResult> allDetections;
     std::vector<DetectionResult> keptDetections;
     std::vector<DetectionResult> removedDetections;
+    std::vector<DetectionResult> validationDetections;
     CalibrationMetrics metrics;
+    CrossValidationReport crossValidation;
     HeatmapBundle heatmaps;
 };
 
@@ -85,51 +93,103 @@ class CalibrationEngine : public QObject {
 public:
     struct Settings {
         BoardSpec boardSpec;
+        DetectionConfig detection;
         double maxMeanErrorPx {3.0};
         double maxPointErrorPx {12.0};
         int maxIterations {3};
+        // The robust loop stops once its best removal set improves the held-out
+        // RMS by less than this.
+        double robustMinGainPx {0.002};
         int minSamples {12};
+        // Successful views beyond this count are subsampled for the solve and used
+        // for validation residuals only; <= 0 solves with every view.
+        int maxCalibrationViews {150};
+        enum class ValidationMode {
+            None,
+            HoldOut,
+            KFold
+        };
+        ValidationMode validationMode {ValidationMode::None};
+        int validationFolds {5};      // k in KFold mode
+        double holdOutFraction {0.2}; // share of views held out in HoldOut mode
         bool enableRefinement {true};
+        // > 0 runs detection in that many DetectionWorkerPool processes instead of
+        // in-process; only for executables that serve the worker argument.
+        int detectionWorkers {0};
+        // Detection profile written by DetectionTuner; when the file exists its
+        // fields replace those in detection.
+        QString detectionProfilePath;
     };
 
     static QString resolveOutputDirectory(const QString &requestedPath);
+    // settings.detection with the detection profile applied, if one is set and readable.
+    [[nodiscard]] static DetectionConfig resolveDetectionConfig(const Settings &settings);
 
     explicit CalibrationEngine(QObject *parent = nullptr);
     ~CalibrationEngine() override;
 
+    // knownImages, when given (e.g. from a DatasetIndex), replaces the directory scan.
     void run(const QString &imageDirectory,
              const Settings &settings,
-             const QString &outputDirectory);
+             const QString &outputDirectory,
+             const QStringList &knownImages = {});
 
     CalibrationOutput runBlocking(const QString &imageDirectory,
                                   const Settings &settings,
                                   const QString &outputDirectory);
 
+    // Runs the solve, filter and export stages on detections the caller already has;
+    // rig mode uses this to share one detection pass across cameras.
+    CalibrationOutput runBlocking(std::vector<DetectionResult> detections,
+                                  const Settings &settings,
+                                  const QString &outputDirectory);
+
+    // Loads and detects one image the way the pipeline does. Safe to call from
+    // several threads at once. With thumbnails, the decoded pixels also seed the
+    // preview cache.
+    [[nodiscard]] static DetectionResult detectImage(const std::string &path,
+                                                     const BoardSpec &spec,
+                                                     const BoardDetector &detector,
+                                                     ThumbnailCache *thumbnails = nullptr);
+
+    // Not owned; must outlive any run. nullptr disables thumbnail generation.
+    void setThumbnailCache(ThumbnailCache *cache) { m_thumbnails = cache; }
+
     void cancelAndWait();
     bool isRunning() const;
 
+    // Progress counters and per-worker stages of the current run; observers poll
+    // snapshot() instead of receiving a signal per image.
+    [[nodiscard]] const RunControl &control() const { return m_control; }
+
 Q_SIGNALS:
-    void progressUpdated(int processed, int total);
     void statusChanged(const QString &message);
     void finished(const CalibrationOutput &output);
     void failed(const QString &reason, const CalibrationOutput &details);
 
 private:
     QString m_directory;
+    QStringList m_knownImages;
     Settings m_settings;
     QString m_outputDirectory;
     BoardDetector m_detector;
+    ThumbnailCache *m_thumbnails {nullptr};
     QFutureWatcher<CalibrationOutput> *m_watcher {nullptr};
     QFuture<CalibrationOutput> m_future;
-    std::atomic_bool m_abortRequested {false};
+    RunControl m_control;
 
     CalibrationOutput executePipeline();
+    CalibrationOutput solveDetections(std::vector<DetectionResult> detections);
     std::vector<std::string> collectImagePaths(const QString &directory) const;
-    DetectionResult detectBoard(const std::string &path) const;
     CalibrationOutput calibrate(const std::vector<DetectionResult> &detections) const;
-    CalibrationOutput filterAndRecalibrate(CalibrationOutput &&input) const;
+    // probeViews: held-out views (may be empty) that score candidate removal sets.
+    CalibrationOutput filterAndRecalibrate(CalibrationOutput &&input,
+                                           const std::vector<DetectionResult> &probeViews) const;
+    void evaluateValidationViews(CalibrationOutput &output, std::vector<DetectionResult> views) const;
+    CrossValidationReport crossValidate(const CalibrationOutput &output) const;
     void exportReport(const CalibrationOutput &output) const;
     void exportHeatmap(const cv::Mat &heatmap, const QString &path) const;
+    void exportHeatmap(const HeatmapBundle &bundle, HeatmapField field, const QString &path) const;
 
     static void ensureDirectory(const QString &path);
     bool shouldAbort() const;
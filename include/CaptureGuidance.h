@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "BoardSpec.h"
+#include "DetectionResult.h"
+
+namespace mycalib {
+
+// Board orientation requested for a capture, expressed with the same pitch / yaw
+// convention inferPoseFromDetection() classifies against (degrees).
+struct CaptureTilt {
+    double pitchDeg {0.0};
+    double yawDeg {0.0};
+};
+
+struct CaptureRecommendation {
+    bool valid {false};
+    int row {-1};
+    int col {-1};
+    int tiltIndex {-1};
+    double gain {0.0};     // log-det information gain (nats) of the recommended view
+    double bestOther {0.0}; // gain of the runner-up, useful to judge how decisive the pick is
+};
+
+// Next-best-view planner. Keeps the intrinsics information matrix of the views
+// accepted so far, with each view's extrinsics marginalized out (Schur complement),
+// and scores a candidate grid cell / tilt by the D-optimal gain
+// log det(I + dI) - log det(I), which does not depend on parameter scaling.
+//
+// The model covers fx, fy, cx, cy, k1, k2, p1, p2, k3. The higher-order terms the
+// engine also solves for are driven by the same coverage, so the guidance does
+// not track them separately.
+class CaptureGuidance {
+public:
+    static constexpr int kParamCount = 9;
+    using InfoMatrix = cv::Matx<double, kParamCount, kParamCount>;
+
+    // Starts from a weak prior around the supplied intrinsics; a nominal pinhole
+    // (f = image width, centred principal point) is used when cameraMatrix is empty.
+    void reset(const BoardSpec &spec,
+               const cv::Size &imageSize,
+               const cv::Mat &cameraMatrix = {},
+               const cv::Mat &distCoeffs = {},
+               double pixelSigma = 0.25);
+
+    // Adds a detection with a solved pose (rotationMatrix / translationMm).
+    bool addObservedView(const DetectionResult &detection);
+    // Adds the view a shot taken in the given cell with the given tilt would produce;
+    // used for shots that have not been through a calibration run yet.
+    bool addNominalView(int row, int col, int gridRows, int gridCols, const CaptureTilt &tilt);
+
+    [[nodiscard]] double expectedGain(int row, int col, int gridRows, int gridCols, const CaptureTilt &tilt) const;
+    [[nodiscard]] CaptureRecommendation recommend(int gridRows, int gridCols, const std::vector<CaptureTilt> &tilts) const;
+
+    // 1-sigma standard deviations in parameter order, from the inverse information.
+    [[nodiscard]] std::array<double, kParamCount> parameterStdDev() const;
+    [[nodiscard]] int viewCount() const { return m_viewCount; }
+    [[nodiscard]] bool isReady() const { return m_ready; }
+
+private:
+    bool m_ready {false};
+    BoardSpec m_spec;
+    cv::Size m_imageSize;
+    cv::Matx33d m_cameraMatrix;
+    cv::Mat m_distCoeffs; // k1, k2, p1, p2, k3
+    double m_pixelSigma {0.25};
+    std::vector<cv::Point3f> m_objectPoints;
+    cv::Point3d m_boardCentre;
+    std::vector<double> m_observedDepths;
+    InfoMatrix m_information;
+    int m_viewCount {0};
+
+    [[nodiscard]] double nominalDepth() const;
+    bool nominalPose(int row, int col, int gridRows, int gridCols, const CaptureTilt &tilt,
+                     cv::Vec3d &rvec, cv::Vec3d &tvec) const;
+    bool viewInformation(const std::vector<cv::Point3f> &objectPoints,
+                         const cv::Vec3d &rvec,
+                         const cv::Vec3d &tvec,
+                         InfoMatrix &information) const;
+};
+
+} // namespace mycalib
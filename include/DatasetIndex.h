@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+namespace mycalib {
+
+// Live index of the calibration images in one directory, shared by the GUI and
+// CalibrationEngine. The initial scan runs on the thread pool. Watcher events are
+// coalesced into one background rescan that is diffed against the index, and
+// files the application writes itself are added directly. Queries never touch
+// the file system. The extension policy is ImageLoader::isSupportedImage().
+class DatasetIndex : public QObject {
+    Q_OBJECT
+
+public:
+    explicit DatasetIndex(QObject *parent = nullptr);
+    ~DatasetIndex() override;
+
+    // Starts tracking directory; an empty path stops tracking. Re-setting the
+    // current directory is a no-op.
+    void setDirectory(const QString &directory);
+    [[nodiscard]] QString directory() const { return m_directory; }
+
+    // False until the first scan of the current directory has landed.
+    [[nodiscard]] bool isReady() const { return m_ready; }
+    [[nodiscard]] int count() const { return static_cast<int>(m_files.size()); }
+    // Sorted absolute paths; implicitly shared, so copying is O(1).
+    [[nodiscard]] QStringList files() const { return m_files; }
+    // True when directory is the tracked one (after cleaning) and the index is ready.
+    [[nodiscard]] bool covers(const QString &directory) const;
+
+    // For files the application itself writes into the directory; avoids waiting
+    // for the watcher round trip.
+    void noteFileAdded(const QString &path);
+
+Q_SIGNALS:
+    // Emitted when the indexed file set changes, including the first scan.
+    void changed(int count);
+
+private:
+    void scheduleRescan();
+    void startScan();
+    void applyScan(const QStringList &files);
+
+    QString m_directory;
+    QStringList m_files;
+    bool m_ready {false};
+    bool m_rescanPending {false};
+    quint64 m_generation {0};
+    QFileSystemWatcher *m_watcher {nullptr};
+    QTimer *m_debounce {nullptr};
+    QFutureWatcher<QStringList> *m_scan {nullptr};
+    quint64 m_scanGeneration {0};
+};
+
+} // namespace mycalib
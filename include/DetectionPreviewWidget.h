@@ -17,6 +17,8 @@ class QVBoxLayout;
 
 namespace mycalib {
 
+class ThumbnailCache;
+
 class DetectionPreviewWidget : public QWidget {
     Q_OBJECT
 
@@ -24,7 +26,11 @@ public:
     explicit DetectionPreviewWidget(QWidget *parent = nullptr);
 
     void clear();
-    void setDetection(const DetectionResult &result);
+    // sourcePath, when known, adds the original image as a view.
+    void setDetection(const DetectionResult &result, const QString &sourcePath = QString());
+    // Not owned. Views are then served from cached pyramid levels, and the files
+    // themselves are only decoded once the zoom reaches 1:1.
+    void setThumbnailCache(ThumbnailCache *cache) { m_thumbnails = cache; }
 
 protected:
     void resizeEvent(QResizeEvent *event) override;
@@ -40,11 +46,16 @@ private Q_SLOTS:
 private:
     struct ViewItem {
         QString title;
-        QImage image;
+        QString filePath;      // empty for generated views
+        bool sourceImage {false}; // decoded like the pipeline does (raw formats, 16-bit)
+        QImage image;          // best resolution loaded so far
+        QSize fullSize;        // resolution of filePath once known
+        bool fullyLoaded {false};
     };
 
     void rebuildStageList();
     void updateImage();
+    bool ensureResolution(ViewItem &view, int longSide);
     static QImage matToQImage(const cv::Mat &mat);
     void setInfoText(const DetectionResult &result);
     void applyScale(double factor);
@@ -67,6 +78,8 @@ private:
     std::vector<ViewItem> m_views;
     int m_currentIndex {-1};
     QPixmap m_originalPixmap;
+    qint64 m_pixmapImageKey {0};
+    ThumbnailCache *m_thumbnails {nullptr};
     double m_scaleFactor {1.0};
     bool m_fitToWindow {true};
 };
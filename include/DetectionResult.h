@@ -26,8 +26,14 @@ struct DetectionResult {
     std::vector<float> circleRadiiPx;
     std::vector<float> bigCircleRadiiPx;
     int bigCircleCount {0};
+    double sharpness {0.0}; // variance of the Laplacian over the board bounding box
     std::optional<std::vector<int>> inlierIndices;
     int iterationRemoved {0};
+    // Solver diagnostics, populated after calibration: share of the intrinsics
+    // information this view carries and Cook's distance of dropping it.
+    double leverage {0.0};
+    double influence {0.0};
+    bool validationOnly {false}; // held out of the solve by view selection
 
     // Cached scalar metrics, populated when detailed residual vectors are unavailable.
     double cachedMeanErrorPx {-1.0};
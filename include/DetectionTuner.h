@@ -0,0 +1,61 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include "BoardDetector.h"
+#include "BoardSpec.h"
+
+namespace mycalib {
+
+struct DetectionTuningOptions {
+    int sampleSize {16};         // images drawn evenly from the dataset
+    int rounds {6};              // round 0 explores globally, later rounds refine the best
+    int candidatesPerRound {12};
+    unsigned int seed {0x5EEDu}; // fixed so a rerun proposes the same candidates
+};
+
+struct DetectionTuningResult {
+    bool success {false};
+    QString message;
+    DetectionConfig config;
+    int sampleSize {0};
+    int evaluated {0}; // candidate configs scored, baseline included
+    int baselineDetected {0};
+    double baselineMeanMs {0.0};
+    int detected {0};
+    double meanMs {0.0};
+};
+
+// Searches the detector's tunable thresholds on a sample of the dataset. Each
+// sampled image is decoded once and shared by every candidate; a round's
+// candidate x image detections run across the global thread pool. Candidates
+// rank by images detected, then by mean detection time. The starting config is
+// always scored first, so the result is never worse on the sample.
+class DetectionTuner {
+public:
+    DetectionTuner(const BoardSpec &spec,
+                   const DetectionConfig &baseline,
+                   const DetectionTuningOptions &options = {});
+
+    // shouldAbort is polled between rounds.
+    DetectionTuningResult tune(const std::vector<std::string> &paths,
+                               const std::function<bool()> &shouldAbort = {}) const;
+
+private:
+    BoardSpec m_spec;
+    DetectionConfig m_baseline;
+    DetectionTuningOptions m_options;
+};
+
+// Project-level detection profile: every DetectionConfig threshold as JSON. Fields
+// missing from the file keep the value already in config. warpFreeDetection and
+// writeDebugImages are left out: they choose the pipeline and its outputs per run
+// (--warp-free, debug exports), and a saved profile must not switch them silently.
+bool saveDetectionProfile(const QString &path, const DetectionConfig &config, QString *errorMessage = nullptr);
+bool loadDetectionProfile(const QString &path, DetectionConfig &config, QString *errorMessage = nullptr);
+
+} // namespace mycalib
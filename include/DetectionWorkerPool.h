@@ -0,0 +1,49 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <QString>
+
+#include "BoardDetector.h"
+#include "BoardSpec.h"
+#include "DetectionResult.h"
+
+namespace mycalib {
+
+// Runs CalibrationEngine::detectImage in child processes so a crash or OOM inside
+// the decoder or OpenCV takes down one worker, not the batch. Each worker is this
+// executable started with kWorkerArgument. Paths go down its stdin and results
+// come back on its stdout as length-prefixed QDataStream frames; the workers'
+// log output stays on stderr. A worker that dies or exceeds the per-image timeout
+// is restarted and its image is reported as failed.
+class DetectionWorkerPool {
+public:
+    static constexpr const char *kWorkerArgument = "--detect-worker";
+
+    // program defaults to the running executable.
+    DetectionWorkerPool(const BoardSpec &spec,
+                        const DetectionConfig &config,
+                        int workerCount,
+                        const QString &program = QString());
+
+    // Detects every path; results come back in input order. shouldAbort is polled
+    // while waiting on workers, which are killed when it returns true.
+    // onResult(index, result) runs on the pool's threads as each image lands.
+    std::vector<DetectionResult> detect(const std::vector<std::string> &paths,
+                                        const std::function<bool()> &shouldAbort = {},
+                                        const std::function<void(size_t, const DetectionResult &)> &onResult = {}) const;
+
+    // Entry point of a worker process: serves requests on stdin until it closes.
+    // Needs a QCoreApplication. Returns the process exit code.
+    static int serveWorker();
+
+private:
+    BoardSpec m_spec;
+    DetectionConfig m_config;
+    int m_workerCount {1};
+    QString m_program;
+};
+
+} // namespace mycalib
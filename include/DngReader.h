@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+#include <opencv2/core.hpp>
+
+namespace mycalib {
+
+struct DngDecodeOptions {
+    bool halfResolution {false}; // one gray pixel per 2x2 CFA cell instead of one per photosite
+    bool keep16Bit {false};      // CV_16U over the full 16-bit range instead of CV_8U
+};
+
+// Decodes the raw image of a DNG / TIFF-EP file straight from a memory map into a
+// single output Mat. Handles CFA and single-sample LinearRaw data stored in strips
+// or tiles, uncompressed (1-16 bits per sample) or lossless JPEG (compression 7).
+// LinearizationTable, BlackLevel and WhiteLevel are applied and each CFA colour is
+// balanced by AsShotNeutral, so the mosaic reads as a gray image of the scene.
+// Returns an empty Mat for anything else (lossy DNG, floating point, planar
+// colour); error, when given, says why. sensorSize, when given, receives the
+// full-resolution size also in halfResolution mode.
+[[nodiscard]] cv::Mat decodeDng(const std::string &path,
+                                const DngDecodeOptions &options = DngDecodeOptions(),
+                                std::string *error = nullptr,
+                                cv::Size *sensorSize = nullptr);
+
+} // namespace mycalib
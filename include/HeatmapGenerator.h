@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include <opencv2/core.hpp>
@@ -9,27 +11,87 @@
 namespace mycalib {
 struct CalibrationMetrics;
 
+enum class HeatmapField {
+    BoardCoverage,
+    PixelError,
+    BoardError,
+    Distortion
+};
+
+// Colourized renders keyed by field and target size. Entries are held weakly so a
+// render only lives as long as a view or exporter keeps a reference to it.
+class HeatmapRenderCache {
+public:
+    [[nodiscard]] std::shared_ptr<const cv::Mat> find(HeatmapField field, const cv::Size &size);
+    void store(HeatmapField field, const cv::Size &size, const std::shared_ptr<const cv::Mat> &image);
+
+private:
+    struct Entry {
+        HeatmapField field;
+        cv::Size size;
+        std::weak_ptr<const cv::Mat> image;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_entries;
+};
+
+// Scalar fields are stored at grid resolution (long side <= HeatmapGenerator::kFieldMaxDim)
+// so the bundle size does not depend on the sensor resolution. Colour images are
+// produced on demand through render().
+struct HeatmapBundle {
+    cv::Size imageSize {0, 0};
+    cv::Mat boardCoverageScalar;
+    cv::Mat pixelErrorScalar;
+    cv::Mat boardErrorScalar;
+    cv::Mat distortionScalar;
+    cv::Mat distortionVectors;
+    cv::Mat residualScatter;
+    std::vector<std::vector<cv::Point2f>> distortionGrid;
+    double boardCoverageMin {0.0};
+    double boardCoverageMax {1.0};
+    double pixelErrorMin {0.0};
+    double pixelErrorMax {1.0};
+    double boardErrorMin {0.0};
+    double boardErrorMax {1.0};
+    double residualScatterMax {0.0};
+    double distortionMin {0.0};
+    double distortionMax {0.0};
+    std::shared_ptr<HeatmapRenderCache> renderCache;
+
+    [[nodiscard]] const cv::Mat &scalarField(HeatmapField field) const;
+    [[nodiscard]] bool hasField(HeatmapField field) const { return !scalarField(field).empty(); }
+    [[nodiscard]] std::shared_ptr<const cv::Mat> render(HeatmapField field, const cv::Size &targetSize) const;
+};
+
 class HeatmapGenerator {
 public:
+    static constexpr int kFieldMaxDim = 256;
+
     HeatmapGenerator() = default;
 
+    [[nodiscard]] static cv::Size fieldSizeFor(const cv::Size &imageSize);
+    [[nodiscard]] static cv::Mat renderField(const cv::Mat &field, const cv::Size &targetSize);
+
+    [[nodiscard]] HeatmapBundle buildBundle(const std::vector<DetectionResult> &detections,
+                                            const cv::Mat &cameraMatrix,
+                                            const cv::Mat &distCoeffs,
+                                            const cv::Size &imageSize) const;
+
     [[nodiscard]] cv::Mat buildBoardCoverage(const std::vector<DetectionResult> &detections,
                                              const cv::Size &imageSize,
                                              double *minValue = nullptr,
-                                             double *maxValue = nullptr,
-                                             cv::Mat *rawScalarOut = nullptr) const;
+                                             double *maxValue = nullptr) const;
 
     [[nodiscard]] cv::Mat buildPixelErrorHeatmap(const std::vector<DetectionResult> &detections,
                                                  const cv::Size &imageSize,
                                                  double *minValue = nullptr,
-                                                 double *maxValue = nullptr,
-                                                 cv::Mat *rawScalarOut = nullptr) const;
+                                                 double *maxValue = nullptr) const;
 
     [[nodiscard]] cv::Mat buildBoardErrorHeatmap(const std::vector<DetectionResult> &detections,
                                                  const cv::Size &imageSize,
                                                  double *minValue = nullptr,
-                                                 double *maxValue = nullptr,
-                                                 cv::Mat *rawScalarOut = nullptr) const;
+                                                 double *maxValue = nullptr) const;
 
     [[nodiscard]] cv::Mat buildResidualScatter(const std::vector<DetectionResult> &detections,
                                                double *maxMagnitude = nullptr) const;
@@ -40,11 +102,7 @@ public:
                                                 double *minValue = nullptr,
                                                 double *maxValue = nullptr,
                                                 std::vector<std::vector<cv::Point2f>> *gridLines = nullptr,
-                                                cv::Mat *rawScalarOut = nullptr,
                                                 cv::Mat *vectorFieldOut = nullptr) const;
-
-private:
-    static cv::Mat renderHeatmapFromHistogram(const cv::Mat &histogram, const cv::Size &targetSize);
 };
 
 } // namespace mycalib
@@ -27,9 +27,15 @@ protected:
 
 private:
     QString formatValue(double value) const;
+    void buildMipChain();
+    const QImage &scaledHeatmap(const QSize &target);
 
     QString m_title;
     QImage m_heatmap;
+    // m_heatmap halved repeatedly, built once per setHeatmap(); paints resample the
+    // smallest level still at least the target size instead of the full image.
+    QVector<QImage> m_mipChain;
+    QImage m_scaledCache; // last painted size, reused until the size or image changes
     double m_minValue {0.0};
     double m_maxValue {1.0};
     QString m_legendLabel;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -7,13 +8,37 @@
 
 namespace mycalib {
 
+struct ReducedImage {
+    cv::Mat image;      // 8-bit gray at 1/factor of the full resolution
+    int factor {1};
+    cv::Size fullSize;
+};
+
 class ImageLoader {
 public:
     ImageLoader() = default;
 
+    // The one extension policy for calibration images (png, jpg/jpeg, bmp, tif/tiff,
+    // dng), matched case-insensitively on the file name or path.
+    [[nodiscard]] static bool isSupportedImage(const std::string &path);
+
     [[nodiscard]] std::vector<std::string> gatherImageFiles(const std::string &directory) const;
 
-    [[nodiscard]] cv::Mat loadImage(const std::string &path) const;
+    // 8-bit gray by default (raw DNG scaled by its white level, other formats
+    // through OpenCV's conversion); keep16Bit returns CV_16U for 16-bit sources
+    // and raw DNG.
+    [[nodiscard]] cv::Mat loadImage(const std::string &path, bool keep16Bit = false) const;
+
+    // JPEG: decodes at 1/2, 1/4 or 1/8 scale in the DCT domain, picking the
+    // smallest scale whose short side stays >= minShortSide. Raw DNG: bins each
+    // 2x2 CFA cell into one gray pixel (factor 2). Empty for other formats, JPEGs
+    // that need EXIF rotation, CFAs other than 2x2, and images already small.
+    [[nodiscard]] std::optional<ReducedImage> loadReduced(const std::string &path, int minShortSide) const;
+
+    // Full-resolution gray decode of region only. The JPEG decoder stops after the
+    // region's last row and skips colour conversion outside it; other formats,
+    // raw DNG included, are decoded whole and cropped.
+    [[nodiscard]] cv::Mat loadRegion(const std::string &path, const cv::Rect &region) const;
 };
 
 } // namespace mycalib
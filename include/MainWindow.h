@@ -2,16 +2,20 @@
 
 #include <array>
 #include <memory>
+#include <vector>
 
 #include <QDateTime>
 #include <QJsonArray>
 #include <QJsonObject>
 #include <QMainWindow>
 #include <QPointer>
+#include <QSet>
 #include <QString>
+#include <QUuid>
 #include <QVector>
 
 #include "CalibrationEngine.h"
+#include "CaptureGuidance.h"
 #include "ProjectSession.h"
 
 #ifndef MYCALIB_HAVE_CONNECTED_CAMERA
@@ -23,6 +27,7 @@ class QLabel;
 class QComboBox;
 class QLineEdit;
 class QProgressBar;
+class QTimer;
 class QPushButton;
 class QSplitter;
 class QTextEdit;
@@ -40,17 +45,19 @@ class QScrollArea;
 class QStackedLayout;
 class QStackedWidget;
 class QTabWidget;
-class QFileSystemWatcher;
 class QToolBar;
 class QTabWidget;
 class QVBoxLayout;
 class QTableWidget;
 class QDialog;
+class QFutureWatcherBase;
 
 class CameraWindow;
 
 namespace mycalib {
 
+class DatasetIndex;
+class ThumbnailCache;
 class HeatmapView;
 class ResidualScatterView;
 class Pose3DView;
@@ -73,6 +80,7 @@ public:
 
 private Q_SLOTS:
     void runCalibration();
+    void tuneDetection();
     void resetUi();
     void exportJson();
     void showParameters();
@@ -110,12 +118,12 @@ private Q_SLOTS:
     void handleCameraStreamingChanged(bool streaming);
 #endif
 
-    void handleProgress(int processed, int total);
+    void pollProgress();
     void handleStatus(const QString &message);
     void handleFinished(const CalibrationOutput &output);
     void handleFailed(const QString &reason, const CalibrationOutput &details);
     void handleDetectionSelectionChanged();
-    void handleInputDirectoryChanged(const QString &path);
+    void handleInputDirectoryChanged(int count);
     void handleTuningItemActivated(QTreeWidgetItem *item, int column);
     void markCameraTuningCompleted();
     void openTuningFolder();
@@ -132,10 +140,10 @@ private:
     void updateCaptureFeedback(const CalibrationOutput &output);
     void showHeatmaps(const CalibrationOutput &output);
     void regenerateHeatmaps(CalibrationOutput &output);
-    bool reloadHeatmapsFromDisk(const QString &outputDir, HeatmapBundle *bundle) const;
     void showDetectionPreview(const QString &name);
     void updateDetectionDetailPanel(const DetectionResult *result);
     const DetectionResult *findDetection(const QString &name) const;
+    QString sourceImagePath(const QString &name) const;
     void refreshState(bool running);
     void appendLog(QtMsgType type, const QString &message);
     void ensurePoseView();
@@ -177,6 +185,9 @@ private:
     void refreshCapturePoseButtons();
     void updateCaptureOverlay();
     void recomputeCellQuality();
+    void syncCaptureGuidance(const QVector<ProjectSession::CaptureShot> &pendingShots);
+    void updateCaptureRecommendation();
+    void updateCapturePlanSummary();
     void showCaptureCellDetails(int row, int col);
     void handleCapturePlanToggled(bool enabled);
     void handleCaptureGridSelection(int id);
@@ -196,6 +207,8 @@ private:
     void syncCameraActions();
     void updateModeExplainer();
     void updateInputSummary();
+    CalibrationEngine::Settings calibrationSettings() const;
+    QString detectionProfilePath() const;
     void updateRunAvailability();
     void updateLaserStageUi();
     int countImageFiles(const QString &directory) const;
@@ -220,6 +233,7 @@ private:
     QAction *m_actionImportImages {nullptr};
     QAction *m_toolbarPrimarySeparator {nullptr};
     QAction *m_actionRun {nullptr};
+    QAction *m_actionTuneDetection {nullptr};
     QAction *m_actionExport {nullptr};
     QAction *m_actionShowParameters {nullptr};
     QAction *m_actionEvaluate {nullptr};
@@ -238,6 +252,7 @@ private:
     QLabel *m_modeDescription {nullptr};
     QLabel *m_inputStatusLabel {nullptr};
     QProgressBar *m_progressBar {nullptr};
+    QTimer *m_progressTimer {nullptr};
     QTextEdit *m_logView {nullptr};
     QTreeWidget *m_detectionTree {nullptr};
     QGroupBox *m_stageTuningBox {nullptr};
@@ -272,6 +287,9 @@ private:
     HeatmapView *m_heatmapPixel {nullptr};
     ResidualScatterView *m_scatterView {nullptr};
     HeatmapView *m_distortionMap {nullptr};
+    // Renders behind the heatmap views. HeatmapRenderCache only holds them weakly,
+    // so these references are what let a repaint of the same output reuse them.
+    std::vector<std::shared_ptr<const cv::Mat>> m_shownHeatmapRenders;
     QLabel *m_detectionMetaLabel {nullptr};
     QLabel *m_detectionResidualMmLabel {nullptr};
     QLabel *m_detectionResidualPercentLabel {nullptr};
@@ -315,6 +333,13 @@ private:
     int m_captureSelectedCol {0};
     ProjectSession::CapturePose m_captureSelectedPose {ProjectSession::CapturePose::Flat};
     QVector<ProjectSession::CaptureShot> m_datasetDerivedShots;
+    CaptureGuidance m_captureGuidance;
+    CaptureRecommendation m_captureRecommendation;
+    // Set whenever m_lastOutput changes; the guidance is rebuilt from the new
+    // calibration and otherwise only gains the nominal views of new shots.
+    bool m_captureGuidanceStale {true};
+    cv::Size m_captureGuidanceImageSize;
+    QSet<QUuid> m_captureGuidanceShots;
     struct CellSampleInfo {
         QString displayName;
         QString key;
@@ -390,6 +415,9 @@ private:
     QLabel *m_metricMeanResidualPercent {nullptr};
 
     QPointer<CalibrationEngine> m_engine;
+    // Set while detection tuning runs; the tune action then stops it.
+    std::shared_ptr<RunControl> m_detectionTuningControl;
+    QPointer<QFutureWatcherBase> m_detectionTuningWatcher;
     QPointer<ImageEvaluationDialog> m_evaluationDialog;
     CalibrationOutput m_lastOutput;
     bool m_lastOutputFromSnapshot {false};
@@ -399,7 +427,8 @@ private:
     int m_lastLogRepeat {0};
     int m_lastSortColumn {0};
     Qt::SortOrder m_lastSortOrder {Qt::AscendingOrder};
-    QFileSystemWatcher *m_inputWatcher {nullptr};
+    DatasetIndex *m_inputIndex {nullptr};
+    std::unique_ptr<ThumbnailCache> m_thumbnails;
     int m_lastInputImageCount {0};
 
 #if MYCALIB_HAVE_CONNECTED_CAMERA
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <functional>
 #include <vector>
 
@@ -26,6 +27,7 @@ private:
     };
 
     static void exportScalarFieldFigure(const cv::Mat &field,
+                                        const cv::Size &imageSize,
                                         double minValue,
                                         double maxValue,
                                         const QString &title,
@@ -43,6 +45,7 @@ private:
 
     static void drawScalarField(QPainter &painter,
                                 const cv::Mat &field,
+                                const cv::Size &imageSize,
                                 double minValue,
                                 double maxValue,
                                 const QString &title,
@@ -65,6 +68,10 @@ private:
     static QColor colorForMap(ScalarColormap map, double t);
 
     static QColor blendTowardsWhite(const QColor &color, double weight);
+
+    // Heat-map colours per map, white blend included, indexed by t * (size - 1).
+    static constexpr int kScalarLutSize = 1024;
+    static const std::array<QRgb, kScalarLutSize> &scalarLut(ScalarColormap map);
     static void writeSvgAndPng(const QString &fileBasePath,
                                const std::function<void(QPainter &)> &drawFunction);
 };
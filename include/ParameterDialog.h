@@ -21,12 +21,14 @@ private:
     enum class SnippetStyle {
         Python,
         Cpp,
+        Runtime,
         PlainText
     };
 
     void refreshPreview();
     QString buildPythonSnippet() const;
     QString buildCppSnippet() const;
+    QString buildRuntimeSnippet() const;
     QString buildPlainSnippet() const;
     QString formatDouble(double value, int precision = 8) const;
 
@@ -91,6 +91,7 @@ public:
         DataSource dataSource {DataSource::LocalDataset};
         QString cameraVendor;
         QString cameraModel;
+        QString boardLayout; // BoardSpec layout key; empty selects the default board
         StageState cameraTuning;
         StageState calibrationCapture;
         StageState laserCalibration;
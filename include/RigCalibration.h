@@ -0,0 +1,71 @@
+#pragma once
+
+#include <vector>
+
+#include <QString>
+
+#include <opencv2/core.hpp>
+
+#include "CalibrationEngine.h"
+
+namespace mycalib {
+
+struct RigCameraInput {
+    QString name;      // used for the per-camera output sub-directory and the report
+    QString directory; // images of this camera
+};
+
+enum class RigMatchMode {
+    FileName,  // synchronized shots share a file stem across camera directories
+    Timestamp  // shots are paired by file modification time within a tolerance
+};
+
+struct RigSettings {
+    CalibrationEngine::Settings calibration;
+    RigMatchMode matchMode {RigMatchMode::FileName};
+    int timestampToleranceMs {20};
+};
+
+struct RigCameraResult {
+    QString name;
+    QString directory;
+    int images {0};
+    CalibrationOutput calibration;
+};
+
+// Pose of camera `camera` relative to camera `reference`: X_camera = rotation * X_reference + translationMm.
+struct RigExtrinsics {
+    bool valid {false};
+    int camera {0};
+    int reference {0};
+    int frames {0}; // synchronized frames with the board solved in both cameras
+    double rmsPx {0.0};
+    cv::Matx33d rotation = cv::Matx33d::eye();
+    cv::Vec3d translationMm {0.0, 0.0, 0.0};
+    // RMS deviation of the per-frame relative poses from the joint estimate.
+    double rotationSpreadDeg {0.0};
+    double translationSpreadMm {0.0};
+};
+
+struct RigCalibrationOutput {
+    bool success {false};
+    QString message;
+    int matchedFrames {0};
+    std::vector<RigCameraResult> cameras;
+    std::vector<RigExtrinsics> extrinsics; // one per camera after the first, relative to camera 0
+};
+
+// Calibrates a 2-4 camera rig in one pass: every image of every camera is detected
+// once in a shared thread pool, the intrinsics of each camera are solved
+// concurrently from those detections, and the camera-to-reference extrinsics are
+// refined jointly over the synchronized frames with the intrinsics held fixed.
+// Per-camera artefacts land in <output>/<camera name>/, the rig summary in
+// <output>/rig_report.json.
+class RigCalibrator {
+public:
+    RigCalibrationOutput run(const std::vector<RigCameraInput> &cameras,
+                             const RigSettings &settings,
+                             const QString &outputDirectory) const;
+};
+
+} // namespace mycalib
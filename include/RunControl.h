@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+namespace mycalib {
+
+// Live state of one calibration run, shared by the pipeline threads and whoever
+// watches them. Workers bump relaxed atomics and observers sample snapshot() on a
+// timer, so nothing is queued per image. The cancel flag is polled by the
+// pipeline between steps and, through WorkerScope, by the detector inside its
+// long stages.
+class RunControl {
+public:
+    enum class Stage : int {
+        Idle,
+        Collecting,
+        Detecting,
+        Calibrating,
+        Filtering,
+        Validating,
+        Reporting
+    };
+
+    enum class WorkerStage : int {
+        Idle,
+        Decoding,
+        LocatingBoard,
+        Rectifying,
+        FindingCircles,
+        Numbering,
+        Refining
+    };
+
+    static constexpr int kMaxWorkers = 16;
+
+    struct Snapshot {
+        Stage stage {Stage::Idle};
+        int total {0};
+        int processed {0};
+        int failed {0};
+        std::array<WorkerStage, kMaxWorkers> workers {};
+        int busyWorkers {0};
+    };
+
+    // Binds the calling thread to a free worker slot and to this run's cancel
+    // flag until destroyed. When every slot is taken only the flag is bound.
+    class WorkerScope {
+    public:
+        explicit WorkerScope(RunControl &control);
+        ~WorkerScope();
+
+        WorkerScope(const WorkerScope &) = delete;
+        WorkerScope &operator=(const WorkerScope &) = delete;
+
+    private:
+        RunControl &m_control;
+        int m_slot {-1};
+        RunControl *m_previousControl {nullptr};
+        int m_previousSlot {-1};
+    };
+
+    RunControl();
+
+    // Clears counters and the cancel flag for a new run.
+    void reset();
+    void setStage(Stage stage);
+    void setTotal(int total);
+    void finishItem(bool success);
+    void requestCancel();
+    [[nodiscard]] bool cancelRequested() const;
+    [[nodiscard]] Snapshot snapshot() const;
+
+    // Hooks for code running under a WorkerScope; no-ops on any other thread.
+    static void markWorker(WorkerStage stage);
+    [[nodiscard]] static bool cancelled();
+
+private:
+    static constexpr int kFreeSlot = -1;
+
+    std::atomic<int> m_stage {static_cast<int>(Stage::Idle)};
+    std::atomic<int> m_total {0};
+    std::atomic<int> m_processed {0};
+    std::atomic<int> m_failed {0};
+    std::atomic_bool m_cancel {false};
+    std::array<std::atomic<int>, kMaxWorkers> m_workers; // WorkerStage, or kFreeSlot
+};
+
+} // namespace mycalib
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+
+#include <opencv2/core.hpp>
+
+namespace mycalib {
+
+// Project-level preview cache. Each image gets a pyramid of downscaled levels
+// (long side 1024 halving down to 128), JPEG-coded and stored back to back in one
+// packed atlas file; a small index maps source path -> levels. The atlas is
+// memory-mapped on open, so a lookup is a hash probe plus decoding one small
+// level straight out of the map, and never touches the source. Levels are built
+// from pixels a caller has already decoded (the detector's input, a preview the
+// GUI just loaded). All methods are thread-safe.
+class ThumbnailCache {
+public:
+    struct Hit {
+        QImage image;     // null on a miss
+        QSize sourceSize; // full resolution of the source file
+    };
+
+    static constexpr int kTopLevelLongSide = 1024;
+    static constexpr int kBottomLevelLongSide = 128;
+
+    // Opens (or starts) the cache stored in directory.
+    explicit ThumbnailCache(const QString &directory);
+    // Waits for queued work and flushes.
+    ~ThumbnailCache();
+
+    ThumbnailCache(const ThumbnailCache &) = delete;
+    ThumbnailCache &operator=(const ThumbnailCache &) = delete;
+
+    // Builds the pyramid for path from pixels (8- or 16-bit, 1, 3 or 4 channels).
+    // sourceSize is the file's full resolution when pixels is a reduced decode.
+    // Skipped when an entry at least as detailed exists for the unchanged file.
+    void insert(const QString &path, const cv::Mat &pixels, const cv::Size &sourceSize = cv::Size());
+    // Same, but the pyramid is built on the cache's own pool and this returns at once.
+    void insertAsync(const QString &path, const cv::Mat &pixels, const cv::Size &sourceSize = cv::Size());
+
+    // The smallest level whose long side reaches longSide. Misses when the path is
+    // unknown, the file changed since it was cached, or longSide is above the
+    // largest level (unless that level is the source itself).
+    [[nodiscard]] Hit lookup(const QString &path, int longSide) const;
+
+    // Forgets entries whose file was deleted or changed, appends new levels to the
+    // atlas and rewrites the index; compacts the atlas once superseded levels
+    // outweigh live ones.
+    bool flush();
+
+private:
+    struct Level {
+        int width {0};
+        int height {0};
+        qint64 offset {-1}; // into the atlas; -1 while the level is only in pending
+        qint64 length {0};
+        QByteArray pending; // encoded bytes until flushed
+    };
+
+    struct Entry {
+        qint64 fileSize {0};
+        qint64 modifiedMs {0};
+        QSize sourceSize;
+        QVector<Level> levels; // largest first
+    };
+
+    bool loadIndex();
+    bool writeIndex(const QString &atlasName, const QHash<QString, Entry> &entries) const;
+    bool appendPending();
+    bool compact();
+    // Stats every cached file (without holding the mutex) and drops the entries
+    // whose file is gone or changed; their levels count as superseded.
+    void dropStaleEntries();
+    void mapAtlas();
+    void unmapAtlas();
+    [[nodiscard]] bool isCurrent(const QString &key, int topLongSide) const;
+    [[nodiscard]] QString filePath(const QString &name) const;
+
+    QString m_directory;
+    QString m_atlasName;
+    QHash<QString, Entry> m_entries;
+    QFile m_atlas;
+    const uchar *m_map {nullptr};
+    qint64 m_mapSize {0};
+    qint64 m_liveBytes {0};
+    qint64 m_deadBytes {0};
+    bool m_dirty {false};
+    mutable QMutex m_mutex;
+    QThreadPool m_pool;
+};
+
+} // namespace mycalib
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+#include "DetectionResult.h"
+
+namespace mycalib {
+
+struct ViewSelectionOptions {
+    int maxViews {150};      // <= 0 disables subsampling
+    int coverageGrid {4};    // image split into coverageGrid x coverageGrid cells
+    double poseWeight {1.0};
+    double coverageWeight {1.0};
+    double sharpnessWeight {0.25};
+};
+
+// Indices into the detection list handed to selectCalibrationViews().
+struct ViewSelection {
+    std::vector<size_t> selected;
+    std::vector<size_t> holdout; // successful views left out of the solve
+};
+
+// Picks a pose- and coverage-diverse subset of the successful detections by greedy
+// farthest-point sampling, biased towards sharper views. Poses come from a quick
+// PnP against initCameraMatrix2D(), so the cost is O(n * maxViews) and independent
+// of the solver. When there are no more than maxViews successful views all of them
+// are selected.
+[[nodiscard]] ViewSelection selectCalibrationViews(const std::vector<DetectionResult> &detections,
+                                                   const cv::Size &imageSize,
+                                                   const ViewSelectionOptions &options = {});
+
+} // namespace mycalib
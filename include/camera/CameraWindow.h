@@ -44,6 +44,7 @@ public:
 	bool isCameraConnected() const { return m_connected; }
 	bool isStreaming() const { return m_streaming; }
 	QVariantMap currentSnapshotMetrics() const;
+	QSize lastFrameSize() const { return m_lastFrame.size(); }
     void setEmbeddedMode(bool embedded);
     bool isEmbeddedMode() const { return m_embeddedMode; }
 	QComboBox* cameraSelector() const { return m_cameraCombo; }
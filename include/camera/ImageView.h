@@ -20,6 +20,8 @@ public:
 	void setGridDimensions(int rows, int cols);
 	void setGridHighlight(int row, int col);
 	void setGridCellCounts(const QVector<QVector<int>> &counts, int maxPerCell);
+	// Next-best-view hint; row/col of -1 clears it.
+	void setGridRecommendation(int row, int col, const QString &label);
 
 Q_SIGNALS:
 	void roiChanged(const QRect& r);
@@ -44,4 +46,7 @@ private:
 	int m_gridHighlightCol { -1 };
 	QVector<QVector<int>> m_gridCellCounts;
 	int m_gridMaxPerCell { 0 };
+	int m_gridRecommendRow { -1 };
+	int m_gridRecommendCol { -1 };
+	QString m_gridRecommendLabel;
 };
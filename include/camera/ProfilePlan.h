@@ -0,0 +1,90 @@
+#pragma once
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <vector>
+
+class QIODevice;
+
+// Camera configuration profiles (Vimba X XML settings files) compiled into a typed
+// write plan. Nothing here touches the Vimba SDK: features are read and written
+// through FeatureBackend, so the planner and executor can be driven by an
+// in-memory backend as well as by a live camera.
+
+enum class ProfileValueType {
+    Int,
+    Float,
+    Bool,
+    Enum,
+    String,
+    Command,
+    Unsupported
+};
+
+struct ProfileSelector {
+    QString name;
+    ProfileValueType type = ProfileValueType::Unsupported;
+    QString value;
+};
+
+struct ProfileEntry {
+    QString name;
+    ProfileValueType type = ProfileValueType::Unsupported;
+    QString value;
+    // Selector values the feature is scoped to, outermost first; empty for plain features.
+    std::vector<ProfileSelector> selectors;
+};
+
+struct ProfilePlan {
+    QString cameraId;
+    QString model;
+    QString sourceFile;
+    int maxIterations = 10; // SettingsStruct/MaxIterations: write passes for dependent features
+    // Write order: plain features, then selector-scoped features grouped by scope,
+    // then the plain writes to selector features so the profile's final selector
+    // state wins.
+    std::vector<ProfileEntry> entries;
+};
+
+struct FeatureState {
+    bool exists = false;
+    bool writable = false;
+    QString value;
+};
+
+class FeatureBackend {
+public:
+    virtual ~FeatureBackend() = default;
+    // Current state of each named feature, in the order of names.
+    virtual std::vector<FeatureState> readFeatures(const QStringList& names) = 0;
+    virtual bool writeFeature(const QString& name, ProfileValueType type, const QString& value, QString* error) = 0;
+};
+
+struct ProfileApplyReport {
+    int total = 0;
+    int written = 0;
+    int unchanged = 0;
+    int failed = 0;
+    int passes = 0;
+    bool cancelled = false;
+    QStringList warnings;
+};
+
+ProfileValueType profileValueTypeFromString(const QString& type);
+// Typed comparison: numeric for Int/Float/Bool, case-insensitive for Enum.
+bool profileValuesEqual(ProfileValueType type, const QString& a, const QString& b);
+
+// Parses the CameraInfo block matching cameraId (any block when cameraId is empty).
+std::optional<ProfilePlan> parseProfilePlan(QIODevice& device, const QString& cameraId, QString* error = nullptr);
+// First *.xml in directory (by name) with a block for cameraId.
+std::optional<ProfilePlan> loadProfilePlan(const QString& directory, const QString& cameraId, QString* error = nullptr);
+
+// Reads current values in batches, writes only the entries that differ and retries
+// failed writes for up to plan.maxIterations passes while they keep making progress.
+// progress(done, total) is called from the calling thread.
+ProfileApplyReport applyProfilePlan(const ProfilePlan& plan,
+                                    FeatureBackend& backend,
+                                    const std::function<void(int, int)>& progress = {},
+                                    const std::atomic_bool* cancel = nullptr);
@@ -3,9 +3,11 @@
 #include <QThread>
 #include <QAtomicInteger>
 #include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QImage>
 #include <QString>
 #include <QStringList>
+#include <atomic>
 #include <optional>
 #include <memory>
 
@@ -41,6 +43,10 @@ VmbCPP::FeaturePtr feature(const char* name);
 std::vector<VmbCPP::FeaturePtr> allFeatures();
 
 bool applyConfigurationProfile(const QString& directory, const QString& cameraId, QString* statusMessage = nullptr);
+// Parses the profile on the calling thread and writes it on a worker; progress and
+// the outcome arrive through profileProgress() / profileApplied().
+bool applyConfigurationProfileAsync(const QString& directory, const QString& cameraId);
+bool isApplyingProfile() const;
 
 VmbCPP::CameraPtr camera() const { return m_cam; }
 
@@ -52,6 +58,8 @@ Q_SIGNALS:
 	void cameraOpened(const QString& id, const QString& model);
 	void cameraClosed();
 	void errorOccured(const QString& msg);
+	void profileProgress(int done, int total);
+	void profileApplied(bool success, const QString& message);
 
 private:
 	VmbCPP::VmbSystem& m_sys;
@@ -64,4 +72,9 @@ private:
 	int64_t m_frameCount = 0;
 	int64_t m_bytesAccum = 0;
 	std::optional<VmbPixelFormatType> m_lastUnsupportedPixelFormat;
+	QFutureWatcher<void>* m_profileWatcher{nullptr};
+	std::atomic_bool m_profileCancel{false};
+
+	void waitForProfile(bool cancel = false);
+	QString resolveProfileCameraId(const QString& cameraId) const;
 };
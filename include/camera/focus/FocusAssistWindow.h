@@ -5,15 +5,16 @@
 #include <QImage>
 #include <QRect>
 #include <QStringList>
-#include <deque>
 
 #include "camera/focus/FocusEvaluator.h"
 
+class FocusHistoryModel;
+class FocusSparkline;
 class QAction;
 class QComboBox;
 class QLabel;
 class QProgressBar;
-class QTableWidget;
+class QTableView;
 class QTextBrowser;
 class ImageView;
 class VimbaController;
@@ -45,17 +46,11 @@ private:
     void refreshCameraList();
     void applyMetrics(const FocusEvaluator::Metrics& metrics);
     void appendHistory(const FocusEvaluator::Metrics& metrics);
-    void updateHistoryTable();
     QStringList buildGuidance(const FocusEvaluator::Metrics& metrics, double previousComposite) const;
     void pushGuidance(const QStringList& lines);
     QRect currentEvaluationRoi(const QImage& source) const;
     void flashStatus(const QString& message, int timeoutMs = 2500);
 
-    struct HistoryEntry {
-        QDateTime timestamp;
-        FocusEvaluator::Metrics metrics;
-    };
-
     VimbaController* m_controller{nullptr};
     FocusEvaluator m_evaluator;
     ImageView* m_view{nullptr};
@@ -78,7 +73,9 @@ private:
     QLabel* m_metricShadow{nullptr};
     QLabel* m_metricComposite{nullptr};
     QProgressBar* m_scoreProgress{nullptr};
-    QTableWidget* m_historyTable{nullptr};
+    QTableView* m_historyTable{nullptr};
+    FocusHistoryModel* m_historyModel{nullptr};
+    FocusSparkline* m_sparkline{nullptr};
     QTextBrowser* m_guidanceBox{nullptr};
 
     bool m_streaming{false};
@@ -88,6 +85,5 @@ private:
     FocusEvaluator::Metrics m_bestMetrics{};
     double m_bestComposite{0.0};
     double m_prevComposite{0.0};
-    std::deque<HistoryEntry> m_history;
     const int m_historyLimit{40};
 };
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QDateTime>
+#include <QString>
+#include <QVector>
+#include <vector>
+
+#include "camera/focus/FocusEvaluator.h"
+
+// Focus metrics history in a fixed-capacity ring buffer, newest entry in row 0.
+// push() reports only the row it inserts and, once full, the oldest row it drops,
+// so attached views update incrementally instead of rebuilding every cell.
+class FocusHistoryModel : public QAbstractTableModel {
+    Q_OBJECT
+public:
+    enum class Field {
+        Time,
+        Score,
+        Laplacian,
+        Tenengrad,
+        HighFrequency, // shown in %
+        Uniformity,    // shown in %
+        Contrast,
+        Mean
+    };
+
+    struct Column {
+        Field field;
+        QString title;
+        int decimals{1};
+    };
+
+    struct Entry {
+        QDateTime timestamp;
+        FocusEvaluator::Metrics metrics;
+    };
+
+    FocusHistoryModel(const QVector<Column>& columns, int capacity, QObject* parent = nullptr);
+
+    void push(const FocusEvaluator::Metrics& metrics, const QDateTime& timestamp = QDateTime::currentDateTime());
+    void clear();
+
+    int size() const { return m_count; }
+    int capacity() const { return static_cast<int>(m_ring.size()); }
+    bool isEmpty() const { return m_count == 0; }
+    // row 0 is the newest entry.
+    const Entry& entry(int row) const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    QVector<Column> m_columns;
+    std::vector<Entry> m_ring;
+    int m_head{-1}; // slot of the newest entry
+    int m_count{0};
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QPointer>
+#include <QWidget>
+
+class FocusHistoryModel;
+
+// Composite-score trend drawn straight from a FocusHistoryModel's ring buffer,
+// oldest entry on the left; repaints when the model changes.
+class FocusSparkline : public QWidget {
+    Q_OBJECT
+public:
+    explicit FocusSparkline(QWidget* parent = nullptr);
+
+    void setModel(FocusHistoryModel* model);
+    // Dashed reference line (e.g. the best score); <= 0 hides it.
+    void setReferenceValue(double value);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    QPointer<FocusHistoryModel> m_model;
+    double m_reference{0.0};
+};
@@ -4,14 +4,15 @@
 #include <QFrame>
 #include <QVariantMap>
 #include <QVector>
-#include <deque>
 
 #include "camera/focus/FocusEvaluator.h"
 
+class FocusHistoryModel;
+class FocusSparkline;
 class QLabel;
 class QProgressBar;
 class QPushButton;
-class QTableWidget;
+class QTableView;
 class QTextBrowser;
 
 class FocusSummaryPanel : public QFrame {
@@ -35,15 +36,10 @@ private Q_SLOTS:
     void handleResetBaseline();
 
 private:
-    struct HistoryEntry {
-        QDateTime timestamp;
-        FocusEvaluator::Metrics metrics;
-    };
-
     void buildUi();
     void applyMetrics(const FocusEvaluator::Metrics& metrics);
     void pushHistory(const FocusEvaluator::Metrics& metrics);
-    void refreshHistoryTable();
+    void clearHistory();
     void updateButtons();
     void updateGuidance(const FocusEvaluator::Metrics& metrics, double previousScore);
     QStringList buildGuidanceLines(const FocusEvaluator::Metrics& metrics, double previousScore) const;
@@ -63,7 +59,9 @@ private:
     QProgressBar* m_scoreProgress{nullptr};
     QPushButton* m_markBestButton{nullptr};
     QPushButton* m_resetBaselineButton{nullptr};
-    QTableWidget* m_historyTable{nullptr};
+    QTableView* m_historyTable{nullptr};
+    FocusHistoryModel* m_historyModel{nullptr};
+    FocusSparkline* m_sparkline{nullptr};
     QTextBrowser* m_guidanceBox{nullptr};
 
     FocusEvaluator::Metrics m_lastMetrics{};
@@ -71,7 +69,6 @@ private:
     double m_bestComposite{0.0};
     double m_previousComposite{0.0};
     bool m_hasBaseline{false};
-    std::deque<HistoryEntry> m_history;
     const int m_historyLimit{40};
     QSize m_lastFrameSize;
     QRect m_lastRoi;
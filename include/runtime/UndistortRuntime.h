@@ -0,0 +1,82 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+// Standalone undistortion runtime for deployed stations. Depends on OpenCV core,
+// imgproc and calib3d only (no Qt), so it links into inspection software without
+// the rest of the calibration tool.
+
+namespace mycalib {
+
+struct UndistortCalibration {
+    cv::Mat cameraMatrix; // 3x3 CV_64F
+    cv::Mat distCoeffs;   // 1xN CV_64F, N in {4, 5, 8, 12, 14}
+    cv::Size imageSize;
+};
+
+// The runtime's own input file, written by every run next to the report. It holds
+// only camera_matrix, distortion_coefficients and image_size as plain number
+// arrays, so it never carries the nulls QJsonDocument writes for NaN / inf in the
+// full calibration_report.json.
+inline constexpr const char *kCalibrationFileName = "undistort_calibration.json";
+
+// Empty on failure (missing keys, non-finite values, a distortion count outside
+// {4, 5, 8, 12, 14}); error, when given, says why.
+[[nodiscard]] std::optional<UndistortCalibration> loadCalibration(const std::string &path,
+                                                                  std::string *error = nullptr);
+bool saveCalibration(const std::string &path, const UndistortCalibration &calibration, std::string *error = nullptr);
+
+// Precomputed undistortion table in OpenCV's fixed-point remap format: per output
+// pixel a CV_16SC2 integer source position and a CV_16UC1 index into the 32x32
+// bilinear weight table. cv::remap runs its vectorized fixed-point path on it, with
+// no per-frame float math. The output keeps the calibrated camera matrix.
+//
+// save() writes the table as a flat file (header, then both planes 64-byte
+// aligned); open() memory-maps it and points the planes straight at the mapping,
+// so a station starts without recomputing the table or copying it.
+class UndistortMap {
+public:
+    static constexpr const char *kFileName = "undistort_map.bin";
+
+    UndistortMap();
+    ~UndistortMap();
+    UndistortMap(UndistortMap &&) noexcept;
+    UndistortMap &operator=(UndistortMap &&) noexcept;
+    UndistortMap(const UndistortMap &) = delete;
+    UndistortMap &operator=(const UndistortMap &) = delete;
+
+    [[nodiscard]] static UndistortMap build(const UndistortCalibration &calibration);
+    [[nodiscard]] static std::optional<UndistortMap> open(const std::string &path, std::string *error = nullptr);
+    bool save(const std::string &path, std::string *error = nullptr) const;
+
+    [[nodiscard]] bool isValid() const { return !m_xy.empty(); }
+    [[nodiscard]] const UndistortCalibration &calibration() const { return m_calibration; }
+    [[nodiscard]] cv::Size imageSize() const { return m_calibration.imageSize; }
+
+    // Undistorts a full frame of imageSize(), any depth and channel count cv::remap accepts.
+    void remap(const cv::Mat &src, cv::Mat &dst, int borderMode = cv::BORDER_CONSTANT) const;
+    // Produces only roi of the undistorted frame (dst is roi.size()); src is still the
+    // full distorted frame, since an output ROI samples from a wider input area.
+    void remap(const cv::Mat &src, cv::Mat &dst, const cv::Rect &roi, int borderMode = cv::BORDER_CONSTANT) const;
+    // The distorted-frame rectangle that roi samples from, for callers that only
+    // acquire or decode part of the sensor.
+    [[nodiscard]] cv::Rect sourceRect(const cv::Rect &roi) const;
+
+    // Distorted pixel positions to undistorted pixel positions in the same camera matrix.
+    void undistortPoints(const std::vector<cv::Point2f> &distorted, std::vector<cv::Point2f> &undistorted) const;
+
+private:
+    struct Mapping;
+
+    UndistortCalibration m_calibration;
+    cv::Mat m_xy;       // CV_16SC2
+    cv::Mat m_fraction; // CV_16UC1
+    std::unique_ptr<Mapping> m_mapping; // backs m_xy / m_fraction after open()
+};
+
+} // namespace mycalib
@@ -1,5 +1,6 @@
 #include "BoardDetector.h"
 #include "Logger.h"
+#include "RunControl.h"
 
 #include <algorithm>
 #include <array>
@@ -7,6 +8,7 @@
 #include <chrono>
 #include <cmath>
 #include <cctype>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <filesystem>
@@ -14,15 +16,16 @@
 #include <numeric>
 #include <optional>
 #include <random>
-#include <set>
 #include <sstream>
 #include <utility>
 #include <unordered_set>
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QString>
 #include <QStringList>
 
+#include <opencv2/calib3d.hpp>
 #include <opencv2/core.hpp>
 #include <opencv2/features2d.hpp>
 #include <opencv2/imgcodecs.hpp>
@@ -90,10 +93,11 @@ struct AxisOrientation {
     bool valid {false};
 };
 
-struct KMeans1dResult {
+struct LatticeAssignment {
     bool success {false};
-    std::vector<int> labels;
-    std::vector<float> centers;
+    std::vector<cv::Vec2i> cells; // (col, row), shifted so both start at zero
+    double maxResidual {0.0};
+    std::string message;
 };
 
 AxisOrientation axes_from_big4(const std::vector<RefinedBlob> &big)
@@ -201,114 +205,174 @@ AxisOrientation axes_from_big4(const std::vector<RefinedBlob> &big)
     return axes;
 }
 
-KMeans1dResult kmeans_1d(const std::vector<float> &values, int clusters)
+float median_of(std::vector<float> &values)
 {
-    KMeans1dResult result;
-    if (values.empty() || clusters <= 0) {
-        return result;
-    }
+    const auto mid = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+    std::nth_element(values.begin(), mid, values.end());
+    return *mid;
+}
 
-    cv::Mat samples(static_cast<int>(values.size()), 1, CV_32F);
-    for (size_t i = 0; i < values.size(); ++i) {
-        samples.at<float>(static_cast<int>(i), 0) = values[i];
-    }
+// Assigns every centre an integer lattice cell. The two lattice vectors are the
+// median nearest-neighbour offsets along u and v; an affine fit of that first
+// assignment then absorbs residual shear and scale before the final snap. Runs in
+// O(n^2) for the neighbour search on a few dozen points, with no iterative
+// clustering, so the result is deterministic.
+LatticeAssignment snap_to_lattice(const std::vector<cv::Vec2f> &uv, int cols, int rows)
+{
+    constexpr double kMaxResidual = 0.35;
+    constexpr int kRefineIterations = 2;
 
-    cv::Mat labels;
-    cv::Mat centers;
-    const cv::TermCriteria criteria(cv::TermCriteria::EPS + cv::TermCriteria::MAX_ITER, 200, 1e-4);
-    bool fallback = false;
-    try {
-        cv::kmeans(samples, clusters, labels, criteria, 10, cv::KMEANS_PP_CENTERS, centers);
-        if (centers.rows != clusters) {
-            fallback = true;
-        }
-    } catch (const cv::Exception &) {
-        fallback = true;
+    LatticeAssignment result;
+    const size_t n = uv.size();
+    if (n < 4 || cols <= 0 || rows <= 0) {
+        result.message = "lattice_too_few_points";
+        return result;
     }
 
-    auto run_lloyd = [&](std::vector<float> &centersVec) {
-        const float minValue = *std::min_element(values.begin(), values.end());
-        const float maxValue = *std::max_element(values.begin(), values.end());
-        centersVec.resize(static_cast<size_t>(clusters));
-        if (std::abs(maxValue - minValue) < 1e-6F) {
-            std::fill(centersVec.begin(), centersVec.end(), minValue);
-        } else {
-            const float step = (maxValue - minValue) / static_cast<float>(clusters - 1);
-            for (int k = 0; k < clusters; ++k) {
-                centersVec[static_cast<size_t>(k)] = minValue + step * static_cast<float>(k);
-            }
-        }
-
-        std::vector<int> assign(values.size(), 0);
-        for (int iter = 0; iter < 32; ++iter) {
-            double maxShift = 0.0;
-            for (size_t i = 0; i < values.size(); ++i) {
-                float bestDist = std::numeric_limits<float>::infinity();
-                int bestIdx = 0;
-                for (int k = 0; k < clusters; ++k) {
-                    const float diff = values[i] - centersVec[static_cast<size_t>(k)];
-                    const float dist = std::abs(diff);
-                    if (dist < bestDist) {
-                        bestDist = dist;
-                        bestIdx = k;
-                    }
-                }
-                assign[i] = bestIdx;
-            }
-
-            std::vector<float> newCenters = centersVec;
-            for (int k = 0; k < clusters; ++k) {
-                double sum = 0.0;
-                int count = 0;
-                for (size_t i = 0; i < values.size(); ++i) {
-                    if (assign[i] == k) {
-                        sum += values[i];
-                        ++count;
-                    }
-                }
-                if (count > 0) {
-                    const float updated = static_cast<float>(sum / static_cast<double>(count));
-                    maxShift = std::max(maxShift, static_cast<double>(std::abs(updated - centersVec[static_cast<size_t>(k)])));
-                    newCenters[static_cast<size_t>(k)] = updated;
-                }
+    // Nearest neighbour in each of the two cones |du| >= |dv| and |du| < |dv|, so
+    // an anisotropic pitch still yields offsets for both directions.
+    std::vector<float> colDx, colDy, rowDx, rowDy;
+    colDx.reserve(n);
+    colDy.reserve(n);
+    rowDx.reserve(n);
+    rowDy.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        float bestAlongU = std::numeric_limits<float>::max();
+        float bestAlongV = std::numeric_limits<float>::max();
+        cv::Vec2f offsetU;
+        cv::Vec2f offsetV;
+        for (size_t j = 0; j < n; ++j) {
+            if (i == j) {
+                continue;
             }
-            centersVec = newCenters;
-            if (maxShift < 1e-4) {
-                break;
+            const cv::Vec2f d = uv[j] - uv[i];
+            const float dist2 = d.dot(d);
+            if (std::abs(d[0]) >= std::abs(d[1])) {
+                if (dist2 < bestAlongU) {
+                    bestAlongU = dist2;
+                    offsetU = d[0] < 0.0F ? -d : d;
+                }
+            } else if (dist2 < bestAlongV) {
+                bestAlongV = dist2;
+                offsetV = d[1] < 0.0F ? -d : d;
             }
         }
+        if (bestAlongU < std::numeric_limits<float>::max()) {
+            colDx.push_back(offsetU[0]);
+            colDy.push_back(offsetU[1]);
+        }
+        if (bestAlongV < std::numeric_limits<float>::max()) {
+            rowDx.push_back(offsetV[0]);
+            rowDy.push_back(offsetV[1]);
+        }
+    }
+    if (colDx.empty() || rowDx.empty()) {
+        result.message = "lattice_fit_failed";
+        return result;
+    }
 
-        result.labels = assign;
-        result.centers = centersVec;
-        result.success = true;
+    // Columns of A are the lattice vectors, t the position of cell (0, 0).
+    cv::Matx22d A(median_of(colDx), median_of(rowDx),
+                  median_of(colDy), median_of(rowDy));
+    if (std::abs(cv::determinant(A)) < 1e-6) {
+        result.message = "lattice_fit_failed";
+        return result;
+    }
+
+    std::vector<float> us(n), vs(n);
+    for (size_t i = 0; i < n; ++i) {
+        us[i] = uv[i][0];
+        vs[i] = uv[i][1];
+    }
+    const cv::Vec2f mid(median_of(us), median_of(vs));
+    size_t anchor = 0;
+    float anchorDist = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < n; ++i) {
+        const cv::Vec2f d = uv[i] - mid;
+        if (d.dot(d) < anchorDist) {
+            anchorDist = d.dot(d);
+            anchor = i;
+        }
+    }
+    cv::Vec2d t(uv[anchor][0], uv[anchor][1]);
+
+    std::vector<cv::Vec2i> cells(n);
+    auto snap = [&]() {
+        const cv::Matx22d inv = A.inv();
+        double maxResidual = 0.0;
+        bool changed = false;
+        for (size_t i = 0; i < n; ++i) {
+            const cv::Vec2d q = inv * (cv::Vec2d(uv[i][0], uv[i][1]) - t);
+            const cv::Vec2i cell(static_cast<int>(std::lround(q[0])), static_cast<int>(std::lround(q[1])));
+            maxResidual = std::max({maxResidual, std::abs(q[0] - cell[0]), std::abs(q[1] - cell[1])});
+            changed = changed || cell != cells[i];
+            cells[i] = cell;
+        }
+        result.maxResidual = maxResidual;
+        return changed;
     };
 
-    if (!fallback) {
-        std::vector<float> centersVec(static_cast<size_t>(clusters));
-        for (int r = 0; r < clusters; ++r) {
-            centersVec[static_cast<size_t>(r)] = centers.at<float>(r, 0);
+    snap();
+    for (int iter = 0; iter < kRefineIterations; ++iter) {
+        cv::Mat design(static_cast<int>(n), 3, CV_64F);
+        cv::Mat target(static_cast<int>(n), 2, CV_64F);
+        for (size_t i = 0; i < n; ++i) {
+            const int r = static_cast<int>(i);
+            design.at<double>(r, 0) = cells[i][0];
+            design.at<double>(r, 1) = cells[i][1];
+            design.at<double>(r, 2) = 1.0;
+            target.at<double>(r, 0) = uv[i][0];
+            target.at<double>(r, 1) = uv[i][1];
+        }
+        cv::Mat affine;
+        if (!cv::solve(design, target, affine, cv::DECOMP_SVD)) {
+            break;
         }
-        std::set<float> uniqueCenters;
-        for (float c : centersVec) {
-            uniqueCenters.insert(std::round(c * 1e4F) / 1e4F);
+        const cv::Matx22d refined(affine.at<double>(0, 0), affine.at<double>(1, 0),
+                                  affine.at<double>(0, 1), affine.at<double>(1, 1));
+        if (std::abs(cv::determinant(refined)) < 1e-6) {
+            break;
         }
-        if (static_cast<int>(uniqueCenters.size()) < clusters) {
-            fallback = true;
-        } else {
-            result.labels.resize(values.size());
-            for (int i = 0; i < labels.rows; ++i) {
-                result.labels[static_cast<size_t>(i)] = labels.at<int>(i, 0);
-            }
-            result.centers = std::move(centersVec);
-            result.success = true;
+        A = refined;
+        t = cv::Vec2d(affine.at<double>(2, 0), affine.at<double>(2, 1));
+        if (!snap()) {
+            break;
         }
     }
 
-    if (fallback) {
-        std::vector<float> centersVec;
-        run_lloyd(centersVec);
+    int minCol = std::numeric_limits<int>::max();
+    int maxCol = std::numeric_limits<int>::min();
+    int minRow = std::numeric_limits<int>::max();
+    int maxRow = std::numeric_limits<int>::min();
+    for (const auto &cell : cells) {
+        minCol = std::min(minCol, cell[0]);
+        maxCol = std::max(maxCol, cell[0]);
+        minRow = std::min(minRow, cell[1]);
+        maxRow = std::max(maxRow, cell[1]);
+    }
+    if (maxCol - minCol != cols - 1 || maxRow - minRow != rows - 1) {
+        result.message = "lattice_extent_mismatch";
+        return result;
+    }
+
+    std::vector<unsigned char> occupied(static_cast<size_t>(cols * rows), 0);
+    for (auto &cell : cells) {
+        cell -= cv::Vec2i(minCol, minRow);
+        auto &slot = occupied[static_cast<size_t>(cell[1] * cols + cell[0])];
+        if (slot != 0) {
+            result.message = "lattice_collision";
+            return result;
+        }
+        slot = 1;
+    }
+
+    if (result.maxResidual > kMaxResidual) {
+        result.message = "lattice_residual";
+        return result;
     }
 
+    result.cells = std::move(cells);
+    result.success = true;
     return result;
 }
 
@@ -447,6 +511,50 @@ cv::Mat ensure_gray(const cv::Mat &input) {
     return gray;
 }
 
+// Non-8-bit input is stretched rather than saturated, so dark linear data keeps
+// its contrast. 16-bit input maps its 0.1% / 99.9% percentiles to 0 / 255, so a
+// few hot or dead pixels cannot compress the rest of the range.
+cv::Mat to_gray_8u(const cv::Mat &gray) {
+    if (gray.type() == CV_8UC1) {
+        return gray;
+    }
+    cv::Mat converted;
+    if (gray.type() == CV_16UC1) {
+        std::vector<int> histogram(65536, 0);
+        for (int y = 0; y < gray.rows; ++y) {
+            const auto *row = gray.ptr<std::uint16_t>(y);
+            for (int x = 0; x < gray.cols; ++x) {
+                ++histogram[row[x]];
+            }
+        }
+        const std::int64_t total = static_cast<std::int64_t>(gray.total());
+        const std::int64_t tail = total / 1000;
+        int low = 0;
+        for (std::int64_t seen = histogram[0]; low < 65535 && seen <= tail; seen += histogram[++low]) {
+        }
+        int high = 65535;
+        for (std::int64_t seen = histogram[65535]; high > 0 && seen <= tail; seen += histogram[--high]) {
+        }
+        if (high <= low) {
+            gray.convertTo(converted, CV_8UC1, 1.0 / 257.0);
+            return converted;
+        }
+        const double scale = 255.0 / (high - low);
+        gray.convertTo(converted, CV_8UC1, scale, -low * scale);
+        return converted;
+    }
+    double minVal = 0.0;
+    double maxVal = 0.0;
+    cv::minMaxLoc(gray, &minVal, &maxVal);
+    if (!std::isfinite(minVal) || !std::isfinite(maxVal) || maxVal - minVal < 1e-6) {
+        gray.convertTo(converted, CV_8UC1);
+        return converted;
+    }
+    const double scale = 255.0 / (maxVal - minVal);
+    gray.convertTo(converted, CV_8UC1, scale, -minVal * scale);
+    return converted;
+}
+
 cv::Mat ensure_color_8u(const cv::Mat &input)
 {
     if (input.empty()) {
@@ -829,7 +937,8 @@ std::optional<std::array<Point2, 4>> expand_quad(const std::array<Point2, 4> &qu
     return expanded;
 }
 
-WarpResult warp_quad(const cv::Mat &image, const std::array<Point2, 4> &quad, const DetectionConfig &cfg) {
+// Rectified board frame of the expanded quad at its native resolution (no upscale).
+WarpResult rectified_frame(const std::array<Point2, 4> &quad, const DetectionConfig &cfg, cv::Size *size) {
     auto ordered = order_quad(quad);
     const double widthA = cv::norm(ordered[1] - ordered[0]);
     const double widthB = cv::norm(ordered[2] - ordered[3]);
@@ -848,12 +957,33 @@ WarpResult warp_quad(const cv::Mat &image, const std::array<Point2, 4> &quad, co
         Point2{0, static_cast<float>(dstH - 1)}
     };
 
-    cv::Mat H = cv::getPerspectiveTransform(ordered, dst);
+    WarpResult result;
+    result.homography = cv::getPerspectiveTransform(ordered, dst);
+    *size = cv::Size(dstW, dstH);
+    return result;
+}
+
+bool invert_warp(WarpResult &result) {
+    cv::Mat Hinv;
+    if (result.homography.empty() || cv::invert(result.homography, Hinv, cv::DECOMP_LU) == 0) {
+        result.homography.release();
+        result.homographyInv.release();
+        result.image.release();
+        return false;
+    }
+    result.homographyInv = Hinv;
+    return true;
+}
+
+WarpResult warp_quad(const cv::Mat &image, const std::array<Point2, 4> &quad, const DetectionConfig &cfg) {
+    cv::Size dstSize;
+    WarpResult result = rectified_frame(quad, cfg, &dstSize);
+    cv::Mat H = result.homography;
 
     cv::Mat warped;
-    cv::warpPerspective(image, warped, H, cv::Size(dstW, dstH));
+    cv::warpPerspective(image, warped, H, dstSize);
 
-    const int shortDim = std::min(dstW, dstH);
+    const int shortDim = std::min(dstSize.width, dstSize.height);
     if (shortDim < cfg.warpMinShort && shortDim > 0) {
         const double scale = static_cast<double>(cfg.warpMinShort) / static_cast<double>(shortDim);
         cv::resize(warped, warped, cv::Size(), scale, scale, cv::INTER_CUBIC);
@@ -861,17 +991,9 @@ WarpResult warp_quad(const cv::Mat &image, const std::array<Point2, 4> &quad, co
         H = scaleMat * H;
     }
 
-    WarpResult result;
     result.image = warped;
     result.homography = H;
-    cv::Mat Hinv;
-    if (cv::invert(H, Hinv, cv::DECOMP_LU) == 0) {
-        result.homography.release();
-        result.homographyInv.release();
-        result.image.release();
-        return result;
-    }
-    result.homographyInv = Hinv;
+    invert_warp(result);
     return result;
 }
 
@@ -930,6 +1052,33 @@ double bilinear_sample(const cv::Mat &gray, const Point2 &pt) {
     return w00 * v00 + w10 * v10 + w01 * v01 + w11 * v11;
 }
 
+// Hard-fail limits of quad_score() on margin, area and aspect, evaluated without
+// sampling edges or logging; used to drop enumeration candidates before scoring.
+bool quad_geometry_rejected(const PointVec &ordered, double area, int rows, int cols, const DetectionConfig &cfg) {
+    const double relaxedMarginX = cfg.quadMargin * cols * 3.0 + 12.0;
+    const double relaxedMarginY = cfg.quadMargin * rows * 3.0 + 12.0;
+    const double marginX = cfg.quadMargin * cols;
+    const double marginY = cfg.quadMargin * rows;
+    for (const auto &p : ordered) {
+        const double overflowX = p.x < marginX ? marginX - p.x : (p.x > cols - marginX ? p.x - (cols - marginX) : 0.0);
+        const double overflowY = p.y < marginY ? marginY - p.y : (p.y > rows - marginY ? p.y - (rows - marginY) : 0.0);
+        if (overflowX > relaxedMarginX || overflowY > relaxedMarginY) {
+            return true;
+        }
+    }
+
+    const double totalArea = static_cast<double>(rows * cols);
+    if (area < cfg.quadAreaMinRatio * totalArea * 0.15 || area > cfg.quadAreaMaxRatio * totalArea * 1.6) {
+        return true;
+    }
+
+    const double meanWidth = 0.5 * (cv::norm(ordered[1] - ordered[0]) + cv::norm(ordered[2] - ordered[3]));
+    const double meanHeight = 0.5 * (cv::norm(ordered[3] - ordered[0]) + cv::norm(ordered[2] - ordered[1]));
+    const double ratio = meanWidth > meanHeight ? (meanWidth / std::max(1.0, meanHeight))
+                                                : (meanHeight / std::max(1.0, meanWidth));
+    return ratio < cfg.quadAspectMin * 0.7 || ratio > cfg.quadAspectMax * 1.5;
+}
+
 std::vector<QuadCandidate> detect_quads_from_segments(const cv::Mat &gray, const std::vector<cv::Vec4f> &segments, const DetectionConfig &cfg) {
     if (segments.size() < 4) {
         return {};
@@ -996,63 +1145,122 @@ std::vector<QuadCandidate> detect_quads_from_segments(const cv::Mat &gray, const
         return {};
     }
 
-    std::vector<QuadCandidate> candidates;
-    const auto try_pairs = [&](const std::vector<NormalLine> &g0, const std::vector<NormalLine> &g1) {
-        for (size_t i = 0; i < g0.size(); ++i) {
-            for (size_t j = i + 1; j < g0.size(); ++j) {
-                if (deg_diff(line_angle_deg(g0[i]), line_angle_deg(g0[j])) > cfg.houghOrientationTol) {
+    // Each quad is one pair of near-parallel lines from each group; enumerating
+    // group 0 x group 1 once covers every quad (the swapped order yields the same
+    // corners). Pairs carry their gap, so pairs of pairs whose side lengths cannot
+    // satisfy the area / aspect limits are never formed.
+    struct LinePair {
+        size_t a {0};
+        size_t b {0};
+        double gap {0.0};
+    };
+    const auto make_pairs = [&](const std::vector<NormalLine> &lines, std::vector<double> &angles) {
+        angles.resize(lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            angles[i] = line_angle_deg(lines[i]);
+        }
+        std::vector<LinePair> pairs;
+        for (size_t i = 0; i < lines.size(); ++i) {
+            for (size_t j = i + 1; j < lines.size(); ++j) {
+                if (deg_diff(angles[i], angles[j]) > cfg.houghOrientationTol) {
                     continue;
                 }
-                for (size_t k = 0; k < g1.size(); ++k) {
-                    for (size_t l = k + 1; l < g1.size(); ++l) {
-                        if (deg_diff(line_angle_deg(g1[k]), line_angle_deg(g1[l])) > cfg.houghOrientationTol) {
-                            continue;
-                        }
-                        const double ortho = std::abs(deg_diff(line_angle_deg(g0[i]), line_angle_deg(g1[k])) - 90.0);
-                        if (ortho > cfg.houghOrthogonalityTol) {
-                            continue;
-                        }
-                        std::array<std::optional<Point2>, 4> ptsOpt {
-                            intersect_lines(g0[i], g1[k]),
-                            intersect_lines(g0[j], g1[k]),
-                            intersect_lines(g0[j], g1[l]),
-                            intersect_lines(g0[i], g1[l])
-                        };
-                        bool ok = true;
-                        std::array<Point2, 4> pts {};
-                        for (int idx = 0; idx < 4; ++idx) {
-                            if (!ptsOpt[idx]) {
-                                ok = false;
-                                break;
-                            }
-                            pts[static_cast<size_t>(idx)] = *ptsOpt[idx];
-                        }
-                        if (!ok) {
-                            continue;
-                        }
-                        auto ordered = order_quad(pts);
-                        double area = std::abs(cv::contourArea(ordered));
-                        if (area < 50.0) {
-                            continue;
-                        }
-                        double score = quad_score(gray, pts, cfg);
-                        if (score <= -1e8) {
-                            continue;
-                        }
-                        candidates.push_back({pts, score, area});
-                    }
-                }
+                const cv::Vec4f &seg = lines[j].segment;
+                const double mx = 0.5 * (seg[0] + seg[2]);
+                const double my = 0.5 * (seg[1] + seg[3]);
+                const double gap = std::abs(lines[i].nx * mx + lines[i].ny * my + lines[i].c);
+                pairs.push_back({i, j, gap});
             }
         }
+        std::sort(pairs.begin(), pairs.end(), [](const LinePair &lhs, const LinePair &rhs) {
+            return lhs.gap < rhs.gap;
+        });
+        return pairs;
     };
+    std::array<std::vector<double>, 2> angles;
+    const auto pairs0 = make_pairs(groups[0], angles[0]);
+    const auto pairs1 = make_pairs(groups[1], angles[1]);
+
+    // Midpoint gaps only approximate the side lengths of a quad whose lines are up
+    // to houghOrientationTol off parallel, hence the slack on the bounds.
+    constexpr double kGapSlack = 2.0;
+    const double totalArea = static_cast<double>(gray.rows) * gray.cols;
+    const double areaLo = std::max(50.0, cfg.quadAreaMinRatio * 0.15 * totalArea) / (kGapSlack * kGapSlack);
+    const double areaHi = cfg.quadAreaMaxRatio * 1.6 * totalArea * kGapSlack * kGapSlack;
+    const double aspectHi = std::max(cfg.quadAspectMax * 1.5, 1.0) * kGapSlack * kGapSlack;
+
+    const size_t topK = static_cast<size_t>(std::max(1, cfg.houghQuadTopK));
+    const auto worse = [](const QuadCandidate &lhs, const QuadCandidate &rhs) {
+        return lhs.score > rhs.score;
+    };
+    std::vector<QuadCandidate> heap; // min-heap on score holding the best topK
+    heap.reserve(topK + 1);
 
-    try_pairs(groups[0], groups[1]);
-    try_pairs(groups[1], groups[0]);
+    for (const auto &p0 : pairs0) {
+        if (RunControl::cancelled()) {
+            return {};
+        }
+        if (p0.gap < 1e-6) {
+            continue;
+        }
+        const double lo = std::max(p0.gap / aspectHi, areaLo / p0.gap);
+        const double hi = std::min(p0.gap * aspectHi, areaHi / p0.gap);
+        if (lo > hi) {
+            continue;
+        }
+        auto it = std::lower_bound(pairs1.begin(), pairs1.end(), lo, [](const LinePair &pair, double value) {
+            return pair.gap < value;
+        });
+        for (; it != pairs1.end() && it->gap <= hi; ++it) {
+            const NormalLine &l0 = groups[0][p0.a];
+            const NormalLine &l1 = groups[0][p0.b];
+            const NormalLine &m0 = groups[1][it->a];
+            const NormalLine &m1 = groups[1][it->b];
+            const double ortho = std::abs(deg_diff(angles[0][p0.a], angles[1][it->a]) - 90.0);
+            if (ortho > cfg.houghOrthogonalityTol) {
+                continue;
+            }
+            std::array<std::optional<Point2>, 4> ptsOpt {
+                intersect_lines(l0, m0),
+                intersect_lines(l1, m0),
+                intersect_lines(l1, m1),
+                intersect_lines(l0, m1)
+            };
+            bool ok = true;
+            std::array<Point2, 4> pts {};
+            for (int idx = 0; idx < 4; ++idx) {
+                if (!ptsOpt[idx]) {
+                    ok = false;
+                    break;
+                }
+                pts[static_cast<size_t>(idx)] = *ptsOpt[idx];
+            }
+            if (!ok) {
+                continue;
+            }
+            const auto ordered = order_quad(pts);
+            const double area = std::abs(cv::contourArea(ordered));
+            if (area < 50.0 || quad_geometry_rejected(ordered, area, gray.rows, gray.cols, cfg)) {
+                continue;
+            }
+            const double score = quad_score(gray, pts, cfg);
+            if (score <= -1e8) {
+                continue;
+            }
+            if (heap.size() == topK && score <= heap.front().score) {
+                continue;
+            }
+            heap.push_back({pts, score, area});
+            std::push_heap(heap.begin(), heap.end(), worse);
+            if (heap.size() > topK) {
+                std::pop_heap(heap.begin(), heap.end(), worse);
+                heap.pop_back();
+            }
+        }
+    }
 
-    std::sort(candidates.begin(), candidates.end(), [](const auto &lhs, const auto &rhs) {
-        return lhs.score > rhs.score;
-    });
-    return candidates;
+    std::sort_heap(heap.begin(), heap.end(), worse);
+    return heap;
 }
 
 bool quad_within_image(const std::array<Point2, 4> &quad, int rows, int cols, double marginRatio) {
@@ -1480,6 +1688,9 @@ std::optional<QuadCandidate> detect_quad(const cv::Mat &gray, const DetectionCon
         whiteMaskDebug->release();
     }
 
+    if (RunControl::cancelled()) {
+        return std::nullopt;
+    }
     if (auto hough = detect_by_hough_search(gray, cfg)) {
         consider(*hough, best);
     }
@@ -1549,6 +1760,193 @@ BlobSet detect_blobs(const cv::Mat &input, const DetectionConfig &cfg) {
     return opened;
 }
 
+// Dual-conic ellipse fit on the image gradient (Ouellet & Hebert). Every gradient
+// in an annulus around the blob edge gives a line near-tangent to the ellipse; the
+// dual conic C* minimizing sum |g|^2 (l^T C* l)^2 comes out of a 5x5 linear
+// system, and the image of the circle centre is C* times the vanishing line.
+constexpr int kConicMaxSamples = 64;       // samples per window side; larger windows are strided
+constexpr double kConicInnerRatio = 0.45;  // gradient annulus, in blob radii
+constexpr double kConicOuterRatio = 1.6;
+constexpr int kConicIterations = 2;        // the second pass re-centres the annulus
+// A fit outside this range of the expected radius locked onto something else.
+constexpr double kConicMinRadiusRatio = 0.5;
+constexpr double kConicMaxRadiusRatio = 2.0;
+
+struct ConicFit {
+    cv::Point2d center;  // image of the circle centre
+    double radius {0.0}; // geometric mean of the ellipse semi-axes
+};
+
+// In-place Cholesky solve of a 5x5 symmetric positive definite system.
+bool solve_spd5(double (&m)[5][5], double (&b)[5]) {
+    for (int j = 0; j < 5; ++j) {
+        double d = m[j][j];
+        for (int k = 0; k < j; ++k) {
+            d -= m[j][k] * m[j][k];
+        }
+        if (!(d > 1e-12)) {
+            return false;
+        }
+        m[j][j] = std::sqrt(d);
+        for (int i = j + 1; i < 5; ++i) {
+            double s = m[i][j];
+            for (int k = 0; k < j; ++k) {
+                s -= m[i][k] * m[j][k];
+            }
+            m[i][j] = s / m[j][j];
+        }
+    }
+    for (int i = 0; i < 5; ++i) {
+        double s = b[i];
+        for (int k = 0; k < i; ++k) {
+            s -= m[i][k] * b[k];
+        }
+        b[i] = s / m[i][i];
+    }
+    for (int i = 4; i >= 0; --i) {
+        double s = b[i];
+        for (int k = i + 1; k < 5; ++k) {
+            s -= m[k][i] * b[k];
+        }
+        b[i] = s / m[i][i];
+    }
+    return true;
+}
+
+// gray must be 8-bit. vanishingLine is the image of the board's line at infinity;
+// (0, 0, 1) when gray is already fronto-parallel. The window is capped at
+// maxHalfWindow pixels. Runs on the stack only: rows are read in place and the
+// normal equations are accumulated in registers.
+std::optional<ConicFit> fit_dual_conic(const cv::Mat &gray,
+                                       const cv::Point2d &seed,
+                                       double radiusPx,
+                                       const cv::Vec3d &vanishingLine,
+                                       double maxHalfWindow) {
+    if (gray.type() != CV_8UC1 || !(radiusPx >= 1.0)) {
+        return std::nullopt;
+    }
+    const double half = std::min(kConicOuterRatio * radiusPx + 2.0, maxHalfWindow);
+    const int stride = std::max(1, static_cast<int>(std::ceil(2.0 * half / kConicMaxSamples)));
+    const int halfSamples = static_cast<int>(std::ceil(half / stride));
+    const float inner2 = static_cast<float>(kConicInnerRatio * kConicInnerRatio);
+    const float outer2 = static_cast<float>(kConicOuterRatio * kConicOuterRatio);
+    const float invRadius = static_cast<float>(1.0 / radiusPx);
+
+    cv::Point2d center = seed;
+    std::optional<ConicFit> fit;
+    for (int iteration = 0; iteration < kConicIterations; ++iteration) {
+        const int cx = cvRound(center.x);
+        const int cy = cvRound(center.y);
+        const int reach = (halfSamples + 1) * stride;
+        if (cx - reach < 0 || cy - reach < 0 || cx + reach >= gray.cols || cy + reach >= gray.rows) {
+            return fit;
+        }
+        // Coordinates are relative to the current centre in units of the radius,
+        // which keeps the normal equations well conditioned.
+        const auto ox = static_cast<float>(center.x);
+        const auto oy = static_cast<float>(center.y);
+        double normal[5][5] = {};
+        double rhs[5] = {};
+        for (int j = -halfSamples; j <= halfSamples; ++j) {
+            const int y = cy + j * stride;
+            const uchar *up = gray.ptr<uchar>(y - stride);
+            const uchar *mid = gray.ptr<uchar>(y);
+            const uchar *down = gray.ptr<uchar>(y + stride);
+            const float yn = (static_cast<float>(y) - oy) * invRadius;
+            // Per-row partial sums stay in float so the inner loop vectorizes.
+            float s[20] = {};
+            for (int i = -halfSamples; i <= halfSamples; ++i) {
+                const int x = cx + i * stride;
+                const float gx = static_cast<float>((up[x + stride] - up[x - stride]) + 2 * (mid[x + stride] - mid[x - stride]) +
+                                                    (down[x + stride] - down[x - stride]));
+                const float gy = static_cast<float>((down[x - stride] + 2 * down[x] + down[x + stride]) -
+                                                    (up[x - stride] + 2 * up[x] + up[x + stride]));
+                const float xn = (static_cast<float>(x) - ox) * invRadius;
+                const float d2 = xn * xn + yn * yn;
+                const float g2 = gx * gx + gy * gy;
+                const float w = (d2 >= inner2 && d2 <= outer2 && g2 > 1.0F) ? g2 : 0.0F;
+                const float invNorm = 1.0F / std::sqrt(std::max(g2, 1.0F));
+                const float a = gx * invNorm;
+                const float b = gy * invNorm;
+                const float c = -(a * xn + b * yn);
+                const float k0 = a * a;
+                const float k1 = a * b;
+                const float k2 = b * b;
+                const float k3 = a * c;
+                const float k4 = b * c;
+                const float r = -c * c;
+                s[0] += w * k0 * k0;
+                s[1] += w * k0 * k1;
+                s[2] += w * k0 * k2;
+                s[3] += w * k0 * k3;
+                s[4] += w * k0 * k4;
+                s[5] += w * k1 * k1;
+                s[6] += w * k1 * k2;
+                s[7] += w * k1 * k3;
+                s[8] += w * k1 * k4;
+                s[9] += w * k2 * k2;
+                s[10] += w * k2 * k3;
+                s[11] += w * k2 * k4;
+                s[12] += w * k3 * k3;
+                s[13] += w * k3 * k4;
+                s[14] += w * k4 * k4;
+                s[15] += w * k0 * r;
+                s[16] += w * k1 * r;
+                s[17] += w * k2 * r;
+                s[18] += w * k3 * r;
+                s[19] += w * k4 * r;
+            }
+            int idx = 0;
+            for (int p = 0; p < 5; ++p) {
+                for (int q = p; q < 5; ++q) {
+                    normal[q][p] = (normal[p][q] += s[idx++]);
+                }
+            }
+            for (int p = 0; p < 5; ++p) {
+                rhs[p] += s[15 + p];
+            }
+        }
+        if (!solve_spd5(normal, rhs)) {
+            return fit;
+        }
+
+        // Dual conic with F = 1: [[A, B/2, D/2], [B/2, C, E/2], [D/2, E/2, 1]].
+        const double A = rhs[0];
+        const double B = rhs[1] * 0.5;
+        const double C = rhs[2];
+        const double D = rhs[3] * 0.5;
+        const double E = rhs[4] * 0.5;
+        // The ellipse centre is (D, E); its shape matrix (semi-axes^2 as eigenvalues)
+        // is centre * centre^T minus the upper-left block.
+        const double qxx = D * D - A;
+        const double qxy = D * E - B;
+        const double qyy = E * E - C;
+        const double det = qxx * qyy - qxy * qxy;
+        if (!(qxx > 0.0) || !(det > 0.0)) {
+            return fit;
+        }
+        // Vanishing line in the normalized frame, then its pole.
+        const double r = radiusPx;
+        const cv::Vec3d l(vanishingLine[0] * r, vanishingLine[1] * r,
+                          vanishingLine[0] * center.x + vanishingLine[1] * center.y + vanishingLine[2]);
+        const double px = A * l[0] + B * l[1] + D * l[2];
+        const double py = B * l[0] + C * l[1] + E * l[2];
+        const double pw = D * l[0] + E * l[1] + l[2];
+        if (!(std::abs(pw) > 1e-12)) {
+            return fit;
+        }
+        ConicFit next;
+        next.center = cv::Point2d(center.x + r * px / pw, center.y + r * py / pw);
+        next.radius = r * std::pow(det, 0.25);
+        if (!std::isfinite(next.center.x) || !std::isfinite(next.center.y) || !std::isfinite(next.radius)) {
+            return fit;
+        }
+        fit = next;
+        center = next.center;
+    }
+    return fit;
+}
+
 std::optional<RefinedBlob> refine_blob(const cv::Mat &gray, const BlobCandidate &blob, const DetectionConfig &cfg) {
     const Point2 seed = blob.keypoint.pt;
     const double seedRadius = std::max(1.0f, blob.keypoint.size * 0.5f);
@@ -1562,54 +1960,22 @@ std::optional<RefinedBlob> refine_blob(const cv::Mat &gray, const BlobCandidate
         return fallback;
     };
 
-    double winSize = std::clamp(seedRadius * cfg.refineWinScale, cfg.refineWinMin, cfg.refineWinMax);
-    cv::Rect roi(static_cast<int>(std::round(seed.x - winSize * 0.5)),
-                 static_cast<int>(std::round(seed.y - winSize * 0.5)),
-                 static_cast<int>(std::round(winSize)),
-                 static_cast<int>(std::round(winSize)));
-    roi &= cv::Rect(0, 0, gray.cols, gray.rows);
-    if (roi.width <= 6 || roi.height <= 6) {
-        return make_default(0.2);
-    }
-
-    cv::Mat patch = gray(roi).clone();
-    if (patch.empty()) {
-        return make_default(0.2);
-    }
-
-    cv::GaussianBlur(patch, patch, cv::Size(0, 0), 1.0);
-
-    cv::Mat thresh;
-    cv::threshold(patch, thresh, 0, 255, cv::THRESH_BINARY_INV + cv::THRESH_OTSU);
-
-    std::vector<std::vector<cv::Point>> contours;
-    cv::findContours(thresh, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_SIMPLE);
-    if (contours.empty()) {
+    // gray is the rectified board, so the line at infinity stays at infinity.
+    const double winSize = std::clamp(seedRadius * cfg.refineWinScale, cfg.refineWinMin, cfg.refineWinMax);
+    const auto fit = fit_dual_conic(gray, seed, seedRadius, cv::Vec3d(0.0, 0.0, 1.0), 0.5 * winSize);
+    if (!fit) {
         return make_default(0.3);
     }
 
-    auto largestIt = std::max_element(contours.begin(), contours.end(), [](const auto &a, const auto &b) {
-        return cv::contourArea(a) < cv::contourArea(b);
-    });
-    double area = std::max(0.0, cv::contourArea(*largestIt));
-    if (area < 5.0) {
-        return make_default(0.3);
-    }
-
-    cv::Moments m = cv::moments(*largestIt);
-    if (std::abs(m.m00) < 1e-6) {
-        return make_default(0.3);
-    }
-
-    Point2 localCenter(static_cast<float>(m.m10 / m.m00), static_cast<float>(m.m01 / m.m00));
-    Point2 refined {localCenter.x + static_cast<float>(roi.x), localCenter.y + static_cast<float>(roi.y)};
-
     RefinedBlob result = make_default(0.4);
+    const Point2 refined(static_cast<float>(fit->center.x), static_cast<float>(fit->center.y));
     const double shift = cv::norm(refined - seed);
-    if (shift <= seedRadius * std::max(1.0, cfg.refineGate)) {
+    const double radiusRatio = fit->radius / seedRadius;
+    if (shift <= seedRadius * std::max(1.0, cfg.refineGate) &&
+        radiusRatio >= kConicMinRadiusRatio && radiusRatio <= kConicMaxRadiusRatio) {
         result.center = refined;
-        result.radius = std::sqrt(std::max(area / CV_PI, 1.0));
-        result.area = std::max(area, 1.0);
+        result.radius = fit->radius;
+        result.area = CV_PI * fit->radius * fit->radius;
         result.score = 1.0;
     }
 
@@ -1617,7 +1983,7 @@ std::optional<RefinedBlob> refine_blob(const cv::Mat &gray, const BlobCandidate
 }
 
 BlobSet refine_blobs(const cv::Mat &gray, BlobSet blobs, const DetectionConfig &cfg) {
-    for (size_t i = 0; i < blobs.raw.size(); ++i) {
+    for (size_t i = 0; i < blobs.raw.size() && !RunControl::cancelled(); ++i) {
         blobs.refined[i] = refine_blob(gray, blobs.raw[i], cfg);
     }
     return blobs;
@@ -1780,18 +2146,19 @@ SizeClusterResult classify_blob_sizes(const std::vector<BlobCandidate> &blobs)
     return result;
 }
 
-NumberingResult number_circles(const std::vector<RefinedBlob> &smalls,
-                               const std::vector<RefinedBlob> &bigs,
-                               const cv::Size &rectSize,
-                               const BoardSpec &spec)
+template <typename Layout>
+NumberingResult number_circles_for(const std::vector<RefinedBlob> &smalls,
+                                   const std::vector<RefinedBlob> &bigs,
+                                   const cv::Size &rectSize)
 {
-    const int expected = static_cast<int>(spec.expectedCircleCount());
+    using Traits = BoardLayoutTraits<Layout>;
+    constexpr int expected = Traits::kCircleCount;
     if (static_cast<int>(smalls.size()) != expected) {
         return {false, {}, {}, "circle count mismatch"};
     }
 
-    constexpr int kRows = 7;
-    const std::array<int, kRows> expectedRowSizes {6, 6, 6, 5, 6, 6, 6};
+    constexpr int kRows = Traits::kRows;
+    const auto &expectedRowSizes = Traits::kRowSizes;
 
     auto axes = axes_from_big4(bigs);
     if (!axes.valid) {
@@ -1801,195 +2168,30 @@ NumberingResult number_circles(const std::vector<RefinedBlob> &smalls,
         axes.yHat = cv::Vec2f(0.0F, 1.0F);
     }
 
-    std::vector<float> u(smalls.size(), 0.0F);
-    std::vector<float> v(smalls.size(), 0.0F);
+    std::vector<cv::Vec2f> uv(smalls.size());
     for (size_t i = 0; i < smalls.size(); ++i) {
         const cv::Vec2f rel = smalls[i].center - axes.origin;
-        u[i] = rel[0] * axes.xHat[0] + rel[1] * axes.xHat[1];
-        v[i] = rel[0] * axes.yHat[0] + rel[1] * axes.yHat[1];
-    }
-
-    const auto km = kmeans_1d(v, kRows);
-    if (!km.success) {
-        Logger::warning(QStringLiteral("number_circles: kmeans failed, unable to cluster rows"));
-        return {false, {}, {}, "kmeans_failed"};
+        uv[i] = cv::Vec2f(rel[0] * axes.xHat[0] + rel[1] * axes.xHat[1],
+                          rel[0] * axes.yHat[0] + rel[1] * axes.yHat[1]);
     }
 
-    std::vector<int> order(kRows);
-    std::iota(order.begin(), order.end(), 0);
-    std::sort(order.begin(), order.end(), [&](int lhs, int rhs) {
-        return km.centers[static_cast<size_t>(lhs)] < km.centers[static_cast<size_t>(rhs)];
-    });
-    std::vector<int> rank(kRows, 0);
-    for (int i = 0; i < kRows; ++i) {
-        rank[static_cast<size_t>(order[static_cast<size_t>(i)])] = i;
-    }
-
-    struct RowCluster {
-        std::vector<int> indices;
-        float center {0.0F};
-    };
-
-    std::vector<RowCluster> rows(kRows);
-    for (int i = 0; i < kRows; ++i) {
-        rows[static_cast<size_t>(i)].center = km.centers[static_cast<size_t>(order[static_cast<size_t>(i)])];
+    const auto lattice = snap_to_lattice(uv, Traits::kCols, kRows);
+    if (!lattice.success) {
+        Logger::warning(QStringLiteral("number_circles: lattice snapping failed (%1)")
+                            .arg(QString::fromStdString(lattice.message)));
+        return {false, {}, {}, lattice.message};
     }
 
+    std::array<std::vector<int>, kRows> rows {};
     for (size_t i = 0; i < smalls.size(); ++i) {
-        const int raw = km.labels[static_cast<size_t>(i)];
-        if (raw < 0 || raw >= kRows) {
-            Logger::warning(QStringLiteral("number_circles: row label out of range %1").arg(raw));
-            return {false, {}, {}, "invalid_row_label"};
-        }
-        rows[static_cast<size_t>(rank[static_cast<size_t>(raw)])].indices.push_back(static_cast<int>(i));
+        rows[static_cast<size_t>(lattice.cells[i][1])].push_back(static_cast<int>(i));
     }
-
-    auto sortRow = [&](RowCluster &row) {
-        std::sort(row.indices.begin(), row.indices.end(), [&](int lhs, int rhs) {
-            return u[static_cast<size_t>(lhs)] < u[static_cast<size_t>(rhs)];
-        });
-    };
-
-    auto recomputeCenter = [&](RowCluster &row) {
-        if (row.indices.empty()) {
-            return;
-        }
-        double sum = 0.0;
-        for (int idx : row.indices) {
-            sum += v[static_cast<size_t>(idx)];
-        }
-        row.center = static_cast<float>(sum / static_cast<double>(row.indices.size()));
-    };
-
-    auto recomputeAllCenters = [&]() {
-        for (auto &row : rows) {
-            recomputeCenter(row);
-        }
-    };
-
     for (auto &row : rows) {
-        sortRow(row);
-    }
-    recomputeAllCenters();
-
-    struct MoveCandidate {
-        int index {-1};
-        size_t position {0};
-        float cost {std::numeric_limits<float>::max()};
-        [[nodiscard]] bool valid() const { return index >= 0; }
-    };
-
-    auto evaluateCandidate = [&](int donorIdx, int targetIdx) -> MoveCandidate {
-        MoveCandidate best;
-        const auto &indices = rows[static_cast<size_t>(donorIdx)].indices;
-        if (indices.empty()) {
-            return best;
-        }
-        for (size_t pos = 0; pos < indices.size(); ++pos) {
-            const int idx = indices[pos];
-            const float rowPenalty = static_cast<float>(std::abs(donorIdx - targetIdx)) * 1000.0F;
-            const float centerPenalty = std::abs(v[static_cast<size_t>(idx)] - rows[static_cast<size_t>(targetIdx)].center);
-            const float totalCost = rowPenalty + centerPenalty;
-            if (!best.valid() || totalCost < best.cost) {
-                best.index = idx;
-                best.position = pos;
-                best.cost = totalCost;
-            }
-        }
-        return best;
-    };
-
-    for (int iter = 0; iter < 8; ++iter) {
-        bool moved = false;
-
-        for (int target = 0; target < kRows; ++target) {
-            const int expectedCount = expectedRowSizes[static_cast<size_t>(target)];
-            while (static_cast<int>(rows[static_cast<size_t>(target)].indices.size()) < expectedCount) {
-                MoveCandidate best;
-                int bestDonor = -1;
-                for (int donor = 0; donor < kRows; ++donor) {
-                    if (donor == target) {
-                        continue;
-                    }
-                    if (static_cast<int>(rows[static_cast<size_t>(donor)].indices.size()) <= expectedRowSizes[static_cast<size_t>(donor)]) {
-                        continue;
-                    }
-                    MoveCandidate candidate = evaluateCandidate(donor, target);
-                    if (!candidate.valid()) {
-                        continue;
-                    }
-                    if (!best.valid() || candidate.cost < best.cost) {
-                        best = candidate;
-                        bestDonor = donor;
-                    }
-                }
-                if (bestDonor == -1) {
-                    break;
-                }
-                auto &donorVec = rows[static_cast<size_t>(bestDonor)].indices;
-                if (best.position < donorVec.size()) {
-                    donorVec.erase(donorVec.begin() + static_cast<std::ptrdiff_t>(best.position));
-                }
-                rows[static_cast<size_t>(target)].indices.push_back(best.index);
-                sortRow(rows[static_cast<size_t>(target)]);
-                sortRow(rows[static_cast<size_t>(bestDonor)]);
-                moved = true;
-            }
-        }
-
-        for (int donor = 0; donor < kRows; ++donor) {
-            const int allowed = expectedRowSizes[static_cast<size_t>(donor)];
-            while (static_cast<int>(rows[static_cast<size_t>(donor)].indices.size()) > allowed) {
-                MoveCandidate best;
-                int bestTarget = -1;
-                for (int target = 0; target < kRows; ++target) {
-                    if (target == donor) {
-                        continue;
-                    }
-                    if (static_cast<int>(rows[static_cast<size_t>(target)].indices.size()) >= expectedRowSizes[static_cast<size_t>(target)]) {
-                        continue;
-                    }
-                    MoveCandidate candidate = evaluateCandidate(donor, target);
-                    if (!candidate.valid()) {
-                        continue;
-                    }
-                    if (!best.valid() || candidate.cost < best.cost) {
-                        best = candidate;
-                        bestTarget = target;
-                    }
-                }
-                if (bestTarget == -1) {
-                    break;
-                }
-                auto &donorVec = rows[static_cast<size_t>(donor)].indices;
-                if (best.position < donorVec.size()) {
-                    donorVec.erase(donorVec.begin() + static_cast<std::ptrdiff_t>(best.position));
-                }
-                rows[static_cast<size_t>(bestTarget)].indices.push_back(best.index);
-                sortRow(rows[static_cast<size_t>(donor)]);
-                sortRow(rows[static_cast<size_t>(bestTarget)]);
-                moved = true;
-            }
-        }
-
-        if (!moved) {
-            break;
-        }
-
-        recomputeAllCenters();
-    }
-
-    for (auto &row : rows) {
-        sortRow(row);
+        std::sort(row.begin(), row.end(), [&](int lhs, int rhs) {
+            return lattice.cells[static_cast<size_t>(lhs)][0] < lattice.cells[static_cast<size_t>(rhs)][0];
+        });
     }
 
-    auto columnFor = [](int rowIndex, int orderIndex) {
-        if (rowIndex == 3 && orderIndex >= 3) {
-            return orderIndex + 1;
-        }
-        return orderIndex;
-    };
-
     std::vector<Point2> ordered;
     ordered.reserve(expected);
     std::vector<cv::Vec2i> logical;
@@ -1999,15 +2201,15 @@ NumberingResult number_circles(const std::vector<RefinedBlob> &smalls,
     QStringList rowSizeDebug;
     rowSizeDebug.reserve(kRows);
 
-    int rowsWithFive = 0;
+    int rowsWithGaps = 0;
     for (int rowIdx = 0; rowIdx < kRows; ++rowIdx) {
-        const auto &indices = rows[static_cast<size_t>(rowIdx)].indices;
-        const bool expectFive = (rowIdx == 3);
-        const int expectedCount = expectFive ? 5 : 6;
+        const auto &indices = rows[static_cast<size_t>(rowIdx)];
+        const int expectedCount = expectedRowSizes[static_cast<size_t>(rowIdx)];
+        const bool expectGap = expectedCount < Traits::kCols;
         const int actual = static_cast<int>(indices.size());
         rowSizeDebug << QString::number(actual);
-        if (expectFive && actual == 5) {
-            ++rowsWithFive;
+        if (expectGap && actual == expectedCount) {
+            ++rowsWithGaps;
         }
         if (actual != expectedCount) {
             Logger::warning(QStringLiteral("number_circles: row %1 count=%2 expected=%3 | rows=%4")
@@ -2018,17 +2220,23 @@ NumberingResult number_circles(const std::vector<RefinedBlob> &smalls,
             return {false, {}, {}, "row_size_mismatch"};
         }
 
-        int colCounter = 0;
+        // The snapped lattice column is the logical column; landing on a missing
+        // cell means the gap is elsewhere (mirrored board or misplaced circle).
         for (int idx : indices) {
-            const int col = columnFor(rowIdx, colCounter);
-            ++colCounter;
-        ordered.push_back(smalls[static_cast<size_t>(idx)].center);
-        logical.emplace_back(rowIdx, col);
-        source.push_back(idx);
+            const int col = lattice.cells[static_cast<size_t>(idx)][0];
+            if (isMissingCell<Layout>(rowIdx, col)) {
+                Logger::warning(QStringLiteral("number_circles: circle at missing cell (row %1, col %2)")
+                                    .arg(rowIdx)
+                                    .arg(col));
+                return {false, {}, {}, "gap_position_mismatch"};
+            }
+            ordered.push_back(smalls[static_cast<size_t>(idx)].center);
+            logical.emplace_back(rowIdx, col);
+            source.push_back(idx);
         }
     }
 
-    if (rowsWithFive != 1) {
+    if (rowsWithGaps != Traits::kRowsWithGaps) {
         Logger::warning(QStringLiteral("number_circles: center row count anomaly %1")
                             .arg(rowSizeDebug.join(QStringLiteral(","))));
         return {false, {}, {}, "missing_center_row_not_unique"};
@@ -2072,11 +2280,362 @@ NumberingResult number_circles(const std::vector<RefinedBlob> &smalls,
     result.sourceIndices = std::move(sourceSorted);
     return result;
 }
+
+NumberingResult number_circles(const std::vector<RefinedBlob> &smalls,
+                               const std::vector<RefinedBlob> &bigs,
+                               const cv::Size &rectSize,
+                               const BoardSpec &spec)
+{
+    return visitBoardLayout(spec.layout, [&](auto tag) {
+        return number_circles_for<typename decltype(tag)::type>(smalls, bigs, rectSize);
+    });
+}
+
+// Warp-free path: coarse candidates on a downscaled crop of the original image,
+// numbering in the rectified frame, then per-circle ROIs resampled onto the board
+// plane. Cost follows the circle count instead of the rectified board area.
+
+// Coarse crop short side relative to the resolution the blob limits are tuned for.
+constexpr double kCoarseShortRatio = 0.4;
+// ROI half-size in circle radii, and the sampling limits of the rectified patch.
+constexpr double kRoiRadiusScale = 2.2;
+constexpr double kRoiMinRadiusSamples = 10.0;
+constexpr int kRoiMinSide = 24;
+constexpr int kRoiMaxSide = 192;
+constexpr double kRoiMinRadiusRatio = 0.5;
+constexpr double kRoiMaxRadiusRatio = 1.6;
+
+cv::Point2d apply_homography(const cv::Matx33d &H, const cv::Point2d &p) {
+    const cv::Vec3d v = H * cv::Vec3d(p.x, p.y, 1.0);
+    return {v[0] / v[2], v[1] / v[2]};
+}
+
+// Mean length of a radius-r cross around p after mapping through H.
+double map_radius(const cv::Matx33d &H, const cv::Point2d &p, double r) {
+    const cv::Point2d c = apply_homography(H, p);
+    return 0.25 * (cv::norm(apply_homography(H, p + cv::Point2d(r, 0.0)) - c) +
+                   cv::norm(apply_homography(H, p - cv::Point2d(r, 0.0)) - c) +
+                   cv::norm(apply_homography(H, p + cv::Point2d(0.0, r)) - c) +
+                   cv::norm(apply_homography(H, p - cv::Point2d(0.0, r)) - c));
+}
+
+// Blob candidates expressed in the rectified frame of `frame`, so the size
+// classification and numbering run unchanged, but found without warping the board.
+BlobSet detect_blobs_coarse(const cv::Mat &gray,
+                            const std::array<Point2, 4> &quad,
+                            const WarpResult &frame,
+                            const cv::Size &rectSize,
+                            const DetectionConfig &cfg) {
+    std::vector<cv::Point> poly(4);
+    for (size_t i = 0; i < 4; ++i) {
+        poly[i] = cv::Point(cvRound(quad[i].x), cvRound(quad[i].y));
+    }
+    const cv::Rect bbox = cv::boundingRect(poly) & cv::Rect(0, 0, gray.cols, gray.rows);
+    if (bbox.width < 8 || bbox.height < 8) {
+        return {};
+    }
+
+    // The blob limits are tuned for a rectified board whose short side is at least
+    // warpMinShort; detect at a fraction of that and scale the limits to match.
+    const double rectShort = std::max(1, std::min(rectSize.width, rectSize.height));
+    const double tunedShort = std::max(rectShort, static_cast<double>(cfg.warpMinShort));
+    const double scale = std::min(1.0, kCoarseShortRatio * tunedShort / rectShort);
+    const double linear = scale * rectShort / tunedShort;
+
+    cv::Mat crop;
+    cv::resize(gray(bbox), crop, cv::Size(), scale, scale, cv::INTER_AREA);
+    cv::Mat outside(crop.size(), CV_8UC1, cv::Scalar(255));
+    std::vector<cv::Point> local(4);
+    for (size_t i = 0; i < 4; ++i) {
+        local[i] = cv::Point(cvRound((quad[i].x - static_cast<float>(bbox.x)) * scale),
+                             cvRound((quad[i].y - static_cast<float>(bbox.y)) * scale));
+    }
+    cv::fillConvexPoly(outside, local, cv::Scalar(0));
+    cv::Mat pre = preprocess_rect(crop, cfg);
+    pre.setTo(cv::Scalar(cfg.blobDark ? 255 : 0), outside);
+
+    DetectionConfig coarseCfg = cfg;
+    coarseCfg.blobMinArea *= linear * linear;
+    coarseCfg.blobMaxArea *= linear * linear;
+    coarseCfg.blobMinDist *= linear;
+    BlobSet blobs = detect_blobs(pre, coarseCfg);
+
+    const cv::Matx33d H = frame.homography;
+    for (size_t i = 0; i < blobs.raw.size(); ++i) {
+        auto &kp = blobs.raw[i].keypoint;
+        const cv::Point2d imagePt(bbox.x + (kp.pt.x + 0.5) / scale - 0.5, bbox.y + (kp.pt.y + 0.5) / scale - 0.5);
+        const cv::Point2d rectPt = apply_homography(H, imagePt);
+        const double rectRadius = map_radius(H, imagePt, 0.5 * kp.size / scale);
+        kp.pt = Point2(static_cast<float>(rectPt.x), static_cast<float>(rectPt.y));
+        kp.size = static_cast<float>(2.0 * rectRadius);
+
+        RefinedBlob blob;
+        blob.center = kp.pt;
+        blob.radius = rectRadius;
+        blob.area = CV_PI * rectRadius * rectRadius;
+        blob.score = 0.4;
+        blob.sourceIndex = blobs.raw[i].index;
+        blobs.refined[i] = blob;
+    }
+    return blobs;
+}
+
+struct RoiCircle {
+    Point2 center;
+    float radiusPx {0.0F};
+};
+
+// Image of the board's line at infinity, for fit_dual_conic.
+cv::Vec3d vanishing_line(const cv::Matx33d &imageToBoard) {
+    return cv::Vec3d(imageToBoard(2, 0), imageToBoard(2, 1), imageToBoard(2, 2));
+}
+
+// Re-measures back-projected centres on the original image, whose edges have not
+// been resampled by the warp. A point keeps its position when the fit fails,
+// drifts further than the refine gate, or finds a circle of the wrong size.
+void refine_points_on_image(const cv::Mat &gray,
+                            const cv::Matx33d &imageToRect,
+                            std::vector<Point2> &points,
+                            const std::vector<float> &radii,
+                            const DetectionConfig &cfg) {
+    const cv::Vec3d vanishing = vanishing_line(imageToRect);
+    const size_t count = std::min(points.size(), radii.size());
+    for (size_t i = 0; i < count && !RunControl::cancelled(); ++i) {
+        const double radius = radii[i];
+        if (!(radius >= 1.0)) {
+            continue;
+        }
+        const auto fit = fit_dual_conic(gray, points[i], radius, vanishing, 0.5 * cfg.refineWinMax);
+        if (!fit) {
+            continue;
+        }
+        const Point2 refined(static_cast<float>(fit->center.x), static_cast<float>(fit->center.y));
+        const double radiusRatio = fit->radius / radius;
+        if (cv::norm(refined - points[i]) <= radius * std::max(1.0, cfg.refineGate) &&
+            radiusRatio >= kConicMinRadiusRatio && radiusRatio <= kConicMaxRadiusRatio) {
+            points[i] = refined;
+        }
+    }
+}
+
+// Re-measures one circle in the original image with a gradient conic fit. If that
+// fails, a small patch around the predicted centre is resampled onto the board
+// plane and thresholded, and its centroid is mapped back through the homography.
+std::optional<RoiCircle> refine_circle_roi(const cv::Mat &gray,
+                                           const cv::Matx33d &boardToImage,
+                                           const cv::Point2d &boardCenter,
+                                           double radiusMm,
+                                           const DetectionConfig &cfg) {
+    const double pxPerMm = map_radius(boardToImage, boardCenter, 1.0);
+    if (!(pxPerMm > 0.0) || !(radiusMm > 0.0)) {
+        return std::nullopt;
+    }
+    const double halfMm = kRoiRadiusScale * radiusMm;
+    const cv::Point2d predicted = apply_homography(boardToImage, boardCenter);
+    const double reachPx = halfMm * pxPerMm * 1.5;
+    if (predicted.x - reachPx < 0.0 || predicted.y - reachPx < 0.0 ||
+        predicted.x + reachPx >= gray.cols || predicted.y + reachPx >= gray.rows) {
+        return std::nullopt;
+    }
+
+    // Gradient fit straight on the original image first; the resampled patch below
+    // is the fallback for circles it cannot lock onto.
+    const double expectedPx = radiusMm * pxPerMm;
+    if (const auto fit = fit_dual_conic(gray, predicted, expectedPx, vanishing_line(boardToImage.inv()), reachPx)) {
+        const cv::Point2d shift = fit->center - predicted;
+        const double radiusRatio = fit->radius / expectedPx;
+        if (std::hypot(shift.x, shift.y) <= expectedPx * std::max(1.0, cfg.refineGate) &&
+            radiusRatio >= kRoiMinRadiusRatio && radiusRatio <= kRoiMaxRadiusRatio) {
+            RoiCircle circle;
+            circle.center = Point2(static_cast<float>(fit->center.x), static_cast<float>(fit->center.y));
+            circle.radiusPx = static_cast<float>(fit->radius);
+            return circle;
+        }
+    }
+
+    const double samplesPerMm = std::max(pxPerMm, kRoiMinRadiusSamples / radiusMm);
+    const int side = std::clamp(cvRound(2.0 * halfMm * samplesPerMm), kRoiMinSide, kRoiMaxSide);
+    const double mmPerSample = 2.0 * halfMm / side;
+    const cv::Matx33d patchToBoard(mmPerSample, 0.0, boardCenter.x - halfMm + 0.5 * mmPerSample,
+                                   0.0, mmPerSample, boardCenter.y - halfMm + 0.5 * mmPerSample,
+                                   0.0, 0.0, 1.0);
+    cv::Mat patch;
+    cv::warpPerspective(gray, patch, cv::Mat(boardToImage * patchToBoard), cv::Size(side, side),
+                        cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_REPLICATE);
+    cv::GaussianBlur(patch, patch, cv::Size(0, 0), 1.0);
+
+    cv::Mat thresh;
+    cv::threshold(patch, thresh, 0, 255, (cfg.blobDark ? cv::THRESH_BINARY_INV : cv::THRESH_BINARY) + cv::THRESH_OTSU);
+    std::vector<std::vector<cv::Point>> contours;
+    cv::findContours(thresh, contours, cv::RETR_EXTERNAL, cv::CHAIN_APPROX_NONE);
+
+    const cv::Point2f patchCenter(0.5F * static_cast<float>(side) - 0.5F, 0.5F * static_cast<float>(side) - 0.5F);
+    const std::vector<cv::Point> *best = nullptr;
+    double bestArea = 0.0;
+    for (const auto &contour : contours) {
+        if (cv::pointPolygonTest(contour, patchCenter, false) < 0.0) {
+            continue;
+        }
+        const double area = cv::contourArea(contour);
+        if (area > bestArea) {
+            bestArea = area;
+            best = &contour;
+        }
+    }
+    if (best == nullptr) {
+        return std::nullopt;
+    }
+
+    const double expectedRadius = radiusMm / mmPerSample;
+    const double radius = std::sqrt(bestArea / CV_PI);
+    if (radius < kRoiMinRadiusRatio * expectedRadius || radius > kRoiMaxRadiusRatio * expectedRadius) {
+        return std::nullopt;
+    }
+    const cv::Moments m = cv::moments(*best);
+    if (std::abs(m.m00) < 1e-6) {
+        return std::nullopt;
+    }
+    const cv::Point2d localCenter(m.m10 / m.m00, m.m01 / m.m00);
+    if (cv::norm(localCenter - cv::Point2d(patchCenter)) > expectedRadius * std::max(1.0, cfg.refineGate)) {
+        return std::nullopt;
+    }
+
+    const cv::Point2d imageCenter = apply_homography(boardToImage, apply_homography(patchToBoard, localCenter));
+    RoiCircle circle;
+    circle.center = Point2(static_cast<float>(imageCenter.x), static_cast<float>(imageCenter.y));
+    circle.radiusPx = static_cast<float>(radius * mmPerSample * pxPerMm);
+    return circle;
+}
+
+// Replaces back-projection on the warp-free path: fits the board homography to
+// the numbered coarse centres, predicts every circle from the BoardSpec lattice
+// and re-measures it in its own ROI. Fails if any circle cannot be re-measured.
+bool refine_circles_in_rois(const cv::Mat &gray,
+                            const NumberingResult &numbering,
+                            const std::vector<RefinedBlob> &smalls,
+                            const std::vector<RefinedBlob> &bigs,
+                            const WarpResult &frame,
+                            const BoardSpec &spec,
+                            const DetectionConfig &cfg,
+                            DetectionResult &result) {
+    const auto objectPoints = spec.buildObjectPoints(static_cast<int>(numbering.orderedPoints.size()));
+    if (objectPoints.size() != numbering.orderedPoints.size() || objectPoints.size() < 4) {
+        return false;
+    }
+    const cv::Matx33d rectToImage = frame.homographyInv;
+    std::vector<cv::Point2f> boardPts;
+    std::vector<cv::Point2f> coarsePts;
+    boardPts.reserve(objectPoints.size());
+    coarsePts.reserve(objectPoints.size());
+    for (size_t i = 0; i < objectPoints.size(); ++i) {
+        boardPts.emplace_back(objectPoints[i].x, objectPoints[i].y);
+        const cv::Point2d p = apply_homography(rectToImage, numbering.orderedPoints[i]);
+        coarsePts.emplace_back(static_cast<float>(p.x), static_cast<float>(p.y));
+    }
+    const cv::Mat boardH = cv::findHomography(boardPts, coarsePts, cv::LMEDS);
+    if (boardH.empty()) {
+        return false;
+    }
+    const cv::Matx33d boardToImage = boardH;
+    const cv::Matx33d rectToBoard = boardToImage.inv() * rectToImage;
+
+    // Circle sizes come from the coarse blobs rather than BoardSpec so a board
+    // printed at a different diameter still gets correctly sized ROIs.
+    std::vector<double> smallRadiiMm;
+    smallRadiiMm.reserve(smalls.size());
+    for (const auto &blob : smalls) {
+        smallRadiiMm.push_back(map_radius(rectToBoard, blob.center, blob.radius));
+    }
+    const double smallRadiusMm = median_value(smallRadiiMm);
+
+    std::vector<Point2> points(boardPts.size());
+    std::vector<float> radii(boardPts.size());
+    for (size_t i = 0; i < boardPts.size(); ++i) {
+        if (RunControl::cancelled()) {
+            return false;
+        }
+        const auto circle = refine_circle_roi(gray, boardToImage, boardPts[i], smallRadiusMm, cfg);
+        if (!circle) {
+            return false;
+        }
+        points[i] = circle->center;
+        radii[i] = circle->radiusPx;
+    }
+
+    std::vector<Point2> bigPoints(bigs.size());
+    std::vector<float> bigRadii(bigs.size());
+    for (size_t i = 0; i < bigs.size(); ++i) {
+        const cv::Point2d boardCenter = apply_homography(rectToBoard, bigs[i].center);
+        const double radiusMm = map_radius(rectToBoard, bigs[i].center, bigs[i].radius);
+        const auto circle = refine_circle_roi(gray, boardToImage, boardCenter, radiusMm, cfg);
+        if (!circle) {
+            return false;
+        }
+        bigPoints[i] = circle->center;
+        bigRadii[i] = circle->radiusPx;
+    }
+
+    result.imagePoints = std::move(points);
+    result.circleRadiiPx = std::move(radii);
+    result.bigCirclePoints = std::move(bigPoints);
+    result.bigCircleRadiiPx = std::move(bigRadii);
+    return true;
+}
 } // namespace
 
 BoardDetector::BoardDetector(const DetectionConfig &config) : m_cfg(sanitize_config(config)) {}
 
 DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec &spec, const std::string &name) const {
+    return detectWithFallback(inputGray, spec, name, nullptr);
+}
+
+std::optional<std::array<cv::Point2f, 4>> BoardDetector::locateBoard(const cv::Mat &inputGray) const {
+    cv::Mat gray = ensure_gray(inputGray);
+    if (gray.empty()) {
+        return std::nullopt;
+    }
+    gray = to_gray_8u(gray);
+    const auto quad = detect_quad(gray, m_cfg, nullptr);
+    if (!quad || !quad_within_image(quad->corners, gray.rows, gray.cols, m_cfg.quadMargin)) {
+        return std::nullopt;
+    }
+    return quad->corners;
+}
+
+DetectionResult BoardDetector::detectWithQuad(const cv::Mat &gray,
+                                              const std::array<cv::Point2f, 4> &quad,
+                                              const BoardSpec &spec,
+                                              const std::string &name) const {
+    return detectWithFallback(gray, spec, name, &quad);
+}
+
+DetectionResult BoardDetector::detectWithFallback(const cv::Mat &inputGray,
+                                                  const BoardSpec &spec,
+                                                  const std::string &name,
+                                                  const std::array<cv::Point2f, 4> *quadHint) const {
+    if (!m_cfg.warpFreeDetection) {
+        return detectImpl(inputGray, spec, name, false, quadHint, nullptr);
+    }
+    bool quadFound = false;
+    DetectionResult result = detectImpl(inputGray, spec, name, true, quadHint, &quadFound);
+    if (result.success || !quadFound) {
+        return result;
+    }
+    Logger::warning(QStringLiteral("%1: warp-free detection failed (%2), retrying with the rectified board")
+                        .arg(QString::fromStdString(name))
+                        .arg(QString::fromStdString(result.message)));
+    const auto firstAttempt = result.elapsed;
+    result = detectImpl(inputGray, spec, name, false, quadHint, nullptr);
+    result.elapsed += firstAttempt;
+    return result;
+}
+
+DetectionResult BoardDetector::detectImpl(const cv::Mat &inputGray,
+                                          const BoardSpec &spec,
+                                          const std::string &name,
+                                          bool warpFree,
+                                          const std::array<cv::Point2f, 4> *quadHint,
+                                          bool *quadFound) const {
     DetectionResult result;
     result.name = name;
 
@@ -2084,6 +2643,19 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
     std::string stage = "initialize";
     cv::Mat gray;
 
+    // Stage boundaries report the worker's progress and double as cancellation
+    // points; the per-candidate loops inside the stages poll the same flag.
+    auto enterStage = [&](const char *name, RunControl::WorkerStage worker) {
+        stage = name;
+        RunControl::markWorker(worker);
+        return !RunControl::cancelled();
+    };
+    auto cancelledResult = [&]() {
+        result.message = "Detection cancelled";
+        result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        return result;
+    };
+
     try {
     Logger::info(QStringLiteral("%1: input type=%2 | size=%3x%4")
                          .arg(QString::fromStdString(name))
@@ -2098,33 +2670,33 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
             result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
             return result;
         }
-        if (gray.type() != CV_8UC1) {
-            gray.convertTo(gray, CV_8UC1);
-        }
+        gray = to_gray_8u(gray);
         result.resolution = gray.size();
 
-        const std::uint64_t debugId = g_debugCounter.fetch_add(1, std::memory_order_relaxed);
-        const std::string sanitizedName = sanitize_filename(name);
-        std::filesystem::path debugDir = std::filesystem::temp_directory_path() / "calib_debug" /
-                                         (sanitizedName + "_" + std::to_string(debugId));
-        std::error_code makeDirEc;
-        std::filesystem::create_directories(debugDir, makeDirEc);
-        if (!makeDirEc) {
-            result.debugDirectory = debugDir.string();
-        } else {
-            result.debugDirectory.clear();
+        if (m_cfg.writeDebugImages) {
+            const std::uint64_t debugId = g_debugCounter.fetch_add(1, std::memory_order_relaxed);
+            const std::string sanitizedName = sanitize_filename(name);
+            // The counter restarts in every detection worker process; the pid keeps
+            // concurrent workers from sharing a directory.
+            std::filesystem::path debugDir = std::filesystem::temp_directory_path() / "calib_debug" /
+                                             (sanitizedName + "_" + std::to_string(QCoreApplication::applicationPid()) +
+                                              "_" + std::to_string(debugId));
+            std::error_code makeDirEc;
+            std::filesystem::create_directories(debugDir, makeDirEc);
+            if (!makeDirEc) {
+                result.debugDirectory = debugDir.string();
+            } else {
+                result.debugDirectory.clear();
+            }
         }
 
         const int debugMaxDim = 1600;
         cv::Mat originalColor = ensure_color_8u(gray);
         auto addDebugImage = [&](const std::string &label, const cv::Mat &image) {
-            if (image.empty()) {
+            if (image.empty() || result.debugDirectory.empty()) {
                 return;
             }
             cv::Mat display = downscale_for_display(image, debugMaxDim);
-            if (result.debugDirectory.empty()) {
-                return;
-            }
             const std::string slug = sanitize_filename(label);
             std::filesystem::path targetPath = std::filesystem::path(result.debugDirectory) /
                                              (slug + "_" + std::to_string(result.debugImages.size()) + ".png");
@@ -2147,9 +2719,20 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
 
         addDebugImage("Input", originalColor);
 
-    stage = "detect_quad/hough";
     cv::Mat whiteMaskDebug;
-    auto quadOpt = detect_quad(gray, m_cfg, &whiteMaskDebug);
+    std::optional<QuadCandidate> quadOpt;
+    if (quadHint != nullptr) {
+        stage = "quad_hint";
+        quadOpt = QuadCandidate{*quadHint, 0.0, 0.0};
+    } else {
+        if (!enterStage("detect_quad/hough", RunControl::WorkerStage::LocatingBoard)) {
+            return cancelledResult();
+        }
+        quadOpt = detect_quad(gray, m_cfg, &whiteMaskDebug);
+    }
+        if (RunControl::cancelled()) {
+            return cancelledResult();
+        }
         if (!quadOpt) {
             if (!whiteMaskDebug.empty()) {
                 cv::Mat maskColor;
@@ -2193,26 +2776,60 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
             return result;
         }
         const auto expandedQuad = *expandedQuadOpt;
-
-        stage = "warp_quad";
-        WarpResult warp = warp_quad(gray, *expandedQuadOpt, m_cfg);
-        if (warp.image.empty() || warp.homography.empty() || warp.homographyInv.empty()) {
-            result.message = "Perspective warp failed";
-            result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
-            return result;
+        if (quadFound != nullptr) {
+            *quadFound = true;
         }
 
-        addDebugImage("Rectified board", ensure_color_8u(warp.image));
+        WarpResult warp;
+        cv::Size rectSize;
+        cv::Mat rectPreColor;
+        BlobSet blobs;
+        if (warpFree) {
+            if (!enterStage("rectified_frame", RunControl::WorkerStage::Rectifying)) {
+                return cancelledResult();
+            }
+            warp = rectified_frame(expandedQuad, m_cfg, &rectSize);
+            if (!invert_warp(warp)) {
+                result.message = "Perspective warp failed";
+                result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                return result;
+            }
 
-        stage = "preprocess_rect";
-        cv::Mat rectPre = preprocess_rect(warp.image, m_cfg);
-        cv::Mat rectPreColor = ensure_color_8u(rectPre);
-        addDebugImage("Preprocessed", rectPreColor);
+            if (!enterStage("detect_blobs_coarse", RunControl::WorkerStage::FindingCircles)) {
+                return cancelledResult();
+            }
+            blobs = detect_blobs_coarse(gray, expandedQuad, warp, rectSize, m_cfg);
+        } else {
+            if (!enterStage("warp_quad", RunControl::WorkerStage::Rectifying)) {
+                return cancelledResult();
+            }
+            warp = warp_quad(gray, expandedQuad, m_cfg);
+            if (warp.image.empty() || warp.homography.empty() || warp.homographyInv.empty()) {
+                result.message = "Perspective warp failed";
+                result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                return result;
+            }
+            rectSize = warp.image.size();
 
-        stage = "detect_blobs";
-        auto blobs = detect_blobs(rectPre, m_cfg);
-        stage = "refine_blobs";
-        blobs = refine_blobs(rectPre, std::move(blobs), m_cfg);
+            addDebugImage("Rectified board", ensure_color_8u(warp.image));
+
+            stage = "preprocess_rect";
+            cv::Mat rectPre = preprocess_rect(warp.image, m_cfg);
+            rectPreColor = ensure_color_8u(rectPre);
+            addDebugImage("Preprocessed", rectPreColor);
+
+            if (!enterStage("detect_blobs", RunControl::WorkerStage::FindingCircles)) {
+                return cancelledResult();
+            }
+            blobs = detect_blobs(rectPre, m_cfg);
+            if (!enterStage("refine_blobs", RunControl::WorkerStage::Refining)) {
+                return cancelledResult();
+            }
+            blobs = refine_blobs(rectPre, std::move(blobs), m_cfg);
+        }
+        if (RunControl::cancelled()) {
+            return cancelledResult();
+        }
 
     Logger::info(QStringLiteral("%1: initial circle candidates = %2")
                          .arg(QString::fromStdString(name))
@@ -2279,7 +2896,7 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
         std::vector<RefinedBlob> selectedSmall = select_by_area(smallCandidates, expectedSmall, m_cfg.areaRelaxSmall, m_cfg);
         std::vector<RefinedBlob> selectedBig = select_by_area(bigCandidates, 4, m_cfg.areaRelaxBig, m_cfg);
 
-        {
+        if (!rectPreColor.empty()) {
             cv::Mat selectionOverlay = rectPreColor.clone();
             for (const auto &blob : selectedSmall) {
                 const cv::Point center(cvRound(blob.center.x), cvRound(blob.center.y));
@@ -2309,8 +2926,10 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
             return result;
         }
 
-    stage = "number_circles";
-    auto numbering = number_circles(selectedSmall, selectedBig, warp.image.size(), spec);
+        if (!enterStage("number_circles", RunControl::WorkerStage::Numbering)) {
+            return cancelledResult();
+        }
+    auto numbering = number_circles(selectedSmall, selectedBig, rectSize, spec);
         if (!numbering.success) {
             Logger::warning(QStringLiteral("%1: numbering failed: %2")
                                 .arg(QString::fromStdString(name))
@@ -2344,8 +2963,20 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
             return count > 0 ? static_cast<float>(sum / static_cast<double>(count)) : radius;
         };
 
-        stage = "back_project_points";
-        if (warp.homographyInv.rows == 3 && warp.homographyInv.cols == 3) {
+        if (warpFree) {
+            if (!enterStage("refine_circle_rois", RunControl::WorkerStage::Refining)) {
+                return cancelledResult();
+            }
+            if (!refine_circles_in_rois(gray, numbering, selectedSmall, selectedBig, warp, spec, m_cfg, result)) {
+                if (RunControl::cancelled()) {
+                    return cancelledResult();
+                }
+                result.message = "Circle ROI refinement failed";
+                result.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+                return result;
+            }
+        } else if (warp.homographyInv.rows == 3 && warp.homographyInv.cols == 3) {
+            stage = "back_project_points";
             cv::Mat pts(static_cast<int>(numbering.orderedPoints.size()), 1, CV_32FC2);
             for (int i = 0; i < pts.rows; ++i) {
                 pts.at<cv::Point2f>(i, 0) = numbering.orderedPoints[static_cast<size_t>(i)];
@@ -2386,16 +3017,29 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
         }
         result.bigCircleCount = static_cast<int>(result.bigCirclePoints.size());
         result.logicalIndices = numbering.logicalIndices;
-        result.circleRadiiPx.clear();
-        result.circleRadiiPx.reserve(numbering.sourceIndices.size());
-        for (size_t i = 0; i < numbering.sourceIndices.size(); ++i) {
-            float storedRadius = 0.0f;
-            const int idx = numbering.sourceIndices[i];
-            if (idx >= 0 && idx < static_cast<int>(selectedSmall.size())) {
-                const auto &blob = selectedSmall[static_cast<size_t>(idx)];
-                storedRadius = projectRadius(blob.center, static_cast<float>(blob.radius));
+        if (!warpFree) {
+            result.circleRadiiPx.clear();
+            result.circleRadiiPx.reserve(numbering.sourceIndices.size());
+            for (size_t i = 0; i < numbering.sourceIndices.size(); ++i) {
+                float storedRadius = 0.0f;
+                const int idx = numbering.sourceIndices[i];
+                if (idx >= 0 && idx < static_cast<int>(selectedSmall.size())) {
+                    const auto &blob = selectedSmall[static_cast<size_t>(idx)];
+                    storedRadius = projectRadius(blob.center, static_cast<float>(blob.radius));
+                }
+                result.circleRadiiPx.push_back(storedRadius);
+            }
+            if (m_cfg.refineOnImage && warp.homography.rows == 3 && warp.homography.cols == 3) {
+                if (!enterStage("refine_on_image", RunControl::WorkerStage::Refining)) {
+                    return cancelledResult();
+                }
+                const cv::Matx33d imageToRect = warp.homography;
+                refine_points_on_image(gray, imageToRect, result.imagePoints, result.circleRadiiPx, m_cfg);
+                refine_points_on_image(gray, imageToRect, result.bigCirclePoints, result.bigCircleRadiiPx, m_cfg);
+                if (RunControl::cancelled()) {
+                    return cancelledResult();
+                }
             }
-            result.circleRadiiPx.push_back(storedRadius);
         }
         if (!whiteMaskDebug.empty()) {
             result.whiteRegionMask = whiteMaskDebug.clone();
@@ -2413,7 +3057,7 @@ DetectionResult BoardDetector::detect(const cv::Mat &inputGray, const BoardSpec
             result.warpHomographyInv.release();
         }
 
-        {
+        if (!warp.image.empty()) {
             cv::Mat warpOverlay = ensure_color_8u(warp.image);
             const std::array<cv::Scalar, 7> rowColors = {
                 cv::Scalar(255, 206, 86),
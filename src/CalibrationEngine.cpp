@@ -5,7 +5,12 @@
 #include <chrono>
 #include <cmath>
 #include <filesystem>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <random>
+#include <unordered_map>
 
 #include <QCoreApplication>
 #include <QDir>
@@ -24,10 +29,15 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "DetectionTuner.h"
+#include "DetectionWorkerPool.h"
 #include "HeatmapGenerator.h"
 #include "PaperFigureExporter.h"
 #include "ImageLoader.h"
 #include "Logger.h"
+#include "ThumbnailCache.h"
+#include "ViewSelection.h"
+#include "runtime/UndistortRuntime.h"
 
 namespace fs = std::filesystem;
 
@@ -173,6 +183,193 @@ void computeResiduals(const cv::Mat &cameraMatrix,
     }
 }
 
+// Variance of the Laplacian inside the board's bounding box, used to prefer crisp
+// views when subsampling large datasets.
+double boardSharpness(const cv::Mat &gray, const std::vector<cv::Point2f> &points)
+{
+    if (gray.empty() || points.empty()) {
+        return 0.0;
+    }
+    const cv::Rect roi = cv::boundingRect(points) & cv::Rect(0, 0, gray.cols, gray.rows);
+    if (roi.area() <= 0) {
+        return 0.0;
+    }
+    // Measured on a 0-255 scale whatever the input depth, so 8- and 16-bit views
+    // rank against each other in view selection.
+    cv::Mat patch = gray(roi);
+    if (patch.depth() != CV_8U) {
+        const double scale = patch.depth() == CV_16U ? 255.0 / 65535.0 : 1.0;
+        patch.convertTo(patch, CV_32F, scale);
+    }
+    cv::Mat laplacian;
+    cv::Laplacian(patch, laplacian, CV_32F);
+    cv::Scalar mean;
+    cv::Scalar stddev;
+    cv::meanStdDev(laplacian, mean, stddev);
+    return stddev[0] * stddev[0];
+}
+
+// Short side kept by the reduced JPEG decode that feeds the quad search.
+constexpr int kReducedDecodeMinShortSide = 800;
+// Border around the located board, relative to its size, for the full-resolution region decode.
+constexpr double kBoardRegionMarginRatio = 0.08;
+// Held-out views used to score robust-loop removal sets.
+constexpr size_t kRobustProbeViews = 24;
+
+// Moves a detection made on a crop back into full-image pixels.
+void offsetDetection(DetectionResult &detection, const cv::Point2f &offset)
+{
+    for (auto &pt : detection.imagePoints) {
+        pt += offset;
+    }
+    for (auto &pt : detection.bigCirclePoints) {
+        pt += offset;
+    }
+    const cv::Matx33d toCrop(1.0, 0.0, -offset.x, 0.0, 1.0, -offset.y, 0.0, 0.0, 1.0);
+    if (!detection.warpHomography.empty()) {
+        detection.warpHomography = detection.warpHomography * cv::Mat(toCrop);
+    }
+    if (!detection.warpHomographyInv.empty()) {
+        detection.warpHomographyInv = cv::Mat(toCrop.inv()) * detection.warpHomographyInv;
+    }
+}
+
+// Two-phase decode for large JPEGs and raw DNGs: quad search on a reduced decode
+// (DCT-domain scaling, or 2x2 CFA binning), then circle detection on a
+// full-resolution decode of the board region only.
+// Empty when the file does not qualify or detection fails there, in which case the
+// caller decodes the whole image.
+std::optional<DetectionResult> detectFromBoardRegion(const ImageLoader &loader,
+                                                     const std::string &path,
+                                                     const BoardSpec &spec,
+                                                     const BoardDetector &detector,
+                                                     const std::string &name,
+                                                     ThumbnailCache *thumbnails)
+{
+    const auto reduced = loader.loadReduced(path, kReducedDecodeMinShortSide);
+    if (!reduced) {
+        return std::nullopt;
+    }
+    if (thumbnails) {
+        thumbnails->insertAsync(QString::fromStdString(path), reduced->image, reduced->fullSize);
+    }
+    RunControl::markWorker(RunControl::WorkerStage::LocatingBoard);
+    const auto coarseQuad = detector.locateBoard(reduced->image);
+    if (!coarseQuad) {
+        return std::nullopt;
+    }
+
+    const auto factor = static_cast<float>(reduced->factor);
+    const cv::Point2f halfPixel(0.5F, 0.5F);
+    std::array<cv::Point2f, 4> quad;
+    for (size_t i = 0; i < quad.size(); ++i) {
+        quad[i] = ((*coarseQuad)[i] + halfPixel) * factor - halfPixel;
+    }
+    const cv::Rect bounds = cv::boundingRect(std::vector<cv::Point2f>(quad.begin(), quad.end()));
+    const int margin = cvRound(kBoardRegionMarginRatio * std::max(bounds.width, bounds.height)) + 4 * reduced->factor;
+    const cv::Rect region = cv::Rect(bounds.x - margin, bounds.y - margin, bounds.width + 2 * margin, bounds.height + 2 * margin) &
+                            cv::Rect(cv::Point(0, 0), reduced->fullSize);
+    RunControl::markWorker(RunControl::WorkerStage::Decoding);
+    const cv::Mat gray = loader.loadRegion(path, region);
+    if (gray.empty()) {
+        return std::nullopt;
+    }
+    const cv::Point2f offset(static_cast<float>(region.x), static_cast<float>(region.y));
+    for (auto &corner : quad) {
+        corner -= offset;
+    }
+
+    DetectionResult detection = detector.detectWithQuad(gray, quad, spec, name);
+    if (!detection.success) {
+        Logger::info(QStringLiteral("%1: board-region decode failed (%2), decoding the full image")
+                         .arg(QString::fromStdString(name))
+                         .arg(QString::fromStdString(detection.message)));
+        return std::nullopt;
+    }
+    detection.sharpness = boardSharpness(gray, detection.imagePoints);
+    offsetDetection(detection, offset);
+    detection.resolution = reduced->fullSize;
+    return detection;
+}
+
+// Per-view leverage and influence from the solver Jacobian at the optimum. Each
+// view's extrinsics are marginalized out (Schur complement), leaving its share S_i
+// of the intrinsics information H = sum S_i and its reduced gradient g_i. Dropping
+// the view moves the intrinsics by roughly (H - S_i)^-1 g_i; Cook's distance
+// measures that step in the metric of H, so no leave-one-out refit is needed.
+void computeViewInfluence(const cv::Mat &cameraMatrix,
+                          const cv::Mat &distCoeffs,
+                          const std::vector<std::vector<cv::Point3f>> &objectPoints,
+                          std::vector<DetectionResult> &detections,
+                          const std::vector<cv::Mat> &rvecs,
+                          const std::vector<cv::Mat> &tvecs,
+                          double rms)
+{
+    constexpr int kExtrinsics = 6;
+    const size_t viewCount = detections.size();
+    if (viewCount == 0 || rvecs.size() != viewCount || tvecs.size() != viewCount) {
+        return;
+    }
+
+    std::vector<cv::Mat> shares(viewCount);
+    std::vector<cv::Mat> gradients(viewCount);
+    cv::Mat information;
+    for (size_t idx = 0; idx < viewCount; ++idx) {
+        const auto &rec = detections[idx];
+        if (!rec.success || rec.imagePoints.size() != objectPoints[idx].size()) {
+            continue;
+        }
+        std::vector<cv::Point2f> projected;
+        cv::Mat jacobian;
+        cv::projectPoints(objectPoints[idx], rvecs[idx], tvecs[idx], cameraMatrix, distCoeffs, projected, jacobian);
+        if (jacobian.cols <= kExtrinsics) {
+            continue;
+        }
+
+        cv::Mat residual(static_cast<int>(2 * projected.size()), 1, CV_64F);
+        for (size_t i = 0; i < projected.size(); ++i) {
+            residual.at<double>(static_cast<int>(2 * i), 0) = rec.imagePoints[i].x - projected[i].x;
+            residual.at<double>(static_cast<int>(2 * i + 1), 0) = rec.imagePoints[i].y - projected[i].y;
+        }
+
+        const cv::Mat je = jacobian.colRange(0, kExtrinsics);
+        const cv::Mat jc = jacobian.colRange(kExtrinsics, jacobian.cols);
+        cv::Mat cInv;
+        if (cv::invert(je.t() * je, cInv, cv::DECOMP_CHOLESKY) == 0.0) {
+            continue;
+        }
+        const cv::Mat coupling = jc.t() * je * cInv;
+        shares[idx] = jc.t() * jc - coupling * (je.t() * jc);
+        gradients[idx] = jc.t() * residual - coupling * (je.t() * residual);
+        if (information.empty()) {
+            information = shares[idx].clone();
+        } else {
+            information += shares[idx];
+        }
+    }
+    if (information.empty()) {
+        return;
+    }
+
+    const int paramCount = information.rows;
+    const double sigma2 = std::max(rms * rms * 0.5, 1e-12);
+    cv::Mat covariance;
+    cv::invert(information, covariance, cv::DECOMP_SVD);
+    for (size_t idx = 0; idx < viewCount; ++idx) {
+        auto &rec = detections[idx];
+        rec.leverage = 0.0;
+        rec.influence = 0.0;
+        if (shares[idx].empty()) {
+            continue;
+        }
+        rec.leverage = cv::trace(shares[idx] * covariance)[0];
+        cv::Mat step;
+        cv::solve(information - shares[idx], gradients[idx], step, cv::DECOMP_SVD);
+        const cv::Mat distance = step.t() * information * step;
+        rec.influence = distance.at<double>(0, 0) / (static_cast<double>(paramCount) * sigma2);
+    }
+}
+
 CalibrationMetrics summarize(const std::vector<DetectionResult> &detections)
 {
     CalibrationMetrics metrics;
@@ -286,6 +483,21 @@ QString CalibrationEngine::resolveOutputDirectory(const QString &requested)
     return QDir(QFileInfo(resolved).absoluteFilePath()).absolutePath();
 }
 
+DetectionConfig CalibrationEngine::resolveDetectionConfig(const Settings &settings)
+{
+    DetectionConfig config = settings.detection;
+    if (settings.detectionProfilePath.isEmpty() || !QFileInfo::exists(settings.detectionProfilePath)) {
+        return config;
+    }
+    QString error;
+    if (loadDetectionProfile(settings.detectionProfilePath, config, &error)) {
+        Logger::info(QStringLiteral("Using detection profile %1").arg(settings.detectionProfilePath));
+        return config;
+    }
+    Logger::warning(QStringLiteral("Ignoring detection profile: %1").arg(error));
+    return settings.detection;
+}
+
 CalibrationEngine::CalibrationEngine(QObject *parent)
     : QObject(parent)
     , m_watcher(new QFutureWatcher<CalibrationOutput>(this))
@@ -317,16 +529,20 @@ CalibrationEngine::~CalibrationEngine()
 
 void CalibrationEngine::run(const QString &imageDirectory,
                             const Settings &settings,
-                            const QString &outputDirectory)
+                            const QString &outputDirectory,
+                            const QStringList &knownImages)
 {
     if (isRunning()) {
         Logger::warning(QStringLiteral("Calibration already running; ignoring duplicate request."));
         return;
     }
 
-    m_abortRequested.store(false, std::memory_order_release);
+    m_control.reset();
     m_directory = imageDirectory;
+    m_knownImages = knownImages;
     m_settings = settings;
+    m_settings.detection = resolveDetectionConfig(settings);
+    m_detector = BoardDetector(m_settings.detection);
     m_outputDirectory = resolveOutputDirectory(outputDirectory);
     ensureDirectory(m_outputDirectory);
 
@@ -342,17 +558,42 @@ CalibrationOutput CalibrationEngine::runBlocking(const QString &imageDirectory,
         cancelAndWait();
     }
 
-    m_abortRequested.store(false, std::memory_order_release);
+    m_control.reset();
     m_directory = imageDirectory;
+    m_knownImages.clear();
     m_settings = settings;
+    m_settings.detection = resolveDetectionConfig(settings);
+    m_detector = BoardDetector(m_settings.detection);
     m_outputDirectory = resolveOutputDirectory(outputDirectory);
     ensureDirectory(m_outputDirectory);
     return executePipeline();
 }
 
+CalibrationOutput CalibrationEngine::runBlocking(std::vector<DetectionResult> detections,
+                                                 const Settings &settings,
+                                                 const QString &outputDirectory)
+{
+    if (isRunning()) {
+        cancelAndWait();
+    }
+
+    m_control.reset();
+    m_directory.clear();
+    m_knownImages.clear();
+    m_settings = settings;
+    m_settings.detection = resolveDetectionConfig(settings);
+    m_detector = BoardDetector(m_settings.detection);
+    m_outputDirectory = resolveOutputDirectory(outputDirectory);
+    ensureDirectory(m_outputDirectory);
+    Logger::info(QStringLiteral("Solving %1 pre-detected views, output directory: %2")
+                     .arg(static_cast<int>(detections.size()))
+                     .arg(m_outputDirectory));
+    return solveDetections(std::move(detections));
+}
+
 void CalibrationEngine::cancelAndWait()
 {
-    m_abortRequested.store(true, std::memory_order_release);
+    m_control.requestCancel();
 
     if (!m_watcher) {
         return;
@@ -379,7 +620,7 @@ bool CalibrationEngine::isRunning() const
 
 bool CalibrationEngine::shouldAbort() const
 {
-    return m_abortRequested.load(std::memory_order_acquire);
+    return m_control.cancelRequested();
 }
 
 CalibrationOutput CalibrationEngine::executePipeline()
@@ -413,10 +654,11 @@ CalibrationOutput CalibrationEngine::executePipeline()
     Logger::info(QStringLiteral("=== Calibration task started ==="));
     Logger::info(QStringLiteral("Input directory: %1").arg(m_directory));
     Logger::info(QStringLiteral("Output directory: %1").arg(m_outputDirectory));
-    Logger::info(QStringLiteral("Board specification: small circle Ø=%1 mm, spacing=%2 mm, expected circles=%3")
+    Logger::info(QStringLiteral("Board specification: layout %4, small circle Ø=%1 mm, spacing=%2 mm, expected circles=%3")
                          .arg(m_settings.boardSpec.smallDiameterMm, 0, 'f', 2)
                          .arg(m_settings.boardSpec.centerSpacingMm, 0, 'f', 2)
-                         .arg(static_cast<int>(m_settings.boardSpec.expectedCircleCount())));
+                         .arg(static_cast<int>(m_settings.boardSpec.expectedCircleCount()))
+                         .arg(QString::fromLatin1(boardLayoutKey(m_settings.boardSpec.layout))));
     Logger::info(QStringLiteral("Detection settings: refinement=%1 | mean threshold=%2 px | point threshold=%3 px | min samples=%4 | max iterations=%5")
              .arg(m_settings.enableRefinement ? QStringLiteral("enabled") : QStringLiteral("disabled"))
                          .arg(m_settings.maxMeanErrorPx, 0, 'f', 2)
@@ -424,6 +666,7 @@ CalibrationOutput CalibrationEngine::executePipeline()
                          .arg(m_settings.minSamples)
                          .arg(m_settings.maxIterations));
 
+        m_control.setStage(RunControl::Stage::Collecting);
         Q_EMIT statusChanged(tr("Collecting images"));
         const auto paths = collectImagePaths(m_directory);
         if (paths.empty()) {
@@ -431,7 +674,7 @@ CalibrationOutput CalibrationEngine::executePipeline()
             output.failureStage = tr("图像收集");
             output.failureDetails = {
                 tr("目录：%1").arg(m_directory),
-                tr("未找到支持的图像格式（png/jpg/jpeg/bmp/tif/tiff）。")
+                tr("未找到支持的图像格式（png/jpg/jpeg/bmp/tif/tiff/dng）。")
             };
             return output;
         }
@@ -445,23 +688,109 @@ CalibrationOutput CalibrationEngine::executePipeline()
 
         const auto total = static_cast<int>(paths.size());
     Logger::info(QStringLiteral("Collected %1 images, starting detection...").arg(total));
+        // Per-image progress goes through m_control only; the log gets a bar every
+        // tenth of the run.
+        Q_EMIT statusChanged(tr("Detecting boards"));
+        m_control.setTotal(total);
+        m_control.setStage(RunControl::Stage::Detecting);
+        if (m_settings.detectionWorkers > 0) {
+            Logger::info(QStringLiteral("Detecting in %1 worker processes").arg(m_settings.detectionWorkers));
+            // The decoded pixels stay in the workers, so this mode does not seed the
+            // thumbnail cache; previews are built when the GUI first shows an image.
+            const DetectionWorkerPool pool(m_settings.boardSpec, m_settings.detection, m_settings.detectionWorkers);
+            std::mutex progressMutex;
+            int processed = 0;
+            int loggedTenth = 0;
+            detections = pool.detect(paths,
+                                     [this]() { return shouldAbort(); },
+                                     [&](size_t, const DetectionResult &result) {
+                                         m_control.finishItem(result.success);
+                                         const std::lock_guard<std::mutex> lock(progressMutex);
+                                         ++processed;
+                                         const int tenth = processed * 10 / total;
+                                         if (tenth > loggedTenth || processed == total) {
+                                             loggedTenth = tenth;
+                                             Logger::info(QStringLiteral("[Progress] [%1] %2/%3")
+                                                              .arg(makeProgressBar(processed, total))
+                                                              .arg(processed)
+                                                              .arg(total));
+                                         }
+                                     });
+            if (m_thumbnails) {
+                m_thumbnails->flush();
+            }
+            if (abortGuard()) {
+                return output;
+            }
+            return solveDetections(std::move(detections));
+        }
+
+        RunControl::WorkerScope worker(m_control);
+        int loggedTenth = 0;
         for (int idx = 0; idx < total; ++idx) {
             if (abortGuard()) {
                 return output;
             }
 
-            Q_EMIT statusChanged(tr("Detecting board %1/%2").arg(idx + 1).arg(total));
-    DetectionResult result = detectBoard(paths[idx]);
-            detections.push_back(result);
-            Q_EMIT progressUpdated(idx + 1, total);
+    DetectionResult result = detectImage(paths[idx], m_settings.boardSpec, m_detector, m_thumbnails);
+            RunControl::markWorker(RunControl::WorkerStage::Idle);
+            m_control.finishItem(result.success);
+            detections.push_back(std::move(result));
 
             const int processed = idx + 1;
-            Logger::info(QStringLiteral("[Progress] [%1] %2/%3")
-                             .arg(makeProgressBar(processed, total))
-                             .arg(processed)
-                             .arg(total));
+            const int tenth = processed * 10 / total;
+            if (tenth > loggedTenth || processed == total) {
+                loggedTenth = tenth;
+                Logger::info(QStringLiteral("[Progress] [%1] %2/%3")
+                                 .arg(makeProgressBar(processed, total))
+                                 .arg(processed)
+                                 .arg(total));
+            }
+        }
+        if (m_thumbnails) {
+            m_thumbnails->flush();
+        }
+
+        return solveDetections(std::move(detections));
+    } catch (const std::exception &ex) {
+        output.success = false;
+        output.message = QString::fromUtf8(ex.what());
+        if (output.failureStage.isEmpty()) {
+            output.failureStage = tr("内部异常");
+        }
+        if (output.failureDetails.isEmpty()) {
+            output.failureDetails = {tr("异常信息：%1").arg(output.message)};
+        }
+        return output;
+    }
+}
+
+CalibrationOutput CalibrationEngine::solveDetections(std::vector<DetectionResult> detections)
+{
+    CalibrationOutput output;
+    output.success = false;
+
+    bool abortLogged = false;
+    auto abortGuard = [this, &output, &abortLogged]() -> bool {
+        if (!shouldAbort()) {
+            return false;
+        }
+        if (!abortLogged) {
+            Logger::warning(QStringLiteral("Calibration aborted on request."));
+            abortLogged = true;
+        }
+        output.message = tr("Calibration aborted");
+        if (output.failureStage.isEmpty()) {
+            output.failureStage = tr("用户取消");
+        }
+        if (output.failureDetails.isEmpty()) {
+            output.failureDetails = {tr("处理过程中被手动中止。")};
         }
+        return true;
+    };
 
+    try {
+        const auto total = static_cast<int>(detections.size());
         int successCount = 0;
         int failureCount = 0;
         int totalSmallCircles = 0;
@@ -572,8 +901,45 @@ CalibrationOutput CalibrationEngine::executePipeline()
             return output;
         }
 
+        std::vector<DetectionResult> solveSet;
+        std::vector<DetectionResult> validationSet;
+        {
+            cv::Size imageSize;
+            for (const auto &rec : detections) {
+                if (rec.success) {
+                    imageSize = rec.resolution;
+                    break;
+                }
+            }
+            ViewSelectionOptions selectionOptions;
+            selectionOptions.maxViews = m_settings.maxCalibrationViews;
+            const ViewSelection selection = selectCalibrationViews(detections, imageSize, selectionOptions);
+            if (selection.holdout.empty()) {
+                solveSet = detections;
+            } else {
+                Q_EMIT statusChanged(tr("Selecting views"));
+                solveSet.reserve(selection.selected.size());
+                for (size_t index : selection.selected) {
+                    solveSet.push_back(detections[index]);
+                }
+                validationSet.reserve(selection.holdout.size());
+                for (size_t index : selection.holdout) {
+                    validationSet.push_back(detections[index]);
+                    validationSet.back().validationOnly = true;
+                }
+                Logger::info(QStringLiteral("View selection: %1 of %2 successful views go to the solve, %3 kept for validation")
+                                 .arg(static_cast<int>(solveSet.size()))
+                                 .arg(successCount)
+                                 .arg(static_cast<int>(validationSet.size())));
+                detectionDiagnostics << tr("视图筛选：%1 张参与求解，%2 张仅用于验证")
+                                          .arg(static_cast<int>(solveSet.size()))
+                                          .arg(static_cast<int>(validationSet.size()));
+            }
+        }
+
+        m_control.setStage(RunControl::Stage::Calibrating);
         Q_EMIT statusChanged(tr("Calibrating camera"));
-        output = calibrate(detections);
+        output = calibrate(solveSet);
         output.detectionDiagnostics = detectionDiagnostics;
         if (!output.success) {
             output.failureStage = tr("初始标定");
@@ -590,62 +956,70 @@ CalibrationOutput CalibrationEngine::executePipeline()
             return output;
         }
 
+        m_control.setStage(RunControl::Stage::Filtering);
         Q_EMIT statusChanged(tr("Filtering outliers"));
-        output = filterAndRecalibrate(std::move(output));
+        output = filterAndRecalibrate(std::move(output), validationSet);
         if (!output.success) {
             return output;
         }
 
+        if (!validationSet.empty()) {
+            m_control.setStage(RunControl::Stage::Validating);
+            Q_EMIT statusChanged(tr("Validating held-out views"));
+            evaluateValidationViews(output, std::move(validationSet));
+
+            // The solve only saw the selected views; restore the full list so the
+            // UI still lists every image, enriched where residuals exist.
+            std::unordered_map<std::string, const DetectionResult *> enriched;
+            for (const auto *pool : {&output.allDetections, &output.validationDetections}) {
+                for (const auto &rec : *pool) {
+                    enriched.emplace(rec.name, &rec);
+                }
+            }
+            std::vector<DetectionResult> merged = detections;
+            for (auto &rec : merged) {
+                const auto it = enriched.find(rec.name);
+                if (it != enriched.end()) {
+                    rec = *it->second;
+                }
+            }
+            output.allDetections = std::move(merged);
+        }
+
         if (abortGuard()) {
             return output;
         }
 
+        if (m_settings.validationMode != Settings::ValidationMode::None) {
+            m_control.setStage(RunControl::Stage::Validating);
+            Q_EMIT statusChanged(tr("Cross-validating"));
+            output.crossValidation = crossValidate(output);
+            if (abortGuard()) {
+                return output;
+            }
+        }
+
+        m_control.setStage(RunControl::Stage::Reporting);
         Q_EMIT statusChanged(tr("Generating heatmaps"));
         HeatmapGenerator generator;
-        output.heatmaps.boardCoverage = generator.buildBoardCoverage(output.keptDetections,
-                                                                     output.imageSize,
-                                                                     &output.heatmaps.boardCoverageMin,
-                                                                     &output.heatmaps.boardCoverageMax,
-                                                                     &output.heatmaps.boardCoverageScalar);
-        output.heatmaps.pixelError = generator.buildPixelErrorHeatmap(output.keptDetections,
-                                                                      output.imageSize,
-                                                                      &output.heatmaps.pixelErrorMin,
-                                                                      &output.heatmaps.pixelErrorMax,
-                                                                      &output.heatmaps.pixelErrorScalar);
-        output.heatmaps.boardError = generator.buildBoardErrorHeatmap(output.keptDetections,
-                                                                      output.imageSize,
-                                                                      &output.heatmaps.boardErrorMin,
-                                                                      &output.heatmaps.boardErrorMax,
-                                                                      &output.heatmaps.boardErrorScalar);
-        output.heatmaps.residualScatter = generator.buildResidualScatter(output.keptDetections,
-                                                                         &output.heatmaps.residualScatterMax);
-        output.heatmaps.distortionMap = generator.buildDistortionHeatmap(output.cameraMatrix,
-                                                                         output.distCoeffs,
-                                                                         output.imageSize,
-                                                                         &output.heatmaps.distortionMin,
-                                                                         &output.heatmaps.distortionMax,
-                                                                         &output.heatmaps.distortionGrid,
-                                                                         &output.heatmaps.distortionScalar,
-                                                                         &output.heatmaps.distortionVectors);
+        output.heatmaps = generator.buildBundle(output.keptDetections,
+                                                output.cameraMatrix,
+                                                output.distCoeffs,
+                                                output.imageSize);
 
+    m_control.setStage(RunControl::Stage::Reporting);
     Q_EMIT statusChanged(tr("Exporting report"));
         exportReport(output);
 
-        if (!output.heatmaps.boardCoverage.empty()) {
-            exportHeatmap(output.heatmaps.boardCoverage, m_outputDirectory + "/board_coverage_heatmap.png");
-        }
-        if (!output.heatmaps.pixelError.empty()) {
-            exportHeatmap(output.heatmaps.pixelError, m_outputDirectory + "/reprojection_error_heatmap_pixels.png");
-        }
-        if (!output.heatmaps.boardError.empty()) {
-            exportHeatmap(output.heatmaps.boardError, m_outputDirectory + "/reprojection_error_heatmap_board.png");
-        }
+        // Raster heatmaps keep the sensor resolution on disk; each render is released
+        // as soon as it has been written.
+        exportHeatmap(output.heatmaps, HeatmapField::BoardCoverage, m_outputDirectory + "/board_coverage_heatmap.png");
+        exportHeatmap(output.heatmaps, HeatmapField::PixelError, m_outputDirectory + "/reprojection_error_heatmap_pixels.png");
+        exportHeatmap(output.heatmaps, HeatmapField::BoardError, m_outputDirectory + "/reprojection_error_heatmap_board.png");
         if (!output.heatmaps.residualScatter.empty()) {
             exportHeatmap(output.heatmaps.residualScatter, m_outputDirectory + "/reprojection_error_scatter.png");
         }
-        if (!output.heatmaps.distortionMap.empty()) {
-            exportHeatmap(output.heatmaps.distortionMap, m_outputDirectory + "/distortion_heatmap.png");
-        }
+        exportHeatmap(output.heatmaps, HeatmapField::Distortion, m_outputDirectory + "/distortion_heatmap.png");
 
         PaperFigureExporter::exportAll(output, m_outputDirectory);
 
@@ -667,23 +1041,49 @@ CalibrationOutput CalibrationEngine::executePipeline()
 
 std::vector<std::string> CalibrationEngine::collectImagePaths(const QString &directory) const
 {
+    if (!m_knownImages.isEmpty()) {
+        std::vector<std::string> paths;
+        paths.reserve(static_cast<size_t>(m_knownImages.size()));
+        for (const QString &path : m_knownImages) {
+            paths.push_back(path.toStdString());
+        }
+        return paths;
+    }
     ImageLoader loader;
     return loader.gatherImageFiles(directory.toStdString());
 }
 
-DetectionResult CalibrationEngine::detectBoard(const std::string &path) const
+DetectionResult CalibrationEngine::detectImage(const std::string &path,
+                                               const BoardSpec &spec,
+                                               const BoardDetector &detector,
+                                               ThumbnailCache *thumbnails)
 {
     DetectionResult result;
     result.name = fs::path(path).stem().string();
 
     const auto start = std::chrono::steady_clock::now();
     try {
+        RunControl::markWorker(RunControl::WorkerStage::Decoding);
         ImageLoader loader;
-        cv::Mat gray = loader.loadImage(path);
-        auto detection = m_detector.detect(gray, m_settings.boardSpec, result.name);
+        DetectionResult detection;
+        if (auto regional = detectFromBoardRegion(loader, path, spec, detector, result.name, thumbnails)) {
+            detection = std::move(*regional);
+        } else if (RunControl::cancelled()) {
+            result.message = "Detection cancelled";
+            return result;
+        } else {
+            cv::Mat gray = loader.loadImage(path);
+            if (thumbnails) {
+                thumbnails->insertAsync(QString::fromStdString(path), gray);
+            }
+            detection = detector.detect(gray, spec, result.name);
+            detection.resolution = gray.size();
+            if (detection.success) {
+                detection.sharpness = boardSharpness(gray, detection.imagePoints);
+            }
+        }
         const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
         detection.elapsed = std::chrono::milliseconds(static_cast<int64_t>(elapsedMs));
-        detection.resolution = gray.size();
         if (detection.success) {
             Logger::info(QStringLiteral("[OK] %1 completed in %2 ms (small circles=%3, large circles=%4)")
                              .arg(QString::fromStdString(result.name))
@@ -743,16 +1143,22 @@ CalibrationOutput CalibrationEngine::calibrate(const std::vector<DetectionResult
     std::vector<cv::Mat> rvecs;
     std::vector<cv::Mat> tvecs;
 
+    cv::Mat stdIntrinsics;
+    cv::Mat stdExtrinsics;
+    cv::Mat perViewErrors;
     const double rms = cv::calibrateCamera(objectPoints, imagePoints, usable.front().resolution,
                                            cameraMatrix, distCoeffs, rvecs, tvecs,
+                                           stdIntrinsics, stdExtrinsics, perViewErrors,
                                            cv::CALIB_RATIONAL_MODEL | cv::CALIB_THIN_PRISM_MODEL | cv::CALIB_TILTED_MODEL);
 
     std::vector<DetectionResult> enriched = usable;
     computeResiduals(cameraMatrix, distCoeffs, objectPoints, imagePoints, enriched, rvecs, tvecs);
+    computeViewInfluence(cameraMatrix, distCoeffs, objectPoints, enriched, rvecs, tvecs, rms);
 
     output.success = true;
     output.cameraMatrix = cameraMatrix;
     output.distCoeffs = distCoeffs;
+    output.intrinsicsStdDev = stdIntrinsics;
     output.imageSize = usable.front().resolution;
     output.keptDetections = enriched;
     output.metrics = summarize(enriched);
@@ -779,7 +1185,8 @@ CalibrationOutput CalibrationEngine::calibrate(const std::vector<DetectionResult
     return output;
 }
 
-CalibrationOutput CalibrationEngine::filterAndRecalibrate(CalibrationOutput &&input) const
+CalibrationOutput CalibrationEngine::filterAndRecalibrate(CalibrationOutput &&input,
+                                                          const std::vector<DetectionResult> &probeViews) const
 {
     if (!input.success) {
         return input;
@@ -802,6 +1209,51 @@ CalibrationOutput CalibrationEngine::filterAndRecalibrate(CalibrationOutput &&in
     auto kept = input.keptDetections;
     std::vector<DetectionResult> removed;
 
+    // Removal sets are scored by PnP on views no candidate solve has seen. View
+    // selection's left-over views serve when there are any; a strided handful keeps
+    // each score to a few PnP solves. Otherwise each iteration holds a strided
+    // subset of its unflagged views out of every candidate solve (see below).
+    std::vector<const DetectionResult *> selectionProbes;
+    if (!probeViews.empty()) {
+        const size_t stride = std::max<size_t>(1, probeViews.size() / kRobustProbeViews);
+        for (size_t i = 0; i < probeViews.size() && selectionProbes.size() < kRobustProbeViews; i += stride) {
+            selectionProbes.push_back(&probeViews[i]);
+        }
+    }
+    std::vector<const DetectionResult *> probes;
+    auto probeRms = [&probes](const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs) {
+        double sumSq = 0.0;
+        size_t count = 0;
+        for (const auto *rec : probes) {
+            cv::Mat rvec;
+            cv::Mat tvec;
+            if (!cv::solvePnP(rec->objectPoints, rec->imagePoints, cameraMatrix, distCoeffs, rvec, tvec)) {
+                continue;
+            }
+            std::vector<cv::Point2f> projected;
+            cv::projectPoints(rec->objectPoints, rvec, tvec, cameraMatrix, distCoeffs, projected);
+            for (size_t i = 0; i < projected.size(); ++i) {
+                const cv::Point2f delta = rec->imagePoints[i] - projected[i];
+                sumSq += delta.dot(delta);
+            }
+            count += projected.size();
+        }
+        return count > 0 ? std::sqrt(sumSq / static_cast<double>(count)) : std::numeric_limits<double>::infinity();
+    };
+
+    struct Candidate {
+        size_t removeCount {0};
+        std::vector<size_t> keptIndices;  // into kept, in order
+        std::vector<size_t> solveIndices; // keptIndices minus the held-out views
+        cv::Mat cameraMatrix;
+        cv::Mat distCoeffs;
+        cv::Mat stdIntrinsics;
+        std::vector<cv::Mat> rvecs;
+        std::vector<cv::Mat> tvecs;
+        double rms {0.0};
+        double score {std::numeric_limits<double>::infinity()};
+    };
+
     for (int iteration = 0; iteration < m_settings.maxIterations; ++iteration) {
         if (abortGuard()) {
             return input;
@@ -809,101 +1261,263 @@ CalibrationOutput CalibrationEngine::filterAndRecalibrate(CalibrationOutput &&in
         if (static_cast<int>(kept.size()) < m_settings.minSamples) {
             break;
         }
-        double thresholdMean = m_settings.maxMeanErrorPx;
-        double thresholdMax = m_settings.maxPointErrorPx;
-
-        std::vector<double> means;
+        const double thresholdMean = m_settings.maxMeanErrorPx;
+        const double thresholdMax = m_settings.maxPointErrorPx;
+
+        // Views are judged by how far they pull the intrinsics (Cook's distance),
+        // not by their mean error alone: a unique view at the image corner has a
+        // larger residual yet is the one worth keeping. The cut combines the usual
+        // 4/n rule with a robust outlier bound on the influence distribution.
+        double thresholdInfluence = std::numeric_limits<double>::infinity();
+        std::vector<double> influences;
+        influences.reserve(kept.size());
         for (const auto &rec : kept) {
-            means.push_back(rec.meanErrorPx());
+            influences.push_back(rec.influence);
         }
-        if (!means.empty()) {
-            std::vector<double> sorted = means;
+        if (!influences.empty()) {
+            std::vector<double> sorted = influences;
             std::nth_element(sorted.begin(), sorted.begin() + sorted.size() / 2, sorted.end());
-            double median = sorted[sorted.size() / 2];
+            const double median = sorted[sorted.size() / 2];
             double mad = 0.0;
-            for (double v : means) {
+            for (double v : influences) {
                 mad += std::abs(v - median);
             }
-            mad /= means.size();
-            thresholdMean = std::min(thresholdMean, median + 3.5 * std::max(mad, 1e-3));
+            mad /= influences.size();
+            thresholdInfluence = std::max(4.0 / static_cast<double>(kept.size()),
+                                          median + 3.5 * std::max(mad, 1e-6));
         }
 
-        std::vector<DetectionResult> next;
-        std::vector<DetectionResult> removedThisIter;
-        for (auto &rec : kept) {
-            if (rec.meanErrorPx() > thresholdMean || rec.maxErrorPx() > thresholdMax) {
-                rec.iterationRemoved = iteration + 1;
-                removedThisIter.push_back(rec);
-            } else {
-                next.push_back(rec);
+        // Flagged views, worst first by how far they overshoot their tightest cut.
+        std::vector<std::pair<double, size_t>> flagged;
+        for (size_t i = 0; i < kept.size(); ++i) {
+            const auto &rec = kept[i];
+            const double severity = std::max({rec.meanErrorPx() / thresholdMean,
+                                              rec.maxErrorPx() / thresholdMax,
+                                              rec.influence / thresholdInfluence});
+            if (severity > 1.0) {
+                flagged.emplace_back(severity, i);
+            }
+        }
+        if (flagged.empty()) {
+            break;
+        }
+        std::stable_sort(flagged.begin(), flagged.end(),
+                         [](const auto &a, const auto &b) { return a.first > b.first; });
+
+        // Candidate sets are nested prefixes of that order: the single worst view,
+        // the worst half, and everything past the cut. Each is a warm-started solve
+        // from the current intrinsics, independent of the others, so they run side
+        // by side on the thread pool.
+        std::vector<size_t> counts {1, (flagged.size() + 1) / 2, flagged.size()};
+        counts.erase(std::unique(counts.begin(), counts.end()), counts.end());
+        std::vector<bool> isFlagged(kept.size(), false);
+        for (const auto &entry : flagged) {
+            isFlagged[entry.second] = true;
+        }
+
+        // Without selection probes, a deterministic fifth of the unflagged views
+        // (at most kRobustProbeViews) sits out every candidate solve, including a
+        // no-removal baseline, and is what they are all scored on.
+        std::vector<bool> heldOut(kept.size(), false);
+        probes = selectionProbes;
+        if (probes.empty()) {
+            std::vector<size_t> unflagged;
+            for (size_t i = 0; i < kept.size(); ++i) {
+                if (!isFlagged[i]) {
+                    unflagged.push_back(i);
+                }
+            }
+            const size_t holdCount = std::min(kRobustProbeViews, std::max<size_t>(1, unflagged.size() / 5));
+            const size_t stride = std::max<size_t>(1, unflagged.size() / holdCount);
+            for (size_t i = 0; i < unflagged.size() && probes.size() < holdCount; i += stride) {
+                heldOut[unflagged[i]] = true;
+                probes.push_back(&kept[unflagged[i]]);
+            }
+            if (probes.empty()) {
+                Logger::info(QStringLiteral("Iteration %1: every view is flagged, nothing left to score removals on; stopping")
+                                 .arg(iteration + 1));
+                break;
+            }
+            counts.insert(counts.begin(), 0);
+        }
+
+        std::vector<Candidate> candidates;
+        for (size_t count : counts) {
+            std::vector<bool> drop(kept.size(), false);
+            for (size_t k = 0; k < count; ++k) {
+                drop[flagged[k].second] = true;
+            }
+            Candidate candidate;
+            candidate.removeCount = count;
+            for (size_t i = 0; i < kept.size(); ++i) {
+                if (!drop[i]) {
+                    candidate.keptIndices.push_back(i);
+                    if (!heldOut[i]) {
+                        candidate.solveIndices.push_back(i);
+                    }
+                }
+            }
+            if (static_cast<int>(candidate.solveIndices.size()) < m_settings.minSamples) {
+                continue;
+            }
+            candidates.push_back(std::move(candidate));
+        }
+        if (candidates.empty() || (candidates.size() == 1 && candidates.front().removeCount == 0)) {
+            break;
+        }
+
+        QtConcurrent::blockingMap(candidates, [&](Candidate &candidate) {
+            if (shouldAbort()) {
+                return;
+            }
+            std::vector<std::vector<cv::Point3f>> objectPoints;
+            std::vector<std::vector<cv::Point2f>> imagePoints;
+            objectPoints.reserve(candidate.solveIndices.size());
+            imagePoints.reserve(candidate.solveIndices.size());
+            for (size_t index : candidate.solveIndices) {
+                objectPoints.push_back(kept[index].objectPoints);
+                imagePoints.push_back(kept[index].imagePoints);
             }
+            try {
+                cv::Mat cameraMatrix = input.cameraMatrix.clone();
+                cv::Mat distCoeffs = input.distCoeffs.clone();
+                cv::Mat stdExtrinsics;
+                cv::Mat perViewErrors;
+                candidate.rms = cv::calibrateCamera(objectPoints, imagePoints, input.imageSize,
+                                                    cameraMatrix, distCoeffs, candidate.rvecs, candidate.tvecs,
+                                                    candidate.stdIntrinsics, stdExtrinsics, perViewErrors,
+                                                    cv::CALIB_USE_INTRINSIC_GUESS | cv::CALIB_RATIONAL_MODEL |
+                                                    cv::CALIB_THIN_PRISM_MODEL | cv::CALIB_TILTED_MODEL);
+                candidate.cameraMatrix = cameraMatrix;
+                candidate.distCoeffs = distCoeffs;
+            } catch (const cv::Exception &ex) {
+                Logger::warning(QStringLiteral("Robust candidate (%1 removed) failed: %2")
+                                    .arg(static_cast<int>(candidate.removeCount))
+                                    .arg(QString::fromStdString(ex.what())));
+                return;
+            }
+
+            candidate.score = probeRms(candidate.cameraMatrix, candidate.distCoeffs);
+        });
+
+        if (abortGuard()) {
+            return input;
+        }
+
+        // Baseline on the same yardstick: the no-removal solve when views were held
+        // out of it, otherwise the current solution (which never saw the probes).
+        double baseline = std::numeric_limits<double>::infinity();
+        if (candidates.front().removeCount == 0) {
+            baseline = candidates.front().score;
+            candidates.erase(candidates.begin());
+        } else if (!selectionProbes.empty()) {
+            baseline = probeRms(input.cameraMatrix, input.distCoeffs);
+        }
+
+        // The smallest set within epsilon of the best score wins, so a view only
+        // goes when dropping it pays for itself; ties resolve by candidate order
+        // and the outcome does not depend on which solve finished first.
+        const double epsilon = m_settings.robustMinGainPx;
+        double bestScore = std::numeric_limits<double>::infinity();
+        for (const auto &candidate : candidates) {
+            bestScore = std::min(bestScore, candidate.score);
         }
-        if (removedThisIter.empty()) {
+        const Candidate *chosen = nullptr;
+        for (const auto &candidate : candidates) {
+            if (std::isfinite(candidate.score) && candidate.score <= bestScore + epsilon) {
+                chosen = &candidate;
+                break;
+            }
+        }
+        if (!chosen) {
+            break;
+        }
+        const double gain = std::isfinite(baseline) ? baseline - chosen->score : std::numeric_limits<double>::infinity();
+        if (gain < epsilon) {
+            Logger::info(QStringLiteral("Iteration %1: best removal set (%2 of %3 flagged) gains %4 px %5 RMS, below %6 px; stopping")
+                             .arg(iteration + 1)
+                             .arg(static_cast<int>(chosen->removeCount))
+                             .arg(static_cast<int>(flagged.size()))
+                             .arg(gain, 0, 'f', 4)
+                             .arg(selectionProbes.empty() ? QStringLiteral("held-out") : QStringLiteral("probe"))
+                             .arg(epsilon, 0, 'f', 4));
             break;
         }
+
+        std::vector<DetectionResult> next;
+        std::vector<DetectionResult> removedThisIter;
+        next.reserve(chosen->keptIndices.size());
+        for (size_t index : chosen->keptIndices) {
+            next.push_back(kept[index]);
+        }
+        for (size_t k = 0; k < chosen->removeCount; ++k) {
+            auto rec = kept[flagged[k].second];
+            rec.iterationRemoved = iteration + 1;
+            removedThisIter.push_back(std::move(rec));
+        }
         removed.insert(removed.end(), removedThisIter.begin(), removedThisIter.end());
         QStringList removedNames;
         for (const auto &rec : removedThisIter) {
-            removedNames << QStringLiteral("%1 (mean=%2 px, max=%3 px)")
+            removedNames << QStringLiteral("%1 (mean=%2 px, max=%3 px, influence=%4)")
                                 .arg(QString::fromStdString(rec.name))
                                 .arg(rec.meanErrorPx(), 0, 'f', 3)
-                                .arg(rec.maxErrorPx(), 0, 'f', 3);
+                                .arg(rec.maxErrorPx(), 0, 'f', 3)
+                                .arg(rec.influence, 0, 'f', 3);
         }
-    Logger::warning(QStringLiteral("Iteration %1 removed %2 samples: %3")
+        Logger::warning(QStringLiteral("Iteration %1 removed %2 of %3 flagged samples (%4 candidate sets, %5 RMS %6 -> %7 px): %8")
                             .arg(iteration + 1)
                             .arg(removedThisIter.size())
+                            .arg(flagged.size())
+                            .arg(candidates.size())
+                            .arg(selectionProbes.empty() ? QStringLiteral("held-out") : QStringLiteral("probe"))
+                            .arg(baseline, 0, 'f', 3)
+                            .arg(chosen->score, 0, 'f', 3)
                             .arg(removedNames.join(QStringLiteral(", "))));
 
-        if (static_cast<int>(next.size()) < m_settings.minSamples) {
-            break;
-        }
-        kept = next;
-
-        // Recalibrate with kept samples
-        CalibrationOutput recalibrated;
-        recalibrated.allDetections = input.allDetections;
-        recalibrated.keptDetections = kept;
-        recalibrated.success = true;
-
+        kept = std::move(next);
         std::vector<std::vector<cv::Point3f>> objectPoints;
         std::vector<std::vector<cv::Point2f>> imagePoints;
-
-            if (abortGuard()) {
-                return input;
-            }
         for (const auto &rec : kept) {
             objectPoints.push_back(rec.objectPoints);
             imagePoints.push_back(rec.imagePoints);
         }
-
-        cv::Mat cameraMatrix = cv::Mat::eye(3, 3, CV_64F);
-        cameraMatrix.at<double>(0, 0) = input.cameraMatrix.at<double>(0, 0);
-        cameraMatrix.at<double>(1, 1) = input.cameraMatrix.at<double>(1, 1);
-        cameraMatrix.at<double>(0, 2) = input.cameraMatrix.at<double>(0, 2);
-        cameraMatrix.at<double>(1, 2) = input.cameraMatrix.at<double>(1, 2);
-
-        cv::Mat distCoeffs = input.distCoeffs.clone();
-        std::vector<cv::Mat> rvecs;
-        std::vector<cv::Mat> tvecs;
-        const double rms = cv::calibrateCamera(objectPoints, imagePoints, input.imageSize,
-                                               cameraMatrix, distCoeffs, rvecs, tvecs,
-                                               cv::CALIB_USE_INTRINSIC_GUESS | cv::CALIB_RATIONAL_MODEL |
-                                               cv::CALIB_THIN_PRISM_MODEL | cv::CALIB_TILTED_MODEL);
-
-        if (abortGuard()) {
-            return input;
+        // The winner was solved without the held-out views; they stay in the set, so
+        // it is refitted on everything it keeps, warm-started from its intrinsics.
+        Candidate solution = *chosen;
+        if (solution.solveIndices.size() != solution.keptIndices.size()) {
+            try {
+                cv::Mat stdExtrinsics;
+                cv::Mat perViewErrors;
+                solution.rms = cv::calibrateCamera(objectPoints, imagePoints, input.imageSize,
+                                                   solution.cameraMatrix, solution.distCoeffs,
+                                                   solution.rvecs, solution.tvecs,
+                                                   solution.stdIntrinsics, stdExtrinsics, perViewErrors,
+                                                   cv::CALIB_USE_INTRINSIC_GUESS | cv::CALIB_RATIONAL_MODEL |
+                                                   cv::CALIB_THIN_PRISM_MODEL | cv::CALIB_TILTED_MODEL);
+            } catch (const cv::Exception &ex) {
+                Logger::warning(QStringLiteral("Iteration %1: refit with held-out views failed: %2")
+                                    .arg(iteration + 1)
+                                    .arg(QString::fromStdString(ex.what())));
+                input.success = false;
+                input.message = tr("Robust calibration failed");
+                input.failureStage = tr("鲁棒迭代");
+                return input;
+            }
         }
-
-        computeResiduals(cameraMatrix, distCoeffs, objectPoints, imagePoints, kept, rvecs, tvecs);
-
-        input.cameraMatrix = cameraMatrix;
-        input.distCoeffs = distCoeffs;
+        computeResiduals(solution.cameraMatrix, solution.distCoeffs, objectPoints, imagePoints, kept,
+                         solution.rvecs, solution.tvecs);
+        computeViewInfluence(solution.cameraMatrix, solution.distCoeffs, objectPoints, kept,
+                             solution.rvecs, solution.tvecs, solution.rms);
+
+        input.cameraMatrix = solution.cameraMatrix;
+        input.distCoeffs = solution.distCoeffs;
+        input.intrinsicsStdDev = solution.stdIntrinsics;
         input.metrics = summarize(kept);
-        input.metrics.rms = rms;
-    Logger::info(QStringLiteral("After iteration %1: samples=%2 | RMS=%3 px | Mean=%4 px | Median=%5 px | Max=%6 px")
+        input.metrics.rms = solution.rms;
+        Logger::info(QStringLiteral("After iteration %1: samples=%2 | RMS=%3 px | Mean=%4 px | Median=%5 px | Max=%6 px")
                          .arg(iteration + 1)
                          .arg(static_cast<int>(kept.size()))
-                         .arg(rms, 0, 'f', 3)
+                         .arg(solution.rms, 0, 'f', 3)
                          .arg(input.metrics.meanErrorPx, 0, 'f', 3)
                          .arg(input.metrics.medianErrorPx, 0, 'f', 3)
                          .arg(input.metrics.maxErrorPx, 0, 'f', 3));
@@ -951,6 +1565,13 @@ CalibrationOutput CalibrationEngine::filterAndRecalibrate(CalibrationOutput &&in
                      .arg(input.metrics.meanResidualPercent[0], 0, 'f', 3)
                      .arg(input.metrics.meanResidualPercent[1], 0, 'f', 3)
                      .arg(input.metrics.meanResidualPercent[2], 0, 'f', 3));
+    if (input.intrinsicsStdDev.total() >= 4) {
+        Logger::info(QStringLiteral("Intrinsics 1σ: fx ±%1 | fy ±%2 | cx ±%3 | cy ±%4 px")
+                         .arg(input.intrinsicsStdDev.at<double>(0), 0, 'f', 3)
+                         .arg(input.intrinsicsStdDev.at<double>(1), 0, 'f', 3)
+                         .arg(input.intrinsicsStdDev.at<double>(2), 0, 'f', 3)
+                         .arg(input.intrinsicsStdDev.at<double>(3), 0, 'f', 3));
+    }
     const double depthMm = input.metrics.meanTranslationMm[2];
     const double fx = input.cameraMatrix.at<double>(0, 0);
     if (std::abs(depthMm) > 1e-3 && fx > 1e-6) {
@@ -969,6 +1590,211 @@ CalibrationOutput CalibrationEngine::filterAndRecalibrate(CalibrationOutput &&in
     return input;
 }
 
+void CalibrationEngine::evaluateValidationViews(CalibrationOutput &output, std::vector<DetectionResult> views) const
+{
+    std::vector<std::vector<cv::Point3f>> objectPoints;
+    std::vector<std::vector<cv::Point2f>> imagePoints;
+    std::vector<cv::Mat> rvecs;
+    std::vector<cv::Mat> tvecs;
+    std::vector<DetectionResult> solved;
+    solved.reserve(views.size());
+    for (auto &rec : views) {
+        if (shouldAbort()) {
+            return;
+        }
+        cv::Mat rvec;
+        cv::Mat tvec;
+        if (!cv::solvePnP(rec.objectPoints, rec.imagePoints, output.cameraMatrix, output.distCoeffs, rvec, tvec)) {
+            continue;
+        }
+        objectPoints.push_back(rec.objectPoints);
+        imagePoints.push_back(rec.imagePoints);
+        rvecs.push_back(rvec);
+        tvecs.push_back(tvec);
+        solved.push_back(std::move(rec));
+    }
+    computeResiduals(output.cameraMatrix, output.distCoeffs, objectPoints, imagePoints, solved, rvecs, tvecs);
+
+    double sumSq = 0.0;
+    size_t count = 0;
+    for (const auto &rec : solved) {
+        for (double r : rec.residualsPx) {
+            sumSq += r * r;
+        }
+        count += rec.residualsPx.size();
+    }
+    output.metrics.validationViews = static_cast<int>(solved.size());
+    output.metrics.validationRmsPx = count > 0 ? std::sqrt(sumSq / static_cast<double>(count)) : 0.0;
+    output.validationDetections = std::move(solved);
+
+    Logger::info(QStringLiteral("Validation on %1 held-out views: RMS=%2 px (solve RMS=%3 px)")
+                     .arg(output.metrics.validationViews)
+                     .arg(output.metrics.validationRmsPx, 0, 'f', 3)
+                     .arg(output.metrics.rms, 0, 'f', 3));
+}
+
+CrossValidationReport CalibrationEngine::crossValidate(const CalibrationOutput &output) const
+{
+    // A fold trains the same 18-parameter model as the full solve, so it needs as
+    // many views as a calibration run may use.
+    const int minTrainViews = std::max(m_settings.minSamples, 4);
+
+    CrossValidationReport report;
+    const auto &views = output.keptDetections;
+    const int viewCount = static_cast<int>(views.size());
+    if (viewCount < minTrainViews + 1) {
+        Logger::warning(QStringLiteral("Cross-validation skipped: %1 views are not enough").arg(viewCount));
+        return report;
+    }
+
+    int foldCount = 0;
+    switch (m_settings.validationMode) {
+    case Settings::ValidationMode::None:
+        return report;
+    case Settings::ValidationMode::HoldOut:
+        foldCount = 1;
+        report.mode = QStringLiteral("holdout");
+        break;
+    case Settings::ValidationMode::KFold:
+        foldCount = std::clamp(m_settings.validationFolds, 2, viewCount);
+        report.mode = QStringLiteral("kfold");
+        break;
+    }
+
+    // Fixed seed so reruns on the same dataset produce the same folds.
+    std::vector<int> order(static_cast<size_t>(viewCount));
+    std::iota(order.begin(), order.end(), 0);
+    std::mt19937 rng(0x5EEDu);
+    std::shuffle(order.begin(), order.end(), rng);
+    std::vector<int> foldOf(static_cast<size_t>(viewCount), -1);
+    if (foldCount == 1) {
+        const int testCount = std::clamp(static_cast<int>(std::lround(m_settings.holdOutFraction * viewCount)),
+                                         1, viewCount - minTrainViews);
+        for (int i = 0; i < testCount; ++i) {
+            foldOf[static_cast<size_t>(order[static_cast<size_t>(i)])] = 0;
+        }
+    } else {
+        for (int i = 0; i < viewCount; ++i) {
+            foldOf[static_cast<size_t>(order[static_cast<size_t>(i)])] = i % foldCount;
+        }
+    }
+
+    // Folds are independent solves over the cached detections, so they run side by
+    // side on the thread pool. Each is seeded from its own training views only: the
+    // full-set intrinsics were fitted on the fold's test views too and would leak
+    // them into training.
+    std::vector<ValidationFold> folds(static_cast<size_t>(foldCount));
+    std::vector<int> foldIds(static_cast<size_t>(foldCount));
+    std::iota(foldIds.begin(), foldIds.end(), 0);
+    QtConcurrent::blockingMap(foldIds, [&](int &fold) {
+        std::vector<std::vector<cv::Point3f>> trainObjects;
+        std::vector<std::vector<cv::Point2f>> trainImages;
+        std::vector<size_t> testViews;
+        for (size_t i = 0; i < views.size(); ++i) {
+            if (foldOf[i] == fold) {
+                testViews.push_back(i);
+            } else {
+                trainObjects.push_back(views[i].objectPoints);
+                trainImages.push_back(views[i].imagePoints);
+            }
+        }
+
+        ValidationFold result;
+        result.trainViews = static_cast<int>(trainObjects.size());
+        result.testViews = static_cast<int>(testViews.size());
+        if (result.trainViews < minTrainViews || testViews.empty() || shouldAbort()) {
+            folds[static_cast<size_t>(fold)] = result;
+            return;
+        }
+
+        try {
+            cv::Mat cameraMatrix = cv::initCameraMatrix2D(trainObjects, trainImages, output.imageSize);
+            cv::Mat distCoeffs = cv::Mat::zeros(1, 14, CV_64F);
+            std::vector<cv::Mat> rvecs;
+            std::vector<cv::Mat> tvecs;
+            result.trainRmsPx = cv::calibrateCamera(trainObjects, trainImages, output.imageSize,
+                                                    cameraMatrix, distCoeffs, rvecs, tvecs,
+                                                    cv::CALIB_USE_INTRINSIC_GUESS | cv::CALIB_RATIONAL_MODEL |
+                                                    cv::CALIB_THIN_PRISM_MODEL | cv::CALIB_TILTED_MODEL);
+
+            double sumSq = 0.0;
+            int points = 0;
+            for (size_t index : testViews) {
+                const auto &rec = views[index];
+                cv::Mat rvec;
+                cv::Mat tvec;
+                if (!cv::solvePnP(rec.objectPoints, rec.imagePoints, cameraMatrix, distCoeffs, rvec, tvec)) {
+                    continue;
+                }
+                std::vector<cv::Point2f> projected;
+                cv::projectPoints(rec.objectPoints, rvec, tvec, cameraMatrix, distCoeffs, projected);
+                for (size_t i = 0; i < projected.size(); ++i) {
+                    const cv::Point2f delta = rec.imagePoints[i] - projected[i];
+                    sumSq += delta.dot(delta);
+                }
+                points += static_cast<int>(projected.size());
+            }
+            result.testPoints = points;
+            result.testRmsPx = points > 0 ? std::sqrt(sumSq / points) : 0.0;
+            result.cameraMatrix = cameraMatrix;
+            result.distCoeffs = distCoeffs;
+        } catch (const cv::Exception &ex) {
+            Logger::warning(QStringLiteral("Cross-validation fold %1 failed: %2")
+                                .arg(fold + 1)
+                                .arg(QString::fromStdString(ex.what())));
+        }
+        folds[static_cast<size_t>(fold)] = result;
+    });
+
+    double sumRms = 0.0;
+    double sumSq = 0.0;
+    int points = 0;
+    std::vector<cv::Vec4d> intrinsics;
+    for (const auto &fold : folds) {
+        if (fold.cameraMatrix.empty() || fold.testPoints <= 0) {
+            continue;
+        }
+        sumRms += fold.testRmsPx;
+        sumSq += fold.testRmsPx * fold.testRmsPx * fold.testPoints;
+        points += fold.testPoints;
+        intrinsics.emplace_back(fold.cameraMatrix.at<double>(0, 0), fold.cameraMatrix.at<double>(1, 1),
+                                fold.cameraMatrix.at<double>(0, 2), fold.cameraMatrix.at<double>(1, 2));
+    }
+    report.folds = std::move(folds);
+    if (intrinsics.empty()) {
+        return report;
+    }
+    report.meanTestRmsPx = sumRms / static_cast<double>(intrinsics.size());
+    report.pooledTestRmsPx = std::sqrt(sumSq / points);
+    if (intrinsics.size() > 1) {
+        cv::Vec4d mean {0.0, 0.0, 0.0, 0.0};
+        for (const auto &v : intrinsics) {
+            mean += v;
+        }
+        mean *= 1.0 / static_cast<double>(intrinsics.size());
+        cv::Vec4d variance {0.0, 0.0, 0.0, 0.0};
+        for (const auto &v : intrinsics) {
+            const cv::Vec4d diff = v - mean;
+            variance += diff.mul(diff);
+        }
+        variance *= 1.0 / static_cast<double>(intrinsics.size() - 1);
+        for (int i = 0; i < 4; ++i) {
+            report.intrinsicsSpread[i] = std::sqrt(variance[i]);
+        }
+    }
+
+    Logger::info(QStringLiteral("Cross-validation (%1, %2 folds): test RMS mean=%3 px | pooled=%4 px | spread fx=%5 fy=%6 cx=%7 cy=%8 px")
+                     .arg(report.mode)
+                     .arg(static_cast<int>(intrinsics.size()))
+                     .arg(report.meanTestRmsPx, 0, 'f', 3)
+                     .arg(report.pooledTestRmsPx, 0, 'f', 3)
+                     .arg(report.intrinsicsSpread[0], 0, 'f', 2)
+                     .arg(report.intrinsicsSpread[1], 0, 'f', 2)
+                     .arg(report.intrinsicsSpread[2], 0, 'f', 2)
+                     .arg(report.intrinsicsSpread[3], 0, 'f', 2));
+    return report;
+}
+
 void CalibrationEngine::exportReport(const CalibrationOutput &output) const
 {
     ensureDirectory(m_outputDirectory);
@@ -984,6 +1810,10 @@ void CalibrationEngine::exportReport(const CalibrationOutput &output) const
     root.insert("std_reprojection_px", output.metrics.stdErrorPx);
     root.insert("p95_reprojection_px", output.metrics.p95ErrorPx);
     root.insert("distortion_max_shift_px", output.heatmaps.distortionMax);
+    if (output.metrics.validationViews > 0) {
+        root.insert("validation_views", output.metrics.validationViews);
+        root.insert("validation_rms_px", output.metrics.validationRmsPx);
+    }
 
     QJsonObject translation;
     translation.insert("mean_x_mm", output.metrics.meanTranslationMm[0]);
@@ -1005,6 +1835,21 @@ void CalibrationEngine::exportReport(const CalibrationOutput &output) const
 
     root.insert("camera_matrix", matToJson(output.cameraMatrix));
     root.insert("distortion_coefficients", matToJson(output.distCoeffs));
+    root.insert("image_size", QJsonArray{output.imageSize.width, output.imageSize.height});
+
+    if (!output.intrinsicsStdDev.empty()) {
+        static const char *kIntrinsicNames[] = {"fx", "fy", "cx", "cy", "k1", "k2", "p1", "p2", "k3",
+                                                "k4", "k5", "k6", "s1", "s2", "s3", "s4", "tau_x", "tau_y"};
+        const int count = std::min(static_cast<int>(output.intrinsicsStdDev.total()),
+                                   static_cast<int>(std::size(kIntrinsicNames)));
+        QJsonObject uncertainty;
+        for (int i = 0; i < count; ++i) {
+            const double sigma = output.intrinsicsStdDev.at<double>(i);
+            uncertainty.insert(QString::fromLatin1(kIntrinsicNames[i]),
+                               QJsonObject{{"std", sigma}, {"ci95", 1.96 * sigma}});
+        }
+        root.insert("intrinsics_uncertainty", uncertainty);
+    }
 
     auto vecToJsonArray = [](const cv::Vec3d &vec) {
         return QJsonArray{vec[0], vec[1], vec[2]};
@@ -1023,6 +1868,8 @@ void CalibrationEngine::exportReport(const CalibrationOutput &output) const
         item.insert("max_error_px", rec.maxErrorPx());
         item.insert("translation_mm", QJsonArray{rec.translationMm[0], rec.translationMm[1], rec.translationMm[2]});
         item.insert("rotation_deg", QJsonArray{rec.rotationDeg[0], rec.rotationDeg[1], rec.rotationDeg[2]});
+        item.insert("leverage", rec.leverage);
+        item.insert("influence", rec.influence);
         detectionsJson.append(item);
     }
     root.insert("kept_samples", detectionsJson);
@@ -1034,15 +1881,59 @@ void CalibrationEngine::exportReport(const CalibrationOutput &output) const
         item.insert("iteration", rec.iterationRemoved);
         item.insert("mean_error_px", rec.meanErrorPx());
         item.insert("max_error_px", rec.maxErrorPx());
+        item.insert("influence", rec.influence);
         removedJson.append(item);
     }
     root.insert("removed_samples", removedJson);
 
+    if (!output.crossValidation.mode.isEmpty()) {
+        const auto &cross = output.crossValidation;
+        QJsonObject validation;
+        validation.insert("mode", cross.mode);
+        validation.insert("mean_test_rms_px", cross.meanTestRmsPx);
+        validation.insert("pooled_test_rms_px", cross.pooledTestRmsPx);
+        validation.insert("intrinsics_spread_px", QJsonObject{{"fx", cross.intrinsicsSpread[0]},
+                                                              {"fy", cross.intrinsicsSpread[1]},
+                                                              {"cx", cross.intrinsicsSpread[2]},
+                                                              {"cy", cross.intrinsicsSpread[3]}});
+        QJsonArray foldsJson;
+        for (const auto &fold : cross.folds) {
+            QJsonObject item;
+            item.insert("train_views", fold.trainViews);
+            item.insert("test_views", fold.testViews);
+            item.insert("train_rms_px", fold.trainRmsPx);
+            item.insert("test_rms_px", fold.testRmsPx);
+            if (!fold.cameraMatrix.empty()) {
+                item.insert("camera_matrix", matToJson(fold.cameraMatrix));
+            }
+            foldsJson.append(item);
+        }
+        validation.insert("folds", foldsJson);
+        root.insert("cross_validation", validation);
+    }
+
     const QString jsonPath = m_outputDirectory + "/calibration_report.json";
     QFile file(jsonPath);
     if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
         file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
     }
+
+    // Inputs and precomputed table for the undistortion runtime, so stations neither
+    // parse the full report nor rebuild the table.
+    if (!output.cameraMatrix.empty() && output.imageSize.area() > 0) {
+        const UndistortCalibration calibration {output.cameraMatrix, output.distCoeffs, output.imageSize};
+        const QString calibrationPath = m_outputDirectory + "/" + QString::fromLatin1(kCalibrationFileName);
+        std::string error;
+        if (!saveCalibration(calibrationPath.toStdString(), calibration, &error)) {
+            Logger::warning(QStringLiteral("Failed to write %1: %2")
+                                .arg(QString::fromLatin1(kCalibrationFileName), QString::fromStdString(error)));
+        }
+        const UndistortMap map = UndistortMap::build(calibration);
+        const QString mapPath = m_outputDirectory + "/" + QString::fromLatin1(UndistortMap::kFileName);
+        if (!map.save(mapPath.toStdString(), &error)) {
+            Logger::warning(QStringLiteral("Failed to write undistort map: %1").arg(QString::fromStdString(error)));
+        }
+    }
 }
 
 void CalibrationEngine::exportHeatmap(const cv::Mat &heatmap, const QString &path) const
@@ -1054,6 +1945,17 @@ void CalibrationEngine::exportHeatmap(const cv::Mat &heatmap, const QString &pat
     cv::imwrite(path.toStdString(), heatmap);
 }
 
+void CalibrationEngine::exportHeatmap(const HeatmapBundle &bundle, HeatmapField field, const QString &path) const
+{
+    if (!bundle.hasField(field)) {
+        return;
+    }
+    const auto rendered = bundle.render(field, bundle.imageSize);
+    if (rendered) {
+        exportHeatmap(*rendered, path);
+    }
+}
+
 void CalibrationEngine::ensureDirectory(const QString &path)
 {
     QDir dir(path);
@@ -0,0 +1,285 @@
+#include "CaptureGuidance.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include <opencv2/calib3d.hpp>
+
+namespace mycalib {
+
+namespace {
+
+constexpr int kDistCount = 5;
+constexpr int kExtrinsicCount = 6;
+// Fraction of the image width a nominal view's board spans when no calibrated
+// depth is known yet.
+constexpr double kNominalBoardFill = 0.45;
+
+double logDet(const CaptureGuidance::InfoMatrix &matrix)
+{
+    cv::Mat eigenvalues;
+    if (!cv::eigen(cv::Mat(matrix), eigenvalues)) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    double sum = 0.0;
+    for (int i = 0; i < eigenvalues.rows; ++i) {
+        sum += std::log(std::max(eigenvalues.at<double>(i, 0), 1e-300));
+    }
+    return sum;
+}
+
+cv::Matx33d tiltRotation(const CaptureTilt &tilt)
+{
+    const double pitch = tilt.pitchDeg * CV_PI / 180.0;
+    const double yaw = tilt.yawDeg * CV_PI / 180.0;
+    const cv::Matx33d rx(1.0, 0.0, 0.0,
+                         0.0, std::cos(pitch), -std::sin(pitch),
+                         0.0, std::sin(pitch), std::cos(pitch));
+    const cv::Matx33d ry(std::cos(yaw), 0.0, std::sin(yaw),
+                         0.0, 1.0, 0.0,
+                         -std::sin(yaw), 0.0, std::cos(yaw));
+    return ry * rx;
+}
+
+} // namespace
+
+void CaptureGuidance::reset(const BoardSpec &spec,
+                            const cv::Size &imageSize,
+                            const cv::Mat &cameraMatrix,
+                            const cv::Mat &distCoeffs,
+                            double pixelSigma)
+{
+    m_ready = false;
+    m_viewCount = 0;
+    m_observedDepths.clear();
+    m_information = InfoMatrix::zeros();
+    if (imageSize.width <= 0 || imageSize.height <= 0) {
+        return;
+    }
+
+    m_spec = spec;
+    m_imageSize = imageSize;
+    m_pixelSigma = pixelSigma > 0.0 ? pixelSigma : 0.25;
+    if (cameraMatrix.rows == 3 && cameraMatrix.cols == 3) {
+        cv::Mat converted;
+        cameraMatrix.convertTo(converted, CV_64F);
+        m_cameraMatrix = cv::Matx33d(converted);
+    } else {
+        const double f = static_cast<double>(imageSize.width);
+        m_cameraMatrix = cv::Matx33d(f, 0.0, 0.5 * (imageSize.width - 1),
+                                     0.0, f, 0.5 * (imageSize.height - 1),
+                                     0.0, 0.0, 1.0);
+    }
+    m_distCoeffs = cv::Mat::zeros(kDistCount, 1, CV_64F);
+    if (!distCoeffs.empty()) {
+        cv::Mat flat;
+        distCoeffs.reshape(1, static_cast<int>(distCoeffs.total())).convertTo(flat, CV_64F);
+        for (int i = 0; i < std::min(kDistCount, flat.rows); ++i) {
+            m_distCoeffs.at<double>(i, 0) = flat.at<double>(i, 0);
+        }
+    }
+
+    m_objectPoints = spec.buildObjectPoints(static_cast<int>(spec.expectedCircleCount()));
+    if (m_objectPoints.empty()) {
+        return;
+    }
+    cv::Point3d sum(0.0, 0.0, 0.0);
+    for (const auto &pt : m_objectPoints) {
+        sum += cv::Point3d(pt.x, pt.y, pt.z);
+    }
+    m_boardCentre = sum * (1.0 / static_cast<double>(m_objectPoints.size()));
+
+    // Weak prior so the matrix stays invertible before the first views arrive.
+    const double fx = m_cameraMatrix(0, 0);
+    const double fy = m_cameraMatrix(1, 1);
+    const std::array<double, kParamCount> priorSigma {
+        0.5 * fx, 0.5 * fy,
+        0.25 * imageSize.width, 0.25 * imageSize.height,
+        1.0, 1.0, 0.05, 0.05, 1.0};
+    for (int i = 0; i < kParamCount; ++i) {
+        m_information(i, i) = 1.0 / (priorSigma[static_cast<size_t>(i)] * priorSigma[static_cast<size_t>(i)]);
+    }
+    m_ready = true;
+}
+
+bool CaptureGuidance::addObservedView(const DetectionResult &detection)
+{
+    if (!m_ready || !detection.success || detection.objectPoints.empty() ||
+        cv::norm(detection.translationMm) <= 0.0) {
+        return false;
+    }
+    cv::Vec3d rvec;
+    cv::Rodrigues(cv::Mat(detection.rotationMatrix), rvec);
+    InfoMatrix information;
+    if (!viewInformation(detection.objectPoints, rvec, detection.translationMm, information)) {
+        return false;
+    }
+    m_information += information;
+    ++m_viewCount;
+    const cv::Vec3d centre = detection.rotationMatrix * cv::Vec3d(m_boardCentre.x, m_boardCentre.y, m_boardCentre.z) +
+                             detection.translationMm;
+    if (centre[2] > 0.0) {
+        m_observedDepths.push_back(centre[2]);
+    }
+    return true;
+}
+
+bool CaptureGuidance::addNominalView(int row, int col, int gridRows, int gridCols, const CaptureTilt &tilt)
+{
+    if (!m_ready) {
+        return false;
+    }
+    cv::Vec3d rvec;
+    cv::Vec3d tvec;
+    InfoMatrix information;
+    if (!nominalPose(row, col, gridRows, gridCols, tilt, rvec, tvec) ||
+        !viewInformation(m_objectPoints, rvec, tvec, information)) {
+        return false;
+    }
+    m_information += information;
+    ++m_viewCount;
+    return true;
+}
+
+double CaptureGuidance::expectedGain(int row, int col, int gridRows, int gridCols, const CaptureTilt &tilt) const
+{
+    if (!m_ready) {
+        return 0.0;
+    }
+    cv::Vec3d rvec;
+    cv::Vec3d tvec;
+    InfoMatrix information;
+    if (!nominalPose(row, col, gridRows, gridCols, tilt, rvec, tvec) ||
+        !viewInformation(m_objectPoints, rvec, tvec, information)) {
+        return 0.0;
+    }
+    return logDet(m_information + information) - logDet(m_information);
+}
+
+CaptureRecommendation CaptureGuidance::recommend(int gridRows, int gridCols, const std::vector<CaptureTilt> &tilts) const
+{
+    CaptureRecommendation best;
+    if (!m_ready || gridRows <= 0 || gridCols <= 0 || tilts.empty()) {
+        return best;
+    }
+    const double baseline = logDet(m_information);
+    for (int r = 0; r < gridRows; ++r) {
+        for (int c = 0; c < gridCols; ++c) {
+            for (size_t t = 0; t < tilts.size(); ++t) {
+                cv::Vec3d rvec;
+                cv::Vec3d tvec;
+                InfoMatrix information;
+                if (!nominalPose(r, c, gridRows, gridCols, tilts[t], rvec, tvec) ||
+                    !viewInformation(m_objectPoints, rvec, tvec, information)) {
+                    continue;
+                }
+                const double gain = logDet(m_information + information) - baseline;
+                if (!best.valid || gain > best.gain) {
+                    best.bestOther = best.valid ? best.gain : 0.0;
+                    best.valid = true;
+                    best.row = r;
+                    best.col = c;
+                    best.tiltIndex = static_cast<int>(t);
+                    best.gain = gain;
+                } else if (gain > best.bestOther) {
+                    best.bestOther = gain;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+std::array<double, CaptureGuidance::kParamCount> CaptureGuidance::parameterStdDev() const
+{
+    std::array<double, kParamCount> sigma {};
+    if (!m_ready) {
+        return sigma;
+    }
+    bool ok = false;
+    const InfoMatrix covariance = m_information.inv(cv::DECOMP_CHOLESKY, &ok);
+    if (!ok) {
+        sigma.fill(std::numeric_limits<double>::infinity());
+        return sigma;
+    }
+    for (int i = 0; i < kParamCount; ++i) {
+        sigma[static_cast<size_t>(i)] = std::sqrt(std::max(covariance(i, i), 0.0));
+    }
+    return sigma;
+}
+
+double CaptureGuidance::nominalDepth() const
+{
+    if (!m_observedDepths.empty()) {
+        std::vector<double> depths = m_observedDepths;
+        const auto mid = depths.begin() + static_cast<std::ptrdiff_t>(depths.size() / 2);
+        std::nth_element(depths.begin(), mid, depths.end());
+        return *mid;
+    }
+    float minX = std::numeric_limits<float>::max();
+    float maxX = std::numeric_limits<float>::lowest();
+    for (const auto &pt : m_objectPoints) {
+        minX = std::min(minX, pt.x);
+        maxX = std::max(maxX, pt.x);
+    }
+    const double extent = std::max(1.0, static_cast<double>(maxX - minX));
+    return m_cameraMatrix(0, 0) * extent / (kNominalBoardFill * m_imageSize.width);
+}
+
+bool CaptureGuidance::nominalPose(int row, int col, int gridRows, int gridCols, const CaptureTilt &tilt,
+                                  cv::Vec3d &rvec, cv::Vec3d &tvec) const
+{
+    if (gridRows <= 0 || gridCols <= 0 || row < 0 || col < 0 || row >= gridRows || col >= gridCols) {
+        return false;
+    }
+    const double u = (col + 0.5) * m_imageSize.width / gridCols;
+    const double v = (row + 0.5) * m_imageSize.height / gridRows;
+    const double depth = nominalDepth();
+    const cv::Vec3d centre((u - m_cameraMatrix(0, 2)) / m_cameraMatrix(0, 0) * depth,
+                           (v - m_cameraMatrix(1, 2)) / m_cameraMatrix(1, 1) * depth,
+                           depth);
+    const cv::Matx33d rotation = tiltRotation(tilt);
+    tvec = centre - rotation * cv::Vec3d(m_boardCentre.x, m_boardCentre.y, m_boardCentre.z);
+    cv::Rodrigues(cv::Mat(rotation), rvec);
+    return true;
+}
+
+bool CaptureGuidance::viewInformation(const std::vector<cv::Point3f> &objectPoints,
+                                      const cv::Vec3d &rvec,
+                                      const cv::Vec3d &tvec,
+                                      InfoMatrix &information) const
+{
+    if (objectPoints.empty()) {
+        return false;
+    }
+    std::vector<cv::Point2f> projected;
+    cv::Mat jacobian;
+    cv::projectPoints(objectPoints, rvec, tvec, cv::Mat(m_cameraMatrix), m_distCoeffs, projected, jacobian);
+
+    // Only views whose points all land on the sensor count; a board hanging off the
+    // edge would not be detected.
+    const cv::Rect2f bounds(0.0F, 0.0F, static_cast<float>(m_imageSize.width), static_cast<float>(m_imageSize.height));
+    for (const auto &pt : projected) {
+        if (!bounds.contains(pt)) {
+            return false;
+        }
+    }
+
+    // projectPoints column layout: rvec(3) tvec(3) f(2) c(2) dist(5).
+    const cv::Mat extrinsic = jacobian.colRange(0, kExtrinsicCount);
+    const cv::Mat intrinsic = jacobian.colRange(kExtrinsicCount, kExtrinsicCount + kParamCount);
+    const cv::Mat A = intrinsic.t() * intrinsic;
+    const cv::Mat B = intrinsic.t() * extrinsic;
+    const cv::Mat C = extrinsic.t() * extrinsic;
+    cv::Mat cInv;
+    if (cv::invert(C, cInv, cv::DECOMP_CHOLESKY) == 0.0) {
+        return false;
+    }
+    const cv::Mat schur = (A - B * cInv * B.t()) / (m_pixelSigma * m_pixelSigma);
+    information = InfoMatrix(reinterpret_cast<const double *>(schur.ptr()));
+    return true;
+}
+
+} // namespace mycalib
@@ -0,0 +1,151 @@
+#include "DatasetIndex.h"
+
+#include <algorithm>
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrent>
+
+#include "ImageLoader.h"
+
+namespace mycalib {
+
+namespace {
+
+// Bursts of watcher events (a camera writing frames, a copy in progress) collapse
+// into one rescan after this quiet period.
+constexpr int kRescanDebounceMs = 150;
+
+QStringList scanDirectory(const QString &directory)
+{
+    QStringList files;
+    QDirIterator it(directory, QDir::Files | QDir::Readable);
+    while (it.hasNext()) {
+        const QString path = it.next();
+        if (ImageLoader::isSupportedImage(it.fileName().toStdString())) {
+            files.append(path);
+        }
+    }
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+QString cleanDirectory(const QString &directory)
+{
+    return directory.isEmpty() ? QString() : QDir::cleanPath(QDir(directory).absolutePath());
+}
+
+} // namespace
+
+DatasetIndex::DatasetIndex(QObject *parent)
+    : QObject(parent)
+    , m_watcher(new QFileSystemWatcher(this))
+    , m_debounce(new QTimer(this))
+    , m_scan(new QFutureWatcher<QStringList>(this))
+{
+    m_debounce->setSingleShot(true);
+    m_debounce->setInterval(kRescanDebounceMs);
+    connect(m_debounce, &QTimer::timeout, this, &DatasetIndex::startScan);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &DatasetIndex::scheduleRescan);
+    connect(m_scan, &QFutureWatcher<QStringList>::finished, this, [this]() {
+        const bool current = m_scanGeneration == m_generation;
+        const QStringList files = m_scan->result();
+        if (current) {
+            applyScan(files);
+        }
+        if (m_rescanPending || !current) {
+            m_rescanPending = false;
+            startScan();
+        }
+    });
+}
+
+DatasetIndex::~DatasetIndex()
+{
+    m_scan->waitForFinished();
+}
+
+void DatasetIndex::setDirectory(const QString &directory)
+{
+    const QString cleaned = cleanDirectory(directory);
+    if (cleaned == m_directory) {
+        return;
+    }
+    if (!m_watcher->directories().isEmpty()) {
+        m_watcher->removePaths(m_watcher->directories());
+    }
+    ++m_generation;
+    m_directory = cleaned;
+    m_ready = false;
+    m_rescanPending = false;
+    m_debounce->stop();
+    const bool hadFiles = !m_files.isEmpty();
+    m_files.clear();
+    if (m_directory.isEmpty()) {
+        if (hadFiles) {
+            Q_EMIT changed(0);
+        }
+        return;
+    }
+    m_watcher->addPath(m_directory);
+    startScan();
+}
+
+bool DatasetIndex::covers(const QString &directory) const
+{
+    return m_ready && !m_directory.isEmpty() && cleanDirectory(directory) == m_directory;
+}
+
+void DatasetIndex::noteFileAdded(const QString &path)
+{
+    const QFileInfo info(path);
+    if (!m_ready || cleanDirectory(info.absolutePath()) != m_directory ||
+        !ImageLoader::isSupportedImage(info.fileName().toStdString())) {
+        return;
+    }
+    const QString absolute = QDir::cleanPath(info.absoluteFilePath());
+    const auto it = std::lower_bound(m_files.begin(), m_files.end(), absolute);
+    if (it != m_files.end() && *it == absolute) {
+        return;
+    }
+    m_files.insert(it, absolute);
+    Q_EMIT changed(count());
+}
+
+void DatasetIndex::scheduleRescan()
+{
+    // The directory may have been deleted and recreated, which drops the watch.
+    if (!m_directory.isEmpty() && m_watcher->directories().isEmpty() && QFileInfo::exists(m_directory)) {
+        m_watcher->addPath(m_directory);
+    }
+    m_debounce->start();
+}
+
+void DatasetIndex::startScan()
+{
+    if (m_directory.isEmpty()) {
+        return;
+    }
+    if (m_scan->isRunning()) {
+        m_rescanPending = true;
+        return;
+    }
+    m_scanGeneration = m_generation;
+    m_scan->setFuture(QtConcurrent::run(scanDirectory, m_directory));
+}
+
+void DatasetIndex::applyScan(const QStringList &files)
+{
+    const bool firstScan = !m_ready;
+    m_ready = true;
+    if (!firstScan && files == m_files) {
+        return;
+    }
+    m_files = files;
+    Q_EMIT changed(count());
+}
+
+} // namespace mycalib
@@ -5,6 +5,7 @@
 
 #include <QComboBox>
 #include <QEvent>
+#include <QFileInfo>
 #include <QFrame>
 #include <QHBoxLayout>
 #include <QLabel>
@@ -23,6 +24,9 @@
 #include <opencv2/imgcodecs.hpp>
 #include <opencv2/imgproc.hpp>
 
+#include "ImageLoader.h"
+#include "ThumbnailCache.h"
+
 namespace mycalib {
 
 namespace {
@@ -164,26 +168,32 @@ void DetectionPreviewWidget::clear()
     updateZoomUi();
 }
 
-void DetectionPreviewWidget::setDetection(const DetectionResult &result)
+void DetectionPreviewWidget::setDetection(const DetectionResult &result, const QString &sourcePath)
 {
     m_views.clear();
     m_currentIndex = -1;
+    m_originalPixmap = QPixmap();
 
+    // Views are decoded lazily, when selected, at the resolution they are shown at.
+    if (!sourcePath.isEmpty() && QFileInfo::exists(sourcePath)) {
+        ViewItem source;
+        source.title = tr("Source image");
+        source.filePath = sourcePath;
+        source.sourceImage = true;
+        m_views.push_back(std::move(source));
+    }
     for (const auto &view : result.debugImages) {
         if (view.filePath.empty()) {
             continue;
         }
-        cv::Mat decoded = cv::imread(view.filePath, cv::IMREAD_UNCHANGED);
-        if (decoded.empty()) {
+        const QString filePath = QString::fromStdString(view.filePath);
+        if (!QFileInfo::exists(filePath)) {
             continue;
         }
-        QImage converted = matToQImage(decoded);
-        if (!converted.isNull()) {
-            ViewItem item;
-            item.title = QString::fromStdString(view.label);
-            item.image = converted;
-            m_views.push_back(std::move(item));
-        }
+        ViewItem item;
+        item.title = QString::fromStdString(view.label);
+        item.filePath = filePath;
+        m_views.push_back(std::move(item));
     }
 
     if (m_views.empty()) {
@@ -207,6 +217,8 @@ void DetectionPreviewWidget::setDetection(const DetectionResult &result)
     ViewItem fallback;
     fallback.title = tr("Placeholder");
         fallback.image = placeholder;
+        fallback.fullSize = placeholder.size();
+        fallback.fullyLoaded = true;
         m_views.push_back(fallback);
     }
 
@@ -285,7 +297,7 @@ void DetectionPreviewWidget::handleStageChanged(int index)
         return;
     }
     m_currentIndex = index;
-    m_originalPixmap = QPixmap::fromImage(m_views[static_cast<size_t>(m_currentIndex)].image);
+    m_originalPixmap = QPixmap();
     updateImage();
     updateZoomUi();
 }
@@ -309,13 +321,32 @@ void DetectionPreviewWidget::updateImage()
         m_imageLabel->clear();
         return;
     }
-    if (m_originalPixmap.isNull()) {
-        const QImage &img = m_views[static_cast<size_t>(m_currentIndex)].image;
-        if (img.isNull()) {
-            m_imageLabel->clear();
-            return;
+    ViewItem &view = m_views[static_cast<size_t>(m_currentIndex)];
+    const QSize available = m_scrollArea->viewport()->size();
+    // Fit-to-window is an overview, so it is served from the cache's top level at most.
+    const int fitLongSide = std::min(std::max(available.width(), available.height()), ThumbnailCache::kTopLevelLongSide);
+    if (view.image.isNull() && !ensureResolution(view, fitLongSide)) {
+        m_originalPixmap = QPixmap();
+        m_imageLabel->clear();
+        return;
+    }
+    // Zoom is relative to the file's own resolution, whichever level is loaded.
+    const QSize fullSize = view.fullSize.isEmpty() ? view.image.size() : view.fullSize;
+    QSize target = fullSize;
+    if (m_fitToWindow) {
+        if (!available.isEmpty()) {
+            target = fullSize.scaled(available, Qt::KeepAspectRatio);
         }
-        m_originalPixmap = QPixmap::fromImage(img);
+    } else {
+        target = (QSizeF(fullSize) * m_scaleFactor).toSize();
+        target.setWidth(std::max(1, target.width()));
+        target.setHeight(std::max(1, target.height()));
+    }
+    ensureResolution(view, m_fitToWindow ? std::min(std::max(target.width(), target.height()), fitLongSide)
+                                         : std::max(target.width(), target.height()));
+    if (m_originalPixmap.isNull() || m_pixmapImageKey != view.image.cacheKey()) {
+        m_originalPixmap = QPixmap::fromImage(view.image);
+        m_pixmapImageKey = view.image.cacheKey();
     }
     if (m_originalPixmap.isNull()) {
         m_imageLabel->clear();
@@ -331,7 +362,6 @@ void DetectionPreviewWidget::updateImage()
         m_imageLabel->setMaximumSize(QSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX));
         m_innerFrame->setMinimumSize(QSize(0, 0));
         m_innerFrame->setMaximumSize(QSize(QWIDGETSIZE_MAX, QWIDGETSIZE_MAX));
-        const QSize available = m_scrollArea->viewport()->size();
         if (!available.isEmpty()) {
             QPixmap scaled = m_originalPixmap.scaled(available, Qt::KeepAspectRatio, Qt::SmoothTransformation);
             m_imageLabel->setPixmap(scaled);
@@ -342,10 +372,6 @@ void DetectionPreviewWidget::updateImage()
         if (m_scrollArea->widgetResizable()) {
             m_scrollArea->setWidgetResizable(false);
         }
-        const QSizeF baseSize = m_originalPixmap.size();
-        QSize target = (baseSize * m_scaleFactor).toSize();
-        target.setWidth(std::max(1, target.width()));
-        target.setHeight(std::max(1, target.height()));
         QPixmap scaled = m_originalPixmap.scaled(target, Qt::KeepAspectRatio, Qt::SmoothTransformation);
         m_imageLabel->setPixmap(scaled);
         m_imageLabel->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
@@ -359,6 +385,39 @@ void DetectionPreviewWidget::updateImage()
     }
 }
 
+bool DetectionPreviewWidget::ensureResolution(ViewItem &view, int longSide)
+{
+    if (view.fullyLoaded || view.filePath.isEmpty()) {
+        return !view.image.isNull();
+    }
+    if (!view.image.isNull() && std::max(view.image.width(), view.image.height()) >= longSide) {
+        return true;
+    }
+    const int fullLongSide = view.fullSize.isEmpty() ? 0 : std::max(view.fullSize.width(), view.fullSize.height());
+    const bool wantsOriginal = fullLongSide > 0 && longSide >= fullLongSide;
+    if (m_thumbnails && !wantsOriginal) {
+        ThumbnailCache::Hit hit = m_thumbnails->lookup(view.filePath, longSide);
+        if (!hit.image.isNull()) {
+            view.image = std::move(hit.image);
+            view.fullSize = hit.sourceSize;
+            return true;
+        }
+    }
+
+    const std::string path = view.filePath.toStdString();
+    const cv::Mat decoded = view.sourceImage ? ImageLoader().loadImage(path) : cv::imread(path, cv::IMREAD_UNCHANGED);
+    view.fullyLoaded = true;
+    if (decoded.empty()) {
+        return !view.image.isNull();
+    }
+    view.image = matToQImage(decoded);
+    view.fullSize = view.image.size();
+    if (m_thumbnails) {
+        m_thumbnails->insertAsync(view.filePath, decoded);
+    }
+    return !view.image.isNull();
+}
+
 void DetectionPreviewWidget::applyScale(double factor)
 {
     if (m_currentIndex < 0 || m_views.empty()) {
@@ -0,0 +1,410 @@
+#include "DetectionTuner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtConcurrent/QtConcurrent>
+
+#include "ImageLoader.h"
+#include "Logger.h"
+
+namespace mycalib {
+
+namespace {
+
+constexpr int kProfileVersion = 1;
+constexpr double kRefineSpreadStart = 0.25; // of a knob's range, in round 1
+constexpr double kRefineSpreadDecay = 0.6;  // per round after that
+constexpr double kRefineMutateChance = 0.5;
+
+// The thresholds worth searching; the rest of DetectionConfig is geometry or
+// solver bookkeeping that a sample cannot say much about.
+struct Knob {
+    double DetectionConfig::*member;
+    double low;
+    double high;
+};
+
+const Knob kKnobs[] = {
+    {&DetectionConfig::houghCannyLowRatio, 0.4, 0.9},
+    {&DetectionConfig::houghCannyHighRatio, 1.5, 3.0},
+    {&DetectionConfig::houghVotesRatio, 0.003, 0.012},
+    {&DetectionConfig::houghMinLineRatio, 0.15, 0.45},
+    {&DetectionConfig::houghMaxGapRatio, 0.01, 0.06},
+    {&DetectionConfig::whiteGaussianSigma, 0.6, 2.4},
+    {&DetectionConfig::claheClipLimit, 1.0, 4.0},
+    {&DetectionConfig::blobMinThreshold, 0.0, 40.0},
+    {&DetectionConfig::blobThresholdStep, 3.0, 12.0},
+    {&DetectionConfig::blobMinCircularity, 0.3, 0.8},
+    {&DetectionConfig::blobMinConvexity, 0.3, 0.85},
+    {&DetectionConfig::blobMinInertia, 0.01, 0.2},
+    {&DetectionConfig::areaRelaxSmall, 0.08, 0.25},
+    {&DetectionConfig::areaRelaxBig, 0.08, 0.25},
+    {&DetectionConfig::refineGate, 0.4, 0.8},
+    {&DetectionConfig::refineWinScale, 2.0, 4.0},
+};
+
+struct Score {
+    int detected {0};
+    double totalMs {0.0};
+
+    [[nodiscard]] bool betterThan(const Score &other) const
+    {
+        if (detected != other.detected) {
+            return detected > other.detected;
+        }
+        return totalMs < other.totalMs;
+    }
+};
+
+std::vector<std::string> sampleEvenly(const std::vector<std::string> &paths, int count)
+{
+    std::vector<std::string> sorted = paths;
+    std::sort(sorted.begin(), sorted.end());
+    if (count <= 0 || static_cast<size_t>(count) >= sorted.size()) {
+        return sorted;
+    }
+    std::vector<std::string> sample;
+    sample.reserve(static_cast<size_t>(count));
+    const double stride = static_cast<double>(sorted.size()) / count;
+    for (int i = 0; i < count; ++i) {
+        sample.push_back(sorted[static_cast<size_t>((i + 0.5) * stride)]);
+    }
+    return sample;
+}
+
+DetectionConfig randomCandidate(const DetectionConfig &base, std::mt19937 &rng)
+{
+    DetectionConfig candidate = base;
+    for (const Knob &knob : kKnobs) {
+        std::uniform_real_distribution<double> dist(knob.low, knob.high);
+        candidate.*knob.member = dist(rng);
+    }
+    return candidate;
+}
+
+DetectionConfig perturbedCandidate(const DetectionConfig &best, double spread, std::mt19937 &rng)
+{
+    DetectionConfig candidate = best;
+    std::bernoulli_distribution mutate(kRefineMutateChance);
+    std::normal_distribution<double> step(0.0, 1.0);
+    bool changed = false;
+    for (const Knob &knob : kKnobs) {
+        if (!mutate(rng)) {
+            continue;
+        }
+        const double value = candidate.*knob.member + step(rng) * spread * (knob.high - knob.low);
+        candidate.*knob.member = std::clamp(value, knob.low, knob.high);
+        changed = true;
+    }
+    if (!changed) {
+        const Knob &knob = kKnobs[std::uniform_int_distribution<size_t>(0, std::size(kKnobs) - 1)(rng)];
+        const double value = candidate.*knob.member + step(rng) * spread * (knob.high - knob.low);
+        candidate.*knob.member = std::clamp(value, knob.low, knob.high);
+    }
+    return candidate;
+}
+
+// Everything except the per-run switches warpFreeDetection and writeDebugImages.
+template <typename Config, typename Visitor>
+void visitProfileFields(Config &config, Visitor &&visit)
+{
+    visit("quadExpandScale", config.quadExpandScale);
+    visit("quadExpandOffset", config.quadExpandOffset);
+    visit("warpMinShort", config.warpMinShort);
+    visit("warpMinDim", config.warpMinDim);
+    visit("houghGaussianSigma", config.houghGaussianSigma);
+    visit("houghCannyLowRatio", config.houghCannyLowRatio);
+    visit("houghCannyLowMin", config.houghCannyLowMin);
+    visit("houghCannyHighRatio", config.houghCannyHighRatio);
+    visit("houghDilateKernel", config.houghDilateKernel);
+    visit("houghDilateIterations", config.houghDilateIterations);
+    visit("houghVotesRatio", config.houghVotesRatio);
+    visit("houghMinLineRatio", config.houghMinLineRatio);
+    visit("houghMaxGapRatio", config.houghMaxGapRatio);
+    visit("houghOrientationTol", config.houghOrientationTol);
+    visit("houghOrthogonalityTol", config.houghOrthogonalityTol);
+    visit("houghRhoNmsRatio", config.houghRhoNmsRatio);
+    visit("houghKmeansMaxIter", config.houghKmeansMaxIter);
+    visit("houghKmeansEps", config.houghKmeansEps);
+    visit("houghKmeansAttempts", config.houghKmeansAttempts);
+    visit("houghQuadTopK", config.houghQuadTopK);
+    visit("quadMargin", config.quadMargin);
+    visit("quadAreaMinRatio", config.quadAreaMinRatio);
+    visit("quadAreaMaxRatio", config.quadAreaMaxRatio);
+    visit("quadAspectMin", config.quadAspectMin);
+    visit("quadAspectMax", config.quadAspectMax);
+    visit("quadEdgeHalf", config.quadEdgeHalf);
+    visit("quadEdgeSamples", config.quadEdgeSamples);
+    visit("quadEdgeMinContrast", config.quadEdgeMinContrast);
+    visit("quadAreaBonus", config.quadAreaBonus);
+    visit("whiteGaussianSigma", config.whiteGaussianSigma);
+    visit("whiteMorphKernel", config.whiteMorphKernel);
+    visit("whiteMorphIterations", config.whiteMorphIterations);
+    visit("whiteApproxEpsRatio", config.whiteApproxEpsRatio);
+    visit("whiteApproxExpand", config.whiteApproxExpand);
+    visit("whiteApproxShrink", config.whiteApproxShrink);
+    visit("areaRelaxDefault", config.areaRelaxDefault);
+    visit("areaRelaxSmall", config.areaRelaxSmall);
+    visit("areaRelaxBig", config.areaRelaxBig);
+    visit("areaRelaxReassignBig", config.areaRelaxReassignBig);
+    visit("areaIterations", config.areaIterations);
+    visit("claheClipLimit", config.claheClipLimit);
+    visit("claheTileGrid", config.claheTileGrid);
+    visit("rectBlurKernel", config.rectBlurKernel);
+    visit("blobMinArea", config.blobMinArea);
+    visit("blobMaxArea", config.blobMaxArea);
+    visit("blobDark", config.blobDark);
+    visit("blobMinCircularity", config.blobMinCircularity);
+    visit("blobMinConvexity", config.blobMinConvexity);
+    visit("blobMinInertia", config.blobMinInertia);
+    visit("blobMinThreshold", config.blobMinThreshold);
+    visit("blobMaxThreshold", config.blobMaxThreshold);
+    visit("blobThresholdStep", config.blobThresholdStep);
+    visit("blobMinDist", config.blobMinDist);
+    visit("refineGate", config.refineGate);
+    visit("refineWinScale", config.refineWinScale);
+    visit("refineWinMin", config.refineWinMin);
+    visit("refineWinMax", config.refineWinMax);
+    visit("refineOnImage", config.refineOnImage);
+    visit("refineSegmentKsize", config.refineSegmentKsize);
+    visit("refineOpenKernel", config.refineOpenKernel);
+    visit("fallbackCannyLow", config.fallbackCannyLow);
+    visit("fallbackCannyHigh", config.fallbackCannyHigh);
+}
+
+QJsonValue toJson(double value) { return value; }
+QJsonValue toJson(int value) { return value; }
+QJsonValue toJson(bool value) { return value; }
+QJsonValue toJson(const cv::Size &value) { return QJsonArray {value.width, value.height}; }
+
+void fromJson(const QJsonValue &json, double &value)
+{
+    if (json.isDouble()) {
+        value = json.toDouble();
+    }
+}
+
+void fromJson(const QJsonValue &json, int &value)
+{
+    if (json.isDouble()) {
+        value = json.toInt(value);
+    }
+}
+
+void fromJson(const QJsonValue &json, bool &value)
+{
+    if (json.isBool()) {
+        value = json.toBool();
+    }
+}
+
+void fromJson(const QJsonValue &json, cv::Size &value)
+{
+    const QJsonArray array = json.toArray();
+    if (array.size() == 2) {
+        value = cv::Size(array.at(0).toInt(value.width), array.at(1).toInt(value.height));
+    }
+}
+
+} // namespace
+
+DetectionTuner::DetectionTuner(const BoardSpec &spec,
+                               const DetectionConfig &baseline,
+                               const DetectionTuningOptions &options)
+    : m_spec(spec)
+    , m_baseline(baseline)
+    , m_options(options)
+{
+    m_baseline.writeDebugImages = false;
+}
+
+DetectionTuningResult DetectionTuner::tune(const std::vector<std::string> &paths,
+                                           const std::function<bool()> &shouldAbort) const
+{
+    DetectionTuningResult result;
+    result.config = m_baseline;
+
+    // Decode once; every candidate detects on the same gray images.
+    const std::vector<std::string> sample = sampleEvenly(paths, m_options.sampleSize);
+    std::vector<cv::Mat> images(sample.size());
+    std::vector<size_t> imageIds(sample.size());
+    std::iota(imageIds.begin(), imageIds.end(), size_t {0});
+    QtConcurrent::blockingMap(imageIds, [&](size_t &index) {
+        images[index] = ImageLoader().loadImage(sample[index]);
+    });
+    std::vector<std::string> names;
+    std::vector<cv::Mat> decoded;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        if (images[i].empty()) {
+            Logger::warning(QStringLiteral("Detection tuning: cannot decode %1").arg(QString::fromStdString(sample[i])));
+            continue;
+        }
+        names.push_back(sample[i]);
+        decoded.push_back(std::move(images[i]));
+    }
+    images.clear();
+    if (decoded.empty()) {
+        result.message = QStringLiteral("No decodable images to tune on");
+        return result;
+    }
+    result.sampleSize = static_cast<int>(decoded.size());
+
+    struct Job {
+        size_t candidate {0};
+        size_t image {0};
+        bool success {false};
+        double ms {0.0};
+    };
+    const auto evaluate = [&](const std::vector<DetectionConfig> &candidates) {
+        std::vector<BoardDetector> detectors;
+        detectors.reserve(candidates.size());
+        for (const DetectionConfig &candidate : candidates) {
+            detectors.emplace_back(candidate);
+        }
+        std::vector<Job> jobs;
+        jobs.reserve(candidates.size() * decoded.size());
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            for (size_t i = 0; i < decoded.size(); ++i) {
+                jobs.push_back({c, i});
+            }
+        }
+        QtConcurrent::blockingMap(jobs, [&](Job &job) {
+            const DetectionResult detection = detectors[job.candidate].detect(decoded[job.image], m_spec, names[job.image]);
+            job.success = detection.success;
+            job.ms = static_cast<double>(detection.elapsed.count());
+        });
+        std::vector<Score> scores(candidates.size());
+        for (const Job &job : jobs) {
+            scores[job.candidate].detected += job.success ? 1 : 0;
+            scores[job.candidate].totalMs += job.ms;
+        }
+        return scores;
+    };
+
+    std::mt19937 rng(m_options.seed);
+    const int perRound = std::max(1, m_options.candidatesPerRound);
+    DetectionConfig best = m_baseline;
+    Score bestScore;
+    for (int round = 0; round < std::max(1, m_options.rounds); ++round) {
+        if (shouldAbort && shouldAbort()) {
+            break;
+        }
+        std::vector<DetectionConfig> candidates;
+        candidates.reserve(static_cast<size_t>(perRound));
+        if (round == 0) {
+            candidates.push_back(m_baseline);
+            while (candidates.size() < static_cast<size_t>(perRound)) {
+                candidates.push_back(randomCandidate(m_baseline, rng));
+            }
+        } else {
+            const double spread = kRefineSpreadStart * std::pow(kRefineSpreadDecay, round - 1);
+            while (candidates.size() < static_cast<size_t>(perRound)) {
+                candidates.push_back(perturbedCandidate(best, spread, rng));
+            }
+        }
+
+        const std::vector<Score> scores = evaluate(candidates);
+        result.evaluated += static_cast<int>(candidates.size());
+        if (round == 0) {
+            bestScore = scores.front();
+            result.baselineDetected = bestScore.detected;
+            result.baselineMeanMs = bestScore.totalMs / static_cast<double>(decoded.size());
+        }
+        for (size_t c = 0; c < candidates.size(); ++c) {
+            if (scores[c].betterThan(bestScore)) {
+                bestScore = scores[c];
+                best = candidates[c];
+            }
+        }
+        Logger::info(QStringLiteral("Detection tuning round %1: best %2/%3 detected, %4 ms/image")
+                         .arg(round + 1)
+                         .arg(bestScore.detected)
+                         .arg(decoded.size())
+                         .arg(bestScore.totalMs / static_cast<double>(decoded.size()), 0, 'f', 1));
+    }
+
+    if (result.evaluated == 0) {
+        result.message = QStringLiteral("Detection tuning cancelled");
+        return result;
+    }
+    best.writeDebugImages = true;
+    result.config = best;
+    result.detected = bestScore.detected;
+    result.meanMs = bestScore.totalMs / static_cast<double>(decoded.size());
+    result.success = true;
+    result.message = QStringLiteral("Detected %1/%2 sample images at %3 ms/image (was %4/%2 at %5 ms/image)")
+                         .arg(result.detected)
+                         .arg(result.sampleSize)
+                         .arg(result.meanMs, 0, 'f', 1)
+                         .arg(result.baselineDetected)
+                         .arg(result.baselineMeanMs, 0, 'f', 1);
+    return result;
+}
+
+bool saveDetectionProfile(const QString &path, const DetectionConfig &config, QString *errorMessage)
+{
+    QJsonObject fields;
+    visitProfileFields(config, [&](const char *name, const auto &value) {
+        fields.insert(QLatin1String(name), toJson(value));
+    });
+    QJsonObject root;
+    root.insert(QStringLiteral("version"), kProfileVersion);
+    root.insert(QStringLiteral("detection"), fields);
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        if (errorMessage) {
+            *errorMessage = QStringLiteral("Failed to open %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    if (!file.commit()) {
+        if (errorMessage) {
+            *errorMessage = QStringLiteral("Failed to write %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    return true;
+}
+
+bool loadDetectionProfile(const QString &path, DetectionConfig &config, QString *errorMessage)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (errorMessage) {
+            *errorMessage = QStringLiteral("Failed to open %1: %2").arg(path, file.errorString());
+        }
+        return false;
+    }
+    QJsonParseError parseError {};
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (errorMessage) {
+            *errorMessage = QStringLiteral("Invalid detection profile %1: %2").arg(path, parseError.errorString());
+        }
+        return false;
+    }
+    const QJsonObject root = doc.object();
+    if (root.value(QStringLiteral("version")).toInt() != kProfileVersion) {
+        if (errorMessage) {
+            *errorMessage = QStringLiteral("Unsupported detection profile version in %1").arg(path);
+        }
+        return false;
+    }
+    const QJsonObject fields = root.value(QStringLiteral("detection")).toObject();
+    visitProfileFields(config, [&](const char *name, auto &value) {
+        fromJson(fields.value(QLatin1String(name)), value);
+    });
+    return true;
+}
+
+} // namespace mycalib
@@ -0,0 +1,510 @@
+#include "DetectionWorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QProcess>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <QtEndian>
+
+#ifdef Q_OS_WIN
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+#include <cstdio>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "CalibrationEngine.h"
+#include "Logger.h"
+
+namespace fs = std::filesystem;
+
+namespace mycalib {
+
+namespace {
+
+constexpr quint32 kHelloMagic = 0x4D434457; // 'MCDW'
+constexpr quint16 kProtocolVersion = 2;
+// A worker that spends longer than this on one image is treated as hung.
+constexpr int kImageTimeoutMs = 180000;
+constexpr int kStartTimeoutMs = 10000;
+constexpr int kStopTimeoutMs = 2000;
+// How often a waiting driver thread re-checks for abort and timeout.
+constexpr int kPollMs = 50;
+// Restarts per worker slot before the slot gives up and fails its remaining images.
+constexpr int kMaxRestarts = 8;
+
+// Workers run this same executable, so the plain-data settings travel as raw bytes;
+// the hello frame still carries their sizes to catch a mismatched binary.
+static_assert(std::is_trivially_copyable_v<BoardSpec>);
+static_assert(std::is_trivially_copyable_v<DetectionConfig>);
+
+QByteArray encodeFrame(const QByteArray &payload)
+{
+    QByteArray frame(4, Qt::Uninitialized);
+    qToBigEndian<quint32>(static_cast<quint32>(payload.size()), frame.data());
+    frame.append(payload);
+    return frame;
+}
+
+// Pops one complete frame off the front of buffer.
+bool takeFrame(QByteArray &buffer, QByteArray &payload)
+{
+    if (buffer.size() < 4) {
+        return false;
+    }
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData());
+    if (static_cast<quint64>(buffer.size()) - 4 < length) {
+        return false;
+    }
+    payload = buffer.mid(4, static_cast<qsizetype>(length));
+    buffer.remove(0, 4 + static_cast<qsizetype>(length));
+    return true;
+}
+
+bool readExact(QIODevice &device, char *data, qint64 size)
+{
+    qint64 done = 0;
+    while (done < size) {
+        const qint64 got = device.read(data + done, size - done);
+        if (got <= 0) {
+            return false;
+        }
+        done += got;
+    }
+    return true;
+}
+
+bool readFrame(QIODevice &device, QByteArray &payload)
+{
+    char header[4];
+    if (!readExact(device, header, 4)) {
+        return false;
+    }
+    const quint32 length = qFromBigEndian<quint32>(header);
+    payload.resize(static_cast<qsizetype>(length));
+    return readExact(device, payload.data(), length);
+}
+
+QByteArray encodeHello(const BoardSpec &spec, const DetectionConfig &config)
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << kHelloMagic << kProtocolVersion
+        << quint32(sizeof(BoardSpec)) << quint32(sizeof(DetectionConfig));
+    out.writeRawData(reinterpret_cast<const char *>(&spec), sizeof(BoardSpec));
+    out.writeRawData(reinterpret_cast<const char *>(&config), sizeof(DetectionConfig));
+    return payload;
+}
+
+bool decodeHello(const QByteArray &payload, BoardSpec &spec, DetectionConfig &config)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 specSize = 0;
+    quint32 configSize = 0;
+    in >> magic >> version >> specSize >> configSize;
+    if (in.status() != QDataStream::Ok || magic != kHelloMagic || version != kProtocolVersion ||
+        specSize != sizeof(BoardSpec) || configSize != sizeof(DetectionConfig)) {
+        return false;
+    }
+    return in.readRawData(reinterpret_cast<char *>(&spec), sizeof(BoardSpec)) == sizeof(BoardSpec) &&
+           in.readRawData(reinterpret_cast<char *>(&config), sizeof(DetectionConfig)) == sizeof(DetectionConfig);
+}
+
+template <typename T>
+void writeVector(QDataStream &out, const std::vector<T> &values)
+{
+    out << quint32(values.size());
+    if (!values.empty()) {
+        out.writeRawData(reinterpret_cast<const char *>(values.data()), static_cast<int>(values.size() * sizeof(T)));
+    }
+}
+
+template <typename T>
+std::vector<T> readVector(QDataStream &in)
+{
+    quint32 count = 0;
+    in >> count;
+    std::vector<T> values;
+    if (in.status() != QDataStream::Ok || count == 0) {
+        return values;
+    }
+    values.resize(count);
+    const int bytes = static_cast<int>(count * sizeof(T));
+    if (in.readRawData(reinterpret_cast<char *>(values.data()), bytes) != bytes) {
+        in.setStatus(QDataStream::ReadPastEnd);
+        values.clear();
+    }
+    return values;
+}
+
+void writeHomography(QDataStream &out, const cv::Mat &mat)
+{
+    const bool present = mat.rows == 3 && mat.cols == 3;
+    out << quint8(present ? 1 : 0);
+    if (present) {
+        cv::Mat values;
+        mat.convertTo(values, CV_64F);
+        for (int i = 0; i < 9; ++i) {
+            out << values.at<double>(i / 3, i % 3);
+        }
+    }
+}
+
+cv::Mat readHomography(QDataStream &in)
+{
+    quint8 present = 0;
+    in >> present;
+    if (!present) {
+        return cv::Mat();
+    }
+    cv::Mat mat(3, 3, CV_64F);
+    for (int i = 0; i < 9; ++i) {
+        in >> mat.at<double>(i / 3, i % 3);
+    }
+    return mat;
+}
+
+// The white-region mask is a binary 8-bit image; PNG keeps it to a few KB.
+void writeMask(QDataStream &out, const cv::Mat &mask)
+{
+    std::vector<uchar> encoded;
+    if (mask.empty() || !cv::imencode(".png", mask, encoded)) {
+        encoded.clear();
+    }
+    writeVector(out, encoded);
+}
+
+cv::Mat readMask(QDataStream &in)
+{
+    const std::vector<uchar> encoded = readVector<uchar>(in);
+    if (encoded.empty()) {
+        return cv::Mat();
+    }
+    return cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
+}
+
+// Only what detection produces; residuals and poses are filled in by the solve.
+void writeDetection(QDataStream &out, const DetectionResult &det)
+{
+    out << QString::fromStdString(det.name) << det.success << QString::fromStdString(det.message)
+        << qint64(det.elapsed.count()) << qint32(det.resolution.width) << qint32(det.resolution.height);
+    writeVector(out, det.imagePoints);
+    writeVector(out, det.objectPoints);
+    writeVector(out, det.bigCirclePoints);
+    writeVector(out, det.circleRadiiPx);
+    writeVector(out, det.bigCircleRadiiPx);
+    writeVector(out, det.logicalIndices);
+    out << qint32(det.bigCircleCount) << det.sharpness;
+    writeHomography(out, det.warpHomography);
+    writeHomography(out, det.warpHomographyInv);
+    writeMask(out, det.whiteRegionMask);
+    out << quint32(det.debugImages.size());
+    for (const auto &image : det.debugImages) {
+        out << QString::fromStdString(image.label) << QString::fromStdString(image.filePath);
+    }
+    out << QString::fromStdString(det.debugDirectory);
+}
+
+bool readDetection(QDataStream &in, DetectionResult &det)
+{
+    QString name;
+    QString message;
+    qint64 elapsedMs = 0;
+    qint32 width = 0;
+    qint32 height = 0;
+    in >> name >> det.success >> message >> elapsedMs >> width >> height;
+    det.name = name.toStdString();
+    det.message = message.toStdString();
+    det.elapsed = std::chrono::milliseconds(elapsedMs);
+    det.resolution = cv::Size(width, height);
+    det.imagePoints = readVector<cv::Point2f>(in);
+    det.objectPoints = readVector<cv::Point3f>(in);
+    det.bigCirclePoints = readVector<cv::Point2f>(in);
+    det.circleRadiiPx = readVector<float>(in);
+    det.bigCircleRadiiPx = readVector<float>(in);
+    det.logicalIndices = readVector<cv::Vec2i>(in);
+    qint32 bigCount = 0;
+    in >> bigCount >> det.sharpness;
+    det.bigCircleCount = bigCount;
+    det.warpHomography = readHomography(in);
+    det.warpHomographyInv = readHomography(in);
+    det.whiteRegionMask = readMask(in);
+    quint32 debugCount = 0;
+    in >> debugCount;
+    for (quint32 i = 0; i < debugCount && in.status() == QDataStream::Ok; ++i) {
+        QString label;
+        QString filePath;
+        in >> label >> filePath;
+        det.debugImages.push_back({label.toStdString(), filePath.toStdString()});
+    }
+    QString debugDirectory;
+    in >> debugDirectory;
+    det.debugDirectory = debugDirectory.toStdString();
+    return in.status() == QDataStream::Ok;
+}
+
+DetectionResult failedResult(const std::string &path, const std::string &message)
+{
+    DetectionResult result;
+    result.name = fs::path(path).stem().string();
+    result.message = message;
+    return result;
+}
+
+// One worker process as seen from the pool thread driving it; every call blocks
+// that thread, so no event loop is needed.
+class WorkerChannel {
+public:
+    enum class Outcome {
+        Done,
+        Crashed,
+        TimedOut,
+        Aborted
+    };
+
+    WorkerChannel(const QString &program, const QByteArray &hello)
+        : m_program(program)
+        , m_hello(hello)
+    {
+    }
+
+    ~WorkerChannel() { stop(); }
+
+    bool start()
+    {
+        stop();
+        m_process = std::make_unique<QProcess>();
+        m_process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        m_process->start(m_program, {QString::fromLatin1(DetectionWorkerPool::kWorkerArgument)});
+        if (!m_process->waitForStarted(kStartTimeoutMs)) {
+            Logger::warning(QStringLiteral("Detection worker failed to start: %1").arg(m_process->errorString()));
+            m_process.reset();
+            return false;
+        }
+        m_buffer.clear();
+        m_process->write(encodeFrame(m_hello));
+        return m_process->waitForBytesWritten(kStartTimeoutMs);
+    }
+
+    void stop()
+    {
+        if (!m_process) {
+            return;
+        }
+        m_process->closeWriteChannel();
+        if (!m_process->waitForFinished(kStopTimeoutMs)) {
+            m_process->kill();
+            m_process->waitForFinished(kStopTimeoutMs);
+        }
+        m_process.reset();
+    }
+
+    Outcome run(quint32 sequence,
+                const std::string &path,
+                const std::function<bool()> &shouldAbort,
+                DetectionResult &result)
+    {
+        QByteArray request;
+        {
+            QDataStream out(&request, QIODevice::WriteOnly);
+            out.setVersion(QDataStream::Qt_6_5);
+            out << sequence << QString::fromStdString(path);
+        }
+        m_process->write(encodeFrame(request));
+        m_process->waitForBytesWritten(kPollMs);
+
+        QElapsedTimer timer;
+        timer.start();
+        while (true) {
+            // State first, then drain, so a reply written just before exiting still counts.
+            const bool exited = m_process->state() == QProcess::NotRunning;
+            m_buffer.append(m_process->readAllStandardOutput());
+            QByteArray reply;
+            if (takeFrame(m_buffer, reply)) {
+                QDataStream in(reply);
+                in.setVersion(QDataStream::Qt_6_5);
+                quint32 echoed = 0;
+                in >> echoed;
+                if (echoed == sequence && readDetection(in, result)) {
+                    return Outcome::Done;
+                }
+                kill();
+                return Outcome::Crashed;
+            }
+            if (exited) {
+                return Outcome::Crashed;
+            }
+            if (shouldAbort && shouldAbort()) {
+                kill();
+                return Outcome::Aborted;
+            }
+            if (timer.elapsed() > kImageTimeoutMs) {
+                kill();
+                return Outcome::TimedOut;
+            }
+            m_process->waitForReadyRead(kPollMs);
+        }
+    }
+
+    [[nodiscard]] QString exitDescription() const
+    {
+        if (!m_process) {
+            return QStringLiteral("not running");
+        }
+        return m_process->exitStatus() == QProcess::CrashExit
+                   ? QStringLiteral("crashed: %1").arg(m_process->errorString())
+                   : QStringLiteral("exited with code %1").arg(m_process->exitCode());
+    }
+
+private:
+    void kill()
+    {
+        m_process->kill();
+        m_process->waitForFinished(kStopTimeoutMs);
+    }
+
+    QString m_program;
+    QByteArray m_hello;
+    std::unique_ptr<QProcess> m_process;
+    QByteArray m_buffer;
+};
+
+} // namespace
+
+DetectionWorkerPool::DetectionWorkerPool(const BoardSpec &spec,
+                                         const DetectionConfig &config,
+                                         int workerCount,
+                                         const QString &program)
+    : m_spec(spec)
+    , m_config(config)
+    , m_workerCount(std::max(1, workerCount))
+    , m_program(program.isEmpty() ? QCoreApplication::applicationFilePath() : program)
+{
+}
+
+std::vector<DetectionResult> DetectionWorkerPool::detect(const std::vector<std::string> &paths,
+                                                         const std::function<bool()> &shouldAbort,
+                                                         const std::function<void(size_t, const DetectionResult &)> &onResult) const
+{
+    std::vector<DetectionResult> results(paths.size());
+    if (paths.empty()) {
+        return results;
+    }
+
+    const QByteArray hello = encodeHello(m_spec, m_config);
+    const int slotCount = static_cast<int>(std::min<size_t>(static_cast<size_t>(m_workerCount), paths.size()));
+    std::vector<int> slotIds(static_cast<size_t>(slotCount));
+    std::iota(slotIds.begin(), slotIds.end(), 0);
+    std::atomic<size_t> next {0};
+
+    // Each slot is one pool thread driving one worker process; images are handed
+    // out one at a time so a slow image never holds up a queue behind it.
+    QThreadPool threads;
+    threads.setMaxThreadCount(slotCount);
+    QtConcurrent::blockingMap(&threads, slotIds, [&](int &slot) {
+        WorkerChannel channel(m_program, hello);
+        bool running = channel.start();
+        int restarts = 0;
+        for (size_t index = next.fetch_add(1); index < paths.size(); index = next.fetch_add(1)) {
+            const std::string &path = paths[index];
+            DetectionResult &result = results[index];
+            if (shouldAbort && shouldAbort()) {
+                result = failedResult(path, "Detection cancelled");
+            } else if (!running) {
+                result = failedResult(path, "No detection worker available");
+            } else {
+                const auto outcome = channel.run(static_cast<quint32>(index), path, shouldAbort, result);
+                if (outcome == WorkerChannel::Outcome::Aborted) {
+                    result = failedResult(path, "Detection cancelled");
+                    running = false;
+                } else if (outcome != WorkerChannel::Outcome::Done) {
+                    const QString reason = outcome == WorkerChannel::Outcome::TimedOut
+                                               ? QStringLiteral("timed out after %1 s").arg(kImageTimeoutMs / 1000)
+                                               : channel.exitDescription();
+                    Logger::warning(QStringLiteral("Detection worker %1 %2 on %3; image marked failed")
+                                        .arg(slot)
+                                        .arg(reason)
+                                        .arg(QString::fromStdString(path)));
+                    result = failedResult(path, "Detection worker " + reason.toStdString());
+                    running = ++restarts <= kMaxRestarts && channel.start();
+                    if (!running) {
+                        Logger::error(QStringLiteral("Detection worker %1 abandoned after %2 restarts")
+                                          .arg(slot)
+                                          .arg(restarts - 1));
+                    }
+                }
+            }
+            if (onResult) {
+                onResult(index, result);
+            }
+        }
+    });
+    return results;
+}
+
+int DetectionWorkerPool::serveWorker()
+{
+#ifdef Q_OS_WIN
+    _setmode(_fileno(stdin), _O_BINARY);
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    QFile input;
+    QFile output;
+    if (!input.open(stdin, QIODevice::ReadOnly | QIODevice::Unbuffered) ||
+        !output.open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        return 1;
+    }
+
+    QByteArray payload;
+    BoardSpec spec;
+    DetectionConfig config;
+    if (!readFrame(input, payload) || !decodeHello(payload, spec, config)) {
+        Logger::error(QStringLiteral("Detection worker: handshake failed (protocol or build mismatch)"));
+        return 1;
+    }
+    const BoardDetector detector(config);
+
+    while (readFrame(input, payload)) {
+        QDataStream in(payload);
+        in.setVersion(QDataStream::Qt_6_5);
+        quint32 sequence = 0;
+        QString path;
+        in >> sequence >> path;
+        if (in.status() != QDataStream::Ok) {
+            return 1;
+        }
+        const DetectionResult result = CalibrationEngine::detectImage(path.toStdString(), spec, detector);
+
+        QByteArray reply;
+        {
+            QDataStream out(&reply, QIODevice::WriteOnly);
+            out.setVersion(QDataStream::Qt_6_5);
+            out << sequence;
+            writeDetection(out, result);
+        }
+        const QByteArray frame = encodeFrame(reply);
+        if (output.write(frame) != frame.size() || !output.flush()) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace mycalib
@@ -0,0 +1,885 @@
+#include "DngReader.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+namespace mycalib {
+
+namespace {
+
+constexpr uint16_t kTagNewSubFileType = 254;
+constexpr uint16_t kTagImageWidth = 256;
+constexpr uint16_t kTagImageLength = 257;
+constexpr uint16_t kTagBitsPerSample = 258;
+constexpr uint16_t kTagCompression = 259;
+constexpr uint16_t kTagPhotometric = 262;
+constexpr uint16_t kTagStripOffsets = 273;
+constexpr uint16_t kTagSamplesPerPixel = 277;
+constexpr uint16_t kTagRowsPerStrip = 278;
+constexpr uint16_t kTagStripByteCounts = 279;
+constexpr uint16_t kTagTileWidth = 322;
+constexpr uint16_t kTagTileLength = 323;
+constexpr uint16_t kTagTileOffsets = 324;
+constexpr uint16_t kTagTileByteCounts = 325;
+constexpr uint16_t kTagSubIfds = 330;
+constexpr uint16_t kTagSampleFormat = 339;
+constexpr uint16_t kTagCfaRepeatPatternDim = 33421;
+constexpr uint16_t kTagCfaPattern = 33422;
+constexpr uint16_t kTagLinearizationTable = 50712;
+constexpr uint16_t kTagBlackLevelRepeatDim = 50713;
+constexpr uint16_t kTagBlackLevel = 50714;
+constexpr uint16_t kTagWhiteLevel = 50717;
+constexpr uint16_t kTagAsShotNeutral = 50728;
+
+constexpr uint32_t kPhotometricCfa = 32803;
+constexpr uint32_t kPhotometricLinearRaw = 34892;
+constexpr uint32_t kCompressionNone = 1;
+constexpr uint32_t kCompressionLosslessJpeg = 7;
+
+constexpr int kMaxIfds = 64;
+constexpr int kMaxPatternDim = 8;
+constexpr int kHuffmanFastBits = 9;
+
+struct IfdEntry {
+    uint16_t type {0};
+    uint32_t count {0};
+    size_t valueOffset {0};
+};
+
+using Ifd = std::map<uint16_t, IfdEntry>;
+
+size_t typeSize(uint16_t type)
+{
+    switch (type) {
+    case 1: case 2: case 6: case 7: return 1;   // BYTE, ASCII, SBYTE, UNDEFINED
+    case 3: case 8: return 2;                   // SHORT, SSHORT
+    case 4: case 9: case 11: case 13: return 4; // LONG, SLONG, FLOAT, IFD
+    case 5: case 10: case 12: return 8;         // RATIONAL, SRATIONAL, DOUBLE
+    default: return 0;
+    }
+}
+
+class TiffView {
+public:
+    TiffView(const uchar *data, size_t size) : m_data(data), m_size(size) {}
+
+    bool parseHeader(uint32_t *firstIfd)
+    {
+        if (m_size < 8 || m_data[0] != m_data[1] || (m_data[0] != 'I' && m_data[0] != 'M')) {
+            return false;
+        }
+        m_little = m_data[0] == 'I';
+        if (u16(2) != 42) {
+            return false;
+        }
+        *firstIfd = u32(4);
+        return true;
+    }
+
+    [[nodiscard]] bool contains(size_t offset, size_t length) const
+    {
+        return offset <= m_size && length <= m_size - offset;
+    }
+
+    [[nodiscard]] uint16_t u16(size_t offset) const
+    {
+        const uchar *p = m_data + offset;
+        return m_little ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : static_cast<uint16_t>((p[0] << 8) | p[1]);
+    }
+
+    [[nodiscard]] uint32_t u32(size_t offset) const
+    {
+        const uchar *p = m_data + offset;
+        return m_little ? (uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24))
+                        : ((uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]));
+    }
+
+    // Reads the IFD at offset; returns the offset of the next IFD in the chain (0 at the end).
+    uint32_t readIfd(uint32_t offset, Ifd &ifd) const
+    {
+        if (!contains(offset, 2)) {
+            return 0;
+        }
+        const uint16_t count = u16(offset);
+        if (!contains(offset + 2, size_t(count) * 12 + 4)) {
+            return 0;
+        }
+        for (uint16_t i = 0; i < count; ++i) {
+            const size_t entry = offset + 2 + size_t(i) * 12;
+            IfdEntry value;
+            value.type = u16(entry + 2);
+            value.count = u32(entry + 4);
+            const size_t bytes = typeSize(value.type) * value.count;
+            value.valueOffset = bytes <= 4 ? entry + 8 : u32(entry + 8);
+            if (typeSize(value.type) == 0 || !contains(value.valueOffset, bytes)) {
+                continue;
+            }
+            ifd[u16(entry)] = value;
+        }
+        return u32(offset + 2 + size_t(count) * 12);
+    }
+
+    [[nodiscard]] double number(const IfdEntry &entry, uint32_t index) const
+    {
+        const size_t at = entry.valueOffset + typeSize(entry.type) * index;
+        switch (entry.type) {
+        case 1: case 7: return m_data[at];
+        case 6: return static_cast<int8_t>(m_data[at]);
+        case 3: return u16(at);
+        case 8: return static_cast<int16_t>(u16(at));
+        case 4: case 13: return u32(at);
+        case 9: return static_cast<int32_t>(u32(at));
+        case 5: {
+            const uint32_t den = u32(at + 4);
+            return den == 0 ? 0.0 : static_cast<double>(u32(at)) / den;
+        }
+        case 10: {
+            const auto den = static_cast<int32_t>(u32(at + 4));
+            return den == 0 ? 0.0 : static_cast<double>(static_cast<int32_t>(u32(at))) / den;
+        }
+        default: return 0.0;
+        }
+    }
+
+    [[nodiscard]] const uchar *data() const { return m_data; }
+    [[nodiscard]] bool littleEndian() const { return m_little; }
+
+private:
+    const uchar *m_data;
+    size_t m_size;
+    bool m_little {true};
+};
+
+class IfdReader {
+public:
+    IfdReader(const TiffView &view, const Ifd &ifd) : m_view(view), m_ifd(ifd) {}
+
+    [[nodiscard]] const IfdEntry *find(uint16_t tag) const
+    {
+        const auto it = m_ifd.find(tag);
+        return it == m_ifd.end() ? nullptr : &it->second;
+    }
+
+    [[nodiscard]] double number(uint16_t tag, double fallback, uint32_t index = 0) const
+    {
+        const IfdEntry *entry = find(tag);
+        return entry && index < entry->count ? m_view.number(*entry, index) : fallback;
+    }
+
+    [[nodiscard]] std::vector<double> numbers(uint16_t tag) const
+    {
+        std::vector<double> values;
+        if (const IfdEntry *entry = find(tag)) {
+            values.reserve(entry->count);
+            for (uint32_t i = 0; i < entry->count; ++i) {
+                values.push_back(m_view.number(*entry, i));
+            }
+        }
+        return values;
+    }
+
+private:
+    const TiffView &m_view;
+    const Ifd &m_ifd;
+};
+
+struct RawLayout {
+    int width {0};
+    int height {0};
+    int bits {0};
+    uint32_t compression {kCompressionNone};
+    bool tiled {false};
+    int tileWidth {0};  // full width for strips
+    int tileHeight {0}; // RowsPerStrip for strips
+    int tilesAcross {1};
+    std::vector<double> offsets;
+    std::vector<double> byteCounts;
+    int cfaRows {1};
+    int cfaCols {1};
+    std::vector<int> cfaColors {1};
+    std::vector<uint16_t> linearization;
+    int blackRows {1};
+    int blackCols {1};
+    std::vector<double> black {0.0};
+    double white {0.0};
+    std::array<double, 3> neutral {1.0, 1.0, 1.0};
+};
+
+// Writes decoded raw rows into the output image: linearize, subtract black,
+// scale to the white level with the CFA colour's white-balance gain and, in half
+// resolution mode, average each 2x2 cell.
+template <typename T>
+class RawSink {
+public:
+    RawSink(const RawLayout &layout, bool half, cv::Mat &out)
+        : m_linearization(layout.linearization), m_half(half), m_out(out)
+    {
+        const double maxOut = static_cast<double>(std::numeric_limits<T>::max());
+        m_phaseRows = std::lcm(layout.cfaRows, layout.blackRows);
+        m_phaseCols = std::lcm(layout.cfaCols, layout.blackCols);
+        const double minNeutral = *std::min_element(layout.neutral.begin(), layout.neutral.end());
+        m_phases.resize(static_cast<size_t>(m_phaseRows * m_phaseCols));
+        for (int py = 0; py < m_phaseRows; ++py) {
+            for (int px = 0; px < m_phaseCols; ++px) {
+                const int color = layout.cfaColors[static_cast<size_t>((py % layout.cfaRows) * layout.cfaCols + px % layout.cfaCols)];
+                const double black = layout.black[static_cast<size_t>((py % layout.blackRows) * layout.blackCols + px % layout.blackCols)];
+                const double balance = color >= 0 && color < 3 ? minNeutral / layout.neutral[static_cast<size_t>(color)] : 1.0;
+                Phase &phase = m_phases[static_cast<size_t>(py * m_phaseCols + px)];
+                phase.black = static_cast<float>(black);
+                phase.scale = static_cast<float>(balance * maxOut / std::max(1.0, layout.white - black));
+            }
+        }
+        if (m_half) {
+            m_accumulator.assign(static_cast<size_t>(out.cols), 0.0F);
+        }
+    }
+
+    void put(int x0, int y, const uint16_t *samples, int count)
+    {
+        const Phase *phases = &m_phases[static_cast<size_t>((y % m_phaseRows) * m_phaseCols)];
+        if (!m_half) {
+            T *row = m_out.ptr<T>(y);
+            for (int i = 0; i < count; ++i) {
+                const int x = x0 + i;
+                row[x] = cv::saturate_cast<T>(normalize(samples[i], phases[x % m_phaseCols]));
+            }
+            return;
+        }
+        const int outY = y / 2;
+        if (outY >= m_out.rows) {
+            return;
+        }
+        T *row = m_out.ptr<T>(outY);
+        const bool secondRow = (y & 1) != 0;
+        for (int i = 0; i < count; ++i) {
+            const int x = x0 + i;
+            const int outX = x / 2;
+            if (outX >= m_out.cols) {
+                break;
+            }
+            const float value = normalize(samples[i], phases[x % m_phaseCols]);
+            float &acc = m_accumulator[static_cast<size_t>(outX)];
+            if (!secondRow && (x & 1) == 0) {
+                acc = value;
+            } else if (secondRow && (x & 1) != 0) {
+                row[outX] = cv::saturate_cast<T>(0.25F * (acc + value));
+            } else {
+                acc += value;
+            }
+        }
+    }
+
+private:
+    struct Phase {
+        float black {0.0F};
+        float scale {1.0F};
+    };
+
+    [[nodiscard]] float normalize(uint16_t sample, const Phase &phase) const
+    {
+        const float linear = m_linearization.empty()
+                                 ? static_cast<float>(sample)
+                                 : static_cast<float>(m_linearization[std::min<size_t>(sample, m_linearization.size() - 1)]);
+        return (linear - phase.black) * phase.scale;
+    }
+
+    const std::vector<uint16_t> &m_linearization;
+    bool m_half;
+    cv::Mat &m_out;
+    int m_phaseRows {1};
+    int m_phaseCols {1};
+    std::vector<Phase> m_phases;
+    std::vector<float> m_accumulator;
+};
+
+// MSB-first bit reader over JPEG entropy-coded data: strips 0xFF00 stuffing and
+// feeds zeros once a marker is reached.
+class JpegBitReader {
+public:
+    JpegBitReader(const uchar *begin, const uchar *end) : m_p(begin), m_end(end) {}
+
+    uint32_t peek(int n)
+    {
+        if (m_bits < n) {
+            fill();
+        }
+        return static_cast<uint32_t>(m_buffer >> (64 - n));
+    }
+
+    void skip(int n)
+    {
+        m_buffer <<= n;
+        m_bits -= n;
+    }
+
+    uint32_t get(int n)
+    {
+        if (n == 0) {
+            return 0;
+        }
+        const uint32_t value = peek(n);
+        skip(n);
+        return value;
+    }
+
+    // Drops the remaining bits of the interval and consumes the RSTn marker.
+    bool restart()
+    {
+        m_buffer = 0;
+        m_bits = 0;
+        while (m_p + 1 < m_end && !(m_p[0] == 0xFF && m_p[1] >= 0xD0 && m_p[1] <= 0xD7)) {
+            ++m_p;
+        }
+        if (m_p + 1 >= m_end) {
+            return false;
+        }
+        m_p += 2;
+        m_atMarker = false;
+        return true;
+    }
+
+private:
+    void fill()
+    {
+        while (m_bits <= 56) {
+            uint32_t byte = 0;
+            if (!m_atMarker && m_p < m_end) {
+                byte = *m_p;
+                if (byte == 0xFF) {
+                    if (m_p + 1 < m_end && m_p[1] == 0x00) {
+                        m_p += 2;
+                    } else {
+                        m_atMarker = true;
+                        byte = 0;
+                    }
+                } else {
+                    ++m_p;
+                }
+            }
+            m_buffer |= static_cast<uint64_t>(byte) << (56 - m_bits);
+            m_bits += 8;
+        }
+    }
+
+    const uchar *m_p;
+    const uchar *m_end;
+    uint64_t m_buffer {0};
+    int m_bits {0};
+    bool m_atMarker {false};
+};
+
+struct HuffmanTable {
+    bool defined {false};
+    std::array<uint16_t, 1 << kHuffmanFastBits> fast {}; // (length << 8) | symbol, 0 = slow path
+    std::array<int32_t, 17> minCode {};
+    std::array<int32_t, 17> maxCode {};
+    std::array<int32_t, 17> valuePtr {};
+    std::vector<uint8_t> values;
+
+    // Rejects tables whose counts overflow a length's code space or need more
+    // symbols than symbolCount; either would index past fast[] or symbols.
+    [[nodiscard]] bool build(const uint8_t *counts, const uint8_t *symbols, size_t symbolCount)
+    {
+        defined = false;
+        fast.fill(0);
+        values.clear();
+        if (static_cast<size_t>(std::accumulate(counts, counts + 16, 0)) > symbolCount) {
+            return false;
+        }
+        int32_t code = 0;
+        int k = 0;
+        for (int length = 1; length <= 16; ++length) {
+            const int n = counts[length - 1];
+            if (code + n > (1 << length)) {
+                return false;
+            }
+            valuePtr[static_cast<size_t>(length)] = k;
+            minCode[static_cast<size_t>(length)] = code;
+            for (int i = 0; i < n; ++i, ++k, ++code) {
+                const uint8_t symbol = symbols[k];
+                values.push_back(symbol);
+                if (length <= kHuffmanFastBits) {
+                    const int shift = kHuffmanFastBits - length;
+                    for (int fill = 0; fill < (1 << shift); ++fill) {
+                        fast[static_cast<size_t>((code << shift) | fill)] = static_cast<uint16_t>((length << 8) | symbol);
+                    }
+                }
+            }
+            maxCode[static_cast<size_t>(length)] = n > 0 ? code - 1 : -1;
+            code <<= 1;
+        }
+        defined = true;
+        return true;
+    }
+
+    [[nodiscard]] int decode(JpegBitReader &reader) const
+    {
+        const uint16_t entry = fast[reader.peek(kHuffmanFastBits)];
+        if (entry != 0) {
+            reader.skip(entry >> 8);
+            return entry & 0xFF;
+        }
+        for (int length = kHuffmanFastBits + 1; length <= 16; ++length) {
+            const auto code = static_cast<int32_t>(reader.peek(length));
+            if (code <= maxCode[static_cast<size_t>(length)]) {
+                reader.skip(length);
+                return values[static_cast<size_t>(valuePtr[static_cast<size_t>(length)] + code - minCode[static_cast<size_t>(length)])];
+            }
+        }
+        return -1;
+    }
+};
+
+// Decodes one lossless JPEG (SOF3) stream and hands its samples out as rows of
+// tileWidth samples; DNG writers pick the JPEG width and component count freely,
+// so the interleaved sample sequence is simply reshaped to the tile.
+template <typename Emit>
+bool decodeLosslessJpeg(const uchar *data, size_t size, int tileWidth, int tileRows, Emit &&emit, std::string *error)
+{
+    auto fail = [&](const char *message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    auto be16 = [&](size_t at) { return static_cast<int>((data[at] << 8) | data[at + 1]); };
+
+    std::array<HuffmanTable, 4> tables;
+    int precision = 0;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    std::vector<int> componentIds;
+    int restartInterval = 0;
+
+    size_t pos = 0;
+    if (size < 4 || data[0] != 0xFF || data[1] != 0xD8) {
+        return fail("lossless JPEG tile without SOI");
+    }
+    pos = 2;
+    while (pos + 4 <= size) {
+        if (data[pos] != 0xFF) {
+            ++pos;
+            continue;
+        }
+        const int marker = data[pos + 1];
+        pos += 2;
+        if (marker == 0xFF || marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+            continue;
+        }
+        if (marker == 0xD9) {
+            break;
+        }
+        const size_t length = static_cast<size_t>(be16(pos));
+        if (length < 2 || pos + length > size) {
+            return fail("truncated JPEG segment");
+        }
+        const uchar *segment = data + pos + 2;
+        const size_t segmentSize = length - 2;
+        if (marker == 0xC3) {
+            if (segmentSize < 6) {
+                return fail("truncated SOF3");
+            }
+            precision = segment[0];
+            frameHeight = (segment[1] << 8) | segment[2];
+            frameWidth = (segment[3] << 8) | segment[4];
+            if (frameWidth <= 0 || frameHeight <= 0) {
+                return fail("bad SOF3 dimensions");
+            }
+            const int components = segment[5];
+            if (segmentSize < 6 + size_t(components) * 3 || components < 1 || components > 4) {
+                return fail("bad SOF3 component list");
+            }
+            for (int c = 0; c < components; ++c) {
+                if (segment[6 + c * 3 + 1] != 0x11) {
+                    return fail("subsampled lossless JPEG");
+                }
+                componentIds.push_back(segment[6 + c * 3]);
+            }
+        } else if ((marker >= 0xC0 && marker <= 0xCF) && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            return fail("JPEG tile is not lossless (SOF3)");
+        } else if (marker == 0xC4) {
+            size_t at = 0;
+            while (at + 17 <= segmentSize) {
+                const int index = segment[at] & 0x0F;
+                const uint8_t *counts = segment + at + 1;
+                const int total = std::accumulate(counts, counts + 16, 0);
+                if (index > 3 || at + 17 + size_t(total) > segmentSize) {
+                    return fail("bad DHT segment");
+                }
+                if (!tables[static_cast<size_t>(index)].build(counts, segment + at + 17, segmentSize - at - 17)) {
+                    return fail("bad DHT segment");
+                }
+                at += 17 + size_t(total);
+            }
+        } else if (marker == 0xDD) {
+            if (segmentSize < 2) {
+                return fail("truncated DRI");
+            }
+            restartInterval = (segment[0] << 8) | segment[1];
+        } else if (marker == 0xDA) {
+            if (componentIds.empty() || segmentSize < 1) {
+                return fail("SOS before SOF3");
+            }
+            const int scanComponents = segment[0];
+            if (scanComponents != static_cast<int>(componentIds.size()) || segmentSize < 1 + size_t(scanComponents) * 2 + 3) {
+                return fail("multi-scan lossless JPEG");
+            }
+            std::vector<const HuffmanTable *> componentTables;
+            for (int c = 0; c < scanComponents; ++c) {
+                const int table = segment[1 + c * 2 + 1] >> 4;
+                if (table > 3 || !tables[static_cast<size_t>(table)].defined) {
+                    return fail("missing Huffman table");
+                }
+                componentTables.push_back(&tables[static_cast<size_t>(table)]);
+            }
+            const int predictor = segment[1 + scanComponents * 2];
+            const int pointTransform = segment[1 + scanComponents * 2 + 2] & 0x0F;
+            if (predictor < 1 || predictor > 7 || precision < 2 || precision > 16 || pointTransform >= precision) {
+                return fail("unsupported lossless JPEG parameters");
+            }
+            if (restartInterval > 0 && restartInterval % frameWidth != 0) {
+                return fail("restart interval not aligned to rows");
+            }
+
+            const int nc = scanComponents;
+            const int rowSamples = frameWidth * nc;
+            std::vector<uint16_t> previous(static_cast<size_t>(rowSamples));
+            std::vector<uint16_t> current(static_cast<size_t>(rowSamples));
+            std::vector<uint16_t> tileRow(static_cast<size_t>(tileWidth));
+            int tileX = 0;
+            int tileY = 0;
+            const int initial = 1 << (precision - pointTransform - 1);
+            const int rowsPerInterval = restartInterval > 0 ? restartInterval / frameWidth : 0;
+            JpegBitReader reader(data + pos + length, data + size);
+
+            for (int y = 0; y < frameHeight && tileY < tileRows; ++y) {
+                bool firstRow = y == 0;
+                if (rowsPerInterval > 0 && y > 0 && y % rowsPerInterval == 0) {
+                    if (!reader.restart()) {
+                        return fail("missing restart marker");
+                    }
+                    firstRow = true;
+                }
+                for (int x = 0; x < frameWidth; ++x) {
+                    for (int c = 0; c < nc; ++c) {
+                        const int idx = x * nc + c;
+                        int prediction = 0;
+                        if (firstRow) {
+                            prediction = x == 0 ? initial : current[static_cast<size_t>(idx - nc)];
+                        } else if (x == 0) {
+                            prediction = previous[static_cast<size_t>(idx)];
+                        } else {
+                            const int ra = current[static_cast<size_t>(idx - nc)];
+                            const int rb = previous[static_cast<size_t>(idx)];
+                            const int rc = previous[static_cast<size_t>(idx - nc)];
+                            switch (predictor) {
+                            case 1: prediction = ra; break;
+                            case 2: prediction = rb; break;
+                            case 3: prediction = rc; break;
+                            case 4: prediction = ra + rb - rc; break;
+                            case 5: prediction = ra + ((rb - rc) >> 1); break;
+                            case 6: prediction = rb + ((ra - rc) >> 1); break;
+                            default: prediction = (ra + rb) >> 1; break;
+                            }
+                        }
+                        const int category = componentTables[static_cast<size_t>(c)]->decode(reader);
+                        if (category < 0 || category > 16) {
+                            return fail("corrupt Huffman data");
+                        }
+                        int diff = 0;
+                        if (category == 16) {
+                            diff = 32768;
+                        } else if (category > 0) {
+                            diff = static_cast<int>(reader.get(category));
+                            if (diff < (1 << (category - 1))) {
+                                diff -= (1 << category) - 1;
+                            }
+                        }
+                        const auto value = static_cast<uint16_t>((prediction + diff) & 0xFFFF);
+                        current[static_cast<size_t>(idx)] = value;
+                        tileRow[static_cast<size_t>(tileX++)] = static_cast<uint16_t>(value << pointTransform);
+                        if (tileX == tileWidth) {
+                            emit(tileY++, tileRow.data());
+                            tileX = 0;
+                            if (tileY == tileRows) {
+                                return true;
+                            }
+                        }
+                    }
+                }
+                std::swap(previous, current);
+            }
+            return tileY == tileRows || fail("lossless JPEG tile shorter than expected");
+        }
+        pos += length;
+    }
+    return fail("lossless JPEG tile without scan");
+}
+
+// Unpacks one row of uncompressed samples: 8 and 16 bit are byte aligned (16 bit
+// in file byte order), other depths are packed MSB first.
+void unpackRow(const uchar *src, int count, int bits, bool littleEndian, uint16_t *dst)
+{
+    if (bits == 8) {
+        for (int i = 0; i < count; ++i) {
+            dst[i] = src[i];
+        }
+        return;
+    }
+    if (bits == 16) {
+        for (int i = 0; i < count; ++i) {
+            const uchar *p = src + i * 2;
+            dst[i] = littleEndian ? static_cast<uint16_t>(p[0] | (p[1] << 8)) : static_cast<uint16_t>((p[0] << 8) | p[1]);
+        }
+        return;
+    }
+    uint32_t buffer = 0;
+    int available = 0;
+    for (int i = 0; i < count; ++i) {
+        while (available < bits) {
+            buffer = (buffer << 8) | *src++;
+            available += 8;
+        }
+        available -= bits;
+        dst[i] = static_cast<uint16_t>((buffer >> available) & ((1U << bits) - 1U));
+    }
+}
+
+bool readLayout(const TiffView &view, const Ifd &raw, const std::vector<Ifd> &ifds, RawLayout &layout, std::string *error)
+{
+    auto fail = [&](const std::string &message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+    const IfdReader tags(view, raw);
+    layout.width = static_cast<int>(tags.number(kTagImageWidth, 0));
+    layout.height = static_cast<int>(tags.number(kTagImageLength, 0));
+    layout.bits = static_cast<int>(tags.number(kTagBitsPerSample, 1));
+    layout.compression = static_cast<uint32_t>(tags.number(kTagCompression, kCompressionNone));
+    if (layout.width <= 1 || layout.height <= 1) {
+        return fail("raw image has no size");
+    }
+    if (static_cast<int>(tags.number(kTagSamplesPerPixel, 1)) != 1 || tags.number(kTagSampleFormat, 1) != 1) {
+        return fail("only single-sample integer raw data is supported");
+    }
+    if (layout.bits < 1 || layout.bits > 16) {
+        return fail("unsupported BitsPerSample " + std::to_string(layout.bits));
+    }
+    if (layout.compression != kCompressionNone && layout.compression != kCompressionLosslessJpeg) {
+        return fail("unsupported compression " + std::to_string(layout.compression));
+    }
+
+    layout.tiled = tags.find(kTagTileOffsets) != nullptr;
+    if (layout.tiled) {
+        layout.tileWidth = static_cast<int>(tags.number(kTagTileWidth, 0));
+        layout.tileHeight = static_cast<int>(tags.number(kTagTileLength, 0));
+        layout.offsets = tags.numbers(kTagTileOffsets);
+        layout.byteCounts = tags.numbers(kTagTileByteCounts);
+    } else {
+        layout.tileWidth = layout.width;
+        layout.tileHeight = static_cast<int>(std::min<double>(tags.number(kTagRowsPerStrip, layout.height), layout.height));
+        layout.offsets = tags.numbers(kTagStripOffsets);
+        layout.byteCounts = tags.numbers(kTagStripByteCounts);
+    }
+    if (layout.tileWidth <= 0 || layout.tileHeight <= 0 || layout.offsets.empty() ||
+        layout.offsets.size() != layout.byteCounts.size()) {
+        return fail("raw image has no strip or tile layout");
+    }
+    layout.tilesAcross = (layout.width + layout.tileWidth - 1) / layout.tileWidth;
+    const size_t tilesDown = static_cast<size_t>((layout.height + layout.tileHeight - 1) / layout.tileHeight);
+    if (layout.offsets.size() < tilesDown * static_cast<size_t>(layout.tilesAcross)) {
+        return fail("strip or tile table is incomplete");
+    }
+
+    if (static_cast<uint32_t>(tags.number(kTagPhotometric, 0)) == kPhotometricCfa) {
+        layout.cfaRows = static_cast<int>(tags.number(kTagCfaRepeatPatternDim, 2, 0));
+        layout.cfaCols = static_cast<int>(tags.number(kTagCfaRepeatPatternDim, 2, 1));
+        const auto pattern = tags.numbers(kTagCfaPattern);
+        if (layout.cfaRows < 1 || layout.cfaCols < 1 || layout.cfaRows > kMaxPatternDim || layout.cfaCols > kMaxPatternDim ||
+            pattern.size() < static_cast<size_t>(layout.cfaRows * layout.cfaCols)) {
+            return fail("bad CFA pattern");
+        }
+        layout.cfaColors.assign(pattern.begin(), pattern.begin() + layout.cfaRows * layout.cfaCols);
+        for (const Ifd &ifd : ifds) {
+            const auto neutral = IfdReader(view, ifd).numbers(kTagAsShotNeutral);
+            if (neutral.size() == 3 && std::all_of(neutral.begin(), neutral.end(), [](double v) { return v > 0.0; })) {
+                std::copy(neutral.begin(), neutral.end(), layout.neutral.begin());
+                break;
+            }
+        }
+    }
+
+    for (double value : tags.numbers(kTagLinearizationTable)) {
+        layout.linearization.push_back(static_cast<uint16_t>(std::clamp(value, 0.0, 65535.0)));
+    }
+    layout.blackRows = static_cast<int>(tags.number(kTagBlackLevelRepeatDim, 1, 0));
+    layout.blackCols = static_cast<int>(tags.number(kTagBlackLevelRepeatDim, 1, 1));
+    const auto black = tags.numbers(kTagBlackLevel);
+    if (layout.blackRows < 1 || layout.blackCols < 1 || layout.blackRows > kMaxPatternDim || layout.blackCols > kMaxPatternDim) {
+        return fail("bad BlackLevelRepeatDim");
+    }
+    if (black.size() >= static_cast<size_t>(layout.blackRows * layout.blackCols)) {
+        layout.black.assign(black.begin(), black.begin() + layout.blackRows * layout.blackCols);
+    } else {
+        layout.blackRows = 1;
+        layout.blackCols = 1;
+        layout.black.assign(1, black.empty() ? 0.0 : black.front());
+    }
+    const double defaultWhite = layout.linearization.empty() ? static_cast<double>((1 << layout.bits) - 1)
+                                                             : static_cast<double>(layout.linearization.back());
+    layout.white = tags.number(kTagWhiteLevel, defaultWhite);
+    return true;
+}
+
+template <typename T>
+bool decodeRaw(const TiffView &view, size_t fileSize, const RawLayout &layout, bool half, cv::Mat &out, std::string *error)
+{
+    RawSink<T> sink(layout, half, out);
+    std::vector<uint16_t> row(static_cast<size_t>(layout.tileWidth));
+    const size_t tiles = layout.offsets.size();
+    for (size_t t = 0; t < tiles; ++t) {
+        const int tileX = static_cast<int>(t % static_cast<size_t>(layout.tilesAcross)) * layout.tileWidth;
+        const int tileY = static_cast<int>(t / static_cast<size_t>(layout.tilesAcross)) * layout.tileHeight;
+        if (tileY >= layout.height) {
+            break;
+        }
+        const int rows = std::min(layout.tileHeight, layout.height - tileY);
+        const int visible = std::min(layout.tileWidth, layout.width - tileX);
+        const auto offset = static_cast<size_t>(layout.offsets[t]);
+        const size_t available = std::min(static_cast<size_t>(layout.byteCounts[t]), offset <= fileSize ? fileSize - offset : 0);
+        if (!view.contains(offset, available)) {
+            if (error) {
+                *error = "strip or tile outside the file";
+            }
+            return false;
+        }
+        const uchar *data = view.data() + offset;
+
+        if (layout.compression == kCompressionLosslessJpeg) {
+            // Edge tiles are stored full size; the last strip only holds the remaining rows.
+            const int tileRows = layout.tiled ? layout.tileHeight : rows;
+            const bool ok = decodeLosslessJpeg(data, available, layout.tileWidth, tileRows,
+                                               [&](int r, const uint16_t *samples) {
+                                                   if (r < rows) {
+                                                       sink.put(tileX, tileY + r, samples, visible);
+                                                   }
+                                               },
+                                               error);
+            if (!ok) {
+                return false;
+            }
+            continue;
+        }
+
+        const size_t rowBytes = (static_cast<size_t>(layout.tileWidth) * static_cast<size_t>(layout.bits) + 7) / 8;
+        if (rowBytes * static_cast<size_t>(rows) > available) {
+            if (error) {
+                *error = "truncated raw strip or tile";
+            }
+            return false;
+        }
+        for (int r = 0; r < rows; ++r) {
+            unpackRow(data + rowBytes * static_cast<size_t>(r), visible, layout.bits, view.littleEndian(), row.data());
+            sink.put(tileX, tileY + r, row.data(), visible);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+cv::Mat decodeDng(const std::string &path, const DngDecodeOptions &options, std::string *error, cv::Size *sensorSize)
+{
+    auto fail = [&](const std::string &message) {
+        if (error) {
+            *error = message;
+        }
+        return cv::Mat();
+    };
+
+    QFile file(QString::fromStdString(path));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return fail("cannot open " + path);
+    }
+    const auto fileSize = static_cast<size_t>(file.size());
+    const uchar *data = file.map(0, file.size());
+    QByteArray fallback;
+    if (data == nullptr) {
+        fallback = file.readAll();
+        data = reinterpret_cast<const uchar *>(fallback.constData());
+    }
+
+    TiffView view(data, fileSize);
+    uint32_t next = 0;
+    if (!view.parseHeader(&next)) {
+        return fail("not a TIFF/DNG file");
+    }
+
+    // IFD0 chain plus every SubIFD tree; the full-resolution raw usually lives in a SubIFD.
+    std::vector<Ifd> ifds;
+    std::vector<uint32_t> pending {next};
+    std::set<uint32_t> visited;
+    while (!pending.empty() && static_cast<int>(ifds.size()) < kMaxIfds) {
+        uint32_t offset = pending.back();
+        pending.pop_back();
+        while (offset != 0 && visited.insert(offset).second && static_cast<int>(ifds.size()) < kMaxIfds) {
+            Ifd ifd;
+            offset = view.readIfd(offset, ifd);
+            if (const auto it = ifd.find(kTagSubIfds); it != ifd.end()) {
+                for (uint32_t i = 0; i < it->second.count; ++i) {
+                    pending.push_back(static_cast<uint32_t>(view.number(it->second, i)));
+                }
+            }
+            ifds.push_back(std::move(ifd));
+        }
+    }
+
+    const Ifd *raw = nullptr;
+    for (const Ifd &ifd : ifds) {
+        const IfdReader tags(view, ifd);
+        const auto photometric = static_cast<uint32_t>(tags.number(kTagPhotometric, 0));
+        if (tags.number(kTagNewSubFileType, 0) == 0 && (photometric == kPhotometricCfa || photometric == kPhotometricLinearRaw)) {
+            raw = &ifd;
+            if (photometric == kPhotometricCfa) {
+                break;
+            }
+        }
+    }
+    if (raw == nullptr) {
+        return fail("no raw CFA or LinearRaw image");
+    }
+
+    RawLayout layout;
+    if (!readLayout(view, *raw, ifds, layout, error)) {
+        return {};
+    }
+    if (options.halfResolution && (layout.cfaRows > 2 || layout.cfaCols > 2)) {
+        return fail("half resolution needs a 2x2 CFA");
+    }
+
+    cv::Mat out;
+    const cv::Size size = options.halfResolution ? cv::Size(layout.width / 2, layout.height / 2)
+                                                 : cv::Size(layout.width, layout.height);
+    out.create(size, options.keep16Bit ? CV_16UC1 : CV_8UC1);
+    const bool ok = options.keep16Bit ? decodeRaw<uint16_t>(view, fileSize, layout, options.halfResolution, out, error)
+                                      : decodeRaw<uint8_t>(view, fileSize, layout, options.halfResolution, out, error);
+    if (ok && sensorSize) {
+        *sensorSize = cv::Size(layout.width, layout.height);
+    }
+    return ok ? out : cv::Mat();
+}
+
+} // namespace mycalib
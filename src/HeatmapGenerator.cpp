@@ -5,6 +5,7 @@
 #include <cmath>
 #include <cstdio>
 #include <limits>
+#include <memory>
 #include <utility>
 
 #include <opencv2/calib3d.hpp>
@@ -14,6 +15,8 @@ namespace mycalib {
 
 namespace {
 constexpr int kHistogramBinSize = 140;
+constexpr int kSubPixelShift = 4;
+constexpr double kSubPixelScale = 1 << kSubPixelShift;
 
 cv::Mat applyColorMapTurbo(const cv::Mat &src)
 {
@@ -47,36 +50,162 @@ cv::Scalar viridisColor(double t)
     return cv::Scalar(last[0], last[1], last[2]);
 }
 
+// Applies a blur specified in full-resolution pixels to a field sampled at `scale`.
+void smoothField(cv::Mat &field, double sigmaImagePx, double scale)
+{
+    const double sigma = sigmaImagePx * scale;
+    if (sigma >= 0.5) {
+        cv::GaussianBlur(field, field, cv::Size(0, 0), sigma);
+    }
+}
+
 } // namespace
 
+std::shared_ptr<const cv::Mat> HeatmapRenderCache::find(HeatmapField field, const cv::Size &size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &entry : m_entries) {
+        if (entry.field == field && entry.size == size) {
+            return entry.image.lock();
+        }
+    }
+    return nullptr;
+}
+
+void HeatmapRenderCache::store(HeatmapField field, const cv::Size &size, const std::shared_ptr<const cv::Mat> &image)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(), [&](const Entry &entry) {
+                        return entry.image.expired() || (entry.field == field && entry.size == size);
+                    }),
+                    m_entries.end());
+    m_entries.push_back(Entry{field, size, image});
+}
+
+const cv::Mat &HeatmapBundle::scalarField(HeatmapField field) const
+{
+    switch (field) {
+    case HeatmapField::BoardCoverage:
+        return boardCoverageScalar;
+    case HeatmapField::PixelError:
+        return pixelErrorScalar;
+    case HeatmapField::BoardError:
+        return boardErrorScalar;
+    case HeatmapField::Distortion:
+        return distortionScalar;
+    }
+    static const cv::Mat kEmpty;
+    return kEmpty;
+}
+
+std::shared_ptr<const cv::Mat> HeatmapBundle::render(HeatmapField field, const cv::Size &targetSize) const
+{
+    const cv::Mat &scalar = scalarField(field);
+    if (scalar.empty() || targetSize.width <= 0 || targetSize.height <= 0) {
+        return nullptr;
+    }
+    if (renderCache) {
+        if (auto cached = renderCache->find(field, targetSize)) {
+            return cached;
+        }
+    }
+    auto image = std::make_shared<const cv::Mat>(HeatmapGenerator::renderField(scalar, targetSize));
+    if (renderCache) {
+        renderCache->store(field, targetSize, image);
+    }
+    return image;
+}
+
+cv::Size HeatmapGenerator::fieldSizeFor(const cv::Size &imageSize)
+{
+    if (imageSize.width <= 0 || imageSize.height <= 0) {
+        return cv::Size(0, 0);
+    }
+    const double scale = std::min(1.0, static_cast<double>(kFieldMaxDim) /
+                                           static_cast<double>(std::max(imageSize.width, imageSize.height)));
+    return cv::Size(std::max(1, static_cast<int>(std::round(imageSize.width * scale))),
+                    std::max(1, static_cast<int>(std::round(imageSize.height * scale))));
+}
+
+cv::Mat HeatmapGenerator::renderField(const cv::Mat &field, const cv::Size &targetSize)
+{
+    if (field.empty() || targetSize.width <= 0 || targetSize.height <= 0) {
+        return cv::Mat();
+    }
+    cv::Mat resized;
+    if (field.size() == targetSize) {
+        resized = field;
+    } else {
+        const bool upscale = targetSize.width > field.cols || targetSize.height > field.rows;
+        cv::resize(field, resized, targetSize, 0, 0, upscale ? cv::INTER_CUBIC : cv::INTER_AREA);
+    }
+    return applyColorMapTurbo(resized);
+}
+
+HeatmapBundle HeatmapGenerator::buildBundle(const std::vector<DetectionResult> &detections,
+                                            const cv::Mat &cameraMatrix,
+                                            const cv::Mat &distCoeffs,
+                                            const cv::Size &imageSize) const
+{
+    HeatmapBundle bundle;
+    bundle.imageSize = imageSize;
+    bundle.renderCache = std::make_shared<HeatmapRenderCache>();
+    bundle.boardCoverageScalar = buildBoardCoverage(detections,
+                                                    imageSize,
+                                                    &bundle.boardCoverageMin,
+                                                    &bundle.boardCoverageMax);
+    bundle.pixelErrorScalar = buildPixelErrorHeatmap(detections,
+                                                     imageSize,
+                                                     &bundle.pixelErrorMin,
+                                                     &bundle.pixelErrorMax);
+    bundle.boardErrorScalar = buildBoardErrorHeatmap(detections,
+                                                     imageSize,
+                                                     &bundle.boardErrorMin,
+                                                     &bundle.boardErrorMax);
+    bundle.residualScatter = buildResidualScatter(detections, &bundle.residualScatterMax);
+    if (!cameraMatrix.empty() && !distCoeffs.empty()) {
+        bundle.distortionScalar = buildDistortionHeatmap(cameraMatrix,
+                                                         distCoeffs,
+                                                         imageSize,
+                                                         &bundle.distortionMin,
+                                                         &bundle.distortionMax,
+                                                         &bundle.distortionGrid,
+                                                         &bundle.distortionVectors);
+    }
+    return bundle;
+}
+
 cv::Mat HeatmapGenerator::buildBoardCoverage(const std::vector<DetectionResult> &detections,
                                              const cv::Size &imageSize,
                                              double *minValue,
-                                             double *maxValue,
-                                             cv::Mat *rawScalarOut) const
+                                             double *maxValue) const
 {
-    cv::Mat coverage = cv::Mat::zeros(imageSize, CV_32F);
+    const cv::Size fieldSize = fieldSizeFor(imageSize);
+    if (fieldSize.area() == 0) {
+        return cv::Mat();
+    }
+
+    // Hulls are rasterized directly at field resolution with sub-pixel vertices.
+    const double sx = static_cast<double>(fieldSize.width) / imageSize.width * kSubPixelScale;
+    const double sy = static_cast<double>(fieldSize.height) / imageSize.height * kSubPixelScale;
+
+    cv::Mat coverage = cv::Mat::zeros(fieldSize, CV_32F);
+    cv::Mat mask(fieldSize, CV_8U);
     for (const auto &rec : detections) {
-        if (!rec.success || rec.imagePoints.empty()) {
+        if (!rec.success || rec.imagePoints.size() < 4) {
             continue;
         }
-        std::vector<cv::Point> hull;
-        hull.reserve(rec.imagePoints.size());
-        for (const auto &pt : rec.imagePoints) {
-            hull.emplace_back(cv::Point(static_cast<int>(pt.x), static_cast<int>(pt.y)));
-        }
-        if (hull.size() >= 4) {
-            std::vector<int> hullIndices;
-            cv::convexHull(hull, hullIndices);
-            std::vector<cv::Point> hullPoints;
-            hullPoints.reserve(hullIndices.size());
-            for (int idx : hullIndices) {
-                hullPoints.emplace_back(hull[idx]);
-            }
-            cv::Mat mask = cv::Mat::zeros(imageSize, CV_8U);
-            cv::fillConvexPoly(mask, hullPoints, cv::Scalar(255));
-            coverage += mask / 255.0f;
+        std::vector<cv::Point2f> hull;
+        cv::convexHull(rec.imagePoints, hull);
+        std::vector<cv::Point> hullPoints;
+        hullPoints.reserve(hull.size());
+        for (const auto &pt : hull) {
+            hullPoints.emplace_back(static_cast<int>(std::round(pt.x * sx)),
+                                    static_cast<int>(std::round(pt.y * sy)));
         }
+        mask.setTo(0);
+        cv::fillConvexPoly(mask, hullPoints, cv::Scalar(1), cv::LINE_8, kSubPixelShift);
+        cv::add(coverage, 1.0, coverage, mask);
     }
 
     double minVal = 0.0, maxVal = 0.0;
@@ -87,19 +216,13 @@ cv::Mat HeatmapGenerator::buildBoardCoverage(const std::vector<DetectionResult>
     if (maxValue) {
         *maxValue = maxVal;
     }
-
-    if (rawScalarOut) {
-        coverage.copyTo(*rawScalarOut);
-    }
-
-    return applyColorMapTurbo(coverage);
+    return coverage;
 }
 
 cv::Mat HeatmapGenerator::buildPixelErrorHeatmap(const std::vector<DetectionResult> &detections,
                                                  const cv::Size &imageSize,
                                                  double *minValue,
-                                                 double *maxValue,
-                                                 cv::Mat *rawScalarOut) const
+                                                 double *maxValue) const
 {
     if (imageSize.width == 0 || imageSize.height == 0) {
         return cv::Mat();
@@ -144,25 +267,28 @@ cv::Mat HeatmapGenerator::buildPixelErrorHeatmap(const std::vector<DetectionResu
         *maxValue = maxVal;
     }
 
-    cv::Mat upscaled = renderHeatmapFromHistogram(avg, imageSize);
-    if (rawScalarOut) {
-        upscaled.copyTo(*rawScalarOut);
-    }
-    return applyColorMapTurbo(upscaled);
+    const cv::Size fieldSize = fieldSizeFor(imageSize);
+    cv::Mat field;
+    cv::resize(avg, field, fieldSize, 0, 0, cv::INTER_CUBIC);
+    smoothField(field, 5.5, static_cast<double>(fieldSize.width) / imageSize.width);
+    return field;
 }
 
 cv::Mat HeatmapGenerator::buildBoardErrorHeatmap(const std::vector<DetectionResult> &detections,
                                                  const cv::Size &imageSize,
                                                  double *minValue,
-                                                 double *maxValue,
-                                                 cv::Mat *rawScalarOut) const
+                                                 double *maxValue) const
 {
     if (imageSize.width == 0 || imageSize.height == 0) {
         return cv::Mat();
     }
 
-    cv::Mat accumulation = cv::Mat::zeros(imageSize, CV_32F);
-    cv::Mat counter = cv::Mat::zeros(imageSize, CV_32F);
+    const cv::Size fieldSize = fieldSizeFor(imageSize);
+    const double scaleX = static_cast<double>(fieldSize.width) / imageSize.width;
+    const double scaleY = static_cast<double>(fieldSize.height) / imageSize.height;
+
+    cv::Mat accumulation = cv::Mat::zeros(fieldSize, CV_32F);
+    cv::Mat counter = cv::Mat::zeros(fieldSize, CV_32F);
 
     for (const auto &rec : detections) {
         if (!rec.success || rec.imagePoints.empty() || rec.residualsPx.empty()) {
@@ -171,8 +297,8 @@ cv::Mat HeatmapGenerator::buildBoardErrorHeatmap(const std::vector<DetectionResu
         for (size_t i = 0; i < rec.imagePoints.size() && i < rec.residualsPx.size(); ++i) {
             const auto &pt = rec.imagePoints[i];
             const double err = rec.residualsPx[i];
-            int x = std::clamp(static_cast<int>(std::round(pt.x)), 0, imageSize.width - 1);
-            int y = std::clamp(static_cast<int>(std::round(pt.y)), 0, imageSize.height - 1);
+            int x = std::clamp(static_cast<int>(pt.x * scaleX), 0, fieldSize.width - 1);
+            int y = std::clamp(static_cast<int>(pt.y * scaleY), 0, fieldSize.height - 1);
             accumulation.at<float>(y, x) += static_cast<float>(err);
             counter.at<float>(y, x) += 1.f;
         }
@@ -184,7 +310,9 @@ cv::Mat HeatmapGenerator::buildBoardErrorHeatmap(const std::vector<DetectionResu
 
     double minVal = 0.0, maxVal = 0.0;
     cv::Mat mask = counter > 0;
-    cv::minMaxLoc(average, &minVal, &maxVal, nullptr, nullptr, mask);
+    if (cv::countNonZero(mask) > 0) {
+        cv::minMaxLoc(average, &minVal, &maxVal, nullptr, nullptr, mask);
+    }
     if (minValue) {
         *minValue = minVal;
     }
@@ -192,21 +320,9 @@ cv::Mat HeatmapGenerator::buildBoardErrorHeatmap(const std::vector<DetectionResu
         *maxValue = maxVal;
     }
 
-    cv::Mat blurred;
-    cv::GaussianBlur(average, blurred, cv::Size(0, 0), 6.0);
-    if (rawScalarOut) {
-        blurred.copyTo(*rawScalarOut);
-    }
-    return applyColorMapTurbo(blurred);
-}
-
-cv::Mat HeatmapGenerator::renderHeatmapFromHistogram(const cv::Mat &histogram, const cv::Size &targetSize)
-{
-    cv::Mat temp;
-    cv::resize(histogram, temp, targetSize, 0, 0, cv::INTER_CUBIC);
-    cv::Mat blurred;
-    cv::GaussianBlur(temp, blurred, cv::Size(0, 0), 5.5);
-    return blurred;
+    // Residuals are sparse at field resolution too; keep at least one cell of smoothing.
+    cv::GaussianBlur(average, average, cv::Size(0, 0), std::max(1.0, 6.0 * scaleX));
+    return average;
 }
 
 cv::Mat HeatmapGenerator::buildResidualScatter(const std::vector<DetectionResult> &detections,
@@ -318,7 +434,6 @@ cv::Mat HeatmapGenerator::buildDistortionHeatmap(const cv::Mat &cameraMatrix,
                                                 double *minValue,
                                                 double *maxValue,
                                                 std::vector<std::vector<cv::Point2f>> *gridLines,
-                                                cv::Mat *rawScalarOut,
                                                 cv::Mat *vectorFieldOut) const
 {
     if (imageSize.width <= 0 || imageSize.height <= 0 || cameraMatrix.empty()) {
@@ -331,9 +446,6 @@ cv::Mat HeatmapGenerator::buildDistortionHeatmap(const cv::Mat &cameraMatrix,
         if (gridLines) {
             gridLines->clear();
         }
-        if (rawScalarOut) {
-            rawScalarOut->release();
-        }
         if (vectorFieldOut) {
             vectorFieldOut->release();
         }
@@ -353,33 +465,65 @@ cv::Mat HeatmapGenerator::buildDistortionHeatmap(const cv::Mat &cameraMatrix,
         distCoeffs.convertTo(distCoeffs64, CV_64F);
     }
 
-    cv::Mat map;
-    cv::Mat map2;
-    cv::initUndistortRectifyMap(camera64, distCoeffs64, cv::Mat(), camera64, imageSize, CV_32FC2, map, map2);
+    const double fx = camera64.at<double>(0, 0);
+    const double fy = camera64.at<double>(1, 1);
+    const double cx = camera64.at<double>(0, 2);
+    const double cy = camera64.at<double>(1, 2);
+
+    // Sample the undistortion displacement at field-cell centres only (plus the four
+    // image corners for the extrema) instead of building a full-resolution remap.
+    const cv::Size fieldSize = fieldSizeFor(imageSize);
+    const double cellW = static_cast<double>(imageSize.width) / fieldSize.width;
+    const double cellH = static_cast<double>(imageSize.height) / fieldSize.height;
+
+    std::vector<cv::Point2f> pixels;
+    pixels.reserve(static_cast<size_t>(fieldSize.area()) + 4);
+    for (int y = 0; y < fieldSize.height; ++y) {
+        for (int x = 0; x < fieldSize.width; ++x) {
+            pixels.emplace_back(static_cast<float>((x + 0.5) * cellW - 0.5),
+                                static_cast<float>((y + 0.5) * cellH - 0.5));
+        }
+    }
+    const float right = static_cast<float>(imageSize.width - 1);
+    const float bottom = static_cast<float>(imageSize.height - 1);
+    pixels.emplace_back(0.0f, 0.0f);
+    pixels.emplace_back(right, 0.0f);
+    pixels.emplace_back(0.0f, bottom);
+    pixels.emplace_back(right, bottom);
+
+    std::vector<cv::Point3f> rays;
+    rays.reserve(pixels.size());
+    for (const auto &px : pixels) {
+        rays.emplace_back(static_cast<float>((px.x - cx) / fx), static_cast<float>((px.y - cy) / fy), 1.0f);
+    }
+    std::vector<cv::Point2f> sources;
+    cv::projectPoints(rays, cv::Vec3d::zeros(), cv::Vec3d::zeros(), camera64, distCoeffs64, sources);
 
-    cv::Mat magnitude(imageSize, CV_32F);
-    cv::Mat *vectorDest = nullptr;
+    cv::Mat magnitude(fieldSize, CV_32F);
     if (vectorFieldOut) {
-        vectorFieldOut->create(imageSize.height, imageSize.width, CV_32FC2);
-        vectorDest = vectorFieldOut;
+        vectorFieldOut->create(fieldSize, CV_32FC2);
     }
     double localMin = std::numeric_limits<double>::infinity();
     double localMax = 0.0;
 
-    for (int y = 0; y < imageSize.height; ++y) {
-        const cv::Vec2f *row = map.ptr<cv::Vec2f>(y);
-        float *dst = magnitude.ptr<float>(y);
-        for (int x = 0; x < imageSize.width; ++x) {
-            const cv::Vec2f src = row[x];
-            const float dx = src[0] - static_cast<float>(x);
-            const float dy = src[1] - static_cast<float>(y);
-            const float mag = std::sqrt(dx * dx + dy * dy);
-            dst[x] = mag;
-            if (vectorDest) {
-                vectorDest->at<cv::Vec2f>(y, x) = cv::Vec2f(dx, dy);
-            }
-            localMin = std::min<double>(localMin, mag);
-            localMax = std::max<double>(localMax, mag);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        float dx = sources[i].x - pixels[i].x;
+        float dy = sources[i].y - pixels[i].y;
+        if (!std::isfinite(dx) || !std::isfinite(dy)) {
+            dx = 0.0f;
+            dy = 0.0f;
+        }
+        const float mag = std::sqrt(dx * dx + dy * dy);
+        localMin = std::min<double>(localMin, mag);
+        localMax = std::max<double>(localMax, mag);
+        if (i >= static_cast<size_t>(fieldSize.area())) {
+            continue;
+        }
+        const int row = static_cast<int>(i) / fieldSize.width;
+        const int col = static_cast<int>(i) % fieldSize.width;
+        magnitude.at<float>(row, col) = mag;
+        if (vectorFieldOut) {
+            vectorFieldOut->at<cv::Vec2f>(row, col) = cv::Vec2f(dx, dy);
         }
     }
 
@@ -400,10 +544,6 @@ cv::Mat HeatmapGenerator::buildDistortionHeatmap(const cv::Mat &cameraMatrix,
         const int clampedSamples = std::clamp(samplesPerLine, 36, 160);
         const double width = static_cast<double>(imageSize.width - 1);
         const double height = static_cast<double>(imageSize.height - 1);
-        const double fx = camera64.at<double>(0, 0);
-        const double fy = camera64.at<double>(1, 1);
-        const double cx = camera64.at<double>(0, 2);
-        const double cy = camera64.at<double>(1, 2);
 
         gridLines->reserve((gridCount + 1) * 2);
 
@@ -449,12 +589,8 @@ cv::Mat HeatmapGenerator::buildDistortionHeatmap(const cv::Mat &cameraMatrix,
         }
     }
 
-    cv::Mat blurred;
-    cv::GaussianBlur(magnitude, blurred, cv::Size(0, 0), 3.0);
-    if (rawScalarOut) {
-        blurred.copyTo(*rawScalarOut);
-    }
-    return applyColorMapTurbo(blurred);
+    smoothField(magnitude, 3.0, 1.0 / cellW);
+    return magnitude;
 }
 
 } // namespace mycalib
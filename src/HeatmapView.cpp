@@ -8,6 +8,12 @@
 
 namespace mycalib {
 
+namespace {
+
+constexpr int kMinMipLongSide = 128;
+
+} // namespace
+
 HeatmapView::HeatmapView(QWidget *parent)
     : QFrame(parent)
 {
@@ -25,6 +31,7 @@ void HeatmapView::setTitle(const QString &title)
 void HeatmapView::setHeatmap(const QImage &image, double minValue, double maxValue, const QString &legendLabel)
 {
     m_heatmap = image;
+    buildMipChain();
     m_minValue = minValue;
     m_maxValue = maxValue;
     m_legendLabel = legendLabel;
@@ -36,6 +43,8 @@ void HeatmapView::setHeatmap(const QImage &image, double minValue, double maxVal
 void HeatmapView::clear()
 {
     m_heatmap = QImage();
+    m_mipChain.clear();
+    m_scaledCache = QImage();
     m_legendLabel.clear();
     m_showLegend = false;
     m_warpedGridLines.clear();
@@ -95,7 +104,7 @@ void HeatmapView::paintEvent(QPaintEvent *event)
     if (!m_heatmap.isNull()) {
         const int legendAreaHeight = m_showLegend ? 82 : 24;
         QRect imageRect = content.adjusted(16, 56, -16, -legendAreaHeight);
-        QImage scaled = m_heatmap.scaled(imageRect.size(), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        const QImage &scaled = scaledHeatmap(m_heatmap.size().scaled(imageRect.size(), Qt::KeepAspectRatio));
         QRect target(imageRect);
         target.setSize(scaled.size());
         target.moveCenter(imageRect.center());
@@ -205,6 +214,46 @@ void HeatmapView::paintEvent(QPaintEvent *event)
     }
 }
 
+void HeatmapView::buildMipChain()
+{
+    m_mipChain.clear();
+    m_scaledCache = QImage();
+    if (m_heatmap.isNull()) {
+        return;
+    }
+    m_mipChain.append(m_heatmap);
+    while (std::max(m_mipChain.constLast().width(), m_mipChain.constLast().height()) / 2 >= kMinMipLongSide) {
+        const QImage &previous = m_mipChain.constLast();
+        m_mipChain.append(previous.scaled(std::max(1, previous.width() / 2),
+                                          std::max(1, previous.height() / 2),
+                                          Qt::IgnoreAspectRatio,
+                                          Qt::SmoothTransformation));
+    }
+}
+
+const QImage &HeatmapView::scaledHeatmap(const QSize &target)
+{
+    if (target.isEmpty()) {
+        m_scaledCache = QImage();
+        return m_scaledCache;
+    }
+    if (m_scaledCache.size() == target) {
+        return m_scaledCache;
+    }
+    // Levels shrink monotonically, so the last one still covering target is the
+    // cheapest source that does not upsample.
+    const QImage *source = &m_mipChain.constFirst();
+    for (const QImage &level : m_mipChain) {
+        if (level.width() < target.width() || level.height() < target.height()) {
+            break;
+        }
+        source = &level;
+    }
+    m_scaledCache = source->scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation)
+                        .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    return m_scaledCache;
+}
+
 QString HeatmapView::formatValue(double value) const
 {
     return QString::number(value, 'f', m_valuePrecision);
@@ -11,39 +11,35 @@
 
 #include <opencv2/imgcodecs.hpp>
 
+#include "DngReader.h"
+
 namespace fs = std::filesystem;
 
 namespace mycalib {
 
 namespace {
-constexpr const char *kExtensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".dng", ".DNG"};
+constexpr const char *kExtensions[] = {".png", ".jpg", ".jpeg", ".bmp", ".tif", ".tiff", ".dng"};
 
-bool hasSupportedExtension(const fs::path &path)
+std::string lowerExtension(const fs::path &path)
 {
-    const std::string ext = path.extension().string();
-    for (const char *candidate : kExtensions) {
-        if (ext == candidate) {
-            return true;
-        }
-    }
-    return false;
+    std::string ext = path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return ext;
 }
 
 bool isRawDng(const fs::path &path)
 {
-    std::string ext = path.extension().string();
-    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
-    return ext == ".dng";
+    return lowerExtension(path) == ".dng";
 }
 
-cv::Mat loadWithQtReader(const std::string &path)
+bool isJpeg(const fs::path &path)
+{
+    const std::string ext = lowerExtension(path);
+    return ext == ".jpg" || ext == ".jpeg";
+}
+
+cv::Mat toGrayMat(QImage qimage, const std::string &path)
 {
-    QImageReader reader(QString::fromStdString(path));
-    reader.setAutoTransform(true);
-    QImage qimage = reader.read();
-    if (qimage.isNull()) {
-        throw std::runtime_error("Failed to read image: " + path + ", error: " + reader.errorString().toStdString());
-    }
     if (qimage.format() != QImage::Format_Grayscale8) {
         qimage = qimage.convertToFormat(QImage::Format_Grayscale8);
     }
@@ -54,8 +50,30 @@ cv::Mat loadWithQtReader(const std::string &path)
     return converted.clone();
 }
 
+cv::Mat loadWithQtReader(const std::string &path)
+{
+    QImageReader reader(QString::fromStdString(path));
+    reader.setAutoTransform(true);
+    QImage qimage = reader.read();
+    if (qimage.isNull()) {
+        throw std::runtime_error("Failed to read image: " + path + ", error: " + reader.errorString().toStdString());
+    }
+    return toGrayMat(std::move(qimage), path);
+}
+
 } // namespace
 
+bool ImageLoader::isSupportedImage(const std::string &path)
+{
+    const std::string ext = lowerExtension(fs::path(path));
+    for (const char *candidate : kExtensions) {
+        if (ext == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
 std::vector<std::string> ImageLoader::gatherImageFiles(const std::string &directory) const
 {
     std::vector<std::string> files;
@@ -68,7 +86,7 @@ std::vector<std::string> ImageLoader::gatherImageFiles(const std::string &direct
         if (!entry.is_regular_file()) {
             continue;
         }
-        if (hasSupportedExtension(entry.path())) {
+        if (isSupportedImage(entry.path().string())) {
             files.emplace_back(entry.path().string());
         }
     }
@@ -77,14 +95,20 @@ std::vector<std::string> ImageLoader::gatherImageFiles(const std::string &direct
     return files;
 }
 
-cv::Mat ImageLoader::loadImage(const std::string &path) const
+cv::Mat ImageLoader::loadImage(const std::string &path, bool keep16Bit) const
 {
     fs::path filePath(path);
     if (isRawDng(filePath)) {
+        DngDecodeOptions options;
+        options.keep16Bit = keep16Bit;
+        cv::Mat raw = decodeDng(path, options);
+        if (!raw.empty()) {
+            return raw;
+        }
         return loadWithQtReader(path);
     }
 
-    cv::Mat image = cv::imread(path, cv::IMREAD_GRAYSCALE);
+    cv::Mat image = cv::imread(path, keep16Bit ? cv::IMREAD_GRAYSCALE | cv::IMREAD_ANYDEPTH : cv::IMREAD_GRAYSCALE);
     if (!image.empty()) {
         return image;
     }
@@ -92,4 +116,83 @@ cv::Mat ImageLoader::loadImage(const std::string &path) const
     return loadWithQtReader(path);
 }
 
+std::optional<ReducedImage> ImageLoader::loadReduced(const std::string &path, int minShortSide) const
+{
+    if (isRawDng(fs::path(path))) {
+        DngDecodeOptions options;
+        options.halfResolution = true;
+        ReducedImage reduced;
+        reduced.image = decodeDng(path, options, nullptr, &reduced.fullSize);
+        if (reduced.image.empty() || std::min(reduced.image.cols, reduced.image.rows) < minShortSide) {
+            return std::nullopt;
+        }
+        reduced.factor = 2;
+        return reduced;
+    }
+    if (!isJpeg(fs::path(path))) {
+        return std::nullopt;
+    }
+    // Header-only probe; the reduced decode below ignores EXIF orientation, so
+    // rotated files take the full path where imread applies it.
+    QImageReader probe(QString::fromStdString(path));
+    const QSize size = probe.size();
+    if (!size.isValid() || probe.transformation() != QImageIOHandler::TransformationNone) {
+        return std::nullopt;
+    }
+
+    const int shortSide = std::min(size.width(), size.height());
+    int factor = 1;
+    for (int candidate : {8, 4, 2}) {
+        if (shortSide / candidate >= minShortSide) {
+            factor = candidate;
+            break;
+        }
+    }
+    if (factor == 1) {
+        return std::nullopt;
+    }
+
+    const int flag = factor == 8 ? cv::IMREAD_REDUCED_GRAYSCALE_8
+                     : factor == 4 ? cv::IMREAD_REDUCED_GRAYSCALE_4
+                                   : cv::IMREAD_REDUCED_GRAYSCALE_2;
+    ReducedImage reduced;
+    reduced.image = cv::imread(path, flag | cv::IMREAD_IGNORE_ORIENTATION);
+    if (reduced.image.empty()) {
+        return std::nullopt;
+    }
+    reduced.factor = factor;
+    reduced.fullSize = cv::Size(size.width(), size.height());
+    return reduced;
+}
+
+cv::Mat ImageLoader::loadRegion(const std::string &path, const cv::Rect &region) const
+{
+    if (region.width <= 0 || region.height <= 0) {
+        return {};
+    }
+    if (isRawDng(fs::path(path))) {
+        const cv::Mat full = decodeDng(path);
+        if ((region & cv::Rect(0, 0, full.cols, full.rows)) != region) {
+            return {};
+        }
+        return full(region).clone();
+    }
+    QImageReader reader(QString::fromStdString(path));
+    reader.setAutoTransform(false);
+    if (reader.supportsOption(QImageIOHandler::ClipRect)) {
+        reader.setClipRect(QRect(region.x, region.y, region.width, region.height));
+        QImage qimage = reader.read();
+        if (!qimage.isNull() && qimage.width() == region.width && qimage.height() == region.height) {
+            return toGrayMat(std::move(qimage), path);
+        }
+    }
+
+    const cv::Mat full = cv::imread(path, cv::IMREAD_GRAYSCALE | cv::IMREAD_IGNORE_ORIENTATION);
+    const cv::Rect clipped = region & cv::Rect(0, 0, full.cols, full.rows);
+    if (clipped != region) {
+        return {};
+    }
+    return full(region).clone();
+}
+
 } // namespace mycalib
@@ -16,6 +16,7 @@
 #include <QCheckBox>
 #include <QColor>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QFileInfo>
 #include <QJsonArray>
 #include <QJsonDocument>
@@ -49,7 +50,6 @@
 #include <QTextBlockFormat>
 #include <QToolBar>
 #include <QTreeWidget>
-#include <QFileSystemWatcher>
 #include <QVBoxLayout>
 #include <QVector>
 #include <QTableWidget>
@@ -60,6 +60,7 @@
 #include <QFile>
 #include <QPoint>
 #include <QDir>
+#include <QDirIterator>
 #include <QMetaObject>
 #include <QWidget>
 #include <QRegularExpression>
@@ -67,10 +68,12 @@
 #include <QSignalBlocker>
 #include <QToolButton>
 #include <QSet>
+#include <QTimer>
 #include <QHash>
 #include <QUuid>
 #include <QtCore/Qt>
 #include <QtMath>
+#include <QtConcurrent/QtConcurrent>
 #include <QMouseEvent>
 #include <QKeyEvent>
 
@@ -98,13 +101,17 @@
 #undef min
 #endif
 
+#include "DatasetIndex.h"
 #include "DetectionPreviewWidget.h"
+#include "DetectionTuner.h"
 #include "ImageEvaluationDialog.h"
 #include "HeatmapGenerator.h"
 #include "HeatmapView.h"
+#include "ImageLoader.h"
 #include "Logger.h"
 #include "Pose3DView.h"
 #include "ResidualScatterView.h"
+#include "ThumbnailCache.h"
 #include "ParameterDialog.h"
 
 #if MYCALIB_HAVE_CONNECTED_CAMERA
@@ -138,6 +145,22 @@ QImage cvMatToQImage(const cv::Mat &mat)
     return {};
 }
 
+// Heatmaps are rendered for the GUI at most this large; the views scale further down.
+constexpr int kHeatmapPreviewMaxDim = 1600;
+// How often the progress bar samples the engine's counters during a run.
+constexpr int kProgressPollMs = 100;
+
+cv::Size heatmapPreviewSize(const cv::Size &imageSize)
+{
+    if (imageSize.width <= 0 || imageSize.height <= 0) {
+        return cv::Size(0, 0);
+    }
+    const double scale = std::min(1.0, static_cast<double>(kHeatmapPreviewMaxDim) /
+                                           static_cast<double>(std::max(imageSize.width, imageSize.height)));
+    return cv::Size(std::max(1, static_cast<int>(std::round(imageSize.width * scale))),
+                    std::max(1, static_cast<int>(std::round(imageSize.height * scale))));
+}
+
 QColor blendColors(const QColor &a, const QColor &b, double t)
 {
     const double clamped = std::clamp(t, 0.0, 1.0);
@@ -241,16 +264,27 @@ struct PoseDescriptor {
     ProjectSession::CapturePose pose;
     const char *display;
     const char *hint;
+    CaptureTilt tilt; // nominal board tilt the capture guidance scores this pose with
 };
 
 const PoseDescriptor kPoseDescriptors[] = {
-    {ProjectSession::CapturePose::Flat, QT_TR_NOOP("平拍"), QT_TR_NOOP("镜头与标定板平行" )},
-    {ProjectSession::CapturePose::TiltUp, QT_TR_NOOP("上仰"), QT_TR_NOOP("相机略微向上俯视棋盘" )},
-    {ProjectSession::CapturePose::TiltDown, QT_TR_NOOP("下俯"), QT_TR_NOOP("相机略微俯视棋盘" )},
-    {ProjectSession::CapturePose::TiltLeft, QT_TR_NOOP("左倾"), QT_TR_NOOP("相机向左倾斜拍摄" )},
-    {ProjectSession::CapturePose::TiltRight, QT_TR_NOOP("右倾"), QT_TR_NOOP("相机向右倾斜拍摄" )}
+    {ProjectSession::CapturePose::Flat, QT_TR_NOOP("平拍"), QT_TR_NOOP("镜头与标定板平行" ), {0.0, 0.0}},
+    {ProjectSession::CapturePose::TiltUp, QT_TR_NOOP("上仰"), QT_TR_NOOP("相机略微向上俯视棋盘" ), {-20.0, 0.0}},
+    {ProjectSession::CapturePose::TiltDown, QT_TR_NOOP("下俯"), QT_TR_NOOP("相机略微俯视棋盘" ), {20.0, 0.0}},
+    {ProjectSession::CapturePose::TiltLeft, QT_TR_NOOP("左倾"), QT_TR_NOOP("相机向左倾斜拍摄" ), {0.0, -20.0}},
+    {ProjectSession::CapturePose::TiltRight, QT_TR_NOOP("右倾"), QT_TR_NOOP("相机向右倾斜拍摄" ), {0.0, 20.0}}
 };
 
+std::vector<CaptureTilt> captureGuidanceTilts()
+{
+    std::vector<CaptureTilt> tilts;
+    tilts.reserve(std::size(kPoseDescriptors));
+    for (const auto &descriptor : kPoseDescriptors) {
+        tilts.push_back(descriptor.tilt);
+    }
+    return tilts;
+}
+
 int capturePoseIndex(ProjectSession::CapturePose pose)
 {
     for (int i = 0; i < static_cast<int>(std::size(kPoseDescriptors)); ++i) {
@@ -534,7 +568,10 @@ QJsonArray vec3dToJson(const cv::Vec3d &vec)
 }
 
 constexpr quint32 kSnapshotMagic = 0x4D43534E; // 'MCSN'
-constexpr quint16 kSnapshotVersion = 1;
+// Version 2 added intrinsicsStdDev and per-view leverage/influence; version 3
+// added per-view sharpness, validationOnly and the validation view list. Older
+// snapshots still load with those left at their defaults.
+constexpr quint16 kSnapshotVersion = 3;
 
 void writeMat(QDataStream &out, const cv::Mat &mat)
 {
@@ -822,6 +859,8 @@ void writeDetectionList(QDataStream &out, const std::vector<DetectionResult> &de
             writeIntVector(out, *det.inlierIndices);
         }
         out << qint32(det.iterationRemoved);
+        out << det.leverage << det.influence;
+        out << det.sharpness << det.validationOnly;
         out << det.cachedMeanErrorPx;
         out << det.cachedMaxErrorPx;
         writeVec2iVector(out, det.logicalIndices);
@@ -847,7 +886,7 @@ void writeDetectionList(QDataStream &out, const std::vector<DetectionResult> &de
     }
 }
 
-std::vector<DetectionResult> readDetectionList(QDataStream &in)
+std::vector<DetectionResult> readDetectionList(QDataStream &in, quint16 version)
 {
     quint32 count = 0;
     in >> count;
@@ -881,6 +920,12 @@ std::vector<DetectionResult> readDetectionList(QDataStream &in)
         qint32 iteration = 0;
         in >> iteration;
         det.iterationRemoved = iteration;
+        if (version >= 2) {
+            in >> det.leverage >> det.influence;
+        }
+        if (version >= 3) {
+            in >> det.sharpness >> det.validationOnly;
+        }
         in >> det.cachedMeanErrorPx;
         in >> det.cachedMaxErrorPx;
         det.logicalIndices = readVec2iVector(in);
@@ -957,9 +1002,20 @@ MainWindow::MainWindow(ProjectSession *session, QWidget *parent)
     setupActions();
     applyTheme();
 
-    m_inputWatcher = new QFileSystemWatcher(this);
-    connect(m_inputWatcher, &QFileSystemWatcher::directoryChanged, this, &MainWindow::handleInputDirectoryChanged);
-    connect(m_inputWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::handleInputDirectoryChanged);
+    m_inputIndex = new DatasetIndex(this);
+    connect(m_inputIndex, &DatasetIndex::changed, this, &MainWindow::handleInputDirectoryChanged);
+
+    m_progressTimer = new QTimer(this);
+    m_progressTimer->setInterval(kProgressPollMs);
+    connect(m_progressTimer, &QTimer::timeout, this, &MainWindow::pollProgress);
+
+    if (m_session && !m_session->rootPath().isEmpty()) {
+        m_thumbnails = std::make_unique<ThumbnailCache>(m_session->configDir().filePath(QStringLiteral("thumbnails")));
+        m_engine->setThumbnailCache(m_thumbnails.get());
+        if (m_detectionPreview) {
+            m_detectionPreview->setThumbnailCache(m_thumbnails.get());
+        }
+    }
 
     bindSessionSignals();
     updateWindowTitle();
@@ -968,7 +1024,6 @@ MainWindow::MainWindow(ProjectSession *session, QWidget *parent)
     restoreCalibrationSnapshot();
     persistProjectSummary(false);
 
-    connect(m_engine, &CalibrationEngine::progressUpdated, this, &MainWindow::handleProgress);
     connect(m_engine, &CalibrationEngine::statusChanged, this, &MainWindow::handleStatus);
     connect(m_engine, &CalibrationEngine::finished, this, &MainWindow::handleFinished);
     connect(m_engine, &CalibrationEngine::failed, this, &MainWindow::handleFailed);
@@ -992,6 +1047,12 @@ MainWindow::~MainWindow()
     if (m_engine) {
         m_engine->cancelAndWait();
     }
+    if (m_detectionTuningControl) {
+        m_detectionTuningControl->requestCancel();
+        if (m_detectionTuningWatcher) {
+            m_detectionTuningWatcher->waitForFinished();
+        }
+    }
     cleanupDebugArtifacts(m_lastOutput);
     if (m_session) {
         QString error;
@@ -2447,19 +2508,7 @@ void MainWindow::refreshCapturePlanUi()
     refreshCaptureGridButtons();
     refreshCapturePoseButtons();
 
-    const int total = captureTotalShots();
-    if (m_capturePlanSummary) {
-        if (m_activeSource == ProjectSession::DataSource::ConnectedCamera) {
-            const int targetTotal = kCaptureGridRows * kCaptureGridCols * kCaptureTargetPerCell;
-            m_capturePlanSummary->setText(tr("阶段二进度：%1 / %2 张样本")
-                                              .arg(total)
-                                              .arg(targetTotal));
-        } else {
-            m_capturePlanSummary->setText(tr("基于检测结果的九宫格统计：%1 张样本" )
-                                              .arg(total));
-        }
-    }
-
+    updateCapturePlanSummary();
     updateCaptureOverlay();
     updateCaptureFeedback(m_lastOutput);
 }
@@ -2627,8 +2676,16 @@ void MainWindow::updateCaptureOverlay()
         if (isCapturePlanActive()) {
             view->setGridOverlayEnabled(true);
             view->setGridHighlight(m_captureSelectedRow, m_captureSelectedCol);
+            if (m_captureRecommendation.valid) {
+                view->setGridRecommendation(m_captureRecommendation.row,
+                                            m_captureRecommendation.col,
+                                            tr("下一张 · %1").arg(capturePoseDisplayName(capturePoseFromIndex(m_captureRecommendation.tiltIndex))));
+            } else {
+                view->setGridRecommendation(-1, -1, QString());
+            }
         } else {
             view->setGridHighlight(-1, -1);
+            view->setGridRecommendation(-1, -1, QString());
             view->setGridOverlayEnabled(false);
         }
     }
@@ -2898,6 +2955,10 @@ void MainWindow::setupActions()
     m_actionRun = new QAction(QIcon(":/icons/play.svg"), tr("Run calibration"), this);
     connect(m_actionRun, &QAction::triggered, this, &MainWindow::runCalibration);
 
+    m_actionTuneDetection = new QAction(QIcon(":/icons/evaluate.svg"), tr("Tune detection"), this);
+    m_actionTuneDetection->setToolTip(tr("Search detector parameters on a sample of the images and save them as the project's detection profile."));
+    connect(m_actionTuneDetection, &QAction::triggered, this, &MainWindow::tuneDetection);
+
     m_actionExport = new QAction(QIcon(":/icons/export.svg"), tr("Export JSON"), this);
     connect(m_actionExport, &QAction::triggered, this, &MainWindow::exportJson);
     m_actionExport->setEnabled(false);
@@ -2920,6 +2981,7 @@ void MainWindow::setupActions()
         m_toolBar->addAction(m_actionImportImages);
         m_toolbarPrimarySeparator = m_toolBar->addSeparator();
         m_toolBar->addAction(m_actionRun);
+        m_toolBar->addAction(m_actionTuneDetection);
         m_toolBar->addAction(m_actionExport);
         m_toolBar->addAction(m_actionShowParameters);
         m_toolBar->addAction(m_actionEvaluate);
@@ -4242,20 +4304,12 @@ void MainWindow::refreshModeUi()
 
 void MainWindow::syncInputWatcher()
 {
-    if (!m_inputWatcher) {
+    if (!m_inputIndex) {
         return;
     }
 
-    const QStringList watchedDirs = m_inputWatcher->directories();
-    if (!watchedDirs.isEmpty()) {
-        m_inputWatcher->removePaths(watchedDirs);
-    }
-    const QStringList watchedFiles = m_inputWatcher->files();
-    if (!watchedFiles.isEmpty()) {
-        m_inputWatcher->removePaths(watchedFiles);
-    }
-
     if (m_inputDir.isEmpty()) {
+        m_inputIndex->setDirectory(QString());
         return;
     }
 
@@ -4269,14 +4323,12 @@ void MainWindow::syncInputWatcher()
         return;
     }
 
-    if (m_inputWatcher->addPaths({absolute}).isEmpty() && m_logView) {
-        m_logView->append(tr("Unable to watch input directory: %1").arg(QDir::toNativeSeparators(absolute)));
-    }
+    m_inputIndex->setDirectory(absolute);
 }
 
-void MainWindow::handleInputDirectoryChanged(const QString &path)
+void MainWindow::handleInputDirectoryChanged(int count)
 {
-    Q_UNUSED(path);
+    Q_UNUSED(count);
 
     const int previous = m_lastInputImageCount;
     updateInputSummary();
@@ -4306,8 +4358,6 @@ void MainWindow::handleInputDirectoryChanged(const QString &path)
             m_logView->append(fragments.join(QLatin1Char(' ')));
         }
     }
-
-    syncInputWatcher();
 }
 
 void MainWindow::updateLaserStageUi()
@@ -4791,11 +4841,13 @@ void MainWindow::persistCalibrationSnapshot(const CalibrationOutput &output) con
     out << output.message;
     writeMat(out, output.cameraMatrix);
     writeMat(out, output.distCoeffs);
+    writeMat(out, output.intrinsicsStdDev);
     out << qint32(output.imageSize.width) << qint32(output.imageSize.height);
     writeCalibrationMetrics(out, output.metrics);
     writeDetectionList(out, output.allDetections);
     writeDetectionList(out, output.keptDetections);
     writeDetectionList(out, output.removedDetections);
+    writeDetectionList(out, output.validationDetections);
     writeHeatmapMeta(out, output.heatmaps);
     out << m_outputDir;
 
@@ -4826,7 +4878,7 @@ bool MainWindow::loadCalibrationSnapshot(const QString &filePath, CalibrationOut
     quint32 magic = 0;
     quint16 version = 0;
     in >> magic >> version;
-    if (magic != kSnapshotMagic || version != kSnapshotVersion) {
+    if (magic != kSnapshotMagic || version < 1 || version > kSnapshotVersion) {
         return false;
     }
 
@@ -4837,14 +4889,20 @@ bool MainWindow::loadCalibrationSnapshot(const QString &filePath, CalibrationOut
     output->message = message;
     output->cameraMatrix = readMat(in);
     output->distCoeffs = readMat(in);
+    if (version >= 2) {
+        output->intrinsicsStdDev = readMat(in);
+    }
     qint32 width = 0;
     qint32 height = 0;
     in >> width >> height;
     output->imageSize = cv::Size(width, height);
     output->metrics = readCalibrationMetrics(in);
-    output->allDetections = readDetectionList(in);
-    output->keptDetections = readDetectionList(in);
-    output->removedDetections = readDetectionList(in);
+    output->allDetections = readDetectionList(in, version);
+    output->keptDetections = readDetectionList(in, version);
+    output->removedDetections = readDetectionList(in, version);
+    if (version >= 3) {
+        output->validationDetections = readDetectionList(in, version);
+    }
     output->heatmaps = readHeatmapMeta(in);
     QString storedOutputDir;
     in >> storedOutputDir;
@@ -4869,6 +4927,7 @@ void MainWindow::restoreCalibrationSnapshot()
     }
 
     m_lastOutput = snapshot;
+    m_captureGuidanceStale = true;
     materializeDebugArtifacts(m_lastOutput);
     m_lastOutputFromSnapshot = true;
 
@@ -4881,7 +4940,6 @@ void MainWindow::restoreCalibrationSnapshot()
     }
 
     regenerateHeatmaps(m_lastOutput);
-    reloadHeatmapsFromDisk(m_outputDir, &m_lastOutput.heatmaps);
 
     updateSummaryPanel(m_lastOutput);
     populateDetectionTree(m_lastOutput);
@@ -5681,15 +5739,20 @@ int MainWindow::countImageFiles(const QString &directory) const
     if (directory.isEmpty()) {
         return 0;
     }
-    QDir dir(directory);
-    if (!dir.exists()) {
-        return 0;
+    if (m_inputIndex && m_inputIndex->covers(directory)) {
+        return m_inputIndex->count();
     }
-    const QStringList filters = {
-        QStringLiteral("*.png"), QStringLiteral("*.jpg"), QStringLiteral("*.jpeg"),
-        QStringLiteral("*.bmp"), QStringLiteral("*.tif"), QStringLiteral("*.tiff")
-    };
-    return dir.entryList(filters, QDir::Files | QDir::Readable).size();
+    // Directories other than the indexed input (stage archives, the live cache
+    // before it becomes the input) are counted with a one-off scan.
+    int count = 0;
+    QDirIterator it(directory, QDir::Files | QDir::Readable);
+    while (it.hasNext()) {
+        it.next();
+        if (ImageLoader::isSupportedImage(it.fileName().toStdString())) {
+            ++count;
+        }
+    }
+    return count;
 }
 
 bool MainWindow::hasInputImages() const
@@ -5739,6 +5802,12 @@ void MainWindow::updateRunAvailability()
     const bool imagesReady = hasInputImages();
     const bool enable = !m_running && imagesReady;
     m_actionRun->setEnabled(enable);
+    if (m_actionTuneDetection) {
+        // While tuning runs the action stops it.
+        const bool tuning = static_cast<bool>(m_detectionTuningControl);
+        m_actionTuneDetection->setEnabled(enable || tuning);
+        m_actionTuneDetection->setText(tuning ? tr("Stop tuning") : tr("Tune detection"));
+    }
 
     QString tooltip;
     if (m_running) {
@@ -5922,6 +5991,9 @@ void MainWindow::handleCameraSnapshotCaptured(const QString &filePath)
     if (m_logView) {
         m_logView->append(tr("Captured snapshot saved to %1").arg(displayPath));
     }
+    if (m_inputIndex) {
+        m_inputIndex->noteFileAdded(finalPath);
+    }
 
     if (recordedCalibrationShot) {
         updateInputSummary();
@@ -6050,30 +6122,26 @@ void MainWindow::runCalibration()
     }
 #else
     if (m_session && m_session->metadata().dataSource == ProjectSession::DataSource::ConnectedCamera) {
-        QDir inputDir(m_inputDir);
-        const QStringList capturedImages = inputDir.entryList({QStringLiteral("*.png"), QStringLiteral("*.jpg"), QStringLiteral("*.jpeg"), QStringLiteral("*.bmp"), QStringLiteral("*.tif"), QStringLiteral("*.tiff")},
-                                                              QDir::Files);
-        if (capturedImages.isEmpty()) {
+        const int capturedImages = countImageFiles(m_inputDir);
+        if (capturedImages == 0) {
             QMessageBox::information(this,
                                      tr("Live capture"),
                                      tr("Capture at least one frame before running calibration."));
             return;
         }
         if (m_logView) {
-            m_logView->append(tr("Running calibration with %1 live-captured frame(s).").arg(capturedImages.size()));
+            m_logView->append(tr("Running calibration with %1 live-captured frame(s).").arg(capturedImages));
         }
     }
 #endif
 
-    CalibrationEngine::Settings settings;
-    settings.boardSpec.smallDiameterMm = 5.0;
-    settings.boardSpec.centerSpacingMm = 25.0;
-    // board layout (7x6 with centre gap) follows the Python reference implementation
+    const CalibrationEngine::Settings settings = calibrationSettings();
 
     resetUi();
 
     refreshState(true);
     m_progressBar->setValue(0);
+    m_progressBar->resetFormat();
     m_logView->append(QStringLiteral("[%1] Starting calibration ...")
                            .arg(QDateTime::currentDateTime().toString("hh:mm:ss")));
 
@@ -6083,7 +6151,109 @@ void MainWindow::runCalibration()
         m_outputPathEdit->setText(QDir::toNativeSeparators(resolvedOutput));
     }
 
-    m_engine->run(m_inputDir, settings, resolvedOutput);
+    // Hand the engine the indexed list so it does not rescan the directory.
+    const QStringList indexedImages = (m_inputIndex && m_inputIndex->covers(m_inputDir))
+                                          ? m_inputIndex->files()
+                                          : QStringList();
+    m_engine->run(m_inputDir, settings, resolvedOutput, indexedImages);
+    m_progressTimer->start();
+}
+
+CalibrationEngine::Settings MainWindow::calibrationSettings() const
+{
+    CalibrationEngine::Settings settings;
+    settings.boardSpec.smallDiameterMm = 5.0;
+    settings.boardSpec.centerSpacingMm = 25.0;
+    // The project file may name another print of the board; 7x6 otherwise.
+    if (m_session && !m_session->metadata().boardLayout.isEmpty()) {
+        const QString key = m_session->metadata().boardLayout.trimmed().toLower();
+        if (!boardLayoutFromKey(key.toStdString(), settings.boardSpec.layout)) {
+            Logger::warning(tr("Unknown board layout '%1' in project; using %2.")
+                                .arg(key, QString::fromLatin1(boardLayoutKey(settings.boardSpec.layout))));
+        }
+    }
+    settings.detectionProfilePath = detectionProfilePath();
+    return settings;
+}
+
+QString MainWindow::detectionProfilePath() const
+{
+    if (!m_session) {
+        return QString();
+    }
+    return m_session->configDir().absoluteFilePath(QStringLiteral("detection_profile.json"));
+}
+
+void MainWindow::tuneDetection()
+{
+    if (m_detectionTuningControl) {
+        if (!m_detectionTuningControl->cancelRequested()) {
+            m_detectionTuningControl->requestCancel();
+            m_logView->append(tr("[%1] Stopping detection tuning after the current round ...")
+                                  .arg(QDateTime::currentDateTime().toString("hh:mm:ss")));
+        }
+        return;
+    }
+    if (m_running) {
+        return;
+    }
+    if (m_inputDir.isEmpty() || !QDir(m_inputDir).exists()) {
+        QMessageBox::warning(this, tr("Missing input"), tr("Please import or capture images first."));
+        return;
+    }
+    const QString profilePath = detectionProfilePath();
+    if (profilePath.isEmpty()) {
+        return;
+    }
+
+    std::vector<std::string> paths;
+    if (m_inputIndex && m_inputIndex->covers(m_inputDir)) {
+        for (const QString &file : m_inputIndex->files()) {
+            paths.push_back(file.toStdString());
+        }
+    } else {
+        paths = ImageLoader().gatherImageFiles(m_inputDir.toStdString());
+    }
+
+    const CalibrationEngine::Settings settings = calibrationSettings();
+    const DetectionConfig baseline = CalibrationEngine::resolveDetectionConfig(settings);
+    const DetectionTuningOptions options;
+    const int sampleSize = std::min(static_cast<int>(paths.size()), options.sampleSize);
+    auto control = std::make_shared<RunControl>();
+    m_detectionTuningControl = control;
+    refreshState(true);
+    m_logView->append(tr("[%1] Tuning detection on a sample of %2 of %3 image(s) ...")
+                          .arg(QDateTime::currentDateTime().toString("hh:mm:ss"))
+                          .arg(sampleSize)
+                          .arg(static_cast<int>(paths.size())));
+
+    auto *watcher = new QFutureWatcher<DetectionTuningResult>(this);
+    m_detectionTuningWatcher = watcher;
+    connect(watcher, &QFutureWatcher<DetectionTuningResult>::finished, this, [this, watcher, control, profilePath]() {
+        const DetectionTuningResult result = watcher->result();
+        watcher->deleteLater();
+        m_detectionTuningControl.reset();
+        refreshState(false);
+        if (control->cancelRequested()) {
+            m_logView->append(tr("Detection tuning stopped; the detection profile is unchanged."));
+            return;
+        }
+        if (!result.success) {
+            m_logView->append(tr("Detection tuning failed: %1").arg(result.message));
+            return;
+        }
+        QString error;
+        if (!saveDetectionProfile(profilePath, result.config, &error)) {
+            m_logView->append(tr("Detection tuning failed: %1").arg(error));
+            return;
+        }
+        m_logView->append(tr("Detection tuning: %1. Profile saved to %2")
+                              .arg(result.message, QDir::toNativeSeparators(profilePath)));
+    });
+    const BoardSpec spec = settings.boardSpec;
+    watcher->setFuture(QtConcurrent::run([spec, baseline, options, paths, control]() {
+        return DetectionTuner(spec, baseline, options).tune(paths, [control]() { return control->cancelRequested(); });
+    }));
 }
 
 void MainWindow::resetUi()
@@ -6133,6 +6303,7 @@ void MainWindow::resetUi()
     if (m_distortionMap) {
         m_distortionMap->clear();
     }
+    m_shownHeatmapRenders.clear();
     if (m_poseView) {
         m_poseView->deleteLater();
         m_poseView = nullptr;
@@ -6145,6 +6316,7 @@ void MainWindow::resetUi()
         m_stageNavigator->setCurrentItem(m_stageOverviewItem);
     }
     m_lastOutput = CalibrationOutput{};
+    m_captureGuidanceStale = true;
     if (m_actionShowParameters) {
         m_actionShowParameters->setEnabled(false);
     }
@@ -6201,9 +6373,7 @@ void MainWindow::showEvaluationDialog()
         return;
     }
 
-    BoardSpec spec;
-    spec.smallDiameterMm = 5.0;
-    spec.centerSpacingMm = 25.0;
+    const BoardSpec spec = calibrationSettings().boardSpec;
 
     if (m_evaluationDialog) {
         m_evaluationDialog->close();
@@ -6293,13 +6463,49 @@ void MainWindow::showAuthorInfo()
     dialog.exec();
 }
 
-void MainWindow::handleProgress(int processed, int total)
+void MainWindow::pollProgress()
 {
-    if (total <= 0) {
+    const RunControl::Snapshot snap = m_engine->control().snapshot();
+    if (snap.total <= 0) {
         return;
     }
-    const int value = static_cast<int>(static_cast<double>(processed) / total * 100.0);
+    const int value = static_cast<int>(static_cast<double>(snap.processed) / snap.total * 100.0);
     m_progressBar->setValue(value);
+
+    QString format = tr("%1/%2").arg(snap.processed).arg(snap.total);
+    if (snap.failed > 0) {
+        format += tr(" · %1 failed").arg(snap.failed);
+    }
+    if (snap.stage == RunControl::Stage::Detecting) {
+        const auto busy = std::find_if(snap.workers.begin(), snap.workers.end(), [](RunControl::WorkerStage stage) {
+            return stage != RunControl::WorkerStage::Idle;
+        });
+        if (busy != snap.workers.end()) {
+            switch (*busy) {
+            case RunControl::WorkerStage::Decoding:
+                format += tr(" · decoding");
+                break;
+            case RunControl::WorkerStage::LocatingBoard:
+                format += tr(" · locating board");
+                break;
+            case RunControl::WorkerStage::Rectifying:
+                format += tr(" · rectifying");
+                break;
+            case RunControl::WorkerStage::FindingCircles:
+                format += tr(" · finding circles");
+                break;
+            case RunControl::WorkerStage::Numbering:
+                format += tr(" · numbering");
+                break;
+            case RunControl::WorkerStage::Refining:
+                format += tr(" · refining centres");
+                break;
+            case RunControl::WorkerStage::Idle:
+                break;
+            }
+        }
+    }
+    m_progressBar->setFormat(format);
 }
 
 void MainWindow::handleStatus(const QString &message)
@@ -6309,8 +6515,11 @@ void MainWindow::handleStatus(const QString &message)
 
 void MainWindow::handleFinished(const CalibrationOutput &output)
 {
+    m_progressTimer->stop();
+    pollProgress();
     m_running = false;
     m_lastOutput = output;
+    m_captureGuidanceStale = true;
     materializeDebugArtifacts(m_lastOutput);
     if (m_evaluationDialog) {
         m_evaluationDialog->close();
@@ -6370,9 +6579,12 @@ void MainWindow::handleFinished(const CalibrationOutput &output)
 
 void MainWindow::handleFailed(const QString &reason, const CalibrationOutput &details)
 {
+    m_progressTimer->stop();
+    pollProgress();
     m_running = false;
     refreshState(false);
     m_lastOutput = details;
+    m_captureGuidanceStale = true;
 
     QString trimmedReason = reason.trimmed();
     if (trimmedReason.isEmpty()) {
@@ -6857,6 +7069,7 @@ void MainWindow::recomputeCellQuality()
         }
     }
 
+    QVector<ProjectSession::CaptureShot> pendingShots;
     for (const auto &ref : shotRefs) {
         if (ref.derived || ref.matched || !ref.shot) {
             continue;
@@ -6866,6 +7079,7 @@ void MainWindow::recomputeCellQuality()
         auto &cell = m_cellQuality[row][col];
         ++cell.pending;
         cell.pendingSamples.append(sampleDisplayNameFromShot(*ref.shot, m_session));
+        pendingShots.append(*ref.shot);
     }
 
     bool anySamples = false;
@@ -6896,9 +7110,92 @@ void MainWindow::recomputeCellQuality()
         }
     }
 
+    syncCaptureGuidance(pendingShots);
     updateCaptureSelectionSummary();
 }
 
+void MainWindow::syncCaptureGuidance(const QVector<ProjectSession::CaptureShot> &pendingShots)
+{
+    // Calibrated views contribute their solved poses; shots that have not been
+    // through a run yet contribute the nominal view of their cell and pose. The
+    // information matrix is only rebuilt when the calibration, the image size or
+    // the pending set (other than by new shots) changes; new shots are added
+    // incrementally.
+    cv::Size imageSize = m_lastOutput.imageSize;
+#if MYCALIB_HAVE_CONNECTED_CAMERA
+    if ((imageSize.width <= 0 || imageSize.height <= 0) && m_cameraWindow) {
+        const QSize frameSize = m_cameraWindow->lastFrameSize();
+        imageSize = cv::Size(frameSize.width(), frameSize.height());
+    }
+#endif
+    if (imageSize.width <= 0 || imageSize.height <= 0) {
+        imageSize = cv::Size(4000, 3000);
+    }
+
+    QSet<QUuid> pendingIds;
+    pendingIds.reserve(pendingShots.size());
+    for (const auto &shot : pendingShots) {
+        pendingIds.insert(shot.id);
+    }
+
+    const bool rebuild = m_captureGuidanceStale || !m_captureGuidance.isReady() ||
+                         imageSize != m_captureGuidanceImageSize ||
+                         !pendingIds.contains(m_captureGuidanceShots);
+    if (rebuild) {
+        const double pixelSigma = m_lastOutput.success && m_lastOutput.metrics.rms > 0.0 ? m_lastOutput.metrics.rms : 0.25;
+        m_captureGuidance.reset(calibrationSettings().boardSpec, imageSize,
+                                m_lastOutput.cameraMatrix, m_lastOutput.distCoeffs, pixelSigma);
+        for (const auto &det : m_lastOutput.keptDetections) {
+            m_captureGuidance.addObservedView(det);
+        }
+        m_captureGuidanceShots.clear();
+        m_captureGuidanceImageSize = imageSize;
+        m_captureGuidanceStale = false;
+    } else if (pendingIds.size() == m_captureGuidanceShots.size()) {
+        return;
+    }
+
+    for (const auto &shot : pendingShots) {
+        if (m_captureGuidanceShots.contains(shot.id)) {
+            continue;
+        }
+        m_captureGuidance.addNominalView(shot.gridRow, shot.gridCol, kCaptureGridRows, kCaptureGridCols,
+                                         kPoseDescriptors[capturePoseIndex(shot.pose)].tilt);
+        m_captureGuidanceShots.insert(shot.id);
+    }
+    updateCaptureRecommendation();
+}
+
+void MainWindow::updateCaptureRecommendation()
+{
+    m_captureRecommendation = m_captureGuidance.recommend(kCaptureGridRows, kCaptureGridCols, captureGuidanceTilts());
+    updateCapturePlanSummary();
+    updateCaptureOverlay();
+}
+
+void MainWindow::updateCapturePlanSummary()
+{
+    if (!m_capturePlanSummary) {
+        return;
+    }
+    const int total = captureTotalShots();
+    if (m_activeSource != ProjectSession::DataSource::ConnectedCamera) {
+        m_capturePlanSummary->setText(tr("基于检测结果的九宫格统计：%1 张样本" )
+                                          .arg(total));
+        return;
+    }
+    const int targetTotal = kCaptureGridRows * kCaptureGridCols * kCaptureTargetPerCell;
+    QString text = tr("阶段二进度：%1 / %2 张样本")
+                       .arg(total)
+                       .arg(targetTotal);
+    if (m_captureRecommendation.valid) {
+        text += tr(" · 建议下一张：%1 · %2")
+                    .arg(captureCellDisplayName(m_captureRecommendation.row, m_captureRecommendation.col),
+                         capturePoseDisplayName(capturePoseFromIndex(m_captureRecommendation.tiltIndex)));
+    }
+    m_capturePlanSummary->setText(text);
+}
+
 void MainWindow::showCaptureCellDetails(int row, int col)
 {
     if (row < 0 || row >= kCaptureGridRows || col < 0 || col >= kCaptureGridCols) {
@@ -6998,85 +7295,27 @@ void MainWindow::regenerateHeatmaps(CalibrationOutput &output)
     }
 
     HeatmapGenerator generator;
-    HeatmapBundle refreshed;
-    refreshed.boardCoverage = generator.buildBoardCoverage(sourceDetections,
-                                                          output.imageSize,
-                                                          &refreshed.boardCoverageMin,
-                                                          &refreshed.boardCoverageMax,
-                                                          &refreshed.boardCoverageScalar);
-    refreshed.pixelError = generator.buildPixelErrorHeatmap(sourceDetections,
-                                                           output.imageSize,
-                                                           &refreshed.pixelErrorMin,
-                                                           &refreshed.pixelErrorMax,
-                                                           &refreshed.pixelErrorScalar);
-    refreshed.boardError = generator.buildBoardErrorHeatmap(sourceDetections,
-                                                           output.imageSize,
-                                                           &refreshed.boardErrorMin,
-                                                           &refreshed.boardErrorMax,
-                                                           &refreshed.boardErrorScalar);
-    refreshed.residualScatter = generator.buildResidualScatter(sourceDetections,
-                                                               &refreshed.residualScatterMax);
-
-    if (!output.cameraMatrix.empty() && !output.distCoeffs.empty()) {
-        refreshed.distortionMap = generator.buildDistortionHeatmap(output.cameraMatrix,
-                                                                   output.distCoeffs,
-                                                                   output.imageSize,
-                                                                   &refreshed.distortionMin,
-                                                                   &refreshed.distortionMax,
-                                                                   &refreshed.distortionGrid,
-                                                                   &refreshed.distortionScalar,
-                                                                   &refreshed.distortionVectors);
-    }
-
-    output.heatmaps = std::move(refreshed);
-}
-
-bool MainWindow::reloadHeatmapsFromDisk(const QString &outputDir, HeatmapBundle *bundle) const
-{
-    if (!bundle) {
-        return false;
-    }
-    if (outputDir.isEmpty()) {
-        return false;
-    }
-
-    QDir dir(outputDir);
-    if (!dir.exists()) {
-        return false;
-    }
-
-    bool anyLoaded = false;
-    auto load = [&](const QString &fileName, cv::Mat *target) {
-        if (!target || !target->empty()) {
-            return false;
-        }
-        const QString path = dir.absoluteFilePath(fileName);
-        if (!QFileInfo::exists(path)) {
-            return false;
-        }
-        cv::Mat image = cv::imread(path.toStdString(), cv::IMREAD_UNCHANGED);
-        if (image.empty()) {
-            return false;
-        }
-        *target = image;
-        return true;
-    };
-
-    anyLoaded |= load(QStringLiteral("board_coverage_heatmap.png"), &bundle->boardCoverage);
-    anyLoaded |= load(QStringLiteral("reprojection_error_heatmap_pixels.png"), &bundle->pixelError);
-    anyLoaded |= load(QStringLiteral("reprojection_error_heatmap_board.png"), &bundle->boardError);
-    anyLoaded |= load(QStringLiteral("distortion_heatmap.png"), &bundle->distortionMap);
-
-    return anyLoaded;
+    output.heatmaps = generator.buildBundle(sourceDetections,
+                                            output.cameraMatrix,
+                                            output.distCoeffs,
+                                            output.imageSize);
 }
 
 void MainWindow::showHeatmaps(const CalibrationOutput &output)
 {
+    const HeatmapBundle &heatmaps = output.heatmaps;
+    const cv::Size previewSize = heatmapPreviewSize(heatmaps.imageSize);
+    // The previous renders stay referenced until the new ones are looked up, so an
+    // unchanged field comes straight from the bundle's render cache.
+    std::vector<std::shared_ptr<const cv::Mat>> shownRenders;
+
     if (m_heatmapBoard) {
-        if (!output.heatmaps.boardCoverage.empty()) {
-            m_heatmapBoard->setHeatmap(cvMatToQImage(output.heatmaps.boardCoverage),
-                                       output.heatmaps.boardCoverageMin,
-                                       output.heatmaps.boardCoverageMax,
+        const auto rendered = heatmaps.render(HeatmapField::BoardCoverage, previewSize);
+        shownRenders.push_back(rendered);
+        if (rendered && !rendered->empty()) {
+            m_heatmapBoard->setHeatmap(cvMatToQImage(*rendered),
+                                       heatmaps.boardCoverageMin,
+                                       heatmaps.boardCoverageMax,
                                        tr("Coverage ratio"));
         } else {
             m_heatmapBoard->clear();
@@ -7084,10 +7323,12 @@ void MainWindow::showHeatmaps(const CalibrationOutput &output)
     }
 
     if (m_heatmapPixel) {
-        if (!output.heatmaps.pixelError.empty()) {
-            m_heatmapPixel->setHeatmap(cvMatToQImage(output.heatmaps.pixelError),
-                                       output.heatmaps.pixelErrorMin,
-                                       output.heatmaps.pixelErrorMax,
+        const auto rendered = heatmaps.render(HeatmapField::PixelError, previewSize);
+        shownRenders.push_back(rendered);
+        if (rendered && !rendered->empty()) {
+            m_heatmapPixel->setHeatmap(cvMatToQImage(*rendered),
+                                       heatmaps.pixelErrorMin,
+                                       heatmaps.pixelErrorMax,
                                        tr("Reprojection error"));
         } else {
             m_heatmapPixel->clear();
@@ -7095,14 +7336,19 @@ void MainWindow::showHeatmaps(const CalibrationOutput &output)
     }
 
     if (m_distortionMap) {
-        if (!output.heatmaps.distortionMap.empty()) {
-            m_distortionMap->setHeatmap(cvMatToQImage(output.heatmaps.distortionMap),
-                                        output.heatmaps.distortionMin,
-                                        output.heatmaps.distortionMax,
+        const auto rendered = heatmaps.render(HeatmapField::Distortion, previewSize);
+        shownRenders.push_back(rendered);
+        if (rendered && !rendered->empty()) {
+            m_distortionMap->setHeatmap(cvMatToQImage(*rendered),
+                                        heatmaps.distortionMin,
+                                        heatmaps.distortionMax,
                                         tr("Δ distortion"));
+            // Grid lines are in sensor pixels; map them onto the preview raster.
+            const double scaleX = static_cast<double>(previewSize.width) / std::max(1, heatmaps.imageSize.width);
+            const double scaleY = static_cast<double>(previewSize.height) / std::max(1, heatmaps.imageSize.height);
             QVector<QPolygonF> warpedLines;
-            warpedLines.reserve(static_cast<int>(output.heatmaps.distortionGrid.size()));
-            for (const auto &line : output.heatmaps.distortionGrid) {
+            warpedLines.reserve(static_cast<int>(heatmaps.distortionGrid.size()));
+            for (const auto &line : heatmaps.distortionGrid) {
                 if (line.size() < 2) {
                     continue;
                 }
@@ -7112,7 +7358,7 @@ void MainWindow::showHeatmaps(const CalibrationOutput &output)
                     if (!std::isfinite(pt.x) || !std::isfinite(pt.y)) {
                         continue;
                     }
-                    poly.append(QPointF(pt.x, pt.y));
+                    poly.append(QPointF(pt.x * scaleX, pt.y * scaleY));
                 }
                 if (poly.size() >= 2) {
                     warpedLines.append(poly);
@@ -7123,6 +7369,7 @@ void MainWindow::showHeatmaps(const CalibrationOutput &output)
             m_distortionMap->clear();
         }
     }
+    m_shownHeatmapRenders = std::move(shownRenders);
 
     if (m_scatterView) {
         std::vector<ResidualScatterView::Sample> samples;
@@ -7188,6 +7435,21 @@ void MainWindow::handleDetectionSelectionChanged()
     }
 }
 
+QString MainWindow::sourceImagePath(const QString &name) const
+{
+    // Detections carry only the file stem; the indexed input folder resolves it.
+    if (name.isEmpty() || !m_inputIndex || !m_inputIndex->covers(m_inputDir)) {
+        return {};
+    }
+    const QStringList files = m_inputIndex->files();
+    for (const QString &file : files) {
+        if (QFileInfo(file).completeBaseName() == name) {
+            return file;
+        }
+    }
+    return {};
+}
+
 void MainWindow::showDetectionPreview(const QString &name)
 {
     if (!m_detectionPreview) {
@@ -7198,7 +7460,7 @@ void MainWindow::showDetectionPreview(const QString &name)
         return;
     }
     if (const auto *result = findDetection(name)) {
-        m_detectionPreview->setDetection(*result);
+        m_detectionPreview->setDetection(*result, sourceImagePath(name));
     } else {
         m_detectionPreview->clear();
     }
@@ -14,6 +14,7 @@
 #include <numbers>
 #include <vector>
 
+#include <opencv2/core/utility.hpp>
 #include <opencv2/imgproc.hpp>
 
 namespace mycalib {
@@ -27,6 +28,11 @@ constexpr int kBleedPx      = 12;
 // Adaptive scalar field render cap
 constexpr int kRenderMin = 512;
 constexpr int kRenderMax = 2048;
+// Fields larger than this multiple of the render size are area-averaged down to
+// it first; Lanczos then only has to bridge the last factor.
+constexpr int kPreReduceFactor = 2;
+// Tint of the heat map towards white, baked into the scalar LUTs.
+constexpr double kHeatWhiteBlend = 0.10;
 
 // base grid alpha / line widths
 constexpr double kFrameLineW = 1.2;
@@ -118,6 +124,8 @@ void PaperFigureExporter::exportAll(const CalibrationOutput &output, const QStri
     QDir paperDir(paperDirPath);
     if (!paperDir.exists() && !paperDir.mkpath(QStringLiteral("."))) return;
 
+    // Scalar fields are stored at grid resolution; axes and overlays use the sensor size.
+    const cv::Size imageSize = output.heatmaps.imageSize;
     const auto exportScalar = [&](const cv::Mat &field,
                                   double minValue, double maxValue,
                                   const QString &fileStem,
@@ -129,7 +137,7 @@ void PaperFigureExporter::exportAll(const CalibrationOutput &output, const QStri
                                   ScalarColormap map = ScalarColormap::Viridis,
                                   const QString &xLabel = QStringLiteral("Image X (px)"),
                                   const QString &yLabel = QStringLiteral("Image Y (px)")) {
-        exportScalarFieldFigure(field, minValue, maxValue,
+        exportScalarFieldFigure(field, imageSize.area() > 0 ? imageSize : field.size(), minValue, maxValue,
                                 QString(), xLabel, yLabel, colorbarLabel,
                                 paperDir.filePath(fileStem),
                                 vectorField, gridLines, drawVector, drawGrid, map);
@@ -193,6 +201,7 @@ void PaperFigureExporter::exportAll(const CalibrationOutput &output, const QStri
 
 // ===================== Scalar Field Figure =====================
 void PaperFigureExporter::exportScalarFieldFigure(const cv::Mat &field,
+                                                  const cv::Size &imageSize,
                                                   double minValue,
                                                   double maxValue,
                                                   const QString &title,
@@ -212,7 +221,7 @@ void PaperFigureExporter::exportScalarFieldFigure(const cv::Mat &field,
         cv::Mat tmp; field.convertTo(tmp, CV_64F); return tmp; }();
 
     const auto draw = [&](QPainter &painter) {
-        drawScalarField(painter, fieldDouble, minValue, maxValue,
+        drawScalarField(painter, fieldDouble, imageSize, minValue, maxValue,
                         title, xLabel, yLabel, colorbarLabel,
                         vectorField, gridLines, drawVectorField, drawGrid, colormap);
     };
@@ -230,6 +239,7 @@ void PaperFigureExporter::exportResidualScatterFigure(const CalibrationOutput &o
 // ===================== Draw Scalar Field =====================
 void PaperFigureExporter::drawScalarField(QPainter &painter,
                                           const cv::Mat &field,
+                                          const cv::Size &imageSize,
                                           double minValue,
                                           double maxValue,
                                           const QString &title,
@@ -256,8 +266,8 @@ void PaperFigureExporter::drawScalarField(QPainter &painter,
     const int tickCount = 6;
     QStringList xTicks, yTicks, cbarTicks;
     for (int i = 0; i < tickCount; ++i) {
-        xTicks << QString::number(double(i) * double(field.cols) / double(tickCount-1), 'f', 0);
-        yTicks << QString::number(double(i) * double(field.rows) / double(tickCount-1), 'f', 0);
+        xTicks << QString::number(double(i) * double(imageSize.width) / double(tickCount-1), 'f', 0);
+        yTicks << QString::number(double(i) * double(imageSize.height) / double(tickCount-1), 'f', 0);
         const double v = minValue + (maxValue - minValue) * (double(i)/(tickCount-1));
         cbarTicks << QString::number(v, 'f', (maxValue - minValue > 1.0) ? 2 : 3);
     }
@@ -269,7 +279,7 @@ void PaperFigureExporter::drawScalarField(QPainter &painter,
     const double rightPad  = cbarGap + cbarCoreW + 18.0;
 
     // Aspect
-    const double aspect = (field.cols>0 && field.rows>0) ? double(field.cols)/double(field.rows) : 1.0;
+    const double aspect = (imageSize.width>0 && imageSize.height>0) ? double(imageSize.width)/double(imageSize.height) : 1.0;
 
     // Layout
     CanvasLayout L = computeLayout(QSize(kCanvasWidth, kCanvasHeight),
@@ -282,26 +292,41 @@ void PaperFigureExporter::drawScalarField(QPainter &painter,
     // ===== Render scalar field =====
     const int renderW = std::clamp(int(std::round(L.plot.width())),  kRenderMin, kRenderMax);
     const int renderH = std::clamp(int(std::round(L.plot.height())), kRenderMin, kRenderMax);
+    cv::Mat source = field;
+    if (field.cols > kPreReduceFactor * renderW && field.rows > kPreReduceFactor * renderH) {
+        cv::resize(field, source, cv::Size(kPreReduceFactor * renderW, kPreReduceFactor * renderH), 0, 0, cv::INTER_AREA);
+    }
     cv::Mat resized;
-    cv::resize(field, resized, cv::Size(renderW, renderH), 0, 0, cv::INTER_LANCZOS4);
+    cv::resize(source, resized, cv::Size(renderW, renderH), 0, 0, cv::INTER_LANCZOS4);
     if (renderW >= 1024 && renderH >= 1024) {
         cv::GaussianBlur(resized, resized, cv::Size(3,3), 0.4);
     }
 
+    // Colourize through the map's LUT straight into the scanlines, rows in parallel.
     QImage heat(resized.cols, resized.rows, QImage::Format_RGB32);
+    const auto &lut = scalarLut(colormap);
     const double range = std::max(maxValue - minValue, 1e-12);
-    for (int y = 0; y < resized.rows; ++y) {
-        const double *rowPtr = resized.ptr<double>(y);
-        for (int x = 0; x < resized.cols; ++x) {
-            const double t = std::clamp((rowPtr[x] - minValue) / range, 0.0, 1.0);
-            const QColor base = colorForMap(colormap, t);
-            heat.setPixelColor(x, y, blendTowardsWhite(base, 0.10));
+    const double lutScale = double(kScalarLutSize - 1) / range;
+    uchar *const heatBits = heat.bits();
+    const qsizetype heatStride = heat.bytesPerLine();
+    cv::parallel_for_(cv::Range(0, resized.rows), [&](const cv::Range &rows) {
+        for (int y = rows.start; y < rows.end; ++y) {
+            const double *rowPtr = resized.ptr<double>(y);
+            auto *out = reinterpret_cast<QRgb *>(heatBits + y * heatStride);
+            for (int x = 0; x < resized.cols; ++x) {
+                const double index = (rowPtr[x] - minValue) * lutScale + 0.5;
+                // Clamp before converting; the negated test also sends NaN to the low end.
+                const int i = !(index > 0.0) ? 0
+                            : index >= double(kScalarLutSize - 1) ? kScalarLutSize - 1
+                                                                  : int(index);
+                out[x] = lut[size_t(i)];
+            }
         }
-    }
+    });
     painter.drawImage(L.plot, heat);
 
     // Mapping function
-    const double imgW = std::max(1, field.cols-1), imgH = std::max(1, field.rows-1);
+    const double imgW = std::max(1, imageSize.width-1), imgH = std::max(1, imageSize.height-1);
     auto toPlot = [&](const cv::Point2f &pt){
         const double nx = pt.x / imgW;
         const double ny = pt.y / imgH;
@@ -357,8 +382,9 @@ void PaperFigureExporter::drawScalarField(QPainter &painter,
                 const double m = std::hypot(v[0], v[1]);
                 if (m <= maxMag*0.01) continue;
 
-                const QPointF start(L.plot.left() + (double(vx)/std::max(1,vecF.cols-1))*L.plot.width(),
-                                    L.plot.top()  + (double(vy)/std::max(1,vecF.rows-1))*L.plot.height());
+                // Vector samples sit at field-cell centres
+                const QPointF start(L.plot.left() + ((vx + 0.5)/vecF.cols)*L.plot.width(),
+                                    L.plot.top()  + ((vy + 0.5)/vecF.rows)*L.plot.height());
                 const double len = arrowMax * std::clamp(m/maxMag, 0.0, 1.0);
                 const double inv = (m>1e-6) ? 1.0/m : 0.0;
                 const QPointF delta(v[0]*inv*len, v[1]*inv*len);
@@ -731,6 +757,26 @@ QColor PaperFigureExporter::blendTowardsWhite(const QColor &color, double weight
     return interpolate(color, QColor(255,255,255), std::clamp(weight, 0.0, 1.0));
 }
 
+const std::array<QRgb, PaperFigureExporter::kScalarLutSize> &PaperFigureExporter::scalarLut(ScalarColormap map)
+{
+    using Lut = std::array<QRgb, kScalarLutSize>;
+    auto build = [](ScalarColormap m) {
+        Lut lut {};
+        for (int i = 0; i < kScalarLutSize; ++i) {
+            const double t = double(i) / double(kScalarLutSize - 1);
+            lut[size_t(i)] = blendTowardsWhite(colorForMap(m, t), kHeatWhiteBlend).rgb();
+        }
+        return lut;
+    };
+    static const std::array<Lut, 4> luts {
+        build(ScalarColormap::Viridis),
+        build(ScalarColormap::Turbo),
+        build(ScalarColormap::Cividis),
+        build(ScalarColormap::Plasma)
+    };
+    return luts[size_t(map)];
+}
+
 // ===================== Write SVG & PNG (with bleed) =====================
 void PaperFigureExporter::writeSvgAndPng(const QString &fileBasePath,
                                          const std::function<void(QPainter &)> &drawFunction)
@@ -59,6 +59,7 @@ ParameterDialog::ParameterDialog(const CalibrationOutput &output, QWidget *paren
     m_styleCombo = new QComboBox(this);
     m_styleCombo->addItem(tr("Python (NumPy style)"), static_cast<int>(SnippetStyle::Python));
     m_styleCombo->addItem(tr("C++ (OpenCV style)"), static_cast<int>(SnippetStyle::Cpp));
+    m_styleCombo->addItem(tr("C++ (undistort runtime)"), static_cast<int>(SnippetStyle::Runtime));
     m_styleCombo->addItem(tr("Plain text summary"), static_cast<int>(SnippetStyle::PlainText));
     header->addWidget(m_styleCombo, 1);
 
@@ -117,6 +118,9 @@ void ParameterDialog::refreshPreview()
     case SnippetStyle::Cpp:
         text = buildCppSnippet();
         break;
+    case SnippetStyle::Runtime:
+        text = buildRuntimeSnippet();
+        break;
     case SnippetStyle::PlainText:
         text = buildPlainSnippet();
         break;
@@ -229,6 +233,32 @@ QString ParameterDialog::buildCppSnippet() const
     return result;
 }
 
+QString ParameterDialog::buildRuntimeSnippet() const
+{
+    QString result;
+    result += QStringLiteral("// Link mycalib_undistort; the run's output directory holds both files.\n");
+    result += QStringLiteral("#include \"runtime/UndistortRuntime.h\"\n\n");
+    result += QStringLiteral("// Station startup: map the precomputed table (no recomputation).\n");
+    result += QStringLiteral("std::string error;\n");
+    result += QStringLiteral("auto map = mycalib::UndistortMap::open(\"undistort_map.bin\", &error);\n");
+    result += QStringLiteral("if (!map) {\n");
+    result += QStringLiteral("    // Fall back to building it from the calibration file.\n");
+    result += QStringLiteral("    if (auto calibration = mycalib::loadCalibration(mycalib::kCalibrationFileName, &error)) {\n");
+    result += QStringLiteral("        map = mycalib::UndistortMap::build(*calibration);\n");
+    result += QStringLiteral("    }\n");
+    result += QStringLiteral("}\n\n");
+    result += QStringLiteral("// Per frame (%1 x %2): whole image, or only an inspection ROI.\n")
+                  .arg(m_output.imageSize.width)
+                  .arg(m_output.imageSize.height);
+    result += QStringLiteral("cv::Mat undistorted;\n");
+    result += QStringLiteral("map->remap(frame, undistorted);\n");
+    result += QStringLiteral("map->remap(frame, undistorted, cv::Rect(x, y, w, h));\n\n");
+    result += QStringLiteral("// Measured points (distorted pixels) to undistorted pixels.\n");
+    result += QStringLiteral("std::vector<cv::Point2f> corrected;\n");
+    result += QStringLiteral("map->undistortPoints(points, corrected);\n");
+    return result;
+}
+
 QString ParameterDialog::buildPlainSnippet() const
 {
     QString result;
@@ -262,6 +292,18 @@ QString ParameterDialog::buildPlainSnippet() const
         result += QStringLiteral("  (none)\n\n");
     }
 
+    const cv::Mat sigma = toDoubleMat(m_output.intrinsicsStdDev);
+    if (sigma.total() >= 4) {
+        static const char *kNames[] = {"fx", "fy", "cx", "cy"};
+        result += QStringLiteral("95% confidence (±1.96σ):\n");
+        for (int i = 0; i < 4; ++i) {
+            result += QStringLiteral("  %1 ± %2 px\n")
+                          .arg(QLatin1String(kNames[i]))
+                          .arg(formatDouble(1.96 * sigma.at<double>(i), 4));
+        }
+        result += QStringLiteral("\n");
+    }
+
     result += QStringLiteral("Image size : %1 x %2 px\n")
                   .arg(m_output.imageSize.width)
                   .arg(m_output.imageSize.height);
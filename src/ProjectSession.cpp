@@ -339,6 +339,7 @@ bool ProjectSession::initializeNew(const QString &rootDirectory,
     m_metadata.lastOpenedAt = m_metadata.createdAt;
     m_metadata.cameraVendor.clear();
     m_metadata.cameraModel.clear();
+    m_metadata.boardLayout.clear();
     m_metadata.cameraTuning = {};
     m_metadata.calibrationCapture = {};
     m_metadata.laserCalibration = {};
@@ -1047,6 +1048,9 @@ QJsonObject ProjectSession::toJson() const
     if (!m_metadata.cameraModel.isEmpty()) {
         obj.insert(QStringLiteral("camera_model"), m_metadata.cameraModel);
     }
+    if (!m_metadata.boardLayout.isEmpty()) {
+        obj.insert(QStringLiteral("board_layout"), m_metadata.boardLayout);
+    }
     obj.insert(stageKeyCamera(), stageToJson(m_metadata.cameraTuning));
     obj.insert(stageKeyCalibration(), stageToJson(m_metadata.calibrationCapture));
     obj.insert(stageKeyLaser(), stageToJson(m_metadata.laserCalibration));
@@ -1087,6 +1091,7 @@ void ProjectSession::fromJson(const QJsonObject &obj)
     m_metadata.dataSource = dataSourceFromString(obj.value(QStringLiteral("data_source")).toString(), DataSource::LocalDataset);
     m_metadata.cameraVendor = obj.value(QStringLiteral("camera_vendor")).toString();
     m_metadata.cameraModel = obj.value(QStringLiteral("camera_model")).toString();
+    m_metadata.boardLayout = obj.value(QStringLiteral("board_layout")).toString();
     m_metadata.cameraTuning = stageFromJson(obj.value(stageKeyCamera()).toObject());
     m_metadata.calibrationCapture = stageFromJson(obj.value(stageKeyCalibration()).toObject());
     m_metadata.laserCalibration = stageFromJson(obj.value(stageKeyLaser()).toObject());
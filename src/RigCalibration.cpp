@@ -0,0 +1,409 @@
+#include "RigCalibration.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <iterator>
+#include <numeric>
+#include <unordered_map>
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtConcurrent/QtConcurrent>
+
+#include <opencv2/calib3d.hpp>
+
+#include "ImageLoader.h"
+#include "Logger.h"
+
+namespace fs = std::filesystem;
+
+namespace mycalib {
+
+namespace {
+
+constexpr int kSolveFlags = cv::CALIB_RATIONAL_MODEL | cv::CALIB_THIN_PRISM_MODEL | cv::CALIB_TILTED_MODEL;
+
+struct DetectionJob {
+    size_t camera {0};
+    size_t image {0};
+};
+
+QJsonArray matToJson(const cv::Mat &mat)
+{
+    QJsonArray rows;
+    cv::Mat converted;
+    mat.convertTo(converted, CV_64F);
+    for (int r = 0; r < converted.rows; ++r) {
+        QJsonArray row;
+        for (int c = 0; c < converted.cols; ++c) {
+            row.append(converted.at<double>(r, c));
+        }
+        rows.append(row);
+    }
+    return rows;
+}
+
+// frames[f][camera] is the image index of camera `camera` synchronized with image f
+// of the reference camera, or -1 when that camera has no matching shot.
+std::vector<std::vector<int>> matchFrames(const std::vector<std::vector<std::string>> &paths,
+                                          const RigSettings &settings)
+{
+    const size_t cameraCount = paths.size();
+    std::vector<std::vector<int>> frames(paths.front().size(), std::vector<int>(cameraCount, -1));
+    for (size_t f = 0; f < frames.size(); ++f) {
+        frames[f][0] = static_cast<int>(f);
+    }
+
+    if (settings.matchMode == RigMatchMode::FileName) {
+        for (size_t camera = 1; camera < cameraCount; ++camera) {
+            std::unordered_map<std::string, int> byStem;
+            for (size_t i = 0; i < paths[camera].size(); ++i) {
+                byStem.emplace(fs::path(paths[camera][i]).stem().string(), static_cast<int>(i));
+            }
+            for (size_t f = 0; f < frames.size(); ++f) {
+                const auto it = byStem.find(fs::path(paths.front()[f]).stem().string());
+                if (it != byStem.end()) {
+                    frames[f][camera] = it->second;
+                }
+            }
+        }
+        return frames;
+    }
+
+    auto timestamps = [](const std::vector<std::string> &list) {
+        std::vector<std::pair<qint64, int>> stamped;
+        stamped.reserve(list.size());
+        for (size_t i = 0; i < list.size(); ++i) {
+            const QFileInfo info(QString::fromStdString(list[i]));
+            stamped.emplace_back(info.lastModified().toMSecsSinceEpoch(), static_cast<int>(i));
+        }
+        std::sort(stamped.begin(), stamped.end());
+        return stamped;
+    };
+    const auto reference = timestamps(paths.front());
+    const qint64 tolerance = std::max(0, settings.timestampToleranceMs);
+    for (size_t camera = 1; camera < cameraCount; ++camera) {
+        const auto stamped = timestamps(paths[camera]);
+        std::vector<unsigned char> used(stamped.size(), 0);
+        for (const auto &[time, refIndex] : reference) {
+            auto it = std::lower_bound(stamped.begin(), stamped.end(), std::make_pair(time, -1));
+            int best = -1;
+            qint64 bestDelta = tolerance + 1;
+            for (auto candidate : {it, it == stamped.begin() ? stamped.end() : std::prev(it)}) {
+                if (candidate == stamped.end()) {
+                    continue;
+                }
+                const auto index = static_cast<size_t>(std::distance(stamped.begin(), candidate));
+                const qint64 delta = std::llabs(candidate->first - time);
+                if (!used[index] && delta < bestDelta) {
+                    bestDelta = delta;
+                    best = static_cast<int>(index);
+                }
+            }
+            if (best >= 0) {
+                used[static_cast<size_t>(best)] = 1;
+                frames[static_cast<size_t>(refIndex)][camera] = stamped[static_cast<size_t>(best)].second;
+            }
+        }
+    }
+    return frames;
+}
+
+// Views the solve produced a board pose for, keyed by detection name.
+std::unordered_map<std::string, const DetectionResult *> posedViews(const CalibrationOutput &output)
+{
+    std::unordered_map<std::string, const DetectionResult *> views;
+    for (const auto *pool : {&output.keptDetections, &output.validationDetections}) {
+        for (const auto &rec : *pool) {
+            if (rec.success && !rec.residualsPx.empty()) {
+                views.emplace(rec.name, &rec);
+            }
+        }
+    }
+    return views;
+}
+
+RigExtrinsics solveExtrinsics(size_t camera,
+                              const std::vector<std::vector<std::string>> &paths,
+                              const std::vector<std::vector<int>> &frames,
+                              const CalibrationOutput &reference,
+                              const CalibrationOutput &target)
+{
+    RigExtrinsics result;
+    result.camera = static_cast<int>(camera);
+    result.reference = 0;
+
+    const auto referenceViews = posedViews(reference);
+    const auto targetViews = posedViews(target);
+    std::vector<std::vector<cv::Point3f>> objectPoints;
+    std::vector<std::vector<cv::Point2f>> referencePoints;
+    std::vector<std::vector<cv::Point2f>> targetPoints;
+    std::vector<cv::Matx33d> rotations;
+    std::vector<cv::Vec3d> translations;
+    for (const auto &frame : frames) {
+        if (frame[camera] < 0) {
+            continue;
+        }
+        const auto refIt = referenceViews.find(fs::path(paths.front()[static_cast<size_t>(frame[0])]).stem().string());
+        const auto tgtIt = targetViews.find(fs::path(paths[camera][static_cast<size_t>(frame[camera])]).stem().string());
+        if (refIt == referenceViews.end() || tgtIt == targetViews.end()) {
+            continue;
+        }
+        const DetectionResult &ref = *refIt->second;
+        const DetectionResult &tgt = *tgtIt->second;
+        // Both cameras must see the same board points for a joint solve.
+        if (ref.objectPoints.size() != tgt.objectPoints.size()) {
+            continue;
+        }
+        objectPoints.push_back(ref.objectPoints);
+        referencePoints.push_back(ref.imagePoints);
+        targetPoints.push_back(tgt.imagePoints);
+        const cv::Matx33d relative = tgt.rotationMatrix * ref.rotationMatrix.t();
+        rotations.push_back(relative);
+        translations.push_back(tgt.translationMm - relative * ref.translationMm);
+    }
+    result.frames = static_cast<int>(objectPoints.size());
+    if (objectPoints.empty()) {
+        return result;
+    }
+
+    // Initial guess from the per-frame relative poses: chordal mean of the rotations
+    // and component-wise median of the translations.
+    cv::Matx33d rotationSum = cv::Matx33d::zeros();
+    for (const auto &rotation : rotations) {
+        rotationSum += rotation;
+    }
+    cv::Mat w;
+    cv::Mat u;
+    cv::Mat vt;
+    cv::SVD::compute(cv::Mat(rotationSum), w, u, vt);
+    cv::Mat rotation = u * vt;
+    if (cv::determinant(rotation) < 0.0) {
+        u.col(2) *= -1.0;
+        rotation = u * vt;
+    }
+    cv::Mat translation(3, 1, CV_64F);
+    for (int axis = 0; axis < 3; ++axis) {
+        std::vector<double> values;
+        values.reserve(translations.size());
+        for (const auto &t : translations) {
+            values.push_back(t[axis]);
+        }
+        auto mid = values.begin() + static_cast<std::ptrdiff_t>(values.size() / 2);
+        std::nth_element(values.begin(), mid, values.end());
+        translation.at<double>(axis, 0) = *mid;
+    }
+
+    cv::Mat referenceK = reference.cameraMatrix.clone();
+    cv::Mat referenceDist = reference.distCoeffs.clone();
+    cv::Mat targetK = target.cameraMatrix.clone();
+    cv::Mat targetDist = target.distCoeffs.clone();
+    cv::Mat essential;
+    cv::Mat fundamental;
+    try {
+        result.rmsPx = cv::stereoCalibrate(objectPoints, referencePoints, targetPoints,
+                                           referenceK, referenceDist, targetK, targetDist,
+                                           reference.imageSize, rotation, translation, essential, fundamental,
+                                           cv::CALIB_FIX_INTRINSIC | cv::CALIB_USE_EXTRINSIC_GUESS | kSolveFlags,
+                                           cv::TermCriteria(cv::TermCriteria::COUNT + cv::TermCriteria::EPS, 100, 1e-9));
+    } catch (const cv::Exception &ex) {
+        Logger::warning(QStringLiteral("Rig extrinsics for camera %1 failed: %2")
+                            .arg(static_cast<int>(camera))
+                            .arg(QString::fromStdString(ex.what())));
+        return result;
+    }
+    result.rotation = cv::Matx33d(rotation);
+    result.translationMm = cv::Vec3d(translation.at<double>(0, 0), translation.at<double>(1, 0), translation.at<double>(2, 0));
+
+    double sumSqAngle = 0.0;
+    double sumSqOffset = 0.0;
+    for (size_t i = 0; i < rotations.size(); ++i) {
+        cv::Vec3d delta;
+        cv::Rodrigues(cv::Mat(rotations[i] * result.rotation.t()), delta);
+        const double angleDeg = cv::norm(delta) * 180.0 / CV_PI;
+        const double offset = cv::norm(translations[i] - result.translationMm);
+        sumSqAngle += angleDeg * angleDeg;
+        sumSqOffset += offset * offset;
+    }
+    result.rotationSpreadDeg = std::sqrt(sumSqAngle / static_cast<double>(rotations.size()));
+    result.translationSpreadMm = std::sqrt(sumSqOffset / static_cast<double>(rotations.size()));
+    result.valid = true;
+    return result;
+}
+
+void exportRigReport(const RigCalibrationOutput &output, const QString &outputDirectory)
+{
+    QJsonObject root;
+    root.insert("success", output.success);
+    root.insert("message", output.message);
+    root.insert("matched_frames", output.matchedFrames);
+
+    QJsonArray camerasJson;
+    for (const auto &camera : output.cameras) {
+        QJsonObject item;
+        item.insert("name", camera.name);
+        item.insert("directory", camera.directory);
+        item.insert("images", camera.images);
+        item.insert("success", camera.calibration.success);
+        item.insert("message", camera.calibration.message);
+        if (camera.calibration.success) {
+            item.insert("image_size", QJsonArray{camera.calibration.imageSize.width, camera.calibration.imageSize.height});
+            item.insert("rms_px", camera.calibration.metrics.rms);
+            item.insert("kept_views", static_cast<int>(camera.calibration.keptDetections.size()));
+            item.insert("camera_matrix", matToJson(camera.calibration.cameraMatrix));
+            item.insert("distortion_coefficients", matToJson(camera.calibration.distCoeffs));
+        }
+        camerasJson.append(item);
+    }
+    root.insert("cameras", camerasJson);
+
+    QJsonArray extrinsicsJson;
+    for (const auto &pose : output.extrinsics) {
+        QJsonObject item;
+        item.insert("camera", output.cameras[static_cast<size_t>(pose.camera)].name);
+        item.insert("reference", output.cameras[static_cast<size_t>(pose.reference)].name);
+        item.insert("valid", pose.valid);
+        item.insert("frames", pose.frames);
+        if (pose.valid) {
+            cv::Vec3d rvec;
+            cv::Rodrigues(cv::Mat(pose.rotation), rvec);
+            item.insert("rms_px", pose.rmsPx);
+            item.insert("rotation", matToJson(cv::Mat(pose.rotation)));
+            item.insert("rotation_vector_deg", QJsonArray{rvec[0] * 180.0 / CV_PI,
+                                                          rvec[1] * 180.0 / CV_PI,
+                                                          rvec[2] * 180.0 / CV_PI});
+            item.insert("translation_mm", QJsonArray{pose.translationMm[0], pose.translationMm[1], pose.translationMm[2]});
+            item.insert("baseline_mm", cv::norm(pose.translationMm));
+            item.insert("rotation_spread_deg", pose.rotationSpreadDeg);
+            item.insert("translation_spread_mm", pose.translationSpreadMm);
+        }
+        extrinsicsJson.append(item);
+    }
+    root.insert("extrinsics", extrinsicsJson);
+
+    QFile file(outputDirectory + "/rig_report.json");
+    if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    } else {
+        Logger::warning(QStringLiteral("Failed to write %1").arg(file.fileName()));
+    }
+}
+
+} // namespace
+
+RigCalibrationOutput RigCalibrator::run(const std::vector<RigCameraInput> &cameras,
+                                        const RigSettings &settings,
+                                        const QString &outputDirectory) const
+{
+    RigCalibrationOutput output;
+    if (cameras.size() < 2) {
+        output.message = QStringLiteral("Rig mode needs at least two cameras");
+        return output;
+    }
+    const QString rootDirectory = CalibrationEngine::resolveOutputDirectory(outputDirectory);
+    QDir().mkpath(rootDirectory);
+
+    ImageLoader loader;
+    std::vector<std::vector<std::string>> paths(cameras.size());
+    std::vector<DetectionJob> jobs;
+    output.cameras.resize(cameras.size());
+    for (size_t camera = 0; camera < cameras.size(); ++camera) {
+        paths[camera] = loader.gatherImageFiles(cameras[camera].directory.toStdString());
+        output.cameras[camera].name = cameras[camera].name;
+        output.cameras[camera].directory = cameras[camera].directory;
+        output.cameras[camera].images = static_cast<int>(paths[camera].size());
+        for (size_t image = 0; image < paths[camera].size(); ++image) {
+            jobs.push_back({camera, image});
+        }
+        Logger::info(QStringLiteral("Rig camera %1: %2 images in %3")
+                         .arg(cameras[camera].name)
+                         .arg(static_cast<int>(paths[camera].size()))
+                         .arg(cameras[camera].directory));
+    }
+    if (paths.front().empty()) {
+        output.message = QStringLiteral("Reference camera %1 has no images").arg(cameras.front().name);
+        exportRigReport(output, rootDirectory);
+        return output;
+    }
+
+    const auto frames = matchFrames(paths, settings);
+    for (const auto &frame : frames) {
+        if (std::any_of(frame.begin() + 1, frame.end(), [](int index) { return index >= 0; })) {
+            ++output.matchedFrames;
+        }
+    }
+    Logger::info(QStringLiteral("Rig: %1 synchronized frames matched by %2")
+                     .arg(output.matchedFrames)
+                     .arg(settings.matchMode == RigMatchMode::FileName ? QStringLiteral("file name")
+                                                                       : QStringLiteral("timestamp")));
+
+    // One detection pass over every image of every camera, sharing the global pool.
+    const BoardDetector detector(CalibrationEngine::resolveDetectionConfig(settings.calibration));
+    std::vector<std::vector<DetectionResult>> detections(cameras.size());
+    for (size_t camera = 0; camera < cameras.size(); ++camera) {
+        detections[camera].resize(paths[camera].size());
+    }
+    QtConcurrent::blockingMap(jobs, [&](const DetectionJob &job) {
+        detections[job.camera][job.image] = CalibrationEngine::detectImage(paths[job.camera][job.image],
+                                                                           settings.calibration.boardSpec, detector);
+    });
+
+    // Intrinsics per camera, solved side by side from the shared detections.
+    std::vector<size_t> cameraIds(cameras.size());
+    std::iota(cameraIds.begin(), cameraIds.end(), size_t {0});
+    QtConcurrent::blockingMap(cameraIds, [&](size_t camera) {
+        CalibrationEngine engine;
+        output.cameras[camera].calibration = engine.runBlocking(std::move(detections[camera]),
+                                                                settings.calibration,
+                                                                rootDirectory + "/" + cameras[camera].name);
+    });
+
+    const CalibrationOutput &reference = output.cameras.front().calibration;
+    bool allSolved = true;
+    for (const auto &camera : output.cameras) {
+        if (!camera.calibration.success) {
+            allSolved = false;
+            Logger::warning(QStringLiteral("Rig camera %1 failed: %2").arg(camera.name, camera.calibration.message));
+        }
+    }
+
+    for (size_t camera = 1; camera < cameras.size(); ++camera) {
+        if (!reference.success || !output.cameras[camera].calibration.success) {
+            RigExtrinsics missing;
+            missing.camera = static_cast<int>(camera);
+            output.extrinsics.push_back(missing);
+            continue;
+        }
+        RigExtrinsics pose = solveExtrinsics(camera, paths, frames, reference, output.cameras[camera].calibration);
+        if (pose.valid) {
+            Logger::info(QStringLiteral("Rig extrinsics %1 -> %2: frames=%3 | RMS=%4 px | baseline=%5 mm | spread=%6 deg / %7 mm")
+                             .arg(cameras.front().name)
+                             .arg(cameras[camera].name)
+                             .arg(pose.frames)
+                             .arg(pose.rmsPx, 0, 'f', 3)
+                             .arg(cv::norm(pose.translationMm), 0, 'f', 2)
+                             .arg(pose.rotationSpreadDeg, 0, 'f', 3)
+                             .arg(pose.translationSpreadMm, 0, 'f', 2));
+        } else {
+            allSolved = false;
+            Logger::warning(QStringLiteral("Rig extrinsics %1 -> %2: no usable synchronized frames")
+                                .arg(cameras.front().name, cameras[camera].name));
+        }
+        output.extrinsics.push_back(pose);
+    }
+
+    output.success = allSolved;
+    output.message = allSolved ? QStringLiteral("Rig calibration complete")
+                               : QStringLiteral("Rig calibration incomplete; see per-camera results");
+    exportRigReport(output, rootDirectory);
+    return output;
+}
+
+} // namespace mycalib
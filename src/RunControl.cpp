@@ -0,0 +1,112 @@
+#include "RunControl.h"
+
+namespace mycalib {
+
+namespace {
+
+thread_local RunControl *t_control = nullptr;
+thread_local int t_slot = -1;
+
+} // namespace
+
+RunControl::WorkerScope::WorkerScope(RunControl &control)
+    : m_control(control)
+    , m_previousControl(t_control)
+    , m_previousSlot(t_slot)
+{
+    for (int i = 0; i < kMaxWorkers; ++i) {
+        int expected = kFreeSlot;
+        if (control.m_workers[static_cast<size_t>(i)].compare_exchange_strong(expected,
+                                                                              static_cast<int>(WorkerStage::Idle),
+                                                                              std::memory_order_relaxed)) {
+            m_slot = i;
+            break;
+        }
+    }
+    t_control = &control;
+    t_slot = m_slot;
+}
+
+RunControl::WorkerScope::~WorkerScope()
+{
+    if (m_slot >= 0) {
+        m_control.m_workers[static_cast<size_t>(m_slot)].store(kFreeSlot, std::memory_order_relaxed);
+    }
+    t_control = m_previousControl;
+    t_slot = m_previousSlot;
+}
+
+RunControl::RunControl()
+{
+    for (auto &worker : m_workers) {
+        worker.store(kFreeSlot, std::memory_order_relaxed);
+    }
+}
+
+void RunControl::reset()
+{
+    m_stage.store(static_cast<int>(Stage::Idle), std::memory_order_relaxed);
+    m_total.store(0, std::memory_order_relaxed);
+    m_processed.store(0, std::memory_order_relaxed);
+    m_failed.store(0, std::memory_order_relaxed);
+    m_cancel.store(false, std::memory_order_release);
+}
+
+void RunControl::setStage(Stage stage)
+{
+    m_stage.store(static_cast<int>(stage), std::memory_order_relaxed);
+}
+
+void RunControl::setTotal(int total)
+{
+    m_total.store(total, std::memory_order_relaxed);
+}
+
+void RunControl::finishItem(bool success)
+{
+    if (!success) {
+        m_failed.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_processed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void RunControl::requestCancel()
+{
+    m_cancel.store(true, std::memory_order_release);
+}
+
+bool RunControl::cancelRequested() const
+{
+    return m_cancel.load(std::memory_order_acquire);
+}
+
+RunControl::Snapshot RunControl::snapshot() const
+{
+    Snapshot snap;
+    snap.stage = static_cast<Stage>(m_stage.load(std::memory_order_relaxed));
+    snap.total = m_total.load(std::memory_order_relaxed);
+    snap.processed = m_processed.load(std::memory_order_relaxed);
+    snap.failed = m_failed.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < m_workers.size(); ++i) {
+        const int value = m_workers[i].load(std::memory_order_relaxed);
+        snap.workers[i] = value == kFreeSlot ? WorkerStage::Idle : static_cast<WorkerStage>(value);
+        if (snap.workers[i] != WorkerStage::Idle) {
+            ++snap.busyWorkers;
+        }
+    }
+    return snap;
+}
+
+void RunControl::markWorker(WorkerStage stage)
+{
+    if (t_control && t_slot >= 0) {
+        t_control->m_workers[static_cast<size_t>(t_slot)].store(static_cast<int>(stage), std::memory_order_relaxed);
+    }
+}
+
+bool RunControl::cancelled()
+{
+    return t_control && t_control->cancelRequested();
+}
+
+} // namespace mycalib
@@ -0,0 +1,570 @@
+#include "ThumbnailCache.h"
+
+#include <algorithm>
+#include <vector>
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include "Logger.h"
+
+namespace mycalib {
+
+namespace {
+
+constexpr quint32 kIndexMagic = 0x4D435443; // 'MCTC'
+constexpr quint16 kIndexVersion = 1;
+constexpr int kJpegQuality = 90;
+constexpr int kPoolThreads = 2;
+// Superseded levels are only reclaimed once there is enough of them to be worth
+// rewriting the atlas.
+constexpr qint64 kCompactMinDeadBytes = 32LL * 1024 * 1024;
+
+QString cacheKey(const QString &path)
+{
+    return QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+}
+
+bool fileStamp(const QString &key, qint64 *size, qint64 *modifiedMs)
+{
+    const QFileInfo info(key);
+    if (!info.exists()) {
+        return false;
+    }
+    *size = info.size();
+    *modifiedMs = info.lastModified().toMSecsSinceEpoch();
+    return true;
+}
+
+// 8-bit gray or BGR, the two layouts the JPEG levels are stored in.
+cv::Mat toCacheFormat(const cv::Mat &pixels)
+{
+    cv::Mat base = pixels;
+    if (base.depth() != CV_8U) {
+        cv::Mat stretched;
+        cv::normalize(base, stretched, 0, 255, cv::NORM_MINMAX, CV_8U);
+        base = stretched;
+    }
+    switch (base.channels()) {
+    case 1:
+    case 3:
+        return base;
+    case 4: {
+        cv::Mat bgr;
+        cv::cvtColor(base, bgr, cv::COLOR_BGRA2BGR);
+        return bgr;
+    }
+    default: {
+        cv::Mat first;
+        cv::extractChannel(base, first, 0);
+        return first;
+    }
+    }
+}
+
+int longSide(int width, int height)
+{
+    return std::max(width, height);
+}
+
+QString newAtlasName()
+{
+    return QStringLiteral("thumbnails-%1.atlas").arg(QDateTime::currentMSecsSinceEpoch());
+}
+
+} // namespace
+
+ThumbnailCache::ThumbnailCache(const QString &directory)
+    : m_directory(directory)
+{
+    m_pool.setMaxThreadCount(kPoolThreads);
+    if (!m_directory.isEmpty()) {
+        QDir().mkpath(m_directory);
+        loadIndex();
+    }
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+    flush();
+    QMutexLocker lock(&m_mutex);
+    unmapAtlas();
+}
+
+QString ThumbnailCache::filePath(const QString &name) const
+{
+    return QDir(m_directory).filePath(name);
+}
+
+void ThumbnailCache::insertAsync(const QString &path, const cv::Mat &pixels, const cv::Size &sourceSize)
+{
+    if (pixels.empty() || m_directory.isEmpty()) {
+        return;
+    }
+    // Checked here too so a rerun over an unchanged dataset does not even queue work.
+    const int topLongSide = std::min(longSide(pixels.cols, pixels.rows), kTopLevelLongSide);
+    if (isCurrent(cacheKey(path), topLongSide)) {
+        return;
+    }
+    m_pool.start([this, path, pixels, sourceSize]() { insert(path, pixels, sourceSize); });
+}
+
+void ThumbnailCache::insert(const QString &path, const cv::Mat &pixels, const cv::Size &sourceSize)
+{
+    if (pixels.empty() || m_directory.isEmpty()) {
+        return;
+    }
+    const QString key = cacheKey(path);
+    const int pixelsLongSide = longSide(pixels.cols, pixels.rows);
+    if (isCurrent(key, std::min(pixelsLongSide, kTopLevelLongSide))) {
+        return;
+    }
+    Entry entry;
+    if (!fileStamp(key, &entry.fileSize, &entry.modifiedMs)) {
+        return;
+    }
+    const cv::Size source = sourceSize.area() > 0 ? sourceSize : pixels.size();
+    entry.sourceSize = QSize(source.width, source.height);
+
+    cv::Mat level = toCacheFormat(pixels);
+    if (pixelsLongSide > kTopLevelLongSide) {
+        const double scale = static_cast<double>(kTopLevelLongSide) / pixelsLongSide;
+        cv::Mat top;
+        cv::resize(level, top, cv::Size(), scale, scale, cv::INTER_AREA);
+        level = top;
+    }
+    const std::vector<int> params = {cv::IMWRITE_JPEG_QUALITY, kJpegQuality};
+    std::vector<uchar> encoded;
+    while (true) {
+        if (!cv::imencode(".jpg", level, encoded, params)) {
+            return;
+        }
+        Level record;
+        record.width = level.cols;
+        record.height = level.rows;
+        record.length = static_cast<qint64>(encoded.size());
+        record.pending = QByteArray(reinterpret_cast<const char *>(encoded.data()), static_cast<int>(encoded.size()));
+        entry.levels.append(std::move(record));
+        if (longSide(level.cols, level.rows) / 2 < kBottomLevelLongSide) {
+            break;
+        }
+        cv::Mat half;
+        cv::resize(level, half, cv::Size((level.cols + 1) / 2, (level.rows + 1) / 2), 0.0, 0.0, cv::INTER_AREA);
+        level = half;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    const auto previous = m_entries.constFind(key);
+    if (previous != m_entries.constEnd()) {
+        for (const Level &old : previous->levels) {
+            if (old.offset >= 0) {
+                m_liveBytes -= old.length;
+                m_deadBytes += old.length;
+            }
+        }
+    }
+    m_entries.insert(key, std::move(entry));
+    m_dirty = true;
+}
+
+ThumbnailCache::Hit ThumbnailCache::lookup(const QString &path, int longSideWanted) const
+{
+    const QString key = cacheKey(path);
+    qint64 cachedSize = 0;
+    qint64 cachedModifiedMs = 0;
+    QByteArray bytes;
+    Hit hit;
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_entries.constFind(key);
+        if (it == m_entries.constEnd() || it->levels.isEmpty()) {
+            return {};
+        }
+        cachedSize = it->fileSize;
+        cachedModifiedMs = it->modifiedMs;
+        const Level *chosen = nullptr;
+        for (auto level = it->levels.crbegin(); level != it->levels.crend(); ++level) {
+            if (longSide(level->width, level->height) >= longSideWanted) {
+                chosen = &*level;
+                break;
+            }
+        }
+        const Level &top = it->levels.front();
+        if (!chosen && QSize(top.width, top.height) == it->sourceSize) {
+            chosen = &top;
+        }
+        if (!chosen) {
+            return {};
+        }
+        if (chosen->offset < 0) {
+            bytes = chosen->pending;
+        } else if (m_map && chosen->offset + chosen->length <= m_mapSize) {
+            // Only the few-KB level is copied out of the map, so decoding can run unlocked.
+            bytes = QByteArray(reinterpret_cast<const char *>(m_map + chosen->offset), static_cast<int>(chosen->length));
+        } else {
+            return {};
+        }
+        hit.sourceSize = it->sourceSize;
+    }
+
+    // The stat runs unlocked so a slow filesystem does not stall other lookups.
+    qint64 size = 0;
+    qint64 modifiedMs = 0;
+    if (!fileStamp(key, &size, &modifiedMs) || size != cachedSize || modifiedMs != cachedModifiedMs) {
+        return {};
+    }
+    const cv::Mat raw(1, static_cast<int>(bytes.size()), CV_8U, bytes.data());
+    const cv::Mat decoded = cv::imdecode(raw, cv::IMREAD_UNCHANGED);
+    if (decoded.empty()) {
+        return {};
+    }
+    if (decoded.channels() == 1) {
+        hit.image = QImage(decoded.data, decoded.cols, decoded.rows, static_cast<qsizetype>(decoded.step), QImage::Format_Grayscale8).copy();
+    } else {
+        cv::Mat rgb;
+        cv::cvtColor(decoded, rgb, cv::COLOR_BGR2RGB);
+        hit.image = QImage(rgb.data, rgb.cols, rgb.rows, static_cast<qsizetype>(rgb.step), QImage::Format_RGB888).copy();
+    }
+    return hit;
+}
+
+bool ThumbnailCache::isCurrent(const QString &key, int topLongSide) const
+{
+    qint64 cachedSize = 0;
+    qint64 cachedModifiedMs = 0;
+    {
+        QMutexLocker lock(&m_mutex);
+        const auto it = m_entries.constFind(key);
+        if (it == m_entries.constEnd() || it->levels.isEmpty()) {
+            return false;
+        }
+        const Level &top = it->levels.front();
+        if (longSide(top.width, top.height) < topLongSide) {
+            return false;
+        }
+        cachedSize = it->fileSize;
+        cachedModifiedMs = it->modifiedMs;
+    }
+    qint64 size = 0;
+    qint64 modifiedMs = 0;
+    return fileStamp(key, &size, &modifiedMs) && size == cachedSize && modifiedMs == cachedModifiedMs;
+}
+
+void ThumbnailCache::dropStaleEntries()
+{
+    struct Stamp {
+        QString key;
+        qint64 fileSize {0};
+        qint64 modifiedMs {0};
+    };
+    std::vector<Stamp> stamps;
+    {
+        QMutexLocker lock(&m_mutex);
+        stamps.reserve(static_cast<size_t>(m_entries.size()));
+        for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+            stamps.push_back({it.key(), it->fileSize, it->modifiedMs});
+        }
+    }
+    std::vector<Stamp> stale;
+    for (const Stamp &stamp : stamps) {
+        qint64 size = 0;
+        qint64 modifiedMs = 0;
+        if (!fileStamp(stamp.key, &size, &modifiedMs) || size != stamp.fileSize || modifiedMs != stamp.modifiedMs) {
+            stale.push_back(stamp);
+        }
+    }
+    if (stale.empty()) {
+        return;
+    }
+
+    QMutexLocker lock(&m_mutex);
+    int dropped = 0;
+    for (const Stamp &stamp : stale) {
+        const auto it = m_entries.find(stamp.key);
+        // Skip entries rebuilt for the current file while the stats ran.
+        if (it == m_entries.end() || it->fileSize != stamp.fileSize || it->modifiedMs != stamp.modifiedMs) {
+            continue;
+        }
+        for (const Level &level : it->levels) {
+            if (level.offset >= 0) {
+                m_liveBytes -= level.length;
+                m_deadBytes += level.length;
+            }
+        }
+        m_entries.erase(it);
+        ++dropped;
+    }
+    if (dropped > 0) {
+        m_dirty = true;
+        Logger::info(QStringLiteral("Dropped %1 thumbnail(s) of deleted or changed files").arg(dropped));
+    }
+}
+
+bool ThumbnailCache::flush()
+{
+    if (m_directory.isEmpty()) {
+        return false;
+    }
+    m_pool.waitForDone();
+    dropStaleEntries();
+    QMutexLocker lock(&m_mutex);
+    if (!m_dirty) {
+        return true;
+    }
+    const bool ok = (m_deadBytes > m_liveBytes && m_deadBytes > kCompactMinDeadBytes) ? compact() : appendPending();
+    if (ok) {
+        m_dirty = false;
+    }
+    return ok;
+}
+
+bool ThumbnailCache::appendPending()
+{
+    if (m_atlasName.isEmpty()) {
+        m_atlasName = newAtlasName();
+    }
+    unmapAtlas();
+    QFile file(filePath(m_atlasName));
+    if (!file.open(QIODevice::ReadWrite)) {
+        Logger::warning(QStringLiteral("Thumbnail atlas %1 is not writable: %2").arg(file.fileName(), file.errorString()));
+        mapAtlas();
+        return false;
+    }
+    qint64 end = file.size();
+    file.seek(end);
+    bool ok = true;
+    for (Entry &entry : m_entries) {
+        for (Level &level : entry.levels) {
+            if (level.offset >= 0) {
+                continue;
+            }
+            if (file.write(level.pending) != level.length) {
+                ok = false;
+                break;
+            }
+            level.offset = end;
+            level.pending = QByteArray();
+            end += level.length;
+            m_liveBytes += level.length;
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    file.close();
+    if (!ok) {
+        Logger::warning(QStringLiteral("Failed to append to thumbnail atlas %1").arg(file.fileName()));
+    }
+    // Levels written before a failure are still valid, so the index is updated either way.
+    ok = writeIndex(m_atlasName, m_entries) && ok;
+    mapAtlas();
+    return ok;
+}
+
+bool ThumbnailCache::compact()
+{
+    const QString name = newAtlasName();
+    QSaveFile file(filePath(name));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return appendPending();
+    }
+    // Offsets are only applied once the new atlas is committed.
+    QHash<QString, QVector<qint64>> offsets;
+    QStringList unreadable;
+    qint64 position = 0;
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        QVector<qint64> entryOffsets;
+        for (const Level &level : it->levels) {
+            const char *data = nullptr;
+            if (level.offset < 0) {
+                data = level.pending.constData();
+            } else if (m_map && level.offset + level.length <= m_mapSize) {
+                data = reinterpret_cast<const char *>(m_map + level.offset);
+            }
+            if (!data) {
+                break;
+            }
+            if (file.write(data, level.length) != level.length) {
+                file.cancelWriting();
+                return appendPending();
+            }
+            entryOffsets.append(position);
+            position += level.length;
+        }
+        if (entryOffsets.size() == it->levels.size()) {
+            offsets.insert(it.key(), entryOffsets);
+        } else {
+            unreadable.append(it.key());
+        }
+    }
+    if (!file.commit()) {
+        return appendPending();
+    }
+
+    QHash<QString, Entry> compacted = m_entries;
+    for (const QString &key : unreadable) {
+        compacted.remove(key);
+    }
+    for (auto it = compacted.begin(); it != compacted.end(); ++it) {
+        const QVector<qint64> &entryOffsets = offsets[it.key()];
+        for (int i = 0; i < it->levels.size(); ++i) {
+            it->levels[i].offset = entryOffsets[i];
+            it->levels[i].pending = QByteArray();
+        }
+    }
+    if (!writeIndex(name, compacted)) {
+        // The old index still names the old atlas, which stays valid; retry next flush.
+        QFile::remove(filePath(name));
+        return false;
+    }
+    const QString previous = m_atlasName;
+    unmapAtlas();
+    m_entries = std::move(compacted);
+    m_atlasName = name;
+    if (!previous.isEmpty()) {
+        QFile::remove(filePath(previous));
+    }
+    mapAtlas();
+    Logger::info(QStringLiteral("Compacted thumbnail atlas: %1 MB reclaimed")
+                     .arg(QString::number(static_cast<double>(m_deadBytes) / (1024.0 * 1024.0), 'f', 1)));
+    m_liveBytes = position;
+    m_deadBytes = 0;
+    return true;
+}
+
+bool ThumbnailCache::writeIndex(const QString &atlasName, const QHash<QString, Entry> &entries) const
+{
+    QSaveFile file(filePath(QStringLiteral("thumbnails.index")));
+    if (!file.open(QIODevice::WriteOnly)) {
+        Logger::warning(QStringLiteral("Thumbnail index is not writable: %1").arg(file.errorString()));
+        return false;
+    }
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_5);
+    out << kIndexMagic << kIndexVersion << atlasName;
+
+    quint32 count = 0;
+    for (const Entry &entry : entries) {
+        if (std::all_of(entry.levels.cbegin(), entry.levels.cend(), [](const Level &level) { return level.offset >= 0; })) {
+            ++count;
+        }
+    }
+    out << count;
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        const Entry &entry = it.value();
+        if (!std::all_of(entry.levels.cbegin(), entry.levels.cend(), [](const Level &level) { return level.offset >= 0; })) {
+            continue;
+        }
+        out << it.key() << entry.fileSize << entry.modifiedMs;
+        out << qint32(entry.sourceSize.width()) << qint32(entry.sourceSize.height());
+        out << quint8(entry.levels.size());
+        for (const Level &level : entry.levels) {
+            out << qint32(level.width) << qint32(level.height) << level.offset << level.length;
+        }
+    }
+    if (out.status() != QDataStream::Ok) {
+        file.cancelWriting();
+        return false;
+    }
+    return file.commit();
+}
+
+bool ThumbnailCache::loadIndex()
+{
+    QFile file(filePath(QStringLiteral("thumbnails.index")));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_5);
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString atlasName;
+    quint32 count = 0;
+    in >> magic >> version;
+    if (magic != kIndexMagic || version != kIndexVersion) {
+        Logger::warning(QStringLiteral("Ignoring thumbnail index with unknown format: %1").arg(file.fileName()));
+        return false;
+    }
+    in >> atlasName >> count;
+
+    QHash<QString, Entry> entries;
+    entries.reserve(static_cast<qsizetype>(std::min<quint32>(count, 1U << 16)));
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QString key;
+        Entry entry;
+        qint32 width = 0;
+        qint32 height = 0;
+        quint8 levelCount = 0;
+        in >> key >> entry.fileSize >> entry.modifiedMs >> width >> height >> levelCount;
+        entry.sourceSize = QSize(width, height);
+        entry.levels.resize(levelCount);
+        for (Level &level : entry.levels) {
+            qint32 levelWidth = 0;
+            qint32 levelHeight = 0;
+            in >> levelWidth >> levelHeight >> level.offset >> level.length;
+            level.width = levelWidth;
+            level.height = levelHeight;
+        }
+        entries.insert(key, std::move(entry));
+    }
+    if (in.status() != QDataStream::Ok) {
+        Logger::warning(QStringLiteral("Thumbnail index is truncated, starting a new cache: %1").arg(file.fileName()));
+        return false;
+    }
+
+    m_atlasName = atlasName;
+    m_entries = std::move(entries);
+    mapAtlas();
+    // Drop anything the atlas cannot back (a partially written append).
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        const bool valid = std::all_of(it->levels.cbegin(), it->levels.cend(), [this](const Level &level) {
+            return level.offset >= 0 && level.length > 0 && level.offset + level.length <= m_mapSize;
+        });
+        if (!valid) {
+            it = m_entries.erase(it);
+            continue;
+        }
+        for (const Level &level : it->levels) {
+            m_liveBytes += level.length;
+        }
+        ++it;
+    }
+    m_deadBytes = std::max<qint64>(0, m_mapSize - m_liveBytes);
+    return true;
+}
+
+void ThumbnailCache::mapAtlas()
+{
+    if (m_atlasName.isEmpty()) {
+        return;
+    }
+    m_atlas.setFileName(filePath(m_atlasName));
+    if (!m_atlas.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    const qint64 size = m_atlas.size();
+    if (size > 0) {
+        m_map = m_atlas.map(0, size);
+    }
+    m_mapSize = m_map ? size : 0;
+}
+
+void ThumbnailCache::unmapAtlas()
+{
+    if (m_map) {
+        m_atlas.unmap(const_cast<uchar *>(m_map));
+    }
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_atlas.close();
+}
+
+} // namespace mycalib
@@ -0,0 +1,164 @@
+#include "ViewSelection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <opencv2/calib3d.hpp>
+
+namespace mycalib {
+
+namespace {
+
+// Views used to seed initCameraMatrix2D; a strided sample is plenty for a
+// pose-only estimate and keeps the seed cost flat.
+constexpr size_t kIntrinsicSeedViews = 40;
+
+struct ViewFeature {
+    size_t index {0};
+    std::vector<float> values;
+    double sharpness {0.0};
+};
+
+double squaredDistance(const std::vector<float> &a, const std::vector<float> &b)
+{
+    double sum = 0.0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const double d = static_cast<double>(a[i]) - static_cast<double>(b[i]);
+        sum += d * d;
+    }
+    return sum;
+}
+
+} // namespace
+
+ViewSelection selectCalibrationViews(const std::vector<DetectionResult> &detections,
+                                     const cv::Size &imageSize,
+                                     const ViewSelectionOptions &options)
+{
+    ViewSelection selection;
+    std::vector<size_t> candidates;
+    for (size_t i = 0; i < detections.size(); ++i) {
+        const auto &rec = detections[i];
+        if (rec.success && !rec.imagePoints.empty() && rec.imagePoints.size() == rec.objectPoints.size()) {
+            candidates.push_back(i);
+        }
+    }
+    if (options.maxViews <= 0 || candidates.size() <= static_cast<size_t>(options.maxViews) ||
+        imageSize.width <= 0 || imageSize.height <= 0) {
+        selection.selected = std::move(candidates);
+        return selection;
+    }
+
+    std::vector<std::vector<cv::Point3f>> seedObjects;
+    std::vector<std::vector<cv::Point2f>> seedImages;
+    const size_t stride = std::max<size_t>(1, candidates.size() / kIntrinsicSeedViews);
+    for (size_t i = 0; i < candidates.size(); i += stride) {
+        seedObjects.push_back(detections[candidates[i]].objectPoints);
+        seedImages.push_back(detections[candidates[i]].imagePoints);
+    }
+    const cv::Mat cameraMatrix = cv::initCameraMatrix2D(seedObjects, seedImages, imageSize);
+
+    const int grid = std::max(1, options.coverageGrid);
+    std::vector<ViewFeature> features;
+    features.reserve(candidates.size());
+    std::vector<double> depths;
+    depths.reserve(candidates.size());
+    for (size_t index : candidates) {
+        const auto &rec = detections[index];
+        cv::Vec3d rvec;
+        cv::Vec3d tvec;
+        if (!cv::solvePnP(rec.objectPoints, rec.imagePoints, cameraMatrix, cv::noArray(), rvec, tvec,
+                          false, cv::SOLVEPNP_IPPE) || tvec[2] <= 0.0) {
+            continue;
+        }
+        cv::Matx33d rotation;
+        cv::Rodrigues(rvec, rotation);
+        const cv::Vec3d normal = rotation * cv::Vec3d(0.0, 0.0, 1.0);
+
+        ViewFeature feature;
+        feature.index = index;
+        feature.sharpness = rec.sharpness;
+        feature.values.reserve(6 + static_cast<size_t>(grid * grid));
+        const auto pose = static_cast<float>(options.poseWeight);
+        feature.values.push_back(pose * static_cast<float>(normal[0]));
+        feature.values.push_back(pose * static_cast<float>(normal[1]));
+        feature.values.push_back(pose * static_cast<float>(normal[2]));
+        feature.values.push_back(pose * static_cast<float>(tvec[0] / tvec[2]));
+        feature.values.push_back(pose * static_cast<float>(tvec[1] / tvec[2]));
+        feature.values.push_back(static_cast<float>(tvec[2])); // normalized below
+
+        std::vector<float> coverage(static_cast<size_t>(grid * grid), 0.0F);
+        for (const auto &pt : rec.imagePoints) {
+            const int cx = std::clamp(static_cast<int>(pt.x * grid / imageSize.width), 0, grid - 1);
+            const int cy = std::clamp(static_cast<int>(pt.y * grid / imageSize.height), 0, grid - 1);
+            coverage[static_cast<size_t>(cy * grid + cx)] += 1.0F;
+        }
+        const float coverageScale = static_cast<float>(options.coverageWeight) / static_cast<float>(rec.imagePoints.size());
+        for (float cell : coverage) {
+            feature.values.push_back(cell * coverageScale);
+        }
+        depths.push_back(tvec[2]);
+        features.push_back(std::move(feature));
+    }
+
+    if (features.size() <= static_cast<size_t>(options.maxViews)) {
+        for (const auto &feature : features) {
+            selection.selected.push_back(feature.index);
+        }
+    } else {
+        auto mid = depths.begin() + static_cast<std::ptrdiff_t>(depths.size() / 2);
+        std::nth_element(depths.begin(), mid, depths.end());
+        const double medianDepth = std::max(*mid, 1e-6);
+        double maxSharpness = 0.0;
+        for (auto &feature : features) {
+            feature.values[5] = static_cast<float>(options.poseWeight * std::log(feature.values[5] / medianDepth));
+            maxSharpness = std::max(maxSharpness, feature.sharpness);
+        }
+        auto sharpnessFactor = [&](const ViewFeature &feature) {
+            const double normalized = maxSharpness > 0.0 ? feature.sharpness / maxSharpness : 1.0;
+            return 1.0 - options.sharpnessWeight + options.sharpnessWeight * normalized;
+        };
+
+        // Greedy farthest-point sampling seeded with the sharpest view.
+        size_t current = 0;
+        for (size_t i = 1; i < features.size(); ++i) {
+            if (features[i].sharpness > features[current].sharpness) {
+                current = i;
+            }
+        }
+        std::vector<double> nearest(features.size(), std::numeric_limits<double>::infinity());
+        std::vector<unsigned char> taken(features.size(), 0);
+        for (int picked = 0; picked < options.maxViews; ++picked) {
+            taken[current] = 1;
+            selection.selected.push_back(features[current].index);
+            size_t next = current;
+            double bestScore = -1.0;
+            for (size_t i = 0; i < features.size(); ++i) {
+                if (taken[i]) {
+                    continue;
+                }
+                nearest[i] = std::min(nearest[i], squaredDistance(features[i].values, features[current].values));
+                const double score = std::sqrt(nearest[i]) * sharpnessFactor(features[i]);
+                if (score > bestScore) {
+                    bestScore = score;
+                    next = i;
+                }
+            }
+            if (next == current) {
+                break;
+            }
+            current = next;
+        }
+        std::sort(selection.selected.begin(), selection.selected.end());
+    }
+
+    for (size_t index : candidates) {
+        if (!std::binary_search(selection.selected.begin(), selection.selected.end(), index)) {
+            selection.holdout.push_back(index);
+        }
+    }
+    return selection;
+}
+
+} // namespace mycalib
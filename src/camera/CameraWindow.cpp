@@ -87,21 +87,24 @@ CameraWindow::CameraWindow(QWidget* parent)
 			statusParts << tr("相机已连接");
 		}
 
-		QString configMessage;
 		const QString configDir = resolveConfigDirectory();
-		if (!configDir.isEmpty() && m_cam->applyConfigurationProfile(configDir, id, &configMessage)) {
-			if (!configMessage.isEmpty()) {
-				statusParts << configMessage;
-			} else {
-				statusParts << tr("已加载默认配置");
-			}
-			if (m_panel) {
-				m_panel->refresh();
-			}
+		if (!configDir.isEmpty() && m_cam->applyConfigurationProfileAsync(configDir, id)) {
+			statusParts << tr("正在应用配置…");
 		}
 
 		flashStatus(statusParts.join(QStringLiteral(" · ")), 3200);
 	});
+	connect(m_cam, &VimbaController::profileProgress, this, [this](int done, int total) {
+		flashStatus(tr("正在应用配置 %1/%2").arg(done).arg(total), 1500);
+	});
+	connect(m_cam, &VimbaController::profileApplied, this, [this](bool success, const QString& message) {
+		if (success && m_panel) {
+			m_panel->refresh();
+		}
+		if (!message.isEmpty()) {
+			flashStatus(message, 3200);
+		}
+	});
 	connect(m_cam, &VimbaController::cameraClosed, this, [this]() {
 		if (m_panel) {
 			m_panel->setCamera(VmbCPP::CameraPtr());
@@ -100,6 +100,23 @@ void ImageView::setGridCellCounts(const QVector<QVector<int>> &counts, int maxPe
 }
 
 
+void ImageView::setGridRecommendation(int row, int col, const QString &label)
+{
+	if (row < 0 || col < 0 || row >= m_gridRows || col >= m_gridCols) {
+		row = -1;
+		col = -1;
+	}
+	const QString sanitized = row < 0 ? QString() : label;
+	if (m_gridRecommendRow == row && m_gridRecommendCol == col && m_gridRecommendLabel == sanitized) {
+		return;
+	}
+	m_gridRecommendRow = row;
+	m_gridRecommendCol = col;
+	m_gridRecommendLabel = sanitized;
+	update();
+}
+
+
 void ImageView::paintEvent(QPaintEvent*) {
 	QPainter p(this);
 
@@ -143,6 +160,24 @@ void ImageView::paintEvent(QPaintEvent*) {
 				p.drawRect(highlightRect);
 			}
 
+			if (m_gridRecommendRow >= 0 && m_gridRecommendCol >= 0) {
+				const QRectF recommendRect(imageRect.left() + m_gridRecommendCol * cellWidth,
+				                           imageRect.top() + m_gridRecommendRow * cellHeight,
+				                           cellWidth,
+				                           cellHeight);
+				QPen recommendPen(QColor(255, 184, 64, 230));
+				recommendPen.setWidthF(2.5);
+				recommendPen.setStyle(Qt::DashLine);
+				p.setPen(recommendPen);
+				p.drawRect(recommendRect.adjusted(3.0, 3.0, -3.0, -3.0));
+				if (!m_gridRecommendLabel.isEmpty()) {
+					p.setPen(QColor(255, 200, 96, 240));
+					p.drawText(recommendRect.adjusted(8.0, 6.0, -8.0, -6.0),
+					           Qt::AlignTop | Qt::AlignHCenter,
+					           m_gridRecommendLabel);
+				}
+			}
+
 			QPen gridPen(QColor(168, 182, 210, 140));
 			gridPen.setWidthF(1.2);
 			p.setPen(gridPen);
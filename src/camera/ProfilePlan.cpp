@@ -0,0 +1,415 @@
+#include "camera/ProfilePlan.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLocale>
+#include <QObject>
+#include <QSet>
+#include <QXmlStreamReader>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+std::optional<bool> parseBool(const QString& raw) {
+    const QString normalized = raw.trimmed().toLower();
+    if (normalized == QStringLiteral("1") || normalized == QStringLiteral("true") || normalized == QStringLiteral("on") || normalized == QStringLiteral("yes")) {
+        return true;
+    }
+    if (normalized == QStringLiteral("0") || normalized == QStringLiteral("false") || normalized == QStringLiteral("off") || normalized == QStringLiteral("no")) {
+        return false;
+    }
+    bool ok = false;
+    const int asInt = QLocale::c().toInt(normalized, &ok);
+    if (ok) {
+        return asInt != 0;
+    }
+    return std::nullopt;
+}
+
+QString scopeKey(const std::vector<ProfileSelector>& selectors) {
+    QString key;
+    for (const auto& selector : selectors) {
+        key += selector.name + QLatin1Char('=') + selector.value + QLatin1Char(';');
+    }
+    return key;
+}
+
+void parseEntries(QXmlStreamReader& xml,
+                  std::vector<ProfileSelector>& scope,
+                  std::vector<ProfileEntry>& entries) {
+    while (xml.readNextStartElement()) {
+        const auto attributes = xml.attributes();
+        if (xml.name() == QLatin1String("Feature")) {
+            ProfileEntry entry;
+            entry.name = attributes.value(QStringLiteral("Name")).toString();
+            entry.type = profileValueTypeFromString(attributes.value(QStringLiteral("Type")).toString());
+            entry.value = attributes.value(QStringLiteral("Value")).toString();
+            entry.selectors = scope;
+            if (!entry.name.isEmpty() && entry.type != ProfileValueType::Unsupported) {
+                entries.push_back(std::move(entry));
+            }
+            xml.skipCurrentElement();
+        } else if (xml.name() == QLatin1String("SelectorGroup")) {
+            scope.push_back({attributes.value(QStringLiteral("Name")).toString(),
+                             profileValueTypeFromString(attributes.value(QStringLiteral("Type")).toString()),
+                             attributes.value(QStringLiteral("Value")).toString()});
+            parseEntries(xml, scope, entries);
+            scope.pop_back();
+        } else if (xml.name() == QLatin1String("RemoteDevice")) {
+            // Camera features live in the remote device module; LocalDevice holds
+            // transport-layer identity that is not written back.
+            parseEntries(xml, scope, entries);
+        } else {
+            xml.skipCurrentElement();
+        }
+    }
+}
+
+// Plain features first, scoped features grouped by scope (stable), then the plain
+// writes to features that also act as selectors.
+void orderEntries(std::vector<ProfileEntry>& entries) {
+    QSet<QString> selectorNames;
+    for (const auto& entry : entries) {
+        for (const auto& selector : entry.selectors) {
+            selectorNames.insert(selector.name);
+        }
+    }
+    auto rank = [&](const ProfileEntry& entry) {
+        if (!entry.selectors.empty()) {
+            return 1;
+        }
+        return selectorNames.contains(entry.name) ? 2 : 0;
+    };
+    std::vector<QString> scopeOrder;
+    QHash<QString, int> scopeIndex;
+    for (const auto& entry : entries) {
+        const QString key = scopeKey(entry.selectors);
+        if (!scopeIndex.contains(key)) {
+            scopeIndex.insert(key, static_cast<int>(scopeOrder.size()));
+            scopeOrder.push_back(key);
+        }
+    }
+    std::stable_sort(entries.begin(), entries.end(), [&](const ProfileEntry& a, const ProfileEntry& b) {
+        const int ra = rank(a);
+        const int rb = rank(b);
+        if (ra != rb) {
+            return ra < rb;
+        }
+        if (ra == 1) {
+            return scopeIndex.value(scopeKey(a.selectors)) < scopeIndex.value(scopeKey(b.selectors));
+        }
+        return false;
+    });
+}
+
+struct Executor {
+    const ProfilePlan& plan;
+    FeatureBackend& backend;
+    ProfileApplyReport& report;
+    QHash<QString, QString> selectorState; // last known value of every selector the plan touches
+
+    bool selectScope(const std::vector<ProfileSelector>& selectors) {
+        for (const auto& selector : selectors) {
+            const auto it = selectorState.constFind(selector.name);
+            if (it != selectorState.constEnd() && profileValuesEqual(selector.type, it.value(), selector.value)) {
+                continue;
+            }
+            QString error;
+            if (!backend.writeFeature(selector.name, selector.type, selector.value, &error)) {
+                report.warnings << QObject::tr("无法切换选择器 %1=%2：%3").arg(selector.name, selector.value, error);
+                selectorState.remove(selector.name);
+                return false;
+            }
+            selectorState.insert(selector.name, selector.value);
+        }
+        return true;
+    }
+
+    // Writes the entries whose current value differs; returns the indices that
+    // failed and are worth another pass.
+    std::vector<size_t> applyGroup(const std::vector<size_t>& group) {
+        std::vector<size_t> retry;
+        QStringList names;
+        names.reserve(static_cast<int>(group.size()));
+        for (size_t index : group) {
+            names << plan.entries[index].name;
+        }
+        const std::vector<FeatureState> states = backend.readFeatures(names);
+        for (size_t i = 0; i < group.size(); ++i) {
+            const ProfileEntry& entry = plan.entries[group[i]];
+            const FeatureState state = i < states.size() ? states[i] : FeatureState {};
+            if (!state.exists) {
+                report.warnings << QObject::tr("特性 %1 未找到，已跳过").arg(entry.name);
+                ++report.failed;
+                continue;
+            }
+            if (entry.type == ProfileValueType::Command) {
+                const auto run = parseBool(entry.value);
+                if (!run.value_or(false) || !state.writable) {
+                    ++report.unchanged;
+                    continue;
+                }
+            } else if (profileValuesEqual(entry.type, state.value, entry.value)) {
+                ++report.unchanged;
+                if (selectorState.contains(entry.name)) {
+                    selectorState.insert(entry.name, entry.value);
+                }
+                continue;
+            }
+            if (!state.writable) {
+                // Often writable only once a feature it depends on has been written.
+                retry.push_back(group[i]);
+                continue;
+            }
+            QString error;
+            if (backend.writeFeature(entry.name, entry.type, entry.value, &error)) {
+                ++report.written;
+                if (selectorState.contains(entry.name)) {
+                    selectorState.insert(entry.name, entry.value);
+                }
+            } else {
+                retry.push_back(group[i]);
+            }
+        }
+        return retry;
+    }
+
+    // Splits indices into runs that share a selector scope and applies each run.
+    std::vector<size_t> applyPass(const std::vector<size_t>& indices,
+                                  const std::function<void(int)>& advance,
+                                  const std::atomic_bool* cancel) {
+        std::vector<size_t> retry;
+        size_t begin = 0;
+        while (begin < indices.size()) {
+            if (cancel && cancel->load(std::memory_order_acquire)) {
+                report.cancelled = true;
+                retry.insert(retry.end(), indices.begin() + static_cast<std::ptrdiff_t>(begin), indices.end());
+                return retry;
+            }
+            const QString key = scopeKey(plan.entries[indices[begin]].selectors);
+            size_t end = begin + 1;
+            while (end < indices.size() && scopeKey(plan.entries[indices[end]].selectors) == key) {
+                ++end;
+            }
+            const std::vector<size_t> group(indices.begin() + static_cast<std::ptrdiff_t>(begin),
+                                            indices.begin() + static_cast<std::ptrdiff_t>(end));
+            if (selectScope(plan.entries[group.front()].selectors)) {
+                const auto failed = applyGroup(group);
+                retry.insert(retry.end(), failed.begin(), failed.end());
+            } else {
+                retry.insert(retry.end(), group.begin(), group.end());
+            }
+            advance(static_cast<int>(end - begin));
+            begin = end;
+        }
+        return retry;
+    }
+};
+
+} // namespace
+
+ProfileValueType profileValueTypeFromString(const QString& type) {
+    const QString normalized = type.trimmed().toLower();
+    if (normalized == QStringLiteral("int")) {
+        return ProfileValueType::Int;
+    }
+    if (normalized == QStringLiteral("float")) {
+        return ProfileValueType::Float;
+    }
+    if (normalized == QStringLiteral("bool")) {
+        return ProfileValueType::Bool;
+    }
+    if (normalized == QStringLiteral("enum")) {
+        return ProfileValueType::Enum;
+    }
+    if (normalized == QStringLiteral("string")) {
+        return ProfileValueType::String;
+    }
+    if (normalized == QStringLiteral("command")) {
+        return ProfileValueType::Command;
+    }
+    return ProfileValueType::Unsupported;
+}
+
+bool profileValuesEqual(ProfileValueType type, const QString& a, const QString& b) {
+    switch (type) {
+    case ProfileValueType::Int: {
+        bool okA = false;
+        bool okB = false;
+        const qint64 va = QLocale::c().toLongLong(a.trimmed(), &okA);
+        const qint64 vb = QLocale::c().toLongLong(b.trimmed(), &okB);
+        return okA && okB && va == vb;
+    }
+    case ProfileValueType::Float: {
+        bool okA = false;
+        bool okB = false;
+        const double va = QLocale::c().toDouble(a.trimmed(), &okA);
+        const double vb = QLocale::c().toDouble(b.trimmed(), &okB);
+        // Profiles store floats with ~7 significant digits.
+        return okA && okB && std::abs(va - vb) <= 1e-6 * std::max({1.0, std::abs(va), std::abs(vb)});
+    }
+    case ProfileValueType::Bool: {
+        const auto va = parseBool(a);
+        const auto vb = parseBool(b);
+        return va && vb && *va == *vb;
+    }
+    case ProfileValueType::Enum:
+        return a.compare(b, Qt::CaseInsensitive) == 0;
+    case ProfileValueType::String:
+        return a == b;
+    case ProfileValueType::Command:
+    case ProfileValueType::Unsupported:
+        return false;
+    }
+    return false;
+}
+
+std::optional<ProfilePlan> parseProfilePlan(QIODevice& device, const QString& cameraId, QString* error) {
+    QXmlStreamReader xml(&device);
+    ProfilePlan plan;
+    bool matched = false;
+    if (xml.readNextStartElement()) {
+        while (xml.readNextStartElement()) {
+            if (xml.name() == QLatin1String("SettingsStruct")) {
+                while (xml.readNextStartElement()) {
+                    if (xml.name() == QLatin1String("MaxIterations")) {
+                        bool ok = false;
+                        const int value = xml.attributes().value(QStringLiteral("Value")).toInt(&ok);
+                        if (ok && value > 0) {
+                            plan.maxIterations = value;
+                        }
+                    }
+                    xml.skipCurrentElement();
+                }
+            } else if (xml.name() == QLatin1String("CameraInfo") && !matched) {
+                const QString idAttr = xml.attributes().value(QStringLiteral("Id")).toString();
+                if (cameraId.isEmpty() || idAttr.compare(cameraId, Qt::CaseInsensitive) == 0) {
+                    matched = true;
+                    plan.cameraId = idAttr;
+                    plan.model = xml.attributes().value(QStringLiteral("Model")).toString();
+                    std::vector<ProfileSelector> scope;
+                    parseEntries(xml, scope, plan.entries);
+                } else {
+                    xml.skipCurrentElement();
+                }
+            } else {
+                xml.skipCurrentElement();
+            }
+        }
+    }
+    if (xml.hasError()) {
+        if (error) {
+            *error = xml.errorString();
+        }
+        return std::nullopt;
+    }
+    if (!matched) {
+        if (error) {
+            *error = QObject::tr("未找到匹配当前相机的配置");
+        }
+        return std::nullopt;
+    }
+    orderEntries(plan.entries);
+    return plan;
+}
+
+std::optional<ProfilePlan> loadProfilePlan(const QString& directory, const QString& cameraId, QString* error) {
+    const QDir dir(directory);
+    if (!dir.exists()) {
+        if (error) {
+            *error = QObject::tr("配置目录不存在：%1").arg(QDir::toNativeSeparators(directory));
+        }
+        return std::nullopt;
+    }
+    const QStringList filters{QStringLiteral("*.xml"), QStringLiteral("*.XML")};
+    const QFileInfoList files = dir.entryInfoList(filters, QDir::Files | QDir::Readable, QDir::Name);
+    if (files.isEmpty()) {
+        if (error) {
+            *error = QObject::tr("未在 %1 中找到配置文件").arg(dir.absolutePath());
+        }
+        return std::nullopt;
+    }
+    for (const QFileInfo& info : files) {
+        QFile file(info.absoluteFilePath());
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            continue;
+        }
+        if (auto plan = parseProfilePlan(file, cameraId)) {
+            plan->sourceFile = info.fileName();
+            return plan;
+        }
+    }
+    if (error) {
+        *error = QObject::tr("未找到匹配当前相机的配置文件");
+    }
+    return std::nullopt;
+}
+
+ProfileApplyReport applyProfilePlan(const ProfilePlan& plan,
+                                    FeatureBackend& backend,
+                                    const std::function<void(int, int)>& progress,
+                                    const std::atomic_bool* cancel) {
+    ProfileApplyReport report;
+    report.total = static_cast<int>(plan.entries.size());
+    if (plan.entries.empty()) {
+        return report;
+    }
+
+    Executor executor{plan, backend, report, {}};
+    QStringList selectorNames;
+    for (const auto& entry : plan.entries) {
+        for (const auto& selector : entry.selectors) {
+            if (!selectorNames.contains(selector.name)) {
+                selectorNames << selector.name;
+            }
+        }
+    }
+    if (!selectorNames.isEmpty()) {
+        const auto states = backend.readFeatures(selectorNames);
+        for (int i = 0; i < selectorNames.size() && i < static_cast<int>(states.size()); ++i) {
+            if (states[static_cast<size_t>(i)].exists) {
+                executor.selectorState.insert(selectorNames[i], states[static_cast<size_t>(i)].value);
+            }
+        }
+    }
+
+    int done = 0;
+    auto advance = [&](int count) {
+        done += count;
+        if (progress) {
+            progress(std::min(done, report.total), report.total);
+        }
+    };
+    auto ignoreAdvance = [](int) {};
+
+    std::vector<size_t> pending(plan.entries.size());
+    for (size_t i = 0; i < pending.size(); ++i) {
+        pending[i] = i;
+    }
+    const int maxPasses = std::max(1, plan.maxIterations);
+    while (!pending.empty() && report.passes < maxPasses && !report.cancelled) {
+        const size_t before = pending.size();
+        if (report.passes == 0) {
+            pending = executor.applyPass(pending, advance, cancel);
+        } else {
+            pending = executor.applyPass(pending, ignoreAdvance, cancel);
+        }
+        ++report.passes;
+        if (pending.size() == before) {
+            break; // no write succeeded in this pass; further passes cannot help
+        }
+    }
+
+    if (!report.cancelled) {
+        for (size_t index : pending) {
+            const ProfileEntry& entry = plan.entries[index];
+            report.warnings << QObject::tr("写入 %1=%2 失败").arg(entry.name, entry.value);
+            ++report.failed;
+        }
+    }
+    return report;
+}
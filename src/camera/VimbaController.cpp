@@ -1,20 +1,24 @@
 #include "camera/VimbaController.h"
+#include "camera/ProfilePlan.h"
 #include "camera/Utils.h"
 
 #include <QDebug>
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QMetaObject>
+#include <QPointer>
 #include <QLocale>
-#include <QXmlStreamReader>
 #include <QStringList>
+#include <QtConcurrent/QtConcurrent>
 
 #include <opencv2/imgproc.hpp>
 
 #include <algorithm>
 #include <cmath>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
 
@@ -209,195 +213,128 @@ CameraPtr cameraById(const CameraPtrVector& cameras, const QString& id) {
     return CameraPtr();
 }
 
-FeaturePtr resolveFeature(VimbaController* controller, const QString& name) {
-    if (!controller || name.isEmpty()) {
-        return FeaturePtr();
-    }
-    const QByteArray utf8 = name.toUtf8();
-    return controller->feature(utf8.constData());
-}
-
-bool setFeatureValueFromString(const FeaturePtr& feature,
-                               const QString& rawValue,
-                               const QString& featureName,
-                               QStringList& warnings) {
-    if (!feature) {
-        warnings << QObject::tr("特性 %1 未找到，已跳过").arg(featureName);
-        return false;
-    }
-
-    VmbFeatureDataType dataType = VmbFeatureDataUnknown;
-    if (feature->GetDataType(dataType) != VmbErrorSuccess) {
-        warnings << QObject::tr("无法确定特性 %1 的数据类型").arg(featureName);
-        return false;
+// FeatureBackend over a live camera. Feature handles are resolved once from a single
+// GetFeatures() call instead of a GetFeatureByName() lookup per profile entry.
+class VimbaFeatureBackend : public FeatureBackend {
+public:
+    explicit VimbaFeatureBackend(const CameraPtr& cam) {
+        FeaturePtrVector features;
+        if (cam && cam->GetFeatures(features) == VmbErrorSuccess) {
+            m_features.reserve(static_cast<int>(features.size()));
+            for (const auto& feature : features) {
+                std::string name;
+                if (feature && feature->GetName(name) == VmbErrorSuccess) {
+                    m_features.insert(QString::fromStdString(name), feature);
+                }
+            }
+        }
     }
 
-    bool writable = false;
-    feature->IsWritable(writable);
-
-    auto addFailedWarning = [&](const QString& reason) {
-        warnings << QObject::tr("写入 %1 失败：%2").arg(featureName, reason);
-    };
-
-    VmbErrorType err = VmbErrorSuccess;
-    switch (dataType) {
-    case VmbFeatureDataInt: {
-        bool ok = false;
-        const qint64 desired = QLocale::c().toLongLong(rawValue, &ok);
-        if (!ok) {
-            addFailedWarning(QObject::tr("值 %1 无法转换为整数").arg(rawValue));
-            return false;
-        }
-        if (!writable) {
-            VmbInt64_t current = 0;
-            if (feature->GetValue(current) == VmbErrorSuccess && current == desired) {
-                return true;
+    std::vector<FeatureState> readFeatures(const QStringList& names) override {
+        std::vector<FeatureState> states;
+        states.reserve(static_cast<size_t>(names.size()));
+        for (const QString& name : names) {
+            FeatureState state;
+            const FeaturePtr feature = m_features.value(name);
+            VmbFeatureDataType dataType = VmbFeatureDataUnknown;
+            if (feature && feature->GetDataType(dataType) == VmbErrorSuccess) {
+                state.exists = true;
+                feature->IsWritable(state.writable);
+                state.value = readValue(feature, dataType);
             }
-            addFailedWarning(QObject::tr("特性为只读"));
-            return false;
+            states.push_back(std::move(state));
         }
-        err = feature->SetValue(static_cast<VmbInt64_t>(desired));
-        break;
+        return states;
     }
-    case VmbFeatureDataFloat: {
-        bool ok = false;
-        const double desired = QLocale::c().toDouble(rawValue, &ok);
-        if (!ok) {
-            addFailedWarning(QObject::tr("值 %1 无法转换为浮点数").arg(rawValue));
-            return false;
-        }
-        if (!writable) {
-            double current = 0.0;
-            if (feature->GetValue(current) == VmbErrorSuccess && std::abs(current - desired) < 1e-6) {
-                return true;
+
+    bool writeFeature(const QString& name, ProfileValueType type, const QString& value, QString* error) override {
+        const FeaturePtr feature = m_features.value(name);
+        if (!feature) {
+            if (error) {
+                *error = QObject::tr("特性未找到");
             }
-            addFailedWarning(QObject::tr("特性为只读"));
             return false;
         }
-        err = feature->SetValue(desired);
-        break;
-    }
-    case VmbFeatureDataBool: {
-        const QString normalized = rawValue.trimmed().toLower();
-        bool desired = false;
-        if (normalized == QStringLiteral("1") || normalized == QStringLiteral("true") || normalized == QStringLiteral("on") || normalized == QStringLiteral("yes")) {
-            desired = true;
-        } else if (normalized == QStringLiteral("0") || normalized == QStringLiteral("false") || normalized == QStringLiteral("off") || normalized == QStringLiteral("no")) {
-            desired = false;
-        } else {
-            bool ok = false;
-            const int asInt = QLocale::c().toInt(rawValue, &ok);
-            if (ok) {
-                desired = asInt != 0;
-            } else {
-                addFailedWarning(QObject::tr("值 %1 无法转换为布尔").arg(rawValue));
-                return false;
-            }
+        VmbErrorType err = VmbErrorSuccess;
+        bool ok = true;
+        switch (type) {
+        case ProfileValueType::Int:
+            err = feature->SetValue(static_cast<VmbInt64_t>(QLocale::c().toLongLong(value.trimmed(), &ok)));
+            break;
+        case ProfileValueType::Float:
+            err = feature->SetValue(QLocale::c().toDouble(value.trimmed(), &ok));
+            break;
+        case ProfileValueType::Bool:
+            err = feature->SetValue(profileValuesEqual(ProfileValueType::Bool, value, QStringLiteral("1")));
+            break;
+        case ProfileValueType::Enum:
+        case ProfileValueType::String:
+            err = feature->SetValue(value.toStdString().c_str());
+            break;
+        case ProfileValueType::Command:
+            err = feature->RunCommand();
+            break;
+        case ProfileValueType::Unsupported:
+            ok = false;
+            break;
         }
-        if (!writable) {
-            bool current = false;
-            if (feature->GetValue(current) == VmbErrorSuccess && current == desired) {
-                return true;
+        if (!ok) {
+            if (error) {
+                *error = QObject::tr("值 %1 无法转换").arg(value);
             }
-            addFailedWarning(QObject::tr("特性为只读"));
             return false;
         }
-        err = feature->SetValue(desired);
-        break;
-    }
-    case VmbFeatureDataEnum: {
-        std::string desired = rawValue.toStdString();
-        if (!writable) {
-            std::string current;
-            if (feature->GetValue(current) == VmbErrorSuccess && QString::fromStdString(current).compare(rawValue, Qt::CaseInsensitive) == 0) {
-                return true;
+        if (err != VmbErrorSuccess) {
+            if (error) {
+                *error = errorToQString(err);
             }
-            addFailedWarning(QObject::tr("特性为只读"));
             return false;
         }
-        err = feature->SetValue(desired.c_str());
-        break;
+        return true;
     }
-    case VmbFeatureDataString: {
-        std::string desired = rawValue.toStdString();
-        if (!writable) {
-            std::string current;
-            if (feature->GetValue(current) == VmbErrorSuccess && QString::fromStdString(current) == rawValue) {
-                return true;
-            }
-            addFailedWarning(QObject::tr("特性为只读"));
-            return false;
+
+private:
+    QHash<QString, FeaturePtr> m_features;
+
+    static QString readValue(const FeaturePtr& feature, VmbFeatureDataType dataType) {
+        switch (dataType) {
+        case VmbFeatureDataInt: {
+            VmbInt64_t value = 0;
+            return feature->GetValue(value) == VmbErrorSuccess ? QString::number(value) : QString();
         }
-        err = feature->SetValue(desired.c_str());
-        break;
-    }
-    case VmbFeatureDataCommand: {
-        if (!writable) {
-            return false;
+        case VmbFeatureDataFloat: {
+            double value = 0.0;
+            return feature->GetValue(value) == VmbErrorSuccess ? QString::number(value, 'g', 17) : QString();
         }
-        const QString normalized = rawValue.trimmed().toLower();
-        if (normalized == QStringLiteral("1") || normalized == QStringLiteral("true") || normalized == QStringLiteral("run") || normalized == QStringLiteral("execute")) {
-            err = feature->RunCommand();
+        case VmbFeatureDataBool: {
+            bool value = false;
+            return feature->GetValue(value) == VmbErrorSuccess ? QString::number(value ? 1 : 0) : QString();
         }
-        break;
-    }
-    default:
-        addFailedWarning(QObject::tr("不支持的数据类型"));
-        return false;
-    }
-
-    if (err != VmbErrorSuccess) {
-        addFailedWarning(errorToQString(err));
-        return false;
-    }
-    return true;
-}
-
-void applyFeatureElement(QXmlStreamReader& xml,
-                         VimbaController* controller,
-                         QStringList& warnings) {
-    const QString featureName = xml.attributes().value(QStringLiteral("Name")).toString();
-    const QString featureValue = xml.attributes().value(QStringLiteral("Value")).toString();
-    if (!featureName.isEmpty()) {
-        const FeaturePtr feature = resolveFeature(controller, featureName);
-        setFeatureValueFromString(feature, featureValue, featureName, warnings);
-    }
-    xml.skipCurrentElement();
-}
-
-void applySelectorGroup(QXmlStreamReader& xml,
-                        VimbaController* controller,
-                        QStringList& warnings) {
-    const QString selectorName = xml.attributes().value(QStringLiteral("Name")).toString();
-    const QString selectorValue = xml.attributes().value(QStringLiteral("Value")).toString();
-    if (!selectorName.isEmpty()) {
-        const FeaturePtr selectorFeature = resolveFeature(controller, selectorName);
-        setFeatureValueFromString(selectorFeature, selectorValue, selectorName, warnings);
-    }
-
-    while (xml.readNextStartElement()) {
-        if (xml.name() == QLatin1String("Feature")) {
-            applyFeatureElement(xml, controller, warnings);
-        } else if (xml.name() == QLatin1String("SelectorGroup")) {
-            applySelectorGroup(xml, controller, warnings);
-        } else {
-            xml.skipCurrentElement();
+        case VmbFeatureDataEnum:
+        case VmbFeatureDataString: {
+            std::string value;
+            return feature->GetValue(value) == VmbErrorSuccess ? QString::fromStdString(value) : QString();
+        }
+        default:
+            return {};
         }
     }
-}
+};
 
-void applyCameraInfo(QXmlStreamReader& xml,
-                     VimbaController* controller,
-                     QStringList& warnings) {
-    while (xml.readNextStartElement()) {
-        if (xml.name() == QLatin1String("Feature")) {
-            applyFeatureElement(xml, controller, warnings);
-        } else if (xml.name() == QLatin1String("SelectorGroup")) {
-            applySelectorGroup(xml, controller, warnings);
-        } else {
-            xml.skipCurrentElement();
-        }
+QString describeProfileReport(const ProfilePlan& plan, const ProfileApplyReport& report) {
+    if (report.cancelled) {
+        return QObject::tr("配置文件 %1 应用已取消").arg(plan.sourceFile);
+    }
+    if (report.failed == 0) {
+        return QObject::tr("已应用配置文件 %1（写入 %2 项，%3 项无需更改）")
+            .arg(plan.sourceFile)
+            .arg(report.written)
+            .arg(report.unchanged);
     }
+    return QObject::tr("已应用配置文件 %1（写入 %2 项，跳过 %3 项）")
+        .arg(plan.sourceFile)
+        .arg(report.written)
+        .arg(report.failed);
 }
 
 } // namespace
@@ -497,6 +434,7 @@ void VimbaController::close() {
         return;
     }
 
+    waitForProfile(true);
     stop();
 
     try {
@@ -518,6 +456,8 @@ bool VimbaController::start() {
     if (m_running.loadAcquire()) {
         return true;
     }
+    // Profile writes (Width, PixelFormat, ...) are locked while acquiring.
+    waitForProfile();
 
     try {
         m_frames.clear();
@@ -639,84 +579,100 @@ bool VimbaController::applyConfigurationProfile(const QString& directory,
         }
         return false;
     }
+    waitForProfile();
 
-    QDir dir(directory);
-    if (!dir.exists()) {
+    QString error;
+    const auto plan = loadProfilePlan(directory, resolveProfileCameraId(cameraId), &error);
+    if (!plan) {
         if (statusMessage) {
-            *statusMessage = QObject::tr("配置目录不存在：%1").arg(QDir::toNativeSeparators(directory));
+            *statusMessage = error;
         }
         return false;
     }
 
-    QString effectiveCameraId = cameraId;
-    if (effectiveCameraId.isEmpty()) {
-        std::string currentId;
-        if (m_cam->GetID(currentId) == VmbErrorSuccess) {
-            effectiveCameraId = QString::fromLocal8Bit(currentId.c_str());
-        }
+    VimbaFeatureBackend backend(m_cam);
+    const ProfileApplyReport report = applyProfilePlan(*plan, backend);
+    for (const QString& warning : report.warnings) {
+        qWarning() << "配置写入警告:" << warning;
     }
+    if (statusMessage) {
+        *statusMessage = describeProfileReport(*plan, report);
+    }
+    return true;
+}
 
-    const QStringList filters{QStringLiteral("*.xml"), QStringLiteral("*.XML")};
-    const QFileInfoList files = dir.entryInfoList(filters, QDir::Files | QDir::Readable, QDir::Name);
-    if (files.isEmpty()) {
-        if (statusMessage) {
-            *statusMessage = QObject::tr("未在 %1 中找到配置文件").arg(dir.absolutePath());
-        }
+bool VimbaController::applyConfigurationProfileAsync(const QString& directory, const QString& cameraId) {
+    if (!m_cam) {
         return false;
     }
+    waitForProfile();
 
-    for (const QFileInfo& info : files) {
-        QFile file(info.absoluteFilePath());
-        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qWarning() << "无法读取配置文件" << info.absoluteFilePath();
-            continue;
-        }
-
-        QXmlStreamReader xml(&file);
-        bool matchedCamera = false;
-        QStringList warnings;
+    QString error;
+    auto plan = loadProfilePlan(directory, resolveProfileCameraId(cameraId), &error);
+    if (!plan) {
+        Q_EMIT profileApplied(false, error);
+        return false;
+    }
 
-        while (xml.readNextStartElement()) {
-            if (xml.name() == QLatin1String("CameraInfo")) {
-                const QString idAttr = xml.attributes().value(QStringLiteral("Id")).toString();
-                if (effectiveCameraId.isEmpty() || idAttr.compare(effectiveCameraId, Qt::CaseInsensitive) == 0) {
-                    matchedCamera = true;
-                    applyCameraInfo(xml, this, warnings);
-                    break;
-                }
-                xml.skipCurrentElement();
-            } else {
-                xml.skipCurrentElement();
+    m_profileCancel.store(false, std::memory_order_release);
+    if (!m_profileWatcher) {
+        m_profileWatcher = new QFutureWatcher<void>(this);
+    }
+    auto shared = std::make_shared<std::pair<ProfilePlan, ProfileApplyReport>>(std::move(*plan), ProfileApplyReport{});
+    const CameraPtr cam = m_cam;
+    QPointer<VimbaController> self(this);
+    m_profileWatcher->disconnect(this);
+    connect(m_profileWatcher, &QFutureWatcher<void>::finished, this, [this, shared]() {
+        for (const QString& warning : shared->second.warnings) {
+            qWarning() << "配置写入警告:" << warning;
+        }
+        Q_EMIT profileApplied(!shared->second.cancelled, describeProfileReport(shared->first, shared->second));
+    });
+    m_profileWatcher->setFuture(QtConcurrent::run([this, self, cam, shared]() {
+        VimbaFeatureBackend backend(cam);
+        int lastPercent = -1;
+        shared->second = applyProfilePlan(shared->first, backend, [&](int done, int total) {
+            const int percent = total > 0 ? done * 100 / total : 100;
+            if (percent == lastPercent) {
+                return;
             }
-        }
+            lastPercent = percent;
+            QMetaObject::invokeMethod(
+                self.data(),
+                [self, done, total]() {
+                    if (self) {
+                        Q_EMIT self->profileProgress(done, total);
+                    }
+                },
+                Qt::QueuedConnection);
+        }, &m_profileCancel);
+    }));
+    return true;
+}
 
-        if (matchedCamera && !xml.hasError()) {
-            if (!warnings.isEmpty()) {
-                for (const QString& warning : std::as_const(warnings)) {
-                    qWarning() << "配置写入警告:" << warning;
-                }
-            }
-            if (statusMessage) {
-                if (warnings.isEmpty()) {
-                    *statusMessage = QObject::tr("已应用配置文件 %1").arg(info.fileName());
-                } else {
-                    *statusMessage = QObject::tr("已应用配置文件 %1（跳过 %2 项）")
-                                         .arg(info.fileName())
-                                         .arg(warnings.size());
-                }
-            }
-            return true;
-        }
+bool VimbaController::isApplyingProfile() const {
+    return m_profileWatcher && m_profileWatcher->isRunning();
+}
 
-        if (matchedCamera && xml.hasError()) {
-            qWarning() << "配置文件解析失败" << info.absoluteFilePath() << ":" << xml.errorString();
-        }
+void VimbaController::waitForProfile(bool cancel) {
+    if (!isApplyingProfile()) {
+        return;
+    }
+    if (cancel) {
+        m_profileCancel.store(true, std::memory_order_release);
     }
+    m_profileWatcher->waitForFinished();
+}
 
-    if (statusMessage && !files.isEmpty()) {
-        *statusMessage = QObject::tr("未找到匹配当前相机的配置文件");
+QString VimbaController::resolveProfileCameraId(const QString& cameraId) const {
+    if (!cameraId.isEmpty() || !m_cam) {
+        return cameraId;
+    }
+    std::string currentId;
+    if (m_cam->GetID(currentId) == VmbErrorSuccess) {
+        return QString::fromLocal8Bit(currentId.c_str());
     }
-    return false;
+    return {};
 }
 
 
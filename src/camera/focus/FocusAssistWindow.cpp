@@ -1,6 +1,8 @@
 #include "camera/focus/FocusAssistWindow.h"
 
 #include "camera/focus/FocusEvaluator.h"
+#include "camera/focus/FocusHistoryModel.h"
+#include "camera/focus/FocusSparkline.h"
 #include "camera/ImageView.h"
 #include "camera/Utils.h"
 #include "camera/VimbaController.h"
@@ -21,8 +23,7 @@
 #include <QSize>
 #include <QSizePolicy>
 #include <QStatusBar>
-#include <QTableWidget>
-#include <QTableWidgetItem>
+#include <QTableView>
 #include <QTextBrowser>
 #include <QToolBar>
 #include <QVBoxLayout>
@@ -165,8 +166,24 @@ void FocusAssistWindow::buildUi() {
 
     rightColumn->addWidget(metricsBox);
 
-    m_historyTable = new QTableWidget(0, 8, central);
-    m_historyTable->setHorizontalHeaderLabels({tr("时间"), tr("评分"), tr("Laplacian"), tr("Tenengrad"), tr("高频能量"), tr("方向均衡"), tr("对比度"), tr("均值")});
+    m_sparkline = new FocusSparkline(central);
+    rightColumn->addWidget(m_sparkline);
+
+    m_historyModel = new FocusHistoryModel({{FocusHistoryModel::Field::Time, tr("时间"), 0},
+                                            {FocusHistoryModel::Field::Score, tr("评分"), 1},
+                                            {FocusHistoryModel::Field::Laplacian, tr("Laplacian"), 2},
+                                            {FocusHistoryModel::Field::Tenengrad, tr("Tenengrad"), 2},
+                                            {FocusHistoryModel::Field::HighFrequency, tr("高频能量"), 1},
+                                            {FocusHistoryModel::Field::Uniformity, tr("方向均衡"), 1},
+                                            {FocusHistoryModel::Field::Contrast, tr("对比度"), 2},
+                                            {FocusHistoryModel::Field::Mean, tr("均值"), 1}},
+                                           m_historyLimit,
+                                           this);
+    m_sparkline->setModel(m_historyModel);
+
+    m_historyTable = new QTableView(central);
+    m_historyTable->setModel(m_historyModel);
+    m_historyTable->verticalHeader()->setVisible(false);
     m_historyTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     m_historyTable->setSelectionBehavior(QAbstractItemView::SelectRows);
     m_historyTable->setSelectionMode(QAbstractItemView::SingleSelection);
@@ -296,6 +313,7 @@ void FocusAssistWindow::onMarkBest() {
     m_bestMetrics = m_lastMetrics;
     m_bestComposite = m_lastMetrics.compositeScore;
     m_hasBest = true;
+    m_sparkline->setReferenceValue(m_bestComposite);
     flashStatus(tr("已将当前评分 %1 设为参考基线")
                     .arg(QString::number(m_bestComposite, 'f', 1)),
                 2600);
@@ -304,8 +322,8 @@ void FocusAssistWindow::onMarkBest() {
 void FocusAssistWindow::onResetBaseline() {
     m_hasBest = false;
     m_bestComposite = 0.0;
-    m_history.clear();
-    updateHistoryTable();
+    m_historyModel->clear();
+    m_sparkline->setReferenceValue(0.0);
     m_scoreProgress->setValue(0);
     pushGuidance({tr("评分基线已重置，请重新开始调焦流程。")});
     flashStatus(tr("已重置历史记录"), 2000);
@@ -328,7 +346,7 @@ void FocusAssistWindow::updateActionStates() {
     m_actStart->setChecked(m_streaming);
     m_actStop->setChecked(hasController && m_streaming);
     m_actMarkBest->setEnabled(m_lastMetrics.valid);
-    m_actResetBaseline->setEnabled(m_hasBest || !m_history.empty());
+    m_actResetBaseline->setEnabled(m_hasBest || !m_historyModel->isEmpty());
     if (m_cameraCombo) {
         m_cameraCombo->setEnabled(!hasController);
     }
@@ -390,39 +408,11 @@ void FocusAssistWindow::applyMetrics(const FocusEvaluator::Metrics& metrics) {
 }
 
 void FocusAssistWindow::appendHistory(const FocusEvaluator::Metrics& metrics) {
-    HistoryEntry entry;
-    entry.timestamp = QDateTime::currentDateTime();
-    entry.metrics = metrics;
-    m_history.push_front(entry);
-    while (static_cast<int>(m_history.size()) > m_historyLimit) {
-        m_history.pop_back();
-    }
-    updateHistoryTable();
+    m_historyModel->push(metrics);
+    m_sparkline->setReferenceValue(m_hasBest ? m_bestComposite : 0.0);
     m_actResetBaseline->setEnabled(true);
 }
 
-void FocusAssistWindow::updateHistoryTable() {
-    m_historyTable->setRowCount(static_cast<int>(m_history.size()));
-    for (int row = 0; row < static_cast<int>(m_history.size()); ++row) {
-        const auto& entry = m_history[row];
-        const auto timeStr = entry.timestamp.toString(QStringLiteral("HH:mm:ss"));
-        const auto addItem = [&](int column, const QString& text) {
-            auto* item = new QTableWidgetItem(text);
-            item->setTextAlignment(Qt::AlignCenter);
-            m_historyTable->setItem(row, column, item);
-        };
-        addItem(0, timeStr);
-        addItem(1, QString::number(entry.metrics.compositeScore, 'f', 1));
-        addItem(2, QString::number(entry.metrics.laplacianVariance, 'f', 2));
-        addItem(3, QString::number(entry.metrics.tenengrad, 'f', 2));
-        addItem(4, QString::number(entry.metrics.highFrequencyRatio * 100.0, 'f', 1));
-        addItem(5, QString::number(entry.metrics.gradientUniformity * 100.0, 'f', 1));
-        addItem(6, QString::number(entry.metrics.contrast, 'f', 2));
-        addItem(7, QString::number(entry.metrics.meanIntensity, 'f', 1));
-    }
-    m_historyTable->scrollToTop();
-}
-
 QStringList FocusAssistWindow::buildGuidance(const FocusEvaluator::Metrics& metrics, double previousComposite) const {
     QStringList lines;
     const double relative = (m_hasBest && m_bestComposite > 0.0)
@@ -0,0 +1,95 @@
+#include "camera/focus/FocusHistoryModel.h"
+
+#include <algorithm>
+
+FocusHistoryModel::FocusHistoryModel(const QVector<Column>& columns, int capacity, QObject* parent)
+    : QAbstractTableModel(parent)
+    , m_columns(columns)
+    , m_ring(static_cast<size_t>(std::max(1, capacity))) {}
+
+void FocusHistoryModel::push(const FocusEvaluator::Metrics& metrics, const QDateTime& timestamp) {
+    const int ringSize = capacity();
+    if (m_count == ringSize) {
+        beginRemoveRows(QModelIndex(), m_count - 1, m_count - 1);
+        --m_count;
+        endRemoveRows();
+    }
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_head = (m_head + 1) % ringSize;
+    m_ring[static_cast<size_t>(m_head)] = Entry{timestamp, metrics};
+    ++m_count;
+    endInsertRows();
+}
+
+void FocusHistoryModel::clear() {
+    if (m_count == 0) {
+        return;
+    }
+    beginResetModel();
+    m_head = -1;
+    m_count = 0;
+    endResetModel();
+}
+
+const FocusHistoryModel::Entry& FocusHistoryModel::entry(int row) const {
+    const int ringSize = capacity();
+    return m_ring[static_cast<size_t>(((m_head - row) % ringSize + ringSize) % ringSize)];
+}
+
+int FocusHistoryModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_count;
+}
+
+int FocusHistoryModel::columnCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : m_columns.size();
+}
+
+QVariant FocusHistoryModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid() || index.row() >= m_count || index.column() >= m_columns.size()) {
+        return {};
+    }
+    if (role == Qt::TextAlignmentRole) {
+        return QVariant::fromValue(Qt::Alignment(Qt::AlignCenter));
+    }
+    if (role != Qt::DisplayRole) {
+        return {};
+    }
+
+    const Column& column = m_columns.at(index.column());
+    const Entry& item = entry(index.row());
+    const FocusEvaluator::Metrics& m = item.metrics;
+    double value = 0.0;
+    switch (column.field) {
+    case Field::Time:
+        return item.timestamp.toLocalTime().toString(QStringLiteral("HH:mm:ss"));
+    case Field::Score:
+        value = m.compositeScore;
+        break;
+    case Field::Laplacian:
+        value = m.laplacianVariance;
+        break;
+    case Field::Tenengrad:
+        value = m.tenengrad;
+        break;
+    case Field::HighFrequency:
+        value = m.highFrequencyRatio * 100.0;
+        break;
+    case Field::Uniformity:
+        value = m.gradientUniformity * 100.0;
+        break;
+    case Field::Contrast:
+        value = m.contrast;
+        break;
+    case Field::Mean:
+        value = m.meanIntensity;
+        break;
+    }
+    return QString::number(value, 'f', column.decimals);
+}
+
+QVariant FocusHistoryModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole && section >= 0 && section < m_columns.size()) {
+        return m_columns.at(section).title;
+    }
+    return QAbstractTableModel::headerData(section, orientation, role);
+}
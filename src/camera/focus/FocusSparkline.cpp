@@ -0,0 +1,92 @@
+#include "camera/focus/FocusSparkline.h"
+
+#include "camera/focus/FocusHistoryModel.h"
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include <algorithm>
+
+FocusSparkline::FocusSparkline(QWidget* parent)
+    : QWidget(parent) {
+    setMinimumHeight(48);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+}
+
+void FocusSparkline::setModel(FocusHistoryModel* model) {
+    if (m_model) {
+        disconnect(m_model, nullptr, this, nullptr);
+    }
+    m_model = model;
+    if (m_model) {
+        const auto repaint = [this]() { update(); };
+        connect(m_model, &QAbstractItemModel::rowsInserted, this, repaint);
+        connect(m_model, &QAbstractItemModel::rowsRemoved, this, repaint);
+        connect(m_model, &QAbstractItemModel::modelReset, this, repaint);
+    }
+    update();
+}
+
+void FocusSparkline::setReferenceValue(double value) {
+    if (value == m_reference) {
+        return;
+    }
+    m_reference = value;
+    update();
+}
+
+void FocusSparkline::paintEvent(QPaintEvent*) {
+    QPainter p(this);
+    p.setRenderHint(QPainter::Antialiasing);
+
+    const QRectF area = QRectF(rect()).adjusted(4.0, 4.0, -4.0, -4.0);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(12, 20, 34, 150));
+    p.drawRoundedRect(rect(), 8, 8);
+
+    const int count = m_model ? m_model->size() : 0;
+    if (count < 2 || area.width() <= 0.0 || area.height() <= 0.0) {
+        return;
+    }
+
+    double low = m_model->entry(0).metrics.compositeScore;
+    double high = low;
+    for (int row = 1; row < count; ++row) {
+        const double score = m_model->entry(row).metrics.compositeScore;
+        low = std::min(low, score);
+        high = std::max(high, score);
+    }
+    if (m_reference > 0.0) {
+        low = std::min(low, m_reference);
+        high = std::max(high, m_reference);
+    }
+    const double span = std::max(high - low, 1e-6);
+    const double step = area.width() / static_cast<double>(m_model->capacity() - 1);
+    const auto yFor = [&](double score) {
+        return area.bottom() - (score - low) / span * area.height();
+    };
+
+    if (m_reference > 0.0) {
+        p.setPen(QPen(QColor(255, 204, 72, 160), 1.0, Qt::DashLine));
+        p.drawLine(QPointF(area.left(), yFor(m_reference)), QPointF(area.right(), yFor(m_reference)));
+    }
+
+    // Newest sample pinned to the right edge; history fills leftwards as it grows.
+    QPainterPath path;
+    for (int row = count - 1; row >= 0; --row) {
+        const QPointF point(area.right() - row * step, yFor(m_model->entry(row).metrics.compositeScore));
+        if (row == count - 1) {
+            path.moveTo(point);
+        } else {
+            path.lineTo(point);
+        }
+    }
+    p.setPen(QPen(QColor(82, 229, 255), 1.6));
+    p.setBrush(Qt::NoBrush);
+    p.drawPath(path);
+
+    const QPointF newest(area.right(), yFor(m_model->entry(0).metrics.compositeScore));
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(92, 125, 255));
+    p.drawEllipse(newest, 3.0, 3.0);
+}
@@ -1,5 +1,8 @@
 #include "camera/focus/FocusSummaryPanel.h"
 
+#include "camera/focus/FocusHistoryModel.h"
+#include "camera/focus/FocusSparkline.h"
+
 #include <QAbstractItemView>
 #include <QGridLayout>
 #include <QHeaderView>
@@ -7,8 +10,7 @@
 #include <QLabel>
 #include <QProgressBar>
 #include <QPushButton>
-#include <QTableWidget>
-#include <QTableWidgetItem>
+#include <QTableView>
 #include <QTextBrowser>
 #include <QVBoxLayout>
 #include <QSizePolicy>
@@ -157,8 +159,22 @@ void FocusSummaryPanel::buildUi() {
     connect(m_markBestButton, &QPushButton::clicked, this, &FocusSummaryPanel::handleMarkBest);
     connect(m_resetBaselineButton, &QPushButton::clicked, this, &FocusSummaryPanel::handleResetBaseline);
 
-    m_historyTable = new QTableWidget(0, 6, this);
-    m_historyTable->setHorizontalHeaderLabels({tr("时间"), tr("评分"), tr("Laplacian"), tr("Sobel"), tr("高频"), tr("对比度")});
+    m_sparkline = new FocusSparkline(this);
+    root->addWidget(m_sparkline);
+
+    m_historyModel = new FocusHistoryModel({{FocusHistoryModel::Field::Time, tr("时间"), 0},
+                                            {FocusHistoryModel::Field::Score, tr("评分"), 1},
+                                            {FocusHistoryModel::Field::Laplacian, tr("Laplacian"), 1},
+                                            {FocusHistoryModel::Field::Tenengrad, tr("Sobel"), 1},
+                                            {FocusHistoryModel::Field::HighFrequency, tr("高频"), 1},
+                                            {FocusHistoryModel::Field::Contrast, tr("对比度"), 2}},
+                                           m_historyLimit,
+                                           this);
+    m_sparkline->setModel(m_historyModel);
+
+    m_historyTable = new QTableView(this);
+    m_historyTable->setModel(m_historyModel);
+    m_historyTable->verticalHeader()->setVisible(false);
     m_historyTable->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
     m_historyTable->setSelectionMode(QAbstractItemView::NoSelection);
     m_historyTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
@@ -287,39 +303,20 @@ void FocusSummaryPanel::setRoiInfo(const QSize& frameSize, const QRect& roi) {
 }
 
 void FocusSummaryPanel::pushHistory(const FocusEvaluator::Metrics& metrics) {
-    HistoryEntry entry;
-    entry.timestamp = QDateTime::currentDateTime();
-    entry.metrics = metrics;
-    m_history.push_front(entry);
-    while (static_cast<int>(m_history.size()) > m_historyLimit) {
-        m_history.pop_back();
+    if (m_historyModel) {
+        m_historyModel->push(metrics);
+    }
+    if (m_sparkline) {
+        m_sparkline->setReferenceValue(m_hasBaseline ? m_bestComposite : 0.0);
     }
-    refreshHistoryTable();
 }
 
-void FocusSummaryPanel::refreshHistoryTable() {
-    if (!m_historyTable) {
-        return;
+void FocusSummaryPanel::clearHistory() {
+    if (m_historyModel) {
+        m_historyModel->clear();
     }
-    m_historyTable->setRowCount(static_cast<int>(m_history.size()));
-    int row = 0;
-    for (const auto& entry : m_history) {
-        auto addItem = [&](int column, const QString& value) {
-            auto* item = new QTableWidgetItem(value);
-            item->setTextAlignment(Qt::AlignCenter);
-            m_historyTable->setItem(row, column, item);
-        };
-
-        addItem(0, entry.timestamp.toLocalTime().toString(QStringLiteral("HH:mm:ss")));
-        addItem(1, QString::number(entry.metrics.compositeScore, 'f', 1));
-    addItem(2, QString::number(entry.metrics.laplacianVariance, 'f', 1));
-    addItem(3, QString::number(entry.metrics.tenengrad, 'f', 1));
-        addItem(4, QString::number(entry.metrics.highFrequencyRatio * 100.0, 'f', 1));
-        addItem(5, QString::number(entry.metrics.contrast, 'f', 2));
-        ++row;
-    }
-    if (row > 0) {
-        m_historyTable->scrollToTop();
+    if (m_sparkline) {
+        m_sparkline->setReferenceValue(0.0);
     }
 }
 
@@ -393,6 +390,9 @@ void FocusSummaryPanel::handleMarkBest() {
     m_bestMetrics = m_lastMetrics;
     m_bestComposite = m_lastMetrics.compositeScore;
     m_hasBaseline = true;
+    if (m_sparkline) {
+        m_sparkline->setReferenceValue(m_bestComposite);
+    }
     updateButtons();
     if (m_guidanceBox) {
         m_guidanceBox->append(QStringLiteral("\n%1")
@@ -405,9 +405,8 @@ void FocusSummaryPanel::handleResetBaseline() {
     m_hasBaseline = false;
     m_bestComposite = 0.0;
     m_bestMetrics = FocusEvaluator::Metrics{};
-    m_history.clear();
     m_previousComposite = 0.0;
-    refreshHistoryTable();
+    clearHistory();
     updateButtons();
     if (m_guidanceBox) {
         m_guidanceBox->setPlainText(tr("评分基线已重置，请重新开始调焦流程。"));
@@ -419,7 +418,7 @@ void FocusSummaryPanel::updateButtons() {
         m_markBestButton->setEnabled(m_lastMetrics.valid);
     }
     if (m_resetBaselineButton) {
-        m_resetBaselineButton->setEnabled(m_hasBaseline || !m_history.empty());
+        m_resetBaselineButton->setEnabled(m_hasBaseline || (m_historyModel && !m_historyModel->isEmpty()));
     }
 }
 
@@ -429,7 +428,6 @@ void FocusSummaryPanel::resetPanel() {
     m_bestComposite = 0.0;
     m_previousComposite = 0.0;
     m_hasBaseline = false;
-    m_history.clear();
     m_lastFrameSize = {};
     m_lastRoi = {};
 
@@ -461,7 +459,7 @@ void FocusSummaryPanel::resetPanel() {
     if (m_guidanceBox) {
         m_guidanceBox->clear();
     }
-    refreshHistoryTable();
+    clearHistory();
     updateButtons();
 }
 
@@ -2,28 +2,41 @@
 #include <QCommandLineOption>
 #include <QCommandLineParser>
 #include <QCoreApplication>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QFontDatabase>
 #include <QMessageBox>
 #include <QTextStream>
 
 #include <cmath>
+#include <cstring>
 
 #include "CalibrationEngine.h"
+#include "DetectionTuner.h"
+#include "DetectionWorkerPool.h"
+#include "ImageLoader.h"
 #include "MainWindow.h"
 #include "ProjectBootstrapDialog.h"
 #include "ProjectHistory.h"
 #include "ProjectSession.h"
+#include "RigCalibration.h"
 
 namespace {
 
+bool wantsDetectionWorker(int argc, char *argv[])
+{
+    return argc > 1 && std::strcmp(argv[1], mycalib::DetectionWorkerPool::kWorkerArgument) == 0;
+}
+
 bool wantsBatchMode(int argc, char *argv[])
 {
     for (int i = 1; i < argc; ++i) {
         const QString arg = QString::fromLocal8Bit(argv[i]);
         if (arg == QStringLiteral("--batch") || arg == QStringLiteral("-b") ||
             arg.startsWith(QStringLiteral("--input")) || arg == QStringLiteral("-i") ||
-            arg.startsWith(QStringLiteral("--output")) || arg == QStringLiteral("-o")) {
+            arg.startsWith(QStringLiteral("--output")) || arg == QStringLiteral("-o") ||
+            arg.startsWith(QStringLiteral("--rig"))) {
             return true;
         }
     }
@@ -55,6 +68,9 @@ int runBatchMode(int argc, char *argv[])
     QCommandLineOption spacingOption({QStringLiteral("s"), QStringLiteral("spacing")},
                                      QStringLiteral("Circle centre spacing in millimetres."),
                                      QStringLiteral("mm"));
+    QCommandLineOption layoutOption(QStringLiteral("board-layout"),
+                                    QStringLiteral("Circle board layout: 7x6 (default), 9x8 or 11x10."),
+                                    QStringLiteral("layout"));
     QCommandLineOption maxMeanOption({QStringLiteral("M"), QStringLiteral("max-mean")},
                                      QStringLiteral("Maximum mean reprojection error threshold (pixels)."),
                                      QStringLiteral("px"));
@@ -67,24 +83,65 @@ int runBatchMode(int argc, char *argv[])
     QCommandLineOption maxIterationsOption({QStringLiteral("I"), QStringLiteral("max-iterations")},
                                            QStringLiteral("Maximum number of outlier removal iterations."),
                                            QStringLiteral("count"));
+    QCommandLineOption robustEpsilonOption(QStringLiteral("robust-epsilon"),
+                                           QStringLiteral("Stop outlier removal once an iteration improves held-out RMS by less than this (pixels)."),
+                                           QStringLiteral("px"));
+    QCommandLineOption workersOption(QStringLiteral("workers"),
+                                     QStringLiteral("Detect images in this many isolated worker processes."),
+                                     QStringLiteral("count"));
+    QCommandLineOption profileOption(QStringLiteral("detection-profile"),
+                                     QStringLiteral("Load detector parameters from this detection profile (JSON)."),
+                                     QStringLiteral("file"));
+    QCommandLineOption tuneOption(QStringLiteral("tune-detection"),
+                                  QStringLiteral("Tune detector parameters on this many input images first; the profile is saved to the output directory."),
+                                  QStringLiteral("count"));
     QCommandLineOption noRefineOption(QStringLiteral("no-refine"),
                                       QStringLiteral("Disable the non-linear refinement stage."));
+    QCommandLineOption warpFreeOption(QStringLiteral("warp-free"),
+                                      QStringLiteral("Refine circles in per-circle ROIs instead of warping the whole board."));
+    QCommandLineOption kfoldOption(QStringLiteral("kfold"),
+                                   QStringLiteral("Report k-fold cross-validation of the final view set."),
+                                   QStringLiteral("k"));
+    QCommandLineOption holdoutOption(QStringLiteral("holdout"),
+                                     QStringLiteral("Report a single hold-out validation using this fraction of views."),
+                                     QStringLiteral("fraction"));
+    QCommandLineOption rigOption(QStringLiteral("rig"),
+                                 QStringLiteral("Add a rig camera as name=dir; repeat for each camera, the first is the reference."),
+                                 QStringLiteral("name=dir"));
+    QCommandLineOption rigMatchOption(QStringLiteral("rig-match"),
+                                      QStringLiteral("Pair synchronized rig shots by 'filename' (default) or 'timestamp'."),
+                                      QStringLiteral("mode"));
+    QCommandLineOption rigToleranceOption(QStringLiteral("rig-tolerance"),
+                                          QStringLiteral("Timestamp pairing tolerance in milliseconds."),
+                                          QStringLiteral("ms"));
 
     parser.addOption(batchOption);
     parser.addOption(inputOption);
     parser.addOption(outputOption);
     parser.addOption(diameterOption);
     parser.addOption(spacingOption);
+    parser.addOption(layoutOption);
     parser.addOption(maxMeanOption);
     parser.addOption(maxPointOption);
     parser.addOption(minSamplesOption);
     parser.addOption(maxIterationsOption);
+    parser.addOption(robustEpsilonOption);
+    parser.addOption(workersOption);
+    parser.addOption(profileOption);
+    parser.addOption(tuneOption);
     parser.addOption(noRefineOption);
+    parser.addOption(warpFreeOption);
+    parser.addOption(kfoldOption);
+    parser.addOption(holdoutOption);
+    parser.addOption(rigOption);
+    parser.addOption(rigMatchOption);
+    parser.addOption(rigToleranceOption);
 
     parser.process(app);
 
-    if (!parser.isSet(inputOption) || !parser.isSet(outputOption)) {
-        QTextStream(stderr) << "Error: --input and --output must be provided in batch mode." << Qt::endl;
+    const bool rigMode = parser.isSet(rigOption);
+    if (!parser.isSet(outputOption) || (!rigMode && !parser.isSet(inputOption))) {
+        QTextStream(stderr) << "Error: --input (or --rig) and --output must be provided in batch mode." << Qt::endl;
         parser.showHelp(1);
     }
 
@@ -127,17 +184,119 @@ int runBatchMode(int argc, char *argv[])
         !parsePositiveDouble(maxMeanOption, settings.maxMeanErrorPx) ||
         !parsePositiveDouble(maxPointOption, settings.maxPointErrorPx) ||
         !parsePositiveInt(minSamplesOption, settings.minSamples) ||
-        !parsePositiveInt(maxIterationsOption, settings.maxIterations)) {
+        !parsePositiveInt(maxIterationsOption, settings.maxIterations) ||
+        !parsePositiveDouble(robustEpsilonOption, settings.robustMinGainPx) ||
+        !parsePositiveInt(workersOption, settings.detectionWorkers)) {
         return 1;
     }
 
+    if (parser.isSet(layoutOption) &&
+        !mycalib::boardLayoutFromKey(parser.value(layoutOption).trimmed().toLower().toStdString(),
+                                     settings.boardSpec.layout)) {
+        QTextStream(stderr) << "Invalid value for --board-layout: " << parser.value(layoutOption) << Qt::endl;
+        return 1;
+    }
+
+    if (parser.isSet(profileOption)) {
+        settings.detectionProfilePath = parser.value(profileOption);
+    }
+
     if (parser.isSet(noRefineOption)) {
         settings.enableRefinement = false;
     }
+    if (parser.isSet(warpFreeOption)) {
+        settings.detection.warpFreeDetection = true;
+    }
+
+    if (parser.isSet(kfoldOption) && parser.isSet(holdoutOption)) {
+        QTextStream(stderr) << "Error: --kfold and --holdout are mutually exclusive." << Qt::endl;
+        return 1;
+    }
+    if (parser.isSet(kfoldOption)) {
+        if (!parsePositiveInt(kfoldOption, settings.validationFolds) || settings.validationFolds < 2) {
+            QTextStream(stderr) << "Error: --kfold needs at least 2 folds." << Qt::endl;
+            return 1;
+        }
+        settings.validationMode = mycalib::CalibrationEngine::Settings::ValidationMode::KFold;
+    }
+    if (parser.isSet(holdoutOption)) {
+        if (!parsePositiveDouble(holdoutOption, settings.holdOutFraction) || settings.holdOutFraction >= 1.0) {
+            QTextStream(stderr) << "Error: --holdout expects a fraction in (0, 1)." << Qt::endl;
+            return 1;
+        }
+        settings.validationMode = mycalib::CalibrationEngine::Settings::ValidationMode::HoldOut;
+    }
 
-    const QString inputDir = parser.value(inputOption);
     const QString outputDir = parser.value(outputOption);
 
+    if (rigMode) {
+        std::vector<mycalib::RigCameraInput> cameras;
+        for (const QString &spec : parser.values(rigOption)) {
+            const int split = spec.indexOf(QLatin1Char('='));
+            if (split <= 0 || split == spec.size() - 1) {
+                QTextStream(stderr) << "Invalid value for --rig: " << spec << Qt::endl;
+                return 1;
+            }
+            cameras.push_back({spec.left(split), spec.mid(split + 1)});
+        }
+        if (cameras.size() < 2) {
+            QTextStream(stderr) << "Error: rig mode needs at least two --rig cameras." << Qt::endl;
+            return 1;
+        }
+
+        mycalib::RigSettings rigSettings;
+        rigSettings.calibration = settings;
+        if (parser.isSet(rigMatchOption)) {
+            const QString mode = parser.value(rigMatchOption).toLower();
+            if (mode == QStringLiteral("timestamp")) {
+                rigSettings.matchMode = mycalib::RigMatchMode::Timestamp;
+            } else if (mode != QStringLiteral("filename")) {
+                QTextStream(stderr) << "Invalid value for --rig-match: " << parser.value(rigMatchOption) << Qt::endl;
+                return 1;
+            }
+        }
+        if (!parsePositiveInt(rigToleranceOption, rigSettings.timestampToleranceMs)) {
+            return 1;
+        }
+
+        const auto rigResult = mycalib::RigCalibrator().run(cameras, rigSettings, outputDir);
+        if (!rigResult.success) {
+            QTextStream(stderr) << "Rig calibration failed: " << rigResult.message << Qt::endl;
+            return 2;
+        }
+        QTextStream(stdout) << "Rig calibration succeeded. Results written to "
+                            << outputDir << Qt::endl;
+        return 0;
+    }
+
+    const QString inputDir = parser.value(inputOption);
+
+    if (parser.isSet(tuneOption)) {
+        mycalib::DetectionTuningOptions tuning;
+        if (!parsePositiveInt(tuneOption, tuning.sampleSize)) {
+            return 1;
+        }
+        const auto paths = mycalib::ImageLoader().gatherImageFiles(inputDir.toStdString());
+        const auto tuned = mycalib::DetectionTuner(settings.boardSpec,
+                                                   mycalib::CalibrationEngine::resolveDetectionConfig(settings),
+                                                   tuning)
+                               .tune(paths);
+        if (!tuned.success) {
+            QTextStream(stderr) << "Detection tuning failed: " << tuned.message << Qt::endl;
+            return 2;
+        }
+        const QString profilePath = QDir(mycalib::CalibrationEngine::resolveOutputDirectory(outputDir))
+                                        .filePath(QStringLiteral("detection_profile.json"));
+        QDir().mkpath(QFileInfo(profilePath).absolutePath());
+        QString error;
+        if (!mycalib::saveDetectionProfile(profilePath, tuned.config, &error)) {
+            QTextStream(stderr) << "Detection tuning failed: " << error << Qt::endl;
+            return 2;
+        }
+        QTextStream(stdout) << "Detection tuning: " << tuned.message << ". Profile written to " << profilePath << Qt::endl;
+        settings.detectionProfilePath = profilePath;
+    }
+
     mycalib::CalibrationEngine engine;
     const auto result = engine.runBlocking(inputDir, settings, outputDir);
     if (!result.success) {
@@ -154,6 +313,10 @@ int runBatchMode(int argc, char *argv[])
 
 int main(int argc, char *argv[])
 {
+    if (wantsDetectionWorker(argc, argv)) {
+        QCoreApplication app(argc, argv);
+        return mycalib::DetectionWorkerPool::serveWorker();
+    }
     if (wantsBatchMode(argc, argv)) {
         return runBatchMode(argc, argv);
     }
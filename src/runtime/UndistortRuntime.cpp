@@ -0,0 +1,435 @@
+#include "runtime/UndistortRuntime.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mycalib {
+
+namespace {
+
+constexpr char kMagic[4] = {'M', 'C', 'U', 'M'};
+constexpr std::uint32_t kFormatVersion = 1;
+constexpr std::uint64_t kPlaneAlignment = 64;
+constexpr int kMaxDistCoeffs = 14;
+
+struct FileHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::int32_t width;
+    std::int32_t height;
+    double cameraMatrix[9];
+    std::int32_t distCount;
+    std::int32_t reserved;
+    double distCoeffs[kMaxDistCoeffs];
+    std::uint64_t xyOffset;       // CV_16SC2 plane, width * 4 bytes per row
+    std::uint64_t fractionOffset; // CV_16UC1 plane, width * 2 bytes per row
+};
+static_assert(std::is_trivially_copyable_v<FileHeader>);
+static_assert(sizeof(FileHeader) == 224, "undistort map header layout changed");
+
+std::uint64_t alignUp(std::uint64_t value)
+{
+    return (value + kPlaneAlignment - 1) / kPlaneAlignment * kPlaneAlignment;
+}
+
+void setError(std::string *error, const std::string &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+// The distortion models cv::initUndistortRectifyMap accepts.
+bool isSupportedDistCount(std::size_t count)
+{
+    return count == 4 || count == 5 || count == 8 || count == 12 || count == 14;
+}
+
+bool allFinite(const std::vector<double> &values)
+{
+    return std::all_of(values.cbegin(), values.cend(), [](double value) { return std::isfinite(value); });
+}
+
+// Flattens a number or (nested) sequence of numbers in row-major order.
+void readNumbers(const cv::FileNode &node, std::vector<double> &values)
+{
+    if (node.isSeq()) {
+        for (const cv::FileNode &child : node) {
+            readNumbers(child, values);
+        }
+    } else if (node.isReal() || node.isInt()) {
+        values.push_back(static_cast<double>(node));
+    }
+}
+
+} // namespace
+
+struct UndistortMap::Mapping {
+    const unsigned char *data {nullptr};
+    std::size_t size {0};
+#ifdef _WIN32
+    HANDLE file {INVALID_HANDLE_VALUE};
+    HANDLE view {nullptr};
+#endif
+
+    ~Mapping()
+    {
+#ifdef _WIN32
+        if (data) {
+            UnmapViewOfFile(data);
+        }
+        if (view) {
+            CloseHandle(view);
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+#else
+        if (data) {
+            munmap(const_cast<unsigned char *>(data), size);
+        }
+#endif
+    }
+
+    bool open(const std::string &path, std::string *error)
+    {
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            setError(error, "cannot open " + path);
+            return false;
+        }
+        LARGE_INTEGER fileSize {};
+        if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart <= 0) {
+            setError(error, "cannot stat " + path);
+            return false;
+        }
+        size = static_cast<std::size_t>(fileSize.QuadPart);
+        view = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!view) {
+            setError(error, "cannot map " + path);
+            return false;
+        }
+        data = static_cast<const unsigned char *>(MapViewOfFile(view, FILE_MAP_READ, 0, 0, 0));
+        if (!data) {
+            setError(error, "cannot map " + path);
+            return false;
+        }
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            setError(error, "cannot open " + path);
+            return false;
+        }
+        struct stat info {};
+        if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+            ::close(fd);
+            setError(error, "cannot stat " + path);
+            return false;
+        }
+        size = static_cast<std::size_t>(info.st_size);
+        void *mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            setError(error, "cannot map " + path);
+            return false;
+        }
+        data = static_cast<const unsigned char *>(mapped);
+#endif
+        return true;
+    }
+};
+
+std::optional<UndistortCalibration> loadCalibration(const std::string &path, std::string *error)
+{
+    cv::FileStorage storage;
+    try {
+        storage.open(path, cv::FileStorage::READ | cv::FileStorage::FORMAT_JSON);
+    } catch (const cv::Exception &ex) {
+        setError(error, "invalid calibration file " + path + ": " + ex.what());
+        return std::nullopt;
+    }
+    if (!storage.isOpened()) {
+        setError(error, "cannot open " + path);
+        return std::nullopt;
+    }
+
+    std::vector<double> camera;
+    std::vector<double> dist;
+    std::vector<double> size;
+    readNumbers(storage["camera_matrix"], camera);
+    readNumbers(storage["distortion_coefficients"], dist);
+    readNumbers(storage["image_size"], size);
+    if (camera.size() != 9) {
+        setError(error, "camera_matrix missing or not 3x3 in " + path);
+        return std::nullopt;
+    }
+    if (!dist.empty() && !isSupportedDistCount(dist.size())) {
+        setError(error, "unsupported number of distortion coefficients in " + path);
+        return std::nullopt;
+    }
+    if (size.size() != 2 || size[0] < 1.0 || size[1] < 1.0) {
+        setError(error, "image_size missing in " + path);
+        return std::nullopt;
+    }
+    if (!allFinite(camera) || !allFinite(dist) || !allFinite(size)) {
+        setError(error, "non-finite calibration values in " + path);
+        return std::nullopt;
+    }
+
+    UndistortCalibration calibration;
+    calibration.cameraMatrix = cv::Mat(camera, true).reshape(1, 3);
+    calibration.distCoeffs = dist.empty() ? cv::Mat::zeros(1, 5, CV_64F) : cv::Mat(dist, true).reshape(1, 1);
+    calibration.imageSize = cv::Size(static_cast<int>(size[0]), static_cast<int>(size[1]));
+    return calibration;
+}
+
+bool saveCalibration(const std::string &path, const UndistortCalibration &calibration, std::string *error)
+{
+    std::vector<double> camera;
+    std::vector<double> dist;
+    if (calibration.cameraMatrix.total() == 9) {
+        calibration.cameraMatrix.reshape(1, 1).convertTo(camera, CV_64F);
+    }
+    if (!calibration.distCoeffs.empty()) {
+        calibration.distCoeffs.reshape(1, 1).convertTo(dist, CV_64F);
+    }
+    if (camera.size() != 9 || calibration.imageSize.area() <= 0) {
+        setError(error, "incomplete calibration");
+        return false;
+    }
+    if (!dist.empty() && !isSupportedDistCount(dist.size())) {
+        setError(error, "unsupported number of distortion coefficients");
+        return false;
+    }
+    if (!allFinite(camera) || !allFinite(dist)) {
+        setError(error, "non-finite calibration values");
+        return false;
+    }
+
+    try {
+        cv::FileStorage storage(path, cv::FileStorage::WRITE | cv::FileStorage::FORMAT_JSON);
+        if (!storage.isOpened()) {
+            setError(error, "cannot write " + path);
+            return false;
+        }
+        // Plain arrays rather than OpenCV matrix nodes, so any JSON reader can use the file.
+        storage << "camera_matrix" << "[";
+        for (const double value : camera) {
+            storage << value;
+        }
+        storage << "]" << "distortion_coefficients" << "[";
+        for (const double value : dist) {
+            storage << value;
+        }
+        storage << "]" << "image_size" << "[" << calibration.imageSize.width << calibration.imageSize.height << "]";
+    } catch (const cv::Exception &ex) {
+        setError(error, "cannot write " + path + ": " + ex.what());
+        return false;
+    }
+    return true;
+}
+
+UndistortMap::UndistortMap() = default;
+UndistortMap::~UndistortMap() = default;
+UndistortMap::UndistortMap(UndistortMap &&) noexcept = default;
+UndistortMap &UndistortMap::operator=(UndistortMap &&) noexcept = default;
+
+UndistortMap UndistortMap::build(const UndistortCalibration &calibration)
+{
+    UndistortMap map;
+    calibration.cameraMatrix.convertTo(map.m_calibration.cameraMatrix, CV_64F);
+    calibration.distCoeffs.convertTo(map.m_calibration.distCoeffs, CV_64F);
+    map.m_calibration.distCoeffs = map.m_calibration.distCoeffs.reshape(1, 1);
+    map.m_calibration.imageSize = calibration.imageSize;
+    const std::size_t distCount = map.m_calibration.distCoeffs.total();
+    if (map.m_calibration.cameraMatrix.total() != 9 || calibration.imageSize.area() <= 0 ||
+        (distCount != 0 && !isSupportedDistCount(distCount))) {
+        return map;
+    }
+    cv::initUndistortRectifyMap(map.m_calibration.cameraMatrix,
+                                map.m_calibration.distCoeffs,
+                                cv::noArray(),
+                                map.m_calibration.cameraMatrix,
+                                calibration.imageSize,
+                                CV_16SC2,
+                                map.m_xy,
+                                map.m_fraction);
+    return map;
+}
+
+std::optional<UndistortMap> UndistortMap::open(const std::string &path, std::string *error)
+{
+    auto mapping = std::make_unique<Mapping>();
+    if (!mapping->open(path, error)) {
+        return std::nullopt;
+    }
+    if (mapping->size < sizeof(FileHeader)) {
+        setError(error, "truncated undistort map " + path);
+        return std::nullopt;
+    }
+    FileHeader header {};
+    std::memcpy(&header, mapping->data, sizeof(header));
+    if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 || header.version != kFormatVersion) {
+        setError(error, "not an undistort map (or unsupported version): " + path);
+        return std::nullopt;
+    }
+    if (header.width <= 0 || header.height <= 0 ||
+        (header.distCount != 0 && !isSupportedDistCount(static_cast<std::size_t>(header.distCount)))) {
+        setError(error, "corrupt undistort map header in " + path);
+        return std::nullopt;
+    }
+    // Written as offset > size || length > size - offset so a corrupt offset cannot wrap.
+    const std::uint64_t pixels = static_cast<std::uint64_t>(header.width) * static_cast<std::uint64_t>(header.height);
+    const std::uint64_t size = mapping->size;
+    if (header.xyOffset % kPlaneAlignment != 0 || header.fractionOffset % kPlaneAlignment != 0 ||
+        header.xyOffset < sizeof(FileHeader) || header.fractionOffset < sizeof(FileHeader) ||
+        header.xyOffset > size || pixels * 4 > size - header.xyOffset ||
+        header.fractionOffset > size || pixels * 2 > size - header.fractionOffset) {
+        setError(error, "truncated undistort map " + path);
+        return std::nullopt;
+    }
+
+    UndistortMap map;
+    map.m_calibration.cameraMatrix = cv::Mat(3, 3, CV_64F, header.cameraMatrix).clone();
+    map.m_calibration.distCoeffs = header.distCount > 0
+                                       ? cv::Mat(1, header.distCount, CV_64F, header.distCoeffs).clone()
+                                       : cv::Mat::zeros(1, 5, CV_64F);
+    map.m_calibration.imageSize = cv::Size(header.width, header.height);
+    // remap only reads its maps, so the read-only mapping can back them directly.
+    auto *base = const_cast<unsigned char *>(mapping->data);
+    map.m_xy = cv::Mat(header.height, header.width, CV_16SC2, base + header.xyOffset);
+    map.m_fraction = cv::Mat(header.height, header.width, CV_16UC1, base + header.fractionOffset);
+    map.m_mapping = std::move(mapping);
+    return map;
+}
+
+bool UndistortMap::save(const std::string &path, std::string *error) const
+{
+    if (!isValid()) {
+        setError(error, "undistort map is empty");
+        return false;
+    }
+    const int distCount = static_cast<int>(m_calibration.distCoeffs.total());
+    if (distCount != 0 && !isSupportedDistCount(static_cast<std::size_t>(distCount))) {
+        setError(error, "unsupported number of distortion coefficients");
+        return false;
+    }
+
+    FileHeader header {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.width = m_xy.cols;
+    header.height = m_xy.rows;
+    for (int i = 0; i < 9; ++i) {
+        header.cameraMatrix[i] = m_calibration.cameraMatrix.at<double>(i / 3, i % 3);
+    }
+    header.distCount = distCount;
+    for (int i = 0; i < distCount; ++i) {
+        header.distCoeffs[i] = m_calibration.distCoeffs.at<double>(i);
+    }
+    const std::uint64_t pixels = static_cast<std::uint64_t>(m_xy.cols) * static_cast<std::uint64_t>(m_xy.rows);
+    header.xyOffset = alignUp(sizeof(FileHeader));
+    header.fractionOffset = alignUp(header.xyOffset + pixels * 4);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        setError(error, "cannot write " + path);
+        return false;
+    }
+    const char padding[kPlaneAlignment] = {};
+    out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    out.write(padding, static_cast<std::streamsize>(header.xyOffset - sizeof(header)));
+    for (int y = 0; y < m_xy.rows; ++y) {
+        out.write(reinterpret_cast<const char *>(m_xy.ptr(y)), static_cast<std::streamsize>(m_xy.cols) * 4);
+    }
+    out.write(padding, static_cast<std::streamsize>(header.fractionOffset - header.xyOffset - pixels * 4));
+    for (int y = 0; y < m_fraction.rows; ++y) {
+        out.write(reinterpret_cast<const char *>(m_fraction.ptr(y)), static_cast<std::streamsize>(m_fraction.cols) * 2);
+    }
+    out.close();
+    if (!out) {
+        setError(error, "cannot write " + path);
+        return false;
+    }
+    return true;
+}
+
+void UndistortMap::remap(const cv::Mat &src, cv::Mat &dst, int borderMode) const
+{
+    CV_Assert(isValid() && src.size() == m_calibration.imageSize);
+    cv::remap(src, dst, m_xy, m_fraction, cv::INTER_LINEAR, borderMode);
+}
+
+void UndistortMap::remap(const cv::Mat &src, cv::Mat &dst, const cv::Rect &roi, int borderMode) const
+{
+    CV_Assert(isValid() && src.size() == m_calibration.imageSize);
+    const cv::Rect clipped = roi & cv::Rect(cv::Point(), m_calibration.imageSize);
+    if (clipped.empty()) {
+        dst.release();
+        return;
+    }
+    cv::remap(src, dst, m_xy(clipped), m_fraction(clipped), cv::INTER_LINEAR, borderMode);
+}
+
+cv::Rect UndistortMap::sourceRect(const cv::Rect &roi) const
+{
+    const cv::Rect frame(cv::Point(), m_calibration.imageSize);
+    const cv::Rect clipped = roi & frame;
+    if (!isValid() || clipped.empty()) {
+        return cv::Rect();
+    }
+    int minX = std::numeric_limits<int>::max();
+    int minY = std::numeric_limits<int>::max();
+    int maxX = std::numeric_limits<int>::min();
+    int maxY = std::numeric_limits<int>::min();
+    for (int y = clipped.y; y < clipped.y + clipped.height; ++y) {
+        const auto *row = m_xy.ptr<cv::Vec2s>(y);
+        for (int x = clipped.x; x < clipped.x + clipped.width; ++x) {
+            minX = std::min<int>(minX, row[x][0]);
+            maxX = std::max<int>(maxX, row[x][0]);
+            minY = std::min<int>(minY, row[x][1]);
+            maxY = std::max<int>(maxY, row[x][1]);
+        }
+    }
+    // Bilinear sampling also reads the pixel right of and below each integer position.
+    return cv::Rect(cv::Point(minX, minY), cv::Point(maxX + 2, maxY + 2)) & frame;
+}
+
+void UndistortMap::undistortPoints(const std::vector<cv::Point2f> &distorted,
+                                   std::vector<cv::Point2f> &undistorted) const
+{
+    if (distorted.empty()) {
+        undistorted.clear();
+        return;
+    }
+    cv::undistortPoints(distorted,
+                        undistorted,
+                        m_calibration.cameraMatrix,
+                        m_calibration.distCoeffs,
+                        cv::noArray(),
+                        m_calibration.cameraMatrix);
+}
+
+} // namespace mycalib
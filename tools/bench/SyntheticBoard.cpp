@@ -0,0 +1,508 @@
+#include "SyntheticBoard.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
+
+namespace mycalib {
+
+namespace {
+
+constexpr double kDegToRad = CV_PI / 180.0;
+constexpr int kPoseAttempts = 64;
+constexpr double kOutlineMarginRatio = 0.01;
+
+double coverage(double signedDistance, double footprint)
+{
+    return std::clamp(0.5 - signedDistance / footprint, 0.0, 1.0);
+}
+
+cv::Matx33d rotationFromEuler(double rx, double ry, double rz)
+{
+    const double cx = std::cos(rx);
+    const double sx = std::sin(rx);
+    const double cy = std::cos(ry);
+    const double sy = std::sin(ry);
+    const double cz = std::cos(rz);
+    const double sz = std::sin(rz);
+    const cv::Matx33d Rx(1, 0, 0, 0, cx, -sx, 0, sx, cx);
+    const cv::Matx33d Ry(cy, 0, sy, 0, 1, 0, -sy, 0, cy);
+    const cv::Matx33d Rz(cz, -sz, 0, sz, cz, 0, 0, 0, 1);
+    return Rz * Ry * Rx;
+}
+
+QJsonArray matToJson(const cv::Mat &mat)
+{
+    QJsonArray outer;
+    for (int r = 0; r < mat.rows; ++r) {
+        QJsonArray row;
+        for (int c = 0; c < mat.cols; ++c) {
+            row.append(mat.at<double>(r, c));
+        }
+        outer.append(row);
+    }
+    return outer;
+}
+
+cv::Mat matFromJson(const QJsonArray &outer)
+{
+    if (outer.isEmpty()) {
+        return {};
+    }
+    const int rows = outer.size();
+    const int cols = outer.first().toArray().size();
+    cv::Mat mat = cv::Mat::zeros(rows, cols, CV_64F);
+    for (int r = 0; r < rows; ++r) {
+        const QJsonArray row = outer.at(r).toArray();
+        for (int c = 0; c < std::min(cols, static_cast<int>(row.size())); ++c) {
+            mat.at<double>(r, c) = row.at(c).toDouble();
+        }
+    }
+    return mat;
+}
+
+QJsonArray vecToJson(const cv::Vec3d &vec)
+{
+    return QJsonArray{vec[0], vec[1], vec[2]};
+}
+
+cv::Vec3d vecFromJson(const QJsonArray &array)
+{
+    cv::Vec3d vec;
+    for (int i = 0; i < 3 && i < array.size(); ++i) {
+        vec[i] = array.at(i).toDouble();
+    }
+    return vec;
+}
+
+} // namespace
+
+SyntheticCamera SyntheticCamera::makeDefault(const cv::Size &imageSize)
+{
+    SyntheticCamera camera;
+    camera.imageSize = imageSize;
+
+    const double w = static_cast<double>(imageSize.width);
+    const double h = static_cast<double>(imageSize.height);
+    const double f = 0.9 * w;
+    camera.cameraMatrix = (cv::Mat_<double>(3, 3) << f, 0.0, 0.5 * w + 0.004 * w,
+                                                    0.0, f * 1.0005, 0.5 * h - 0.003 * h,
+                                                    0.0, 0.0, 1.0);
+
+    // k1 k2 p1 p2 k3 k4 k5 k6 s1 s2 s3 s4 tauX tauY
+    camera.distCoeffs = (cv::Mat_<double>(14, 1) << -0.11, 0.045, 2.5e-4, -1.8e-4, -0.008,
+                                                    0.015, -0.004, 0.001,
+                                                    1.2e-4, -4.0e-5, -9.0e-5, 3.0e-5,
+                                                    8.0e-4, -6.0e-4);
+    return camera;
+}
+
+SyntheticBoardLayout SyntheticBoardLayout::fromSpec(const BoardSpec &spec)
+{
+    SyntheticBoardLayout layout;
+    const double spacing = spec.centerSpacingMm;
+    layout.smallCentres = spec.buildObjectPoints(static_cast<int>(spec.expectedCircleCount()));
+    layout.smallRadiusMm = 0.5 * spec.smallDiameterMm;
+    layout.bigRadiusMm = std::min(spec.smallDiameterMm, 0.3 * spacing);
+
+    const auto markers = spec.markers();
+    for (size_t i = 0; i < markers.size(); ++i) {
+        layout.bigCentres[i] = cv::Point2f(static_cast<float>(markers[i].col * spacing),
+                                           static_cast<float>(markers[i].row * spacing));
+    }
+
+    double minX = std::numeric_limits<double>::max();
+    double minY = std::numeric_limits<double>::max();
+    double maxX = std::numeric_limits<double>::lowest();
+    double maxY = std::numeric_limits<double>::lowest();
+    for (const auto &pt : layout.smallCentres) {
+        minX = std::min(minX, static_cast<double>(pt.x));
+        minY = std::min(minY, static_cast<double>(pt.y));
+        maxX = std::max(maxX, static_cast<double>(pt.x));
+        maxY = std::max(maxY, static_cast<double>(pt.y));
+    }
+    layout.paper = cv::Rect2d(minX - spacing, minY - spacing,
+                              (maxX - minX) + 2.0 * spacing,
+                              (maxY - minY) + 2.0 * spacing);
+    return layout;
+}
+
+SyntheticBoardRenderer::SyntheticBoardRenderer(const BoardSpec &spec,
+                                               const SyntheticCamera &camera,
+                                               const SyntheticRenderOptions &options)
+    : m_spec(spec)
+    , m_camera(camera)
+    , m_options(options)
+    , m_layout(SyntheticBoardLayout::fromSpec(spec))
+{
+    const double spacing = m_spec.centerSpacingMm;
+    for (const auto &pt : m_layout.smallCentres) {
+        m_latticeCols = std::max(m_latticeCols, static_cast<int>(std::lround(pt.x / spacing)) + 1);
+        m_latticeRows = std::max(m_latticeRows, static_cast<int>(std::lround(pt.y / spacing)) + 1);
+    }
+    m_occupied.assign(static_cast<size_t>(m_latticeCols * m_latticeRows), 0);
+    for (const auto &pt : m_layout.smallCentres) {
+        const int col = static_cast<int>(std::lround(pt.x / spacing));
+        const int row = static_cast<int>(std::lround(pt.y / spacing));
+        m_occupied[static_cast<size_t>(row * m_latticeCols + col)] = 1;
+    }
+
+    // Undistorted rays on a coarse grid; distortion is smooth enough that bilinear
+    // interpolation between samples stays far below the detector's noise floor.
+    const int cols = (m_camera.imageSize.width - 1) / kRayStep + 2;
+    const int rows = (m_camera.imageSize.height - 1) / kRayStep + 2;
+    std::vector<cv::Point2d> samples;
+    samples.reserve(static_cast<size_t>(cols * rows));
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            samples.emplace_back(c * kRayStep, r * kRayStep);
+        }
+    }
+    std::vector<cv::Point2d> undistorted;
+    cv::undistortPoints(samples, undistorted, m_camera.cameraMatrix, m_camera.distCoeffs,
+                        cv::noArray(), cv::noArray(),
+                        cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 100, 1e-12));
+    m_rays.create(rows, cols, CV_64FC2);
+    for (int r = 0; r < rows; ++r) {
+        auto *dst = m_rays.ptr<cv::Vec2d>(r);
+        for (int c = 0; c < cols; ++c) {
+            const auto &pt = undistorted[static_cast<size_t>(r * cols + c)];
+            dst[c] = cv::Vec2d(pt.x, pt.y);
+        }
+    }
+}
+
+cv::Vec2d SyntheticBoardRenderer::rayAt(int x, int y) const
+{
+    const int c0 = x / kRayStep;
+    const int r0 = y / kRayStep;
+    const double fx = static_cast<double>(x - c0 * kRayStep) / kRayStep;
+    const double fy = static_cast<double>(y - r0 * kRayStep) / kRayStep;
+    const auto *row0 = m_rays.ptr<cv::Vec2d>(r0);
+    const auto *row1 = m_rays.ptr<cv::Vec2d>(r0 + 1);
+    const cv::Vec2d top = row0[c0] * (1.0 - fx) + row0[c0 + 1] * fx;
+    const cv::Vec2d bottom = row1[c0] * (1.0 - fx) + row1[c0 + 1] * fx;
+    return top * (1.0 - fy) + bottom * fy;
+}
+
+bool SyntheticBoardRenderer::samplePose(std::uint64_t seed, cv::Vec3d &rvec, cv::Vec3d &tvec) const
+{
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_real_distribution<double> symmetric(-1.0, 1.0);
+
+    const double fx = m_camera.cameraMatrix.at<double>(0, 0);
+    const int width = m_camera.imageSize.width;
+    const int height = m_camera.imageSize.height;
+    const double shortSide = static_cast<double>(std::min(width, height));
+    const auto &paper = m_layout.paper;
+    const double boardExtent = std::max(paper.width, paper.height);
+    const cv::Vec3d centre(paper.x + 0.5 * paper.width, paper.y + 0.5 * paper.height, 0.0);
+
+    const std::vector<cv::Point3f> outline {
+        {static_cast<float>(paper.x), static_cast<float>(paper.y), 0.0F},
+        {static_cast<float>(paper.x + paper.width), static_cast<float>(paper.y), 0.0F},
+        {static_cast<float>(paper.x + paper.width), static_cast<float>(paper.y + paper.height), 0.0F},
+        {static_cast<float>(paper.x), static_cast<float>(paper.y + paper.height), 0.0F}
+    };
+    const double marginX = kOutlineMarginRatio * width;
+    const double marginY = kOutlineMarginRatio * height;
+
+    for (int attempt = 0; attempt < kPoseAttempts; ++attempt) {
+        // Shrink the board as attempts fail so strongly tilted poses still fit.
+        const double shrink = 1.0 - 0.5 * static_cast<double>(attempt) / kPoseAttempts;
+        const double fill = (m_options.minBoardFill + (m_options.maxBoardFill - m_options.minBoardFill) * unit(rng)) * shrink;
+        const double depth = fx * boardExtent / std::max(fill * shortSide, 1.0);
+
+        const cv::Matx33d R = rotationFromEuler(symmetric(rng) * m_options.maxTiltDeg * kDegToRad,
+                                                symmetric(rng) * m_options.maxTiltDeg * kDegToRad,
+                                                symmetric(rng) * m_options.maxRollDeg * kDegToRad);
+
+        const int px = static_cast<int>((0.2 + 0.6 * unit(rng)) * (width - 1));
+        const int py = static_cast<int>((0.2 + 0.6 * unit(rng)) * (height - 1));
+        const cv::Vec2d ray = rayAt(px, py);
+        const cv::Vec3d t = cv::Vec3d(ray[0], ray[1], 1.0) * depth - R * centre;
+
+        bool inFront = true;
+        for (const auto &corner : outline) {
+            const cv::Vec3d pc = R * cv::Vec3d(corner.x, corner.y, corner.z) + t;
+            if (pc[2] <= 0.0) {
+                inFront = false;
+                break;
+            }
+        }
+        if (!inFront) {
+            continue;
+        }
+
+        cv::Mat rotation;
+        cv::Rodrigues(cv::Mat(R), rotation);
+        const cv::Vec3d candidateR(rotation.at<double>(0), rotation.at<double>(1), rotation.at<double>(2));
+
+        std::vector<cv::Point2f> projected;
+        cv::projectPoints(outline, candidateR, t, m_camera.cameraMatrix, m_camera.distCoeffs, projected);
+        const bool inside = std::all_of(projected.begin(), projected.end(), [&](const cv::Point2f &p) {
+            return p.x >= marginX && p.x <= width - 1 - marginX && p.y >= marginY && p.y <= height - 1 - marginY;
+        });
+        if (!inside) {
+            continue;
+        }
+
+        rvec = candidateR;
+        tvec = t;
+        return true;
+    }
+    return false;
+}
+
+cv::Mat SyntheticBoardRenderer::rasterize(const cv::Vec3d &rvec,
+                                          const cv::Vec3d &tvec,
+                                          double blurSigmaPx,
+                                          std::uint64_t seed) const
+{
+    cv::Matx33d R;
+    cv::Rodrigues(rvec, R);
+    // Board plane (x, y, 1) -> normalized camera coordinates, inverted per pixel.
+    const cv::Matx33d H(R(0, 0), R(0, 1), tvec[0],
+                        R(1, 0), R(1, 1), tvec[1],
+                        R(2, 0), R(2, 1), tvec[2]);
+    const cv::Matx33d Hinv = H.inv();
+
+    const int width = m_camera.imageSize.width;
+    const int height = m_camera.imageSize.height;
+    const double spacing = m_spec.centerSpacingMm;
+    const auto &paper = m_layout.paper;
+    const double cx = m_camera.cameraMatrix.at<double>(0, 2);
+    const double cy = m_camera.cameraMatrix.at<double>(1, 2);
+    const double cornerRadius2 = std::max(cx * cx, (width - cx) * (width - cx)) +
+                                 std::max(cy * cy, (height - cy) * (height - cy));
+    const double bg = m_options.backgroundLevel;
+
+    const auto shade = [&](const cv::Vec2d &b, double footprint) {
+        const double outside = std::max({paper.x - b[0], b[0] - (paper.x + paper.width),
+                                         paper.y - b[1], b[1] - (paper.y + paper.height)});
+        const double paperCoverage = coverage(outside, footprint);
+        if (paperCoverage <= 0.0) {
+            return bg;
+        }
+
+        double ink = 0.0;
+        const int col = static_cast<int>(std::lround(b[0] / spacing));
+        const int row = static_cast<int>(std::lround(b[1] / spacing));
+        if (col >= 0 && col < m_latticeCols && row >= 0 && row < m_latticeRows &&
+            m_occupied[static_cast<size_t>(row * m_latticeCols + col)] != 0) {
+            const double d = std::hypot(b[0] - col * spacing, b[1] - row * spacing) - m_layout.smallRadiusMm;
+            ink = coverage(d, footprint);
+        }
+        for (const auto &big : m_layout.bigCentres) {
+            const double d = std::hypot(b[0] - big.x, b[1] - big.y) - m_layout.bigRadiusMm;
+            ink = std::max(ink, coverage(d, footprint));
+        }
+
+        const double onPaper = m_options.paperLevel + (m_options.inkLevel - m_options.paperLevel) * ink;
+        return bg + (onPaper - bg) * paperCoverage;
+    };
+
+    cv::Mat radiance(m_camera.imageSize, CV_32F);
+    std::vector<cv::Vec2d> previous(static_cast<size_t>(width));
+    std::vector<cv::Vec2d> current(static_cast<size_t>(width));
+    std::vector<unsigned char> hits(static_cast<size_t>(width));
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const cv::Vec2d ray = rayAt(x, y);
+            const cv::Vec3d p = Hinv * cv::Vec3d(ray[0], ray[1], 1.0);
+            // p[2] is the inverse depth; non-positive values hit the plane behind the camera.
+            hits[static_cast<size_t>(x)] = p[2] > 0.0 ? 1 : 0;
+            current[static_cast<size_t>(x)] = p[2] > 0.0 ? cv::Vec2d(p[0] / p[2], p[1] / p[2]) : cv::Vec2d(0.0, 0.0);
+        }
+
+        auto *dst = radiance.ptr<float>(y);
+        for (int x = 0; x < width; ++x) {
+            const auto idx = static_cast<size_t>(x);
+            if (hits[idx] == 0) {
+                dst[x] = static_cast<float>(bg);
+                continue;
+            }
+            const cv::Vec2d &b = current[idx];
+            const double stepX = x + 1 < width ? cv::norm(current[idx + 1] - b)
+                                               : (x > 0 ? cv::norm(b - current[idx - 1]) : 0.0);
+            const double stepY = y > 0 ? cv::norm(b - previous[idx]) : stepX;
+            const double footprint = std::max({stepX, stepY, 1e-6});
+
+            const double dx = x - cx;
+            const double dy = y - cy;
+            const double gain = 1.0 - m_options.vignetting * (dx * dx + dy * dy) / cornerRadius2;
+            dst[x] = static_cast<float>(shade(b, footprint) * gain);
+        }
+        std::swap(previous, current);
+    }
+
+    if (blurSigmaPx >= 0.3) {
+        cv::GaussianBlur(radiance, radiance, cv::Size(), blurSigmaPx);
+    }
+
+    cv::RNG rng(seed ^ 0x9E3779B97F4A7C15ULL);
+    cv::Mat image(m_camera.imageSize, CV_8U);
+    const double readVar = m_options.readNoiseSigma * m_options.readNoiseSigma;
+    for (int y = 0; y < height; ++y) {
+        const auto *src = radiance.ptr<float>(y);
+        auto *dst = image.ptr<uint8_t>(y);
+        for (int x = 0; x < width; ++x) {
+            const double signal = std::max(0.0, static_cast<double>(src[x]));
+            const double sigma = std::sqrt(readVar + m_options.shotNoiseGain * signal);
+            dst[x] = cv::saturate_cast<uint8_t>(signal + rng.gaussian(sigma));
+        }
+    }
+    return image;
+}
+
+SyntheticView SyntheticBoardRenderer::render(std::uint64_t seed) const
+{
+    SyntheticView view;
+    if (!samplePose(seed, view.rvec, view.tvec)) {
+        return view;
+    }
+
+    std::mt19937_64 rng(seed ^ 0xD1B54A32D192ED03ULL);
+    std::uniform_real_distribution<double> symmetric(-1.0, 1.0);
+    view.blurSigmaPx = std::max(0.0, m_options.blurSigmaPx * (1.0 + m_options.blurJitter * symmetric(rng)));
+
+    cv::projectPoints(m_layout.smallCentres, view.rvec, view.tvec,
+                      m_camera.cameraMatrix, m_camera.distCoeffs, view.imagePoints);
+    view.image = rasterize(view.rvec, view.tvec, view.blurSigmaPx, seed);
+    view.valid = true;
+    return view;
+}
+
+bool writeGroundTruth(const SyntheticGroundTruth &truth, const QString &path, QString *error)
+{
+    QJsonObject root;
+    root.insert(QStringLiteral("imageWidth"), truth.camera.imageSize.width);
+    root.insert(QStringLiteral("imageHeight"), truth.camera.imageSize.height);
+    root.insert(QStringLiteral("cameraMatrix"), matToJson(truth.camera.cameraMatrix));
+    root.insert(QStringLiteral("distCoeffs"), matToJson(truth.camera.distCoeffs.reshape(1, 1)));
+
+    QJsonObject board;
+    board.insert(QStringLiteral("smallDiameterMm"), truth.boardSpec.smallDiameterMm);
+    board.insert(QStringLiteral("centerSpacingMm"), truth.boardSpec.centerSpacingMm);
+    root.insert(QStringLiteral("board"), board);
+
+    QJsonObject render;
+    render.insert(QStringLiteral("blurSigmaPx"), truth.options.blurSigmaPx);
+    render.insert(QStringLiteral("blurJitter"), truth.options.blurJitter);
+    render.insert(QStringLiteral("readNoiseSigma"), truth.options.readNoiseSigma);
+    render.insert(QStringLiteral("shotNoiseGain"), truth.options.shotNoiseGain);
+    render.insert(QStringLiteral("vignetting"), truth.options.vignetting);
+    render.insert(QStringLiteral("minBoardFill"), truth.options.minBoardFill);
+    render.insert(QStringLiteral("maxBoardFill"), truth.options.maxBoardFill);
+    render.insert(QStringLiteral("maxTiltDeg"), truth.options.maxTiltDeg);
+    render.insert(QStringLiteral("maxRollDeg"), truth.options.maxRollDeg);
+    root.insert(QStringLiteral("render"), render);
+
+    QJsonArray views;
+    for (const auto &view : truth.views) {
+        if (!view.valid) {
+            continue;
+        }
+        QJsonObject obj;
+        obj.insert(QStringLiteral("file"), view.fileName);
+        obj.insert(QStringLiteral("rvec"), vecToJson(view.rvec));
+        obj.insert(QStringLiteral("tvec"), vecToJson(view.tvec));
+        obj.insert(QStringLiteral("blurSigmaPx"), view.blurSigmaPx);
+        QJsonArray points;
+        for (const auto &pt : view.imagePoints) {
+            points.append(QJsonArray{pt.x, pt.y});
+        }
+        obj.insert(QStringLiteral("imagePoints"), points);
+        views.append(obj);
+    }
+    root.insert(QStringLiteral("views"), views);
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    return true;
+}
+
+bool readGroundTruth(const QString &path, SyntheticGroundTruth &truth, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error) {
+            *error = file.errorString();
+        }
+        return false;
+    }
+
+    QJsonParseError parseError;
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (parseError.error != QJsonParseError::NoError || !doc.isObject()) {
+        if (error) {
+            *error = parseError.errorString();
+        }
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    truth.camera.imageSize = cv::Size(root.value(QStringLiteral("imageWidth")).toInt(),
+                                      root.value(QStringLiteral("imageHeight")).toInt());
+    truth.camera.cameraMatrix = matFromJson(root.value(QStringLiteral("cameraMatrix")).toArray());
+    const cv::Mat dist = matFromJson(root.value(QStringLiteral("distCoeffs")).toArray());
+    truth.camera.distCoeffs = dist.empty() ? cv::Mat::zeros(14, 1, CV_64F)
+                                           : dist.reshape(1, static_cast<int>(dist.total())).clone();
+    if (truth.camera.cameraMatrix.size() != cv::Size(3, 3) || truth.camera.imageSize.area() <= 0) {
+        if (error) {
+            *error = QStringLiteral("ground truth is missing camera intrinsics");
+        }
+        return false;
+    }
+
+    const QJsonObject board = root.value(QStringLiteral("board")).toObject();
+    truth.boardSpec.smallDiameterMm = board.value(QStringLiteral("smallDiameterMm")).toDouble(truth.boardSpec.smallDiameterMm);
+    truth.boardSpec.centerSpacingMm = board.value(QStringLiteral("centerSpacingMm")).toDouble(truth.boardSpec.centerSpacingMm);
+
+    const QJsonObject render = root.value(QStringLiteral("render")).toObject();
+    truth.options.blurSigmaPx = render.value(QStringLiteral("blurSigmaPx")).toDouble(truth.options.blurSigmaPx);
+    truth.options.blurJitter = render.value(QStringLiteral("blurJitter")).toDouble(truth.options.blurJitter);
+    truth.options.readNoiseSigma = render.value(QStringLiteral("readNoiseSigma")).toDouble(truth.options.readNoiseSigma);
+    truth.options.shotNoiseGain = render.value(QStringLiteral("shotNoiseGain")).toDouble(truth.options.shotNoiseGain);
+    truth.options.vignetting = render.value(QStringLiteral("vignetting")).toDouble(truth.options.vignetting);
+    truth.options.minBoardFill = render.value(QStringLiteral("minBoardFill")).toDouble(truth.options.minBoardFill);
+    truth.options.maxBoardFill = render.value(QStringLiteral("maxBoardFill")).toDouble(truth.options.maxBoardFill);
+    truth.options.maxTiltDeg = render.value(QStringLiteral("maxTiltDeg")).toDouble(truth.options.maxTiltDeg);
+    truth.options.maxRollDeg = render.value(QStringLiteral("maxRollDeg")).toDouble(truth.options.maxRollDeg);
+
+    truth.views.clear();
+    for (const auto &value : root.value(QStringLiteral("views")).toArray()) {
+        const QJsonObject obj = value.toObject();
+        SyntheticView view;
+        view.fileName = obj.value(QStringLiteral("file")).toString();
+        view.rvec = vecFromJson(obj.value(QStringLiteral("rvec")).toArray());
+        view.tvec = vecFromJson(obj.value(QStringLiteral("tvec")).toArray());
+        view.blurSigmaPx = obj.value(QStringLiteral("blurSigmaPx")).toDouble();
+        for (const auto &pt : obj.value(QStringLiteral("imagePoints")).toArray()) {
+            const QJsonArray xy = pt.toArray();
+            view.imagePoints.emplace_back(static_cast<float>(xy.at(0).toDouble()),
+                                          static_cast<float>(xy.at(1).toDouble()));
+        }
+        view.valid = true;
+        truth.views.push_back(std::move(view));
+    }
+    return true;
+}
+
+} // namespace mycalib
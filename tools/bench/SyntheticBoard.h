@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <QString>
+
+#include <opencv2/core.hpp>
+
+#include "BoardSpec.h"
+
+namespace mycalib {
+
+// Pinhole camera with the 14-coefficient rational / thin-prism / tilted model that
+// CalibrationEngine::calibrate() solves for.
+struct SyntheticCamera {
+    cv::Size imageSize {4000, 3000};
+    cv::Mat cameraMatrix;
+    cv::Mat distCoeffs;
+
+    [[nodiscard]] static SyntheticCamera makeDefault(const cv::Size &imageSize);
+};
+
+struct SyntheticRenderOptions {
+    double blurSigmaPx {0.9};
+    double blurJitter {0.3};
+    double readNoiseSigma {2.0};
+    double shotNoiseGain {0.04};
+    double vignetting {0.25};
+    double minBoardFill {0.30};
+    double maxBoardFill {0.70};
+    double maxTiltDeg {40.0};
+    double maxRollDeg {25.0};
+    double backgroundLevel {38.0};
+    double paperLevel {215.0};
+    double inkLevel {24.0};
+};
+
+// Printed target geometry in board millimetres, expanded from the BoardSpec layout.
+struct SyntheticBoardLayout {
+    std::vector<cv::Point3f> smallCentres;
+    std::array<cv::Point2f, 4> bigCentres {};
+    double smallRadiusMm {2.5};
+    double bigRadiusMm {5.0};
+    cv::Rect2d paper;
+
+    [[nodiscard]] static SyntheticBoardLayout fromSpec(const BoardSpec &spec);
+};
+
+struct SyntheticView {
+    QString fileName;
+    cv::Vec3d rvec;
+    cv::Vec3d tvec;
+    double blurSigmaPx {0.0};
+    std::vector<cv::Point2f> imagePoints;
+    cv::Mat image;
+    bool valid {false};
+};
+
+class SyntheticBoardRenderer {
+public:
+    SyntheticBoardRenderer(const BoardSpec &spec,
+                           const SyntheticCamera &camera,
+                           const SyntheticRenderOptions &options);
+
+    // Deterministic for a given seed, safe to call from several threads at once.
+    [[nodiscard]] SyntheticView render(std::uint64_t seed) const;
+
+    [[nodiscard]] const SyntheticBoardLayout &layout() const { return m_layout; }
+    [[nodiscard]] const SyntheticCamera &camera() const { return m_camera; }
+
+private:
+    static constexpr int kRayStep = 4;
+
+    BoardSpec m_spec;
+    SyntheticCamera m_camera;
+    SyntheticRenderOptions m_options;
+    SyntheticBoardLayout m_layout;
+    cv::Mat m_rays;
+    int m_latticeCols {0};
+    int m_latticeRows {0};
+    std::vector<unsigned char> m_occupied;
+
+    bool samplePose(std::uint64_t seed, cv::Vec3d &rvec, cv::Vec3d &tvec) const;
+    [[nodiscard]] cv::Mat rasterize(const cv::Vec3d &rvec, const cv::Vec3d &tvec, double blurSigmaPx, std::uint64_t seed) const;
+    [[nodiscard]] cv::Vec2d rayAt(int x, int y) const;
+};
+
+struct SyntheticGroundTruth {
+    BoardSpec boardSpec;
+    SyntheticCamera camera;
+    SyntheticRenderOptions options;
+    std::vector<SyntheticView> views;
+};
+
+bool writeGroundTruth(const SyntheticGroundTruth &truth, const QString &path, QString *error = nullptr);
+bool readGroundTruth(const QString &path, SyntheticGroundTruth &truth, QString *error = nullptr);
+
+} // namespace mycalib
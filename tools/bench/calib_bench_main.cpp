@@ -0,0 +1,297 @@
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLoggingCategory>
+#include <QTemporaryDir>
+#include <QTextStream>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include <opencv2/calib3d.hpp>
+
+#include "CalibrationEngine.h"
+#include "SyntheticBoard.h"
+
+namespace {
+
+constexpr int kModelGridCols = 40;
+constexpr int kModelGridRows = 30;
+
+double peakRssMiB()
+{
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<double>(counters.PeakWorkingSetSize) / (1024.0 * 1024.0);
+    }
+    return 0.0;
+#else
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0.0;
+    }
+#if defined(__APPLE__)
+    return static_cast<double>(usage.ru_maxrss) / (1024.0 * 1024.0);
+#else
+    return static_cast<double>(usage.ru_maxrss) / 1024.0;
+#endif
+#endif
+}
+
+struct ErrorStats {
+    double mean {0.0};
+    double rms {0.0};
+    double p95 {0.0};
+    double max {0.0};
+    int samples {0};
+};
+
+ErrorStats summarize(std::vector<double> values)
+{
+    ErrorStats stats;
+    if (values.empty()) {
+        return stats;
+    }
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (double v : values) {
+        sum += v;
+        sumSq += v * v;
+    }
+    stats.samples = static_cast<int>(values.size());
+    stats.mean = sum / values.size();
+    stats.rms = std::sqrt(sumSq / values.size());
+    stats.p95 = values[static_cast<size_t>(std::ceil(0.95 * (values.size() - 1)))];
+    stats.max = values.back();
+    return stats;
+}
+
+QJsonObject statsToJson(const ErrorStats &stats)
+{
+    QJsonObject obj;
+    obj.insert(QStringLiteral("mean"), stats.mean);
+    obj.insert(QStringLiteral("rms"), stats.rms);
+    obj.insert(QStringLiteral("p95"), stats.p95);
+    obj.insert(QStringLiteral("max"), stats.max);
+    obj.insert(QStringLiteral("samples"), stats.samples);
+    return obj;
+}
+
+// Pixel displacement between the true and the estimated camera model: every grid
+// pixel is back-projected through the ground truth and re-projected through the
+// estimate. Independent of how the distortion terms trade off against each other.
+ErrorStats modelDifference(const mycalib::SyntheticCamera &truth, const cv::Mat &cameraMatrix, const cv::Mat &distCoeffs)
+{
+    std::vector<cv::Point2d> pixels;
+    pixels.reserve(kModelGridCols * kModelGridRows);
+    for (int r = 0; r < kModelGridRows; ++r) {
+        for (int c = 0; c < kModelGridCols; ++c) {
+            pixels.emplace_back((c + 0.5) * truth.imageSize.width / kModelGridCols,
+                                (r + 0.5) * truth.imageSize.height / kModelGridRows);
+        }
+    }
+
+    std::vector<cv::Point2d> normalized;
+    cv::undistortPoints(pixels, normalized, truth.cameraMatrix, truth.distCoeffs, cv::noArray(), cv::noArray(),
+                        cv::TermCriteria(cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 100, 1e-12));
+    std::vector<cv::Point3d> rays;
+    rays.reserve(normalized.size());
+    for (const auto &n : normalized) {
+        rays.emplace_back(n.x, n.y, 1.0);
+    }
+
+    std::vector<cv::Point2d> reprojected;
+    cv::projectPoints(rays, cv::Vec3d(0.0, 0.0, 0.0), cv::Vec3d(0.0, 0.0, 0.0), cameraMatrix, distCoeffs, reprojected);
+
+    std::vector<double> errors;
+    errors.reserve(pixels.size());
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        errors.push_back(cv::norm(reprojected[i] - pixels[i]));
+    }
+    return summarize(std::move(errors));
+}
+
+// Detected centres against the projected ground-truth centres, matched by nearest
+// neighbour so the result does not depend on the detector's numbering.
+ErrorStats centreError(const mycalib::SyntheticGroundTruth &truth, const std::vector<mycalib::DetectionResult> &detections)
+{
+    QHash<QString, const mycalib::SyntheticView *> viewsByName;
+    for (const auto &view : truth.views) {
+        viewsByName.insert(QFileInfo(view.fileName).completeBaseName(), &view);
+    }
+
+    std::vector<double> errors;
+    for (const auto &det : detections) {
+        if (!det.success) {
+            continue;
+        }
+        const auto *view = viewsByName.value(QString::fromStdString(det.name), nullptr);
+        if (!view || view->imagePoints.empty()) {
+            continue;
+        }
+        for (const auto &pt : det.imagePoints) {
+            double best = std::numeric_limits<double>::max();
+            for (const auto &gt : view->imagePoints) {
+                best = std::min(best, static_cast<double>(cv::norm(pt - gt)));
+            }
+            errors.push_back(best);
+        }
+    }
+    return summarize(std::move(errors));
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // The pipeline renders report figures through QPainter; no window is ever shown.
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("MyCalib Benchmark"));
+    QCoreApplication::setOrganizationName(QStringLiteral("CalibLab"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("End-to-end calibration throughput and accuracy benchmark on a synthetic dataset"));
+    parser.addHelpOption();
+
+    QCommandLineOption datasetOption({QStringLiteral("i"), QStringLiteral("dataset")},
+                                     QStringLiteral("Directory produced by mycalib_synth_dataset."),
+                                     QStringLiteral("dir"));
+    QCommandLineOption outputOption({QStringLiteral("o"), QStringLiteral("output")},
+                                    QStringLiteral("Directory for the calibration artefacts (default: temporary)."),
+                                    QStringLiteral("dir"));
+    QCommandLineOption reportOption(QStringLiteral("report"),
+                                    QStringLiteral("Write the benchmark summary as JSON."),
+                                    QStringLiteral("file"));
+    QCommandLineOption verboseOption({QStringLiteral("v"), QStringLiteral("verbose")},
+                                     QStringLiteral("Keep the pipeline log output."));
+    QCommandLineOption noRefineOption(QStringLiteral("no-refine"),
+                                      QStringLiteral("Disable the non-linear refinement stage."));
+
+    parser.addOption(datasetOption);
+    parser.addOption(outputOption);
+    parser.addOption(reportOption);
+    parser.addOption(verboseOption);
+    parser.addOption(noRefineOption);
+    parser.process(app);
+
+    if (!parser.isSet(datasetOption)) {
+        QTextStream(stderr) << "Error: --dataset must be provided." << Qt::endl;
+        parser.showHelp(1);
+    }
+    if (!parser.isSet(verboseOption)) {
+        QLoggingCategory::setFilterRules(QStringLiteral("default.info=false\ndefault.warning=false"));
+    }
+
+    const QString datasetDir = QDir(parser.value(datasetOption)).absolutePath();
+    mycalib::SyntheticGroundTruth truth;
+    QString error;
+    if (!mycalib::readGroundTruth(datasetDir + QStringLiteral("/ground_truth.json"), truth, &error)) {
+        QTextStream(stderr) << "Unable to read ground truth: " << error << Qt::endl;
+        return 1;
+    }
+
+    QTemporaryDir scratch;
+    const QString outputDir = parser.isSet(outputOption) ? QDir(parser.value(outputOption)).absolutePath() : scratch.path();
+
+    mycalib::CalibrationEngine::Settings settings;
+    settings.boardSpec = truth.boardSpec;
+    settings.enableRefinement = !parser.isSet(noRefineOption);
+
+    mycalib::CalibrationEngine engine;
+    const auto start = std::chrono::steady_clock::now();
+    const auto result = engine.runBlocking(datasetDir, settings, outputDir);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double rssMiB = peakRssMiB();
+
+    const int images = static_cast<int>(result.allDetections.size());
+    int detected = 0;
+    double detectMs = 0.0;
+    for (const auto &det : result.allDetections) {
+        detected += det.success ? 1 : 0;
+        detectMs += std::chrono::duration<double, std::milli>(det.elapsed).count();
+    }
+
+    QTextStream out(stdout);
+    out << "dataset      : " << datasetDir << " (" << truth.camera.imageSize.width << "x"
+        << truth.camera.imageSize.height << ", " << truth.views.size() << " views)" << Qt::endl;
+    out << "detected     : " << detected << "/" << images << Qt::endl;
+    out << "wall time    : " << QString::number(seconds, 'f', 2) << " s | "
+        << QString::number(seconds > 0.0 ? images / seconds : 0.0, 'f', 2) << " images/s | detection "
+        << QString::number(images > 0 ? detectMs / images : 0.0, 'f', 1) << " ms/image" << Qt::endl;
+    out << "peak RSS     : " << QString::number(rssMiB, 'f', 1) << " MiB" << Qt::endl;
+
+    QJsonObject report;
+    report.insert(QStringLiteral("dataset"), datasetDir);
+    report.insert(QStringLiteral("images"), images);
+    report.insert(QStringLiteral("detected"), detected);
+    report.insert(QStringLiteral("wallSeconds"), seconds);
+    report.insert(QStringLiteral("imagesPerSecond"), seconds > 0.0 ? images / seconds : 0.0);
+    report.insert(QStringLiteral("detectionMsPerImage"), images > 0 ? detectMs / images : 0.0);
+    report.insert(QStringLiteral("peakRssMiB"), rssMiB);
+    report.insert(QStringLiteral("success"), result.success);
+
+    if (result.success) {
+        const auto &K = result.cameraMatrix;
+        const auto &Kt = truth.camera.cameraMatrix;
+        const double dfx = K.at<double>(0, 0) - Kt.at<double>(0, 0);
+        const double dfy = K.at<double>(1, 1) - Kt.at<double>(1, 1);
+        const double dcx = K.at<double>(0, 2) - Kt.at<double>(0, 2);
+        const double dcy = K.at<double>(1, 2) - Kt.at<double>(1, 2);
+        const ErrorStats model = modelDifference(truth.camera, result.cameraMatrix, result.distCoeffs);
+        const ErrorStats centres = centreError(truth, result.keptDetections);
+
+        out << "rms          : " << QString::number(result.metrics.rms, 'f', 4) << " px" << Qt::endl;
+        out << "intrinsics   : dfx=" << QString::number(dfx, 'f', 3) << " dfy=" << QString::number(dfy, 'f', 3)
+            << " dcx=" << QString::number(dcx, 'f', 3) << " dcy=" << QString::number(dcy, 'f', 3) << " px" << Qt::endl;
+        out << "model error  : rms=" << QString::number(model.rms, 'f', 4) << " max=" << QString::number(model.max, 'f', 4)
+            << " px" << Qt::endl;
+        out << "centre error : mean=" << QString::number(centres.mean, 'f', 4) << " p95=" << QString::number(centres.p95, 'f', 4)
+            << " max=" << QString::number(centres.max, 'f', 4) << " px" << Qt::endl;
+
+        QJsonObject intrinsics;
+        intrinsics.insert(QStringLiteral("dfx"), dfx);
+        intrinsics.insert(QStringLiteral("dfy"), dfy);
+        intrinsics.insert(QStringLiteral("dcx"), dcx);
+        intrinsics.insert(QStringLiteral("dcy"), dcy);
+        report.insert(QStringLiteral("rms"), result.metrics.rms);
+        report.insert(QStringLiteral("intrinsicsError"), intrinsics);
+        report.insert(QStringLiteral("modelErrorPx"), statsToJson(model));
+        report.insert(QStringLiteral("centreErrorPx"), statsToJson(centres));
+    } else {
+        out << "calibration failed: " << result.message << Qt::endl;
+    }
+
+    if (parser.isSet(reportOption)) {
+        QFile file(parser.value(reportOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "Unable to write report: " << file.errorString() << Qt::endl;
+            return 2;
+        }
+        file.write(QJsonDocument(report).toJson(QJsonDocument::Indented));
+    }
+
+    return result.success ? 0 : 2;
+}
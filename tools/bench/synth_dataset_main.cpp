@@ -0,0 +1,196 @@
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+#include <opencv2/imgcodecs.hpp>
+
+#include "SyntheticBoard.h"
+
+namespace {
+
+constexpr int kMaxMegapixels = 24;
+
+bool parseDouble(const QCommandLineParser &parser, const QCommandLineOption &option, double minValue, double &target)
+{
+    if (!parser.isSet(option)) {
+        return true;
+    }
+    bool ok = false;
+    const double value = parser.value(option).toDouble(&ok);
+    if (!ok || !std::isfinite(value) || value < minValue) {
+        QTextStream(stderr) << "Invalid value for --" << option.names().last() << ": " << parser.value(option) << Qt::endl;
+        return false;
+    }
+    target = value;
+    return true;
+}
+
+bool parseInt(const QCommandLineParser &parser, const QCommandLineOption &option, int minValue, int &target)
+{
+    if (!parser.isSet(option)) {
+        return true;
+    }
+    bool ok = false;
+    const int value = parser.value(option).toInt(&ok);
+    if (!ok || value < minValue) {
+        QTextStream(stderr) << "Invalid value for --" << option.names().last() << ": " << parser.value(option) << Qt::endl;
+        return false;
+    }
+    target = value;
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("MyCalib Synthetic Dataset"));
+    QCoreApplication::setOrganizationName(QStringLiteral("CalibLab"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Render synthetic 7x6 asymmetric-circle calibration images with known ground truth"));
+    parser.addHelpOption();
+
+    QCommandLineOption outputOption({QStringLiteral("o"), QStringLiteral("output")},
+                                    QStringLiteral("Directory receiving the images and ground_truth.json."),
+                                    QStringLiteral("dir"));
+    QCommandLineOption countOption({QStringLiteral("n"), QStringLiteral("count")},
+                                   QStringLiteral("Number of views to render (default 30)."),
+                                   QStringLiteral("count"));
+    QCommandLineOption widthOption(QStringLiteral("width"), QStringLiteral("Image width in pixels (default 4000)."), QStringLiteral("px"));
+    QCommandLineOption heightOption(QStringLiteral("height"), QStringLiteral("Image height in pixels (default 3000)."), QStringLiteral("px"));
+    QCommandLineOption diameterOption({QStringLiteral("d"), QStringLiteral("diameter")},
+                                      QStringLiteral("Small circle diameter in millimetres."), QStringLiteral("mm"));
+    QCommandLineOption spacingOption({QStringLiteral("s"), QStringLiteral("spacing")},
+                                     QStringLiteral("Circle centre spacing in millimetres."), QStringLiteral("mm"));
+    QCommandLineOption blurOption(QStringLiteral("blur"), QStringLiteral("Gaussian optical blur sigma in pixels."), QStringLiteral("px"));
+    QCommandLineOption noiseOption(QStringLiteral("noise"), QStringLiteral("Read noise sigma in 8-bit DN."), QStringLiteral("dn"));
+    QCommandLineOption vignettingOption(QStringLiteral("vignetting"), QStringLiteral("Relative light falloff at the image corner (0-1)."), QStringLiteral("ratio"));
+    QCommandLineOption tiltOption(QStringLiteral("max-tilt"), QStringLiteral("Maximum board tilt in degrees."), QStringLiteral("deg"));
+    QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Base random seed (default 1)."), QStringLiteral("seed"));
+    QCommandLineOption threadsOption({QStringLiteral("j"), QStringLiteral("threads")},
+                                     QStringLiteral("Number of render threads (default: all cores)."), QStringLiteral("count"));
+    QCommandLineOption formatOption(QStringLiteral("format"), QStringLiteral("Image format: png (default) or jpg."), QStringLiteral("ext"));
+
+    parser.addOption(outputOption);
+    parser.addOption(countOption);
+    parser.addOption(widthOption);
+    parser.addOption(heightOption);
+    parser.addOption(diameterOption);
+    parser.addOption(spacingOption);
+    parser.addOption(blurOption);
+    parser.addOption(noiseOption);
+    parser.addOption(vignettingOption);
+    parser.addOption(tiltOption);
+    parser.addOption(seedOption);
+    parser.addOption(threadsOption);
+    parser.addOption(formatOption);
+    parser.process(app);
+
+    if (!parser.isSet(outputOption)) {
+        QTextStream(stderr) << "Error: --output must be provided." << Qt::endl;
+        parser.showHelp(1);
+    }
+
+    int count = 30;
+    int width = 4000;
+    int height = 3000;
+    int seed = 1;
+    int threads = QThread::idealThreadCount();
+    mycalib::BoardSpec spec;
+    mycalib::SyntheticRenderOptions options;
+    if (!parseInt(parser, countOption, 1, count) ||
+        !parseInt(parser, widthOption, 320, width) ||
+        !parseInt(parser, heightOption, 240, height) ||
+        !parseInt(parser, seedOption, 0, seed) ||
+        !parseInt(parser, threadsOption, 1, threads) ||
+        !parseDouble(parser, diameterOption, 0.1, spec.smallDiameterMm) ||
+        !parseDouble(parser, spacingOption, 0.1, spec.centerSpacingMm) ||
+        !parseDouble(parser, blurOption, 0.0, options.blurSigmaPx) ||
+        !parseDouble(parser, noiseOption, 0.0, options.readNoiseSigma) ||
+        !parseDouble(parser, vignettingOption, 0.0, options.vignetting) ||
+        !parseDouble(parser, tiltOption, 0.0, options.maxTiltDeg)) {
+        return 1;
+    }
+    if (static_cast<qint64>(width) * height > static_cast<qint64>(kMaxMegapixels) * 1000 * 1000) {
+        QTextStream(stderr) << "Resolution " << width << "x" << height << " exceeds " << kMaxMegapixels << " MP." << Qt::endl;
+        return 1;
+    }
+    options.vignetting = std::min(options.vignetting, 0.95);
+
+    const QString format = parser.isSet(formatOption) ? parser.value(formatOption).toLower() : QStringLiteral("png");
+    if (format != QStringLiteral("png") && format != QStringLiteral("jpg")) {
+        QTextStream(stderr) << "Unsupported format: " << format << Qt::endl;
+        return 1;
+    }
+
+    const QString outputDir = QDir(parser.value(outputOption)).absolutePath();
+    if (!QDir().mkpath(outputDir)) {
+        QTextStream(stderr) << "Unable to create " << outputDir << Qt::endl;
+        return 1;
+    }
+
+    mycalib::SyntheticGroundTruth truth;
+    truth.boardSpec = spec;
+    truth.camera = mycalib::SyntheticCamera::makeDefault(cv::Size(width, height));
+    truth.options = options;
+    truth.views.resize(static_cast<size_t>(count));
+
+    const mycalib::SyntheticBoardRenderer renderer(spec, truth.camera, options);
+    QThreadPool::globalInstance()->setMaxThreadCount(threads);
+
+    std::vector<int> indices(static_cast<size_t>(count));
+    std::iota(indices.begin(), indices.end(), 0);
+    std::atomic_int written {0};
+    std::atomic_int failed {0};
+
+    QElapsedTimer timer;
+    timer.start();
+    QtConcurrent::blockingMap(indices, [&](int &index) {
+        const auto viewSeed = static_cast<std::uint64_t>(seed) * 1000003ULL + static_cast<std::uint64_t>(index);
+        mycalib::SyntheticView view = renderer.render(viewSeed);
+        if (!view.valid) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        view.fileName = QStringLiteral("synth_%1.%2").arg(index, 4, 10, QLatin1Char('0')).arg(format);
+        std::vector<int> params;
+        if (format == QStringLiteral("jpg")) {
+            params = {cv::IMWRITE_JPEG_QUALITY, 95};
+        } else {
+            params = {cv::IMWRITE_PNG_COMPRESSION, 1};
+        }
+        if (!cv::imwrite((outputDir + QLatin1Char('/') + view.fileName).toStdString(), view.image, params)) {
+            failed.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        view.image.release();
+        truth.views[static_cast<size_t>(index)] = std::move(view);
+        written.fetch_add(1, std::memory_order_relaxed);
+    });
+    const double seconds = static_cast<double>(timer.elapsed()) / 1000.0;
+
+    QString error;
+    if (!mycalib::writeGroundTruth(truth, outputDir + QStringLiteral("/ground_truth.json"), &error)) {
+        QTextStream(stderr) << "Failed to write ground truth: " << error << Qt::endl;
+        return 2;
+    }
+
+    QTextStream(stdout) << "Rendered " << written.load() << "/" << count << " views at "
+                        << width << "x" << height << " in " << QString::number(seconds, 'f', 2) << " s ("
+                        << failed.load() << " failed) -> " << outputDir << Qt::endl;
+    return written.load() > 0 ? 0 : 2;
+}